@@ -44,6 +44,10 @@ namespace {
 
 constexpr char COMPONENT_NAME[] = "c2.android.avc.encoder";
 constexpr uint32_t kMinOutBufferSize = 524288;
+// Input is converted to I420 on a pipeline thread for up to kMaxPreparedWorks
+// frames ahead of the encoder.
+constexpr size_t kNumPrepareThreads = 1;
+constexpr size_t kMaxPreparedWorks = 2;
 void ParseGop(
         const C2StreamGopTuning::output &gop,
         uint32_t *syncInterval, uint32_t *iInterval, uint32_t *maxBframes) {
@@ -595,6 +599,18 @@ static size_t GetCPUCoreCount() {
     return (size_t)cpuCoreCount;
 }
 
+// Returns whether the encoder can read |input| as is.
+static bool IsI420Compatible(const C2GraphicView &input) {
+    const C2PlanarLayout &layout = input.layout();
+    return layout.type == C2PlanarLayout::TYPE_YUV
+            && IsYUV420(input)
+            && layout.planes[layout.PLANE_Y].colInc == 1
+            && layout.planes[layout.PLANE_U].colInc == 1
+            && layout.planes[layout.PLANE_V].colInc == 1
+            && layout.planes[layout.PLANE_U].rowInc == layout.planes[layout.PLANE_V].rowInc
+            && layout.planes[layout.PLANE_Y].rowInc == 2 * layout.planes[layout.PLANE_V].rowInc;
+}
+
 }  // namespace
 
 C2SoftAvcEnc::C2SoftAvcEnc(
@@ -617,6 +633,7 @@ C2SoftAvcEnc::C2SoftAvcEnc(
     CREATE_DUMP_FILE(mOutFile);
 
     initEncParams();
+    enablePipeline(kNumPrepareThreads, kMaxPreparedWorks);
 }
 
 C2SoftAvcEnc::C2SoftAvcEnc(
@@ -1543,62 +1560,27 @@ c2_status_t C2SoftAvcEnc::setEncodeArgs(
     CHECK_EQ((height & 1u), 0u);
     size_t yPlaneSize = width * height;
 
-    switch (layout.type) {
-        case C2PlanarLayout::TYPE_RGB:
-            [[fallthrough]];
-        case C2PlanarLayout::TYPE_RGBA: {
-            ALOGV("yPlaneSize = %zu", yPlaneSize);
-            MemoryBlock conversionBuffer = mConversionBuffers.fetch(yPlaneSize * 3 / 2);
-            mConversionBuffersInUse.emplace(conversionBuffer.data(), conversionBuffer);
-            yPlane = conversionBuffer.data();
-            uPlane = yPlane + yPlaneSize;
-            vPlane = uPlane + yPlaneSize / 4;
-            yStride = width;
-            uStride = vStride = yStride / 2;
-            ConvertRGBToPlanarYUV(yPlane, yStride, height, conversionBuffer.size(), *input,
-                                  mColorAspects->matrix, mColorAspects->range);
-            break;
-        }
-        case C2PlanarLayout::TYPE_YUV: {
-            if (!IsYUV420(*input)) {
-                ALOGE("input is not YUV420");
-                return C2_BAD_VALUE;
-            }
-
-            if (layout.planes[layout.PLANE_Y].colInc == 1
-                    && layout.planes[layout.PLANE_U].colInc == 1
-                    && layout.planes[layout.PLANE_V].colInc == 1
-                    && uStride == vStride
-                    && yStride == 2 * vStride) {
-                // I420 compatible - already set up above
-                break;
-            }
-
-            // copy to I420
-            yStride = width;
-            uStride = vStride = yStride / 2;
-            MemoryBlock conversionBuffer = mConversionBuffers.fetch(yPlaneSize * 3 / 2);
-            mConversionBuffersInUse.emplace(conversionBuffer.data(), conversionBuffer);
-            MediaImage2 img = CreateYUV420PlanarMediaImage2(width, height, yStride, height);
-            status_t err = ImageCopy(conversionBuffer.data(), &img, *input);
-            if (err != OK) {
-                ALOGE("Buffer conversion failed: %d", err);
-                return C2_BAD_VALUE;
+    if (!IsI420Compatible(*input)) {
+        MemoryBlock conversionBuffer;
+        std::shared_ptr<ConvertedInput> converted =
+                std::static_pointer_cast<ConvertedInput>(preparedWork());
+        if (converted && converted->width == width && converted->height == height
+                && converted->matrix == mColorAspects->matrix
+                && converted->range == mColorAspects->range) {
+            conversionBuffer = converted->buffer;
+        } else {
+            c2_status_t err = convertToI420(*input, width, height, mColorAspects->matrix,
+                                            mColorAspects->range, &conversionBuffer);
+            if (err != C2_OK) {
+                return err;
             }
-            yPlane = conversionBuffer.data();
-            uPlane = yPlane + yPlaneSize;
-            vPlane = uPlane + yPlaneSize / 4;
-            break;
-
         }
-
-        case C2PlanarLayout::TYPE_YUVA:
-            ALOGE("YUVA plane type is not supported");
-            return C2_BAD_VALUE;
-
-        default:
-            ALOGE("Unrecognized plane type: %d", layout.type);
-            return C2_BAD_VALUE;
+        mConversionBuffersInUse.emplace(conversionBuffer.data(), conversionBuffer);
+        yPlane = conversionBuffer.data();
+        uPlane = yPlane + yPlaneSize;
+        vPlane = uPlane + yPlaneSize / 4;
+        yStride = width;
+        uStride = vStride = yStride / 2;
     }
 
     switch (mIvVideoColorFormat) {
@@ -1654,6 +1636,84 @@ c2_status_t C2SoftAvcEnc::setEncodeArgs(
     return C2_OK;
 }
 
+c2_status_t C2SoftAvcEnc::convertToI420(
+        const C2GraphicView &input, uint32_t width, uint32_t height,
+        C2Color::matrix_t matrix, C2Color::range_t range, MemoryBlock *buffer) {
+    const C2PlanarLayout &layout = input.layout();
+    size_t yPlaneSize = width * height;
+    switch (layout.type) {
+        case C2PlanarLayout::TYPE_RGB:
+            [[fallthrough]];
+        case C2PlanarLayout::TYPE_RGBA: {
+            ALOGV("yPlaneSize = %zu", yPlaneSize);
+            *buffer = mConversionBuffers.fetch(yPlaneSize * 3 / 2);
+            ConvertRGBToPlanarYUV(buffer->data(), width, height, buffer->size(), input,
+                                  matrix, range);
+            return C2_OK;
+        }
+        case C2PlanarLayout::TYPE_YUV: {
+            if (!IsYUV420(input)) {
+                ALOGE("input is not YUV420");
+                return C2_BAD_VALUE;
+            }
+
+            // copy to I420
+            *buffer = mConversionBuffers.fetch(yPlaneSize * 3 / 2);
+            MediaImage2 img = CreateYUV420PlanarMediaImage2(width, height, width, height);
+            status_t err = ImageCopy(buffer->data(), &img, input);
+            if (err != OK) {
+                ALOGE("Buffer conversion failed: %d", err);
+                return C2_BAD_VALUE;
+            }
+            return C2_OK;
+        }
+
+        case C2PlanarLayout::TYPE_YUVA:
+            ALOGE("YUVA plane type is not supported");
+            return C2_BAD_VALUE;
+
+        default:
+            ALOGE("Unrecognized plane type: %d", layout.type);
+            return C2_BAD_VALUE;
+    }
+}
+
+std::shared_ptr<SimpleC2Component::PreparedWork> C2SoftAvcEnc::onPrepare(
+        const std::unique_ptr<C2Work> &work) {
+    if (work->input.buffers.empty() || !work->input.buffers[0]) {
+        return nullptr;
+    }
+    std::shared_ptr<C2StreamPictureSizeInfo::input> size;
+    std::shared_ptr<C2StreamColorAspectsInfo::output> colorAspects;
+    {
+        IntfImpl::Lock lock = mIntf->lock();
+        size = mIntf->getSize_l();
+        colorAspects = mIntf->getCodedColorAspects_l();
+    }
+
+    // errors are left for process() to report
+    C2GraphicView view = work->input.buffers[0]->data().graphicBlocks().front().map().get();
+    if (view.error() != C2_OK) {
+        return nullptr;
+    }
+    view.setCrop_be(C2Rect(size->width, size->height));
+    if (view.width() < size->width || view.height() < size->height
+            || IsI420Compatible(view)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<ConvertedInput> converted = std::make_shared<ConvertedInput>();
+    converted->width = size->width;
+    converted->height = size->height;
+    converted->matrix = colorAspects->matrix;
+    converted->range = colorAspects->range;
+    if (convertToI420(view, size->width, size->height, converted->matrix, converted->range,
+                      &converted->buffer) != C2_OK) {
+        return nullptr;
+    }
+    return converted;
+}
+
 void C2SoftAvcEnc::finishWork(uint64_t workIndex, const std::unique_ptr<C2Work> &work,
                               ive_video_encode_op_t *ps_encode_op) {
     std::shared_ptr<C2Buffer> buffer =
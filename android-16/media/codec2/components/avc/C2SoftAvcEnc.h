@@ -133,6 +133,7 @@ struct C2SoftAvcEnc : public SimpleC2Component {
     void onReset() override;
     void onRelease() override;
     c2_status_t onFlush_sm() override;
+    std::shared_ptr<PreparedWork> onPrepare(const std::unique_ptr<C2Work> &work) override;
     void process(
             const std::unique_ptr<C2Work> &work,
             const std::shared_ptr<C2BlockPool> &pool) override;
@@ -212,6 +213,15 @@ private:
     MemoryBlockPool mConversionBuffers;
     std::map<const void *, MemoryBlock> mConversionBuffersInUse;
 
+    // input converted to I420 by onPrepare()
+    struct ConvertedInput : public PreparedWork {
+        MemoryBlock buffer;
+        uint32_t width;
+        uint32_t height;
+        C2Color::matrix_t matrix;
+        C2Color::range_t range;
+    };
+
     void initEncParams();
     c2_status_t initEncoder();
     c2_status_t releaseEncoder();
@@ -232,6 +242,9 @@ private:
     c2_status_t setVbvParams();
     c2_status_t setVuiParams();
     void logVersion();
+    c2_status_t convertToI420(const C2GraphicView &input, uint32_t width, uint32_t height,
+                              C2Color::matrix_t matrix, C2Color::range_t range,
+                              MemoryBlock *buffer);
     c2_status_t setEncodeArgs(
             ive_video_encode_ip_t *ps_encode_ip,
             ive_video_encode_op_t *ps_encode_op,
@@ -26,6 +26,13 @@
 #include <inttypes.h>
 #include <libyuv.h>
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define USE_NEON_CONVERSION 1
+#include <arm_neon.h>
+#else
+#define USE_NEON_CONVERSION 0
+#endif
+
 #include <C2Config.h>
 #include <C2Debug.h>
 #include <C2PlatformSupport.h>
@@ -46,6 +53,14 @@ namespace android {
 constexpr uint8_t kNeutralUVBitDepth8 = 128;
 constexpr uint16_t kNeutralUVBitDepth10 = 512;
 
+// Scales an 8 bit value to 10 bits, rounded to nearest, and returns it in the
+// 10 most significant bits as in P010 and P210. Same as
+// ((uint16_t)((double)value * 1023 / 255 + 0.5) << 6) without the floating
+// point conversions, so that the loops using it can be vectorized.
+static inline uint16_t scale8To10Msb(uint32_t value) {
+    return (uint16_t)((value * 4 + (value * 2 + 85) / 170) << 6);
+}
+
 void convertYUV420Planar8ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, const uint8_t *srcY,
                                 const uint8_t *srcU, const uint8_t *srcV, size_t srcYStride,
                                 size_t srcUStride, size_t srcVStride, size_t dstYStride,
@@ -95,6 +110,30 @@ void convertYUV420Planar16ToY410(uint32_t *dst, const uint16_t *srcY, const uint
 
         uint32_t u01, v01, y01, y23, y45, y67, uv0, uv1;
         size_t x = 0;
+#if USE_NEON_CONVERSION
+        // 8 pixels of each line at a time
+        const uint32x4_t alpha = vdupq_n_u32(3u << 30);
+        const uint16x4_t mask = vdup_n_u16(0x3FF);
+        for (; x + 8 <= width; x += 8) {
+            uint32x4_t u = vmovl_u16(vand_u16(vld1_u16(uSrc), mask));
+            uint32x4_t v = vmovl_u16(vand_u16(vld1_u16(vSrc), mask));
+            uSrc += 4;
+            vSrc += 4;
+            uint32x4_t uv = vorrq_u32(vorrq_u32(u, vshlq_n_u32(v, 20)), alpha);
+            uint32x4x2_t uv2 = vzipq_u32(uv, uv);
+
+            uint16x8_t yTop = vandq_u16(vld1q_u16(ySrcTop), vcombine_u16(mask, mask));
+            uint16x8_t yBot = vandq_u16(vld1q_u16(ySrcBot), vcombine_u16(mask, mask));
+            ySrcTop += 8;
+            ySrcBot += 8;
+            vst1q_u32(dstTop, vorrq_u32(vshll_n_u16(vget_low_u16(yTop), 10), uv2.val[0]));
+            vst1q_u32(dstTop + 4, vorrq_u32(vshll_n_u16(vget_high_u16(yTop), 10), uv2.val[1]));
+            vst1q_u32(dstBot, vorrq_u32(vshll_n_u16(vget_low_u16(yBot), 10), uv2.val[0]));
+            vst1q_u32(dstBot + 4, vorrq_u32(vshll_n_u16(vget_high_u16(yBot), 10), uv2.val[1]));
+            dstTop += 8;
+            dstBot += 8;
+        }
+#endif  // USE_NEON_CONVERSION
         for (; x < width - 3; x += 4) {
             u01 = *((uint32_t *)uSrc);
             uSrc += 2;
@@ -246,6 +285,126 @@ static const struct Coeffs GetCoeffsForAspects(const C2ColorAspectsStruct &aspec
 }
 
 #define CLIP3(min, v, max) (((v) < (min)) ? (min) : (((max) > (v)) ? (v) : (max)))
+
+namespace {
+
+// Converts one pixel to RGBA1010102 from its luma term and the chroma terms of
+// the pixel pair.
+static inline uint32_t toRGBA1010102(int32_t yMult, int32_t u_b, int32_t uv_g, int32_t v_r) {
+    int32_t b = (yMult + u_b) / 1024;
+    int32_t g = (yMult + uv_g) / 1024;
+    int32_t r = (yMult + v_r) / 1024;
+    b = CLIP3(0, b, 1023);
+    g = CLIP3(0, g, 1023);
+    r = CLIP3(0, r, 1023);
+    return 3 << 30 | (b << 20) | (g << 10) | r;
+}
+
+/**
+ * Converts kRows rows of 10 bit YUV sharing one row of horizontally subsampled
+ * chroma to RGBA1010102.
+ *
+ * The samples are shifted right by kShift, 0 for 10 bit planar data and 6 for
+ * P210. Chroma samples are read every kChromaStep values, 1 for planar data and
+ * 2 for interleaved UV. Width must be even.
+ */
+template <int kShift, size_t kChromaStep, size_t kRows>
+void convertRowsToRGBA1010102(uint32_t *const dst[kRows], const uint16_t *const srcY[kRows],
+                              const uint16_t *srcU, const uint16_t *srcV, size_t width,
+                              const Coeffs &coeffs) {
+    const int32_t _y = coeffs._y;
+    const int32_t _b_u = coeffs._b_u;
+    const int32_t _neg_g_u = -coeffs._g_u;
+    const int32_t _neg_g_v = -coeffs._g_v;
+    const int32_t _r_v = coeffs._r_v;
+    const int32_t _c16 = coeffs._c16;
+
+    size_t x = 0;
+#if USE_NEON_CONVERSION
+    // 8 pixels of each row at a time. The division by 1024 of the scalar code is
+    // an arithmetic shift here: they only differ for negative values, which are
+    // clipped to 0.
+    const int32x4_t yCoeff = vdupq_n_s32(_y);
+    const int32x4_t yOffset = vdupq_n_s32(_c16);
+    const int32x4_t uvOffset = vdupq_n_s32(512);
+    const int32x4_t rounding = vdupq_n_s32(512);
+    const int32x4_t zero = vdupq_n_s32(0);
+    const int32x4_t max = vdupq_n_s32(1023);
+    const uint32x4_t alpha = vdupq_n_u32(3u << 30);
+
+    for (; x + 8 <= width; x += 8) {
+        uint16x4_t u4, v4;
+        if constexpr (kChromaStep == 2) {
+            uint16x4x2_t uv = vld2_u16(srcU + x);
+            u4 = uv.val[0];
+            v4 = uv.val[1];
+        } else {
+            u4 = vld1_u16(srcU + x / 2);
+            v4 = vld1_u16(srcV + x / 2);
+        }
+        if constexpr (kShift > 0) {
+            u4 = vshr_n_u16(u4, kShift);
+            v4 = vshr_n_u16(v4, kShift);
+        }
+
+        const int32x4_t u = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(u4)), uvOffset);
+        const int32x4_t v = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(v4)), uvOffset);
+        const int32x4_t uB = vmulq_n_s32(u, _b_u);
+        const int32x4_t uvG = vmlaq_n_s32(vmulq_n_s32(u, _neg_g_u), v, _neg_g_v);
+        const int32x4_t vR = vmulq_n_s32(v, _r_v);
+
+        // each chroma sample covers two pixels.
+        const int32x4x2_t uB2 = vzipq_s32(uB, uB);
+        const int32x4x2_t uvG2 = vzipq_s32(uvG, uvG);
+        const int32x4x2_t vR2 = vzipq_s32(vR, vR);
+
+        for (size_t row = 0; row < kRows; ++row) {
+            uint16x8_t y8 = vld1q_u16(srcY[row] + x);
+            if constexpr (kShift > 0) {
+                y8 = vshrq_n_u16(y8, kShift);
+            }
+            const int32x4_t y4[2] = {
+                vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(y8))),
+                vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(y8))),
+            };
+            for (int i = 0; i < 2; ++i) {
+                const int32x4_t yMult = vmlaq_s32(rounding, vsubq_s32(y4[i], yOffset), yCoeff);
+                int32x4_t b = vshrq_n_s32(vaddq_s32(yMult, uB2.val[i]), 10);
+                int32x4_t g = vshrq_n_s32(vaddq_s32(yMult, uvG2.val[i]), 10);
+                int32x4_t r = vshrq_n_s32(vaddq_s32(yMult, vR2.val[i]), 10);
+                b = vminq_s32(vmaxq_s32(b, zero), max);
+                g = vminq_s32(vmaxq_s32(g, zero), max);
+                r = vminq_s32(vmaxq_s32(r, zero), max);
+
+                uint32x4_t rgba = vorrq_u32(alpha, vreinterpretq_u32_s32(r));
+                rgba = vorrq_u32(rgba, vshlq_n_u32(vreinterpretq_u32_s32(g), 10));
+                rgba = vorrq_u32(rgba, vshlq_n_u32(vreinterpretq_u32_s32(b), 20));
+                vst1q_u32(dst[row] + x + 4 * i, rgba);
+            }
+        }
+    }
+#endif  // USE_NEON_CONVERSION
+
+    for (; x < width; x += 2) {
+        const size_t c = x / 2 * kChromaStep;
+        int32_t u = (srcU[c] >> kShift) - 512;
+        int32_t v = (srcV[c] >> kShift) - 512;
+
+        int32_t u_b = u * _b_u;
+        int32_t uv_g = u * _neg_g_u + v * _neg_g_v;
+        int32_t v_r = v * _r_v;
+
+        for (size_t row = 0; row < kRows; ++row) {
+            int32_t y0 = (srcY[row][x] >> kShift) - _c16;
+            int32_t y1 = (srcY[row][x + 1] >> kShift) - _c16;
+            dst[row][x] = toRGBA1010102(y0 * _y + 512, u_b, uv_g, v_r);
+            dst[row][x + 1] = toRGBA1010102(y1 * _y + 512, u_b, uv_g, v_r);
+        }
+    }
+}
+
+}  // namespace
+
 void convertYUV420Planar16ToRGBA1010102(
         uint32_t *dst, const uint16_t *srcY, const uint16_t *srcU,
         const uint16_t *srcV, size_t srcYStride, size_t srcUStride,
@@ -257,80 +416,11 @@ void convertYUV420Planar16ToRGBA1010102(
 
     struct Coeffs coeffs = GetCoeffsForAspects(_aspects);
 
-    int32_t _y = coeffs._y;
-    int32_t _b_u = coeffs._b_u;
-    int32_t _neg_g_u = -coeffs._g_u;
-    int32_t _neg_g_v = -coeffs._g_v;
-    int32_t _r_v = coeffs._r_v;
-    int32_t _c16 = coeffs._c16;
-
-    // Converting two lines at a time, slightly faster
+    // Converting two lines at a time, sharing the chroma row
     for (size_t y = 0; y < height; y += 2) {
-        uint32_t *dstTop = (uint32_t *)dst;
-        uint32_t *dstBot = (uint32_t *)(dst + dstStride);
-        uint16_t *ySrcTop = (uint16_t *)srcY;
-        uint16_t *ySrcBot = (uint16_t *)(srcY + srcYStride);
-        uint16_t *uSrc = (uint16_t *)srcU;
-        uint16_t *vSrc = (uint16_t *)srcV;
-
-        for (size_t x = 0; x < width; x += 2) {
-            int32_t u, v, y00, y01, y10, y11;
-            u = *uSrc - 512;
-            uSrc += 1;
-            v = *vSrc - 512;
-            vSrc += 1;
-
-            y00 = *ySrcTop - _c16;
-            ySrcTop += 1;
-            y01 = *ySrcTop - _c16;
-            ySrcTop += 1;
-            y10 = *ySrcBot - _c16;
-            ySrcBot += 1;
-            y11 = *ySrcBot - _c16;
-            ySrcBot += 1;
-
-            int32_t u_b = u * _b_u;
-            int32_t u_g = u * _neg_g_u;
-            int32_t v_g = v * _neg_g_v;
-            int32_t v_r = v * _r_v;
-
-            int32_t yMult, b, g, r;
-            yMult = y00 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstTop++ = 3 << 30 | (b << 20) | (g << 10) | r;
-
-            yMult = y01 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstTop++ = 3 << 30 | (b << 20) | (g << 10) | r;
-
-            yMult = y10 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstBot++ = 3 << 30 | (b << 20) | (g << 10) | r;
-
-            yMult = y11 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstBot++ = 3 << 30 | (b << 20) | (g << 10) | r;
-        }
+        uint32_t *const dstRows[2] = {dst, dst + dstStride};
+        const uint16_t *const srcYRows[2] = {srcY, srcY + srcYStride};
+        convertRowsToRGBA1010102<0, 1, 2>(dstRows, srcYRows, srcU, srcV, width, coeffs);
 
         srcY += srcYStride * 2;
         srcU += srcUStride;
@@ -361,54 +451,8 @@ void convertP210ToRGBA1010102(uint32_t* dst, const uint16_t* srcY, const uint16_
     C2ColorAspectsStruct _aspects = FillMissingColorAspects(aspects, width, height);
     struct Coeffs coeffs = GetCoeffsForAspects(_aspects);
 
-    int32_t _y = coeffs._y;
-    int32_t _b_u = coeffs._b_u;
-    int32_t _neg_g_u = -coeffs._g_u;
-    int32_t _neg_g_v = -coeffs._g_v;
-    int32_t _r_v = coeffs._r_v;
-    int32_t _c16 = coeffs._c16;
-
     for (size_t y = 0; y < height; y++) {
-        uint32_t *dstTop = (uint32_t *)dst;
-        uint16_t *ySrcTop = (uint16_t *)srcY;
-        uint16_t *uSrc = (uint16_t *)srcUV;
-        uint16_t *vSrc = (uint16_t *)(srcUV + 1);
-        for (size_t x = 0; x < width; x += 2) {
-            int32_t u, v, y00, y01;
-            u = ((*uSrc) >> 6) - 512;
-            uSrc += 2;
-            v = ((*vSrc) >> 6) - 512;
-            vSrc += 2;
-
-            y00 = ((*ySrcTop) >> 6) - _c16;
-            ySrcTop += 1;
-            y01 = ((*ySrcTop) >> 6) - _c16;
-            ySrcTop += 1;
-
-            int32_t u_b = u * _b_u;
-            int32_t u_g = u * _neg_g_u;
-            int32_t v_g = v * _neg_g_v;
-            int32_t v_r = v * _r_v;
-
-            int32_t yMult, b, g, r;
-            yMult = y00 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstTop++ = 3 << 30 | (b << 20) | (g << 10) | r;
-
-            yMult = y01 * _y + 512;
-            b = (yMult + u_b) / 1024;
-            g = (yMult + v_g + u_g) / 1024;
-            r = (yMult + v_r) / 1024;
-            b = CLIP3(0, b, 1023);
-            g = CLIP3(0, g, 1023);
-            r = CLIP3(0, r, 1023);
-            *dstTop++ = 3 << 30 | (b << 20) | (g << 10) | r;
-        }
+        convertRowsToRGBA1010102<6, 2, 1>(&dst, &srcY, srcUV, srcUV + 1, width, coeffs);
         srcY += srcYStride;
         srcUV += srcUVStride;
         dst += dstStride;
@@ -567,6 +611,8 @@ void convertRGBA1010102ToYUV420Planar16(uint16_t* dstY, uint16_t* dstU, uint16_t
                                          ? bt709Matrix_10bit[colorRange - 1]
                                          : bt2020Matrix_10bit[colorRange - 1];
 
+    // Luma and chroma are computed in separate loops without branches, so that
+    // the compiler can vectorize them.
     for (size_t y = 0; y < height; ++y) {
         for (size_t x = 0; x < width; ++x) {
             b = (srcRGBA[x]  >> 20) & 0x3FF;
@@ -576,11 +622,18 @@ void convertRGBA1010102ToYUV420Planar16(uint16_t* dstY, uint16_t* dstU, uint16_t
             i32Y = ((r * weights[0][0] + g * weights[0][1] + b * weights[0][2] + 512) >> 10) +
                    zeroLvl;
             dstY[x] = CLIP3(zeroLvl, i32Y, maxLvlLuma);
-            if (y % 2 == 0 && x % 2 == 0) {
-                i32U = ((r * weights[1][0] + g * weights[1][1] + b * weights[1][2] + 512) >> 10) +
-                       512;
-                i32V = ((r * weights[2][0] + g * weights[2][1] + b * weights[2][2] + 512) >> 10) +
-                       512;
+        }
+        // chroma is sampled from the top left pixel of each 2x2 block.
+        if (y % 2 == 0) {
+            for (size_t x = 0; x < width; x += 2) {
+                b = (srcRGBA[x]  >> 20) & 0x3FF;
+                g = (srcRGBA[x]  >> 10) & 0x3FF;
+                r = srcRGBA[x] & 0x3FF;
+
+                i32U = ((r * weights[1][0] + g * weights[1][1] + b * weights[1][2] + 512) >> 10)
+                        + 512;
+                i32V = ((r * weights[2][0] + g * weights[2][1] + b * weights[2][2] + 512) >> 10)
+                        + 512;
                 dstU[x >> 1] = CLIP3(zeroLvl, i32U, maxLvlChroma);
                 dstV[x >> 1] = CLIP3(zeroLvl, i32V, maxLvlChroma);
             }
@@ -620,14 +673,19 @@ void convertRGBA1010102ToP210(uint16_t* dstY, uint16_t* dstUV, const uint32_t* s
             i32Y = ((r * weights[0][0] + g * weights[0][1] + b * weights[0][2] + 512) >> 10) +
                    zeroLvl;
             dstY[x] = (CLIP3(zeroLvl, i32Y, maxLvlLuma) << 6) & 0xFFC0;
-            if (x % 2 == 0) {
-                i32U = ((r * weights[1][0] + g * weights[1][1] + b * weights[1][2] + 512) >> 10) +
-                       512;
-                i32V = ((r * weights[2][0] + g * weights[2][1] + b * weights[2][2] + 512) >> 10) +
-                       512;
-                dstUV[x] = (CLIP3(zeroLvl, i32U, maxLvlChroma) << 6) & 0xFFC0;
-                dstUV[x + 1] = (CLIP3(zeroLvl, i32V, maxLvlChroma) << 6) & 0xFFC0;
-            }
+        }
+        // chroma is sampled from the left pixel of each pair.
+        for (size_t x = 0; x < width; x += 2) {
+            b = (srcRGBA[x]  >> 20) & 0x3FF;
+            g = (srcRGBA[x]  >> 10) & 0x3FF;
+            r = srcRGBA[x] & 0x3FF;
+
+            i32U = ((r * weights[1][0] + g * weights[1][1] + b * weights[1][2] + 512) >> 10) +
+                   512;
+            i32V = ((r * weights[2][0] + g * weights[2][1] + b * weights[2][2] + 512) >> 10) +
+                   512;
+            dstUV[x] = (CLIP3(zeroLvl, i32U, maxLvlChroma) << 6) & 0xFFC0;
+            dstUV[x + 1] = (CLIP3(zeroLvl, i32V, maxLvlChroma) << 6) & 0xFFC0;
         }
         srcRGBA += srcRGBStride;
         dstY += dstYStride;
@@ -674,14 +732,14 @@ void convertRGBToP210(uint16_t* dstY, uint16_t* dstUV, const uint32_t* srcRGBA,
 
             i32Y = ((r * weights[0][0] + g * weights[0][1] + b * weights[0][2]) >> 8) + zeroLvl;
             i8Y = CLIP3(zeroLvl, i32Y, maxLvlLuma);
-            dstY[x] = ((uint16_t)((double)i8Y * 1023 / 255 + 0.5) << 6) & 0xFFC0;
+            dstY[x] = scale8To10Msb(i8Y);
             if (x % 2 == 0) {
                 i32U = ((r * weights[1][0] + g * weights[1][1] + b * weights[1][2]) >> 8) + 128;
                 i32V = ((r * weights[2][0] + g * weights[2][1] + b * weights[2][2]) >> 8) + 128;
                 i8U = CLIP3(zeroLvl, i32U, maxLvlChroma);
                 i8V = CLIP3(zeroLvl, i32V, maxLvlChroma);
-                dstUV[x] = ((uint16_t)((double)i8U * 1023 / 255 + 0.5) << 6) & 0xFFC0;
-                dstUV[x + 1] = ((uint16_t)((double)i8V * 1023 / 255 + 0.5) << 6) & 0xFFC0;
+                dstUV[x] = scale8To10Msb(i8U);
+                dstUV[x + 1] = scale8To10Msb(i8V);
             }
         }
         srcRGBA += srcRGBStride;
@@ -820,7 +878,7 @@ void convertSemiPlanar8ToP210(uint16_t *dstY, uint16_t *dstUV,
 
   for (int32_t y = 0; y < height; ++y) {
     for (int32_t x = 0; x < width; ++x) {
-      dstY[x] = ((uint16_t)((double)srcY[x] * 1023 / 255 + 0.5) << 6) & 0xFFC0;
+      dstY[x] = scale8To10Msb(srcY[x]);
     }
     dstY += dstYStride;
     srcY += srcYStride;
@@ -829,8 +887,7 @@ void convertSemiPlanar8ToP210(uint16_t *dstY, uint16_t *dstUV,
   if (isNV12) {
     for (int32_t y = 0; y < (height + 1) / 2; ++y) {
         for (int32_t x = 0; x < width; x++) {
-            dstUV[x] = dstUV[dstUVStride + x] =
-                ((uint16_t)((double)srcUV[x] * 1023 / 255 + 0.5) << 6) & 0xFFC0;
+            dstUV[x] = dstUV[dstUVStride + x] = scale8To10Msb(srcUV[x]);
         }
         srcUV += srcUVStride;
         dstUV += dstUVStride << 1;
@@ -838,10 +895,8 @@ void convertSemiPlanar8ToP210(uint16_t *dstY, uint16_t *dstUV,
   } else { //NV21
     for (int32_t y = 0; y < (height + 1) / 2; ++y) {
         for (int32_t x = 0; x < width; x+=2) {
-            dstUV[x+1] = dstUV[dstUVStride + x + 1] =
-                ((uint16_t)((double)srcUV[x] * 1023 / 255 + 0.5) << 6) & 0xFFC0;
-            dstUV[x] = dstUV[dstUVStride + x] =
-                ((uint16_t)((double)srcUV[x + 1] * 1023 / 255 + 0.5) << 6) & 0xFFC0;
+            dstUV[x+1] = dstUV[dstUVStride + x + 1] = scale8To10Msb(srcUV[x]);
+            dstUV[x] = dstUV[dstUVStride + x] = scale8To10Msb(srcUV[x + 1]);
         }
         srcUV += srcUVStride;
         dstUV += dstUVStride << 1;
@@ -862,7 +917,7 @@ void convertPlanar8ToP210(uint16_t *dstY, uint16_t *dstUV,
 
   for (int32_t y = 0; y < height; ++y) {
     for (int32_t x = 0; x < width; ++x) {
-      dstY[x] = ((uint16_t)((double)srcY[x] * 1023 / 255 + 0.5) << 6) & 0xFFC0;
+      dstY[x] = scale8To10Msb(srcY[x]);
     }
     dstY += dstYStride;
     srcY += srcYStride;
@@ -870,10 +925,8 @@ void convertPlanar8ToP210(uint16_t *dstY, uint16_t *dstUV,
 
   for (int32_t y = 0; y < height / 2; ++y) {
     for (int32_t x = 0; x < width / 2; ++x) {
-      dstUV[x<<1] = dstUV[(x<<1) + dstUVStride] =
-                ((uint16_t)((double)srcU[x] * 1023 / 255 + 0.5) << 6) & 0xFFC0;
-      dstUV[(x<<1) + 1] = dstUV[(x<<1) + dstUVStride + 1] =
-                ((uint16_t)((double)srcV[x] * 1023 / 255 + 0.5) << 6) & 0xFFC0;
+      dstUV[x<<1] = dstUV[(x<<1) + dstUVStride] = scale8To10Msb(srcU[x]);
+      dstUV[(x<<1) + 1] = dstUV[(x<<1) + dstUVStride + 1] = scale8To10Msb(srcV[x]);
     }
     dstUV += dstUVStride << 1;
     srcU += srcUStride;
@@ -882,14 +935,20 @@ void convertPlanar8ToP210(uint16_t *dstY, uint16_t *dstUV,
 }
 
 
-std::unique_ptr<C2Work> SimpleC2Component::WorkQueue::pop_front() {
+std::unique_ptr<C2Work> SimpleC2Component::WorkQueue::pop_front(
+        std::shared_ptr<PreparedWork> *prepared) {
     std::unique_ptr<C2Work> work = std::move(mQueue.front().work);
+    if (prepared) {
+        *prepared = std::move(mQueue.front().prepared);
+    }
     mQueue.pop_front();
     return work;
 }
 
-void SimpleC2Component::WorkQueue::push_back(std::unique_ptr<C2Work> work) {
-    mQueue.push_back({ std::move(work), NO_DRAIN });
+void SimpleC2Component::WorkQueue::push_back(std::unique_ptr<C2Work> work, bool needsPrepare) {
+    mQueue.push_back({ std::move(work), NO_DRAIN,
+                       needsPrepare && !mPrepareDisabled ? Entry::NEEDS_PREPARE : Entry::READY,
+                       nullptr });
 }
 
 bool SimpleC2Component::WorkQueue::empty() const {
@@ -905,7 +964,51 @@ uint32_t SimpleC2Component::WorkQueue::drainMode() const {
 }
 
 void SimpleC2Component::WorkQueue::markDrain(uint32_t drainMode) {
-    mQueue.push_back({ nullptr, drainMode });
+    mQueue.push_back({ nullptr, drainMode, Entry::READY, nullptr });
+}
+
+bool SimpleC2Component::WorkQueue::frontReady() const {
+    return mQueue.front().state == Entry::READY;
+}
+
+const std::unique_ptr<C2Work> *SimpleC2Component::WorkQueue::startPrepare(size_t maxInFlight) {
+    size_t i = 0;
+    for (auto it = mQueue.begin(); it != mQueue.end() && i < maxInFlight; ++it, ++i) {
+        if (it->state == Entry::NEEDS_PREPARE) {
+            it->state = Entry::PREPARING;
+            ++mNumPreparing;
+            return &it->work;
+        }
+    }
+    return nullptr;
+}
+
+bool SimpleC2Component::WorkQueue::finishPrepare(
+        const std::unique_ptr<C2Work> *work, std::shared_ptr<PreparedWork> prepared) {
+    // entries being prepared are not removed from the queue, see waitForPrepared().
+    for (auto it = mQueue.begin(); it != mQueue.end(); ++it) {
+        if (&it->work == work) {
+            it->state = Entry::READY;
+            it->prepared = std::move(prepared);
+            --mNumPreparing;
+            return it == mQueue.begin();
+        }
+    }
+    ALOGE("prepared work not found in the queue");
+    return false;
+}
+
+void SimpleC2Component::WorkQueue::cancelPrepare() {
+    for (Entry &entry : mQueue) {
+        if (entry.state == Entry::NEEDS_PREPARE) {
+            entry.state = Entry::READY;
+        }
+    }
+}
+
+void SimpleC2Component::WorkQueue::disablePrepare() {
+    mPrepareDisabled = true;
+    cancelPrepare();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -988,6 +1091,30 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
     }
 }
 
+void SimpleC2Component::PrepareHandler::setComponent(
+        const std::shared_ptr<SimpleC2Component> &thiz) {
+    mThiz = thiz;
+}
+
+void SimpleC2Component::PrepareHandler::onMessageReceived(const sp<AMessage> &msg) {
+    std::shared_ptr<SimpleC2Component> thiz = mThiz.lock();
+    if (!thiz) {
+        ALOGD("component not yet set; msg = %s", msg->debugString().c_str());
+        return;
+    }
+
+    switch (msg->what()) {
+        case kWhatPrepare: {
+            thiz->prepareQueue();
+            break;
+        }
+        default: {
+            ALOGD("Unrecognized msg: %d", msg->what());
+            break;
+        }
+    }
+}
+
 class SimpleC2Component::BlockingBlockPool : public C2BlockPool {
 public:
     BlockingBlockPool(const std::shared_ptr<C2BlockPool>& base): mBase{base} {}
@@ -1062,11 +1189,59 @@ SimpleC2Component::SimpleC2Component(
 SimpleC2Component::~SimpleC2Component() {
     mLooper->unregisterHandler(mHandler->id());
     (void)mLooper->stop();
+    for (size_t i = 0; i < mPrepareLoopers.size(); ++i) {
+        mPrepareLoopers[i]->unregisterHandler(mPrepareHandlers[i]->id());
+        (void)mPrepareLoopers[i]->stop();
+    }
+}
+
+void SimpleC2Component::enablePipeline(size_t numThreads, size_t maxInFlight) {
+    int32_t threads = property_get_int32("debug.stagefright.c2.sw_pipeline_threads", -1);
+    if (threads >= 0) {
+        numThreads = threads;
+    }
+    if (numThreads == 0 || maxInFlight == 0 || !mPrepareLoopers.empty()) {
+        return;
+    }
+    ALOGV("pipelined mode with %zu threads, %zu works in flight", numThreads, maxInFlight);
+    for (size_t i = 0; i < numThreads; ++i) {
+        sp<ALooper> looper = new ALooper;
+        sp<PrepareHandler> handler = new PrepareHandler;
+        looper->setName((mIntf->getName() + "-prepare").c_str());
+        (void)looper->registerHandler(handler);
+        looper->start(false, false, ANDROID_PRIORITY_VIDEO);
+        mPrepareLoopers.push_back(looper);
+        mPrepareHandlers.push_back(handler);
+    }
+    mMaxInFlight = maxInFlight;
+}
+
+std::shared_ptr<SimpleC2Component::PreparedWork> SimpleC2Component::onPrepare(
+        const std::unique_ptr<C2Work> &work) {
+    (void)work;
+    return nullptr;
+}
+
+void SimpleC2Component::postPrepare() {
+    for (const sp<PrepareHandler> &handler : mPrepareHandlers) {
+        (new AMessage(PrepareHandler::kWhatPrepare, handler))->post();
+    }
+}
+
+void SimpleC2Component::waitForPrepared(Mutexed<WorkQueue>::Locked &queue) {
+    // the works left in the queue are about to be removed, do not prepare them.
+    queue->cancelPrepare();
+    while (queue->numPreparing() > 0) {
+        queue.waitForCondition(mWorkPrepared);
+    }
 }
 
 c2_status_t SimpleC2Component::setListener_vb(
         const std::shared_ptr<C2Component::Listener> &listener, c2_blocking_t mayBlock) {
     mHandler->setComponent(shared_from_this());
+    for (const sp<PrepareHandler> &handler : mPrepareHandlers) {
+        handler->setComponent(shared_from_this());
+    }
 
     Mutexed<ExecState>::Locked state(mExecState);
     if (state->mState == RUNNING) {
@@ -1089,15 +1264,19 @@ c2_status_t SimpleC2Component::queue_nb(std::list<std::unique_ptr<C2Work>> * con
             return C2_BAD_STATE;
         }
     }
+    const bool pipelined = !mPrepareHandlers.empty();
     bool queueWasEmpty = false;
     {
         Mutexed<WorkQueue>::Locked queue(mWorkQueue);
         queueWasEmpty = queue->empty();
         while (!items->empty()) {
-            queue->push_back(std::move(items->front()));
+            queue->push_back(std::move(items->front()), pipelined);
             items->pop_front();
         }
     }
+    if (pipelined) {
+        postPrepare();
+    }
     if (queueWasEmpty) {
         (new AMessage(WorkHandler::kWhatProcess, mHandler))->post();
     }
@@ -1120,6 +1299,7 @@ c2_status_t SimpleC2Component::flush_sm(
     }
     {
         Mutexed<WorkQueue>::Locked queue(mWorkQueue);
+        waitForPrepared(queue);
         queue->incGeneration();
         // TODO: queue->splicedBy(flushedWork, flushedWork->end());
         while (!queue->empty()) {
@@ -1194,6 +1374,7 @@ c2_status_t SimpleC2Component::stop() {
     }
     {
         Mutexed<WorkQueue>::Locked queue(mWorkQueue);
+        waitForPrepared(queue);
         queue->clear();
         queue->pending().clear();
     }
@@ -1215,6 +1396,7 @@ c2_status_t SimpleC2Component::reset() {
     }
     {
         Mutexed<WorkQueue>::Locked queue(mWorkQueue);
+        waitForPrepared(queue);
         queue->clear();
         queue->pending().clear();
     }
@@ -1225,6 +1407,13 @@ c2_status_t SimpleC2Component::reset() {
 
 c2_status_t SimpleC2Component::release() {
     ALOGV("release");
+    {
+        // onRelease() may free what onPrepare() uses, and the prepare loopers
+        // keep running until the component is destroyed.
+        Mutexed<WorkQueue>::Locked queue(mWorkQueue);
+        waitForPrepared(queue);
+        queue->disablePrepare();
+    }
     sp<AMessage> reply;
     (new AMessage(WorkHandler::kWhatRelease, mHandler))->postAndAwaitResponse(&reply);
     return C2_OK;
@@ -1290,8 +1479,23 @@ void SimpleC2Component::cloneAndSend(
     }
 }
 
+void SimpleC2Component::prepareQueue() {
+    Mutexed<WorkQueue>::Locked queue(mWorkQueue);
+    while (const std::unique_ptr<C2Work> *work = queue->startPrepare(mMaxInFlight)) {
+        queue.unlock();
+        std::shared_ptr<PreparedWork> prepared = onPrepare(*work);
+        queue.lock();
+        if (queue->finishPrepare(work, std::move(prepared))) {
+            // processQueue() stopped at this work
+            (new AMessage(WorkHandler::kWhatProcess, mHandler))->post();
+        }
+        mWorkPrepared.broadcast();
+    }
+}
+
 bool SimpleC2Component::processQueue() {
     std::unique_ptr<C2Work> work;
+    std::shared_ptr<PreparedWork> prepared;
     uint64_t generation;
     int32_t drainMode;
     bool isFlushPending = false;
@@ -1301,13 +1505,21 @@ bool SimpleC2Component::processQueue() {
         if (queue->empty()) {
             return false;
         }
+        if (!queue->frontReady()) {
+            // prepareQueue() posts kWhatProcess once the front work is prepared.
+            return false;
+        }
 
         generation = queue->generation();
         drainMode = queue->drainMode();
         isFlushPending = queue->popPendingFlush();
-        work = queue->pop_front();
+        work = queue->pop_front(&prepared);
         hasQueuedWork = !queue->empty();
     }
+    if (!mPrepareHandlers.empty()) {
+        // the next queued work may now be prepared
+        postPrepare();
+    }
     if (isFlushPending) {
         ALOGV("processing pending flush");
         c2_status_t err = onFlush_sm();
@@ -1397,7 +1609,9 @@ bool SimpleC2Component::processQueue() {
         ALOGD("Encountered null input buffer. Clearing the input buffer");
         work->input.buffers.clear();
     }
+    mPreparedWork = std::move(prepared);
     process(work, mOutputBlockPool);
+    mPreparedWork.reset();
     ALOGV("processed frame #%" PRIu64, work->input.ordinal.frameIndex.peeku());
     Mutexed<WorkQueue>::Locked queue(mWorkQueue);
     if (queue->generation() != generation) {
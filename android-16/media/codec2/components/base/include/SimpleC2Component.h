@@ -19,6 +19,7 @@
 
 #include <list>
 #include <unordered_map>
+#include <vector>
 
 #include <C2Component.h>
 #include <C2Config.h>
@@ -43,6 +44,17 @@ void convertYUV420Planar8ToYV12(uint8_t *dstY, uint8_t *dstU, uint8_t *dstV, con
                                 size_t dstUStride, size_t dstVStride, uint32_t width,
                                 uint32_t height, bool isMonochrome = false);
 
+void convertYUV420Planar16ToY410(uint32_t *dst, const uint16_t *srcY, const uint16_t *srcU,
+                                 const uint16_t *srcV, size_t srcYStride, size_t srcUStride,
+                                 size_t srcVStride, size_t dstStride, size_t width, size_t height);
+
+void convertYUV420Planar16ToRGBA1010102(
+        uint32_t *dst, const uint16_t *srcY, const uint16_t *srcU,
+        const uint16_t *srcV, size_t srcYStride, size_t srcUStride,
+        size_t srcVStride, size_t dstStride, size_t width,
+        size_t height,
+        std::shared_ptr<const C2ColorAspectsStruct> aspects);
+
 void convertYUV420Planar16ToY410OrRGBA1010102(
         uint32_t *dst, const uint16_t *srcY,
         const uint16_t *srcU, const uint16_t *srcV,
@@ -153,6 +165,7 @@ public:
 
     // for handler
     bool processQueue();
+    void prepareQueue();
 
 protected:
     /**
@@ -194,6 +207,30 @@ protected:
             const std::unique_ptr<C2Work> &work,
             const std::shared_ptr<C2BlockPool> &pool) = 0;
 
+    /**
+     * Data prepared for a work ahead of process(), see onPrepare().
+     */
+    struct PreparedWork {
+        virtual ~PreparedWork() = default;
+    };
+
+    /**
+     * Prepare the given work ahead of process(), e.g. convert its input to the
+     * layout expected by the codec.
+     *
+     * This method is only called in the pipelined mode, see enablePipeline(). It
+     * runs on a pipeline thread, concurrently with process() of earlier work and
+     * with onPrepare() of other work, so it must neither modify the work nor
+     * touch the state used by process(). Works are still passed to process() one
+     * at a time and in order, and the returned data is available there from
+     * preparedWork().
+     *
+     * \param[in]   work    the work to prepare
+     *
+     * \return the prepared data, or nullptr if process() handles the work as is.
+     */
+    virtual std::shared_ptr<PreparedWork> onPrepare(const std::unique_ptr<C2Work> &work);
+
     /**
      * Drain the component and finish pending work using finish().
      *
@@ -240,6 +277,22 @@ protected:
             std::function<void(const std::unique_ptr<C2Work> &)> fillWork);
 
 
+    /**
+     * Enable the pipelined mode, where onPrepare() runs on |numThreads| threads
+     * for up to |maxInFlight| queued works ahead of process().
+     *
+     * This method must be called from the constructor of the component. The
+     * debug.stagefright.c2.sw_pipeline_threads property overrides |numThreads|,
+     * 0 disables the pipelined mode.
+     */
+    void enablePipeline(size_t numThreads, size_t maxInFlight);
+
+    /**
+     * Returns the data returned by onPrepare() for the work being processed, or
+     * nullptr. Only valid during process().
+     */
+    const std::shared_ptr<PreparedWork> &preparedWork() const { return mPreparedWork; }
+
     std::shared_ptr<C2Buffer> createLinearBuffer(
             const std::shared_ptr<C2LinearBlock> &block, size_t offset, size_t size);
 
@@ -279,6 +332,24 @@ private:
         bool mRunning;
     };
 
+    class PrepareHandler : public AHandler {
+    public:
+        enum {
+            kWhatPrepare,
+        };
+
+        PrepareHandler() = default;
+        ~PrepareHandler() override = default;
+
+        void setComponent(const std::shared_ptr<SimpleC2Component> &thiz);
+
+    protected:
+        void onMessageReceived(const sp<AMessage> &msg) override;
+
+    private:
+        std::weak_ptr<SimpleC2Component> mThiz;
+    };
+
     enum {
         UNINITIALIZED,
         STOPPED,
@@ -305,9 +376,22 @@ private:
         inline uint64_t generation() const { return mGeneration; }
         inline void incGeneration() { ++mGeneration; mFlush = true; }
 
-        std::unique_ptr<C2Work> pop_front();
-        void push_back(std::unique_ptr<C2Work> work);
+        std::unique_ptr<C2Work> pop_front(std::shared_ptr<PreparedWork> *prepared = nullptr);
+        void push_back(std::unique_ptr<C2Work> work, bool needsPrepare = false);
         bool empty() const;
+        // whether the front entry is a drain or a work that is not waiting for onPrepare()
+        bool frontReady() const;
+        // Marks the first work waiting for onPrepare() among the first |maxInFlight|
+        // entries as being prepared and returns it, or returns nullptr.
+        const std::unique_ptr<C2Work> *startPrepare(size_t maxInFlight);
+        // Stores the data prepared for |work|. Returns true if it is the front entry.
+        bool finishPrepare(const std::unique_ptr<C2Work> *work,
+                           std::shared_ptr<PreparedWork> prepared);
+        inline size_t numPreparing() const { return mNumPreparing; }
+        // Stops onPrepare() for the queued works, which process() then handles as is.
+        void cancelPrepare();
+        // Also stops onPrepare() for the works queued later.
+        void disablePrepare();
         uint32_t drainMode() const;
         void markDrain(uint32_t drainMode);
         inline bool popPendingFlush() {
@@ -320,16 +404,37 @@ private:
 
     private:
         struct Entry {
+            enum State {
+                READY,
+                NEEDS_PREPARE,
+                PREPARING,
+            };
+
             std::unique_ptr<C2Work> work;
             uint32_t drainMode;
+            State state;
+            std::shared_ptr<PreparedWork> prepared;
         };
 
         bool mFlush;
         uint64_t mGeneration;
+        size_t mNumPreparing = 0;
+        bool mPrepareDisabled = false;
         std::list<Entry> mQueue;
         PendingWork mPendingWork;
     };
     Mutexed<WorkQueue> mWorkQueue;
+    // signaled when a work is prepared
+    Condition mWorkPrepared;
+
+    // pipelined mode, see enablePipeline()
+    std::vector<sp<ALooper>> mPrepareLoopers;
+    std::vector<sp<PrepareHandler>> mPrepareHandlers;
+    size_t mMaxInFlight = 0;
+    std::shared_ptr<PreparedWork> mPreparedWork;
+
+    void postPrepare();
+    void waitForPrepared(Mutexed<WorkQueue>::Locked &queue);
 
     class BlockingBlockPool;
     std::shared_ptr<BlockingBlockPool> mOutputBlockPool;
@@ -55,6 +55,7 @@ struct C2SoftHevcEnc : public SimpleC2Component {
     void onReset() override;
     void onRelease() override;
     c2_status_t onFlush_sm() override;
+    std::shared_ptr<PreparedWork> onPrepare(const std::unique_ptr<C2Work>& work) override;
     void process(const std::unique_ptr<C2Work>& work,
                  const std::shared_ptr<C2BlockPool>& pool) override;
     c2_status_t drain(uint32_t drainMode,
@@ -80,6 +81,15 @@ struct C2SoftHevcEnc : public SimpleC2Component {
     void* mCodecCtx;
     MemoryBlockPool mConversionBuffers;
     std::map<void*, MemoryBlock> mConversionBuffersInUse;
+
+    // input converted to I420 by onPrepare()
+    struct ConvertedInput : public PreparedWork {
+        MemoryBlock buffer;
+        uint32_t width;
+        uint32_t height;
+        C2Color::matrix_t matrix;
+        C2Color::range_t range;
+    };
     // configurations used by component in process
     // (TODO: keep this in intf but make them internal only)
     std::shared_ptr<C2StreamPictureSizeInfo::input> mSize;
@@ -104,6 +114,9 @@ struct C2SoftHevcEnc : public SimpleC2Component {
     c2_status_t initEncParams();
     c2_status_t initEncoder();
     c2_status_t releaseEncoder();
+    c2_status_t convertToI420(const C2GraphicView& input, uint32_t width, uint32_t height,
+                              C2Color::matrix_t matrix, C2Color::range_t range,
+                              MemoryBlock* buffer);
     c2_status_t setEncodeArgs(ihevce_inp_buf_t* ps_encode_ip,
                               const C2GraphicView* const input,
                               uint64_t workIndex);
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <C2Config.h>
+#include <SimpleC2Component.h>
+#include <benchmark/benchmark.h>
+
+using namespace android;
+
+// Per-frame cost of the color conversions done by the software codecs on their
+// output, or on their input for encoders. Args: width, height.
+
+template <typename T>
+static std::vector<T> randomPlane(size_t size, uint32_t mask) {
+    std::minstd_rand rng(42);
+    std::vector<T> plane(size);
+    for (T &value : plane) {
+        value = rng() & mask;
+    }
+    return plane;
+}
+
+static std::shared_ptr<const C2ColorAspectsStruct> bt2020Aspects() {
+    auto aspects = std::make_shared<C2ColorAspectsStruct>();
+    aspects->range = C2Color::RANGE_LIMITED;
+    aspects->primaries = C2Color::PRIMARIES_BT2020;
+    aspects->transfer = C2Color::TRANSFER_ST2084;
+    aspects->matrix = C2Color::MATRIX_BT2020;
+    return aspects;
+}
+
+// 10 bit 4:2:0 decoder output (av1, vp9, hevc) to RGBA1010102.
+static void BM_YUV420Planar16ToRGBA1010102(benchmark::State &state) {
+    const size_t width = state.range(0), height = state.range(1);
+    auto y = randomPlane<uint16_t>(width * height, 0x3FF);
+    auto u = randomPlane<uint16_t>(width * height / 4, 0x3FF);
+    auto v = randomPlane<uint16_t>(width * height / 4, 0x3FF);
+    std::vector<uint32_t> dst(width * height);
+    auto aspects = bt2020Aspects();
+    for (auto _ : state) {
+        convertYUV420Planar16ToY410OrRGBA1010102(dst.data(), y.data(), u.data(), v.data(), width,
+                                                 width / 2, width / 2, width, width, height,
+                                                 aspects);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 10 bit 4:2:2 decoder output (apv) to RGBA1010102.
+static void BM_P210ToRGBA1010102(benchmark::State &state) {
+    const size_t width = state.range(0), height = state.range(1);
+    auto y = randomPlane<uint16_t>(width * height, 0xFFC0);
+    auto uv = randomPlane<uint16_t>(width * height, 0xFFC0);
+    std::vector<uint32_t> dst(width * height);
+    auto aspects = bt2020Aspects();
+    for (auto _ : state) {
+        convertP210ToRGBA1010102(dst.data(), y.data(), uv.data(), width, width, width, width,
+                                 height, aspects);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// RGBA1010102 encoder input to 10 bit 4:2:0.
+static void BM_RGBA1010102ToYUV420Planar16(benchmark::State &state) {
+    const size_t width = state.range(0), height = state.range(1);
+    auto src = randomPlane<uint32_t>(width * height, 0xFFFFFFFF);
+    std::vector<uint16_t> y(width * height), u(width * height / 4), v(width * height / 4);
+    for (auto _ : state) {
+        convertRGBA1010102ToYUV420Planar16(y.data(), u.data(), v.data(), src.data(), width,
+                                           width, height, C2Color::MATRIX_BT2020,
+                                           C2Color::RANGE_LIMITED);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// RGBA1010102 encoder input to P210.
+static void BM_RGBA1010102ToP210(benchmark::State &state) {
+    const size_t width = state.range(0), height = state.range(1);
+    auto src = randomPlane<uint32_t>(width * height, 0xFFFFFFFF);
+    std::vector<uint16_t> y(width * height), uv(width * height);
+    for (auto _ : state) {
+        convertRGBA1010102ToP210(y.data(), uv.data(), src.data(), width, width, width, width,
+                                 height, C2Color::MATRIX_BT2020, C2Color::RANGE_LIMITED);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 8 bit NV12 encoder input to P210.
+static void BM_SemiPlanar8ToP210(benchmark::State &state) {
+    const size_t width = state.range(0), height = state.range(1);
+    auto y = randomPlane<uint8_t>(width * height, 0xFF);
+    auto uv = randomPlane<uint8_t>(width * height / 2, 0xFF);
+    std::vector<uint16_t> dstY(width * height), dstUV(width * height);
+    for (auto _ : state) {
+        convertSemiPlanar8ToP210(dstY.data(), dstUV.data(), y.data(), uv.data(), width, width,
+                                 width, width, width, height, CONV_FORMAT_I420, true);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 8 bit I420 encoder input to P210.
+static void BM_Planar8ToP210(benchmark::State &state) {
+    const size_t width = state.range(0), height = state.range(1);
+    auto y = randomPlane<uint8_t>(width * height, 0xFF);
+    auto u = randomPlane<uint8_t>(width * height / 4, 0xFF);
+    auto v = randomPlane<uint8_t>(width * height / 4, 0xFF);
+    std::vector<uint16_t> dstY(width * height), dstUV(width * height);
+    for (auto _ : state) {
+        convertPlanar8ToP210(dstY.data(), dstUV.data(), y.data(), u.data(), v.data(), width,
+                             width / 2, width / 2, width, width, width, height,
+                             CONV_FORMAT_I420);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void FrameSizes(benchmark::internal::Benchmark *b) {
+    b->Args({1920, 1080});
+    b->Args({3840, 2160});
+}
+
+BENCHMARK(BM_YUV420Planar16ToRGBA1010102)->Apply(FrameSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_P210ToRGBA1010102)->Apply(FrameSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RGBA1010102ToYUV420Planar16)->Apply(FrameSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RGBA1010102ToP210)->Apply(FrameSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SemiPlanar8ToP210)->Apply(FrameSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Planar8ToP210)->Apply(FrameSizes)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
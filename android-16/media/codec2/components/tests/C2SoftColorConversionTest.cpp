@@ -0,0 +1,473 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <C2Config.h>
+#include <SimpleC2Component.h>
+#include <gtest/gtest.h>
+
+namespace android {
+
+namespace {
+
+/*
+ * Compares the color conversions of SimpleC2Component with the scalar code
+ * they replaced, pixel by pixel, for every matrix and range. The widths cover
+ * every tail length left by the vectorized loops, and odd widths, for which
+ * the conversions write one pixel pair past the width as they always did. The
+ * rows are padded so that these writes are compared too, and start at even
+ * offsets as in the buffers of the codecs.
+ */
+
+constexpr size_t kMinWidth = 3;
+constexpr size_t kMaxWidth = 40;
+constexpr size_t kHeight = 4;
+constexpr size_t kPadding = 8;
+constexpr uint8_t kUnwritten = 0xA5;
+
+const C2Color::matrix_t kMatrices[] = {
+    C2Color::MATRIX_BT601, C2Color::MATRIX_BT709, C2Color::MATRIX_BT2020,
+};
+const C2Color::range_t kRanges[] = {
+    C2Color::RANGE_FULL, C2Color::RANGE_LIMITED, C2Color::RANGE_UNSPECIFIED,
+};
+
+size_t paddedStride(size_t width) {
+    return (width + kPadding + 1) / 2 * 2;
+}
+
+template <typename T>
+std::vector<T> randomPlane(size_t size, uint32_t mask, uint32_t seed) {
+    std::minstd_rand rng(seed);
+    std::vector<T> plane(size);
+    for (T &value : plane) {
+        value = rng() & mask;
+    }
+    // the extremes, for the clipping
+    for (size_t i = 0; i < size && i < 4; ++i) {
+        plane[i] = i % 2 ? mask : 0;
+    }
+    return plane;
+}
+
+template <typename T>
+std::vector<T> unwritten(size_t size) {
+    std::vector<T> plane(size);
+    memset(plane.data(), kUnwritten, size * sizeof(T));
+    return plane;
+}
+
+#define CLIP3(min, v, max) (((v) < (min)) ? (min) : (((max) > (v)) ? (v) : (max)))
+
+struct Coeffs {
+    int32_t _y, _r_v, _g_u, _g_v, _b_u, _c16;
+};
+
+Coeffs coeffsFor(C2Color::matrix_t matrix, C2Color::range_t range) {
+    const bool isFullRange = range == C2Color::RANGE_FULL;
+    switch (matrix) {
+        case C2Color::MATRIX_BT601:
+            return isFullRange ? Coeffs{1024, 1436, 352, 731, 1815, 0}
+                               : Coeffs{1196, 1639, 402, 835, 2072, 64};
+        case C2Color::MATRIX_BT709:
+            return isFullRange ? Coeffs{1024, 1613, 192, 479, 1900, 0}
+                               : Coeffs{1196, 1841, 219, 547, 2169, 64};
+        default:
+            return isFullRange ? Coeffs{1024, 1510, 169, 585, 1927, 0}
+                               : Coeffs{1196, 1724, 192, 668, 2200, 64};
+    }
+}
+
+uint32_t scalarToRGBA1010102(int32_t y, int32_t u, int32_t v, const Coeffs &c) {
+    int32_t yMult = (y - c._c16) * c._y + 512;
+    int32_t b = (yMult + u * c._b_u) / 1024;
+    int32_t g = (yMult + v * -c._g_v + u * -c._g_u) / 1024;
+    int32_t r = (yMult + v * c._r_v) / 1024;
+    b = CLIP3(0, b, 1023);
+    g = CLIP3(0, g, 1023);
+    r = CLIP3(0, r, 1023);
+    return 3 << 30 | (b << 20) | (g << 10) | r;
+}
+
+uint16_t scalarScale8To10Msb(uint8_t value) {
+    return ((uint16_t)((double)value * 1023 / 255 + 0.5) << 6) & 0xFFC0;
+}
+
+const int16_t kBt709Matrix10Bit[2][3][3] = {
+    { { 218, 732, 74 }, { -117, -395, 512 }, { 512, -465, -47 } },
+    { { 186, 627, 63 }, { -103, -345, 448 }, { 448, -407, -41 } },
+};
+
+const int16_t kBt2020Matrix10Bit[2][3][3] = {
+    { { 269, 694, 61 }, { -143, -369, 512 }, { 512, -471, -41 } },
+    { { 230, 594, 52 }, { -125, -323, 448 }, { 448, -412, -36 } },
+};
+
+const int16_t kBt601Matrix8Bit[2][3][3] = {
+    { { 77, 150, 29 }, { -43, -85, 128 }, { 128, -107, -21 } },
+    { { 66, 129, 25 }, { -38, -74, 112 }, { 112, -94, -18 } },
+};
+
+const int16_t kBt709Matrix8Bit[2][3][3] = {
+    { { 54, 183, 19 }, { -29, -99, 128 }, { 128, -116, -12 } },
+    { { 47, 157, 16 }, { -26, -86, 112 }, { 112, -102, -10 } },
+};
+
+// Y, U and V of a pixel with the given 10 bit matrix, unclipped.
+void scalarFromRGBA1010102(uint32_t rgba, const int16_t (*w)[3], int32_t yuv[3]) {
+    const int32_t b = (rgba >> 20) & 0x3FF;
+    const int32_t g = (rgba >> 10) & 0x3FF;
+    const int32_t r = rgba & 0x3FF;
+    for (int i = 0; i < 3; ++i) {
+        yuv[i] = (r * w[i][0] + g * w[i][1] + b * w[i][2] + 512) >> 10;
+    }
+}
+
+const int16_t (*weights10Bit(C2Color::matrix_t matrix, C2Color::range_t range))[3] {
+    const int i = range == C2Color::RANGE_FULL ? 0 : 1;
+    return matrix == C2Color::MATRIX_BT709 ? kBt709Matrix10Bit[i] : kBt2020Matrix10Bit[i];
+}
+
+std::shared_ptr<const C2ColorAspectsStruct> aspectsFor(
+        C2Color::matrix_t matrix, C2Color::range_t range) {
+    auto aspects = std::make_shared<C2ColorAspectsStruct>();
+    aspects->range = range;
+    aspects->matrix = matrix;
+    return aspects;
+}
+
+TEST(C2SoftColorConversionTest, YUV420Planar16ToRGBA1010102) {
+    for (size_t width = kMinWidth; width <= kMaxWidth; ++width) {
+        const size_t yStride = paddedStride(width), uvStride = paddedStride(width / 2);
+        const auto srcY = randomPlane<uint16_t>(yStride * kHeight, 0x3FF, width);
+        const auto srcU = randomPlane<uint16_t>(uvStride * kHeight / 2, 0x3FF, width + 1);
+        const auto srcV = randomPlane<uint16_t>(uvStride * kHeight / 2, 0x3FF, width + 2);
+        for (C2Color::matrix_t matrix : kMatrices) {
+            for (C2Color::range_t range : kRanges) {
+                const Coeffs coeffs = coeffsFor(matrix, range);
+                auto expected = unwritten<uint32_t>(yStride * kHeight);
+                for (size_t y = 0; y < kHeight; ++y) {
+                    for (size_t x = 0; x < width; x += 2) {
+                        const size_t c = y / 2 * uvStride + x / 2;
+                        for (size_t i = x; i < x + 2; ++i) {
+                            expected[y * yStride + i] = scalarToRGBA1010102(
+                                    srcY[y * yStride + i], srcU[c] - 512, srcV[c] - 512, coeffs);
+                        }
+                    }
+                }
+
+                auto dst = unwritten<uint32_t>(yStride * kHeight);
+                convertYUV420Planar16ToRGBA1010102(dst.data(), srcY.data(), srcU.data(),
+                                                   srcV.data(), yStride, uvStride, uvStride,
+                                                   yStride, width, kHeight,
+                                                   aspectsFor(matrix, range));
+                EXPECT_EQ(expected, dst) << "width " << width << ", matrix " << matrix
+                                         << ", range " << range;
+            }
+        }
+    }
+}
+
+TEST(C2SoftColorConversionTest, P210ToRGBA1010102) {
+    for (size_t width = kMinWidth; width <= kMaxWidth; ++width) {
+        const size_t stride = paddedStride(width);
+        const auto srcY = randomPlane<uint16_t>(stride * kHeight, 0xFFC0, width);
+        const auto srcUV = randomPlane<uint16_t>(stride * kHeight, 0xFFC0, width + 1);
+        for (C2Color::matrix_t matrix : kMatrices) {
+            for (C2Color::range_t range : kRanges) {
+                const Coeffs coeffs = coeffsFor(matrix, range);
+                auto expected = unwritten<uint32_t>(stride * kHeight);
+                for (size_t y = 0; y < kHeight; ++y) {
+                    for (size_t x = 0; x < width; x += 2) {
+                        const int32_t u = (srcUV[y * stride + x] >> 6) - 512;
+                        const int32_t v = (srcUV[y * stride + x + 1] >> 6) - 512;
+                        for (size_t i = x; i < x + 2; ++i) {
+                            expected[y * stride + i] = scalarToRGBA1010102(
+                                    srcY[y * stride + i] >> 6, u, v, coeffs);
+                        }
+                    }
+                }
+
+                auto dst = unwritten<uint32_t>(stride * kHeight);
+                convertP210ToRGBA1010102(dst.data(), srcY.data(), srcUV.data(), stride, stride,
+                                         stride, width, kHeight, aspectsFor(matrix, range));
+                EXPECT_EQ(expected, dst) << "width " << width << ", matrix " << matrix
+                                         << ", range " << range;
+            }
+        }
+    }
+}
+
+TEST(C2SoftColorConversionTest, YUV420Planar16ToY410) {
+    for (size_t width = kMinWidth; width <= kMaxWidth; ++width) {
+        const size_t yStride = paddedStride(width), uvStride = paddedStride(width / 2);
+        const auto srcY = randomPlane<uint16_t>(yStride * kHeight, 0x3FF, width);
+        const auto srcU = randomPlane<uint16_t>(uvStride * kHeight / 2, 0x3FF, width + 1);
+        const auto srcV = randomPlane<uint16_t>(uvStride * kHeight / 2, 0x3FF, width + 2);
+
+        // 4 pixels at a time, then a last pair without alpha.
+        auto expected = unwritten<uint32_t>(yStride * kHeight);
+        const size_t alphaWidth = width / 4 * 4;
+        for (size_t y = 0; y < kHeight; ++y) {
+            for (size_t x = 0; x < alphaWidth + (width % 4 ? 2 : 0); ++x) {
+                const size_t c = y / 2 * uvStride + x / 2;
+                expected[y * yStride + x] = (x < alphaWidth ? 3u << 30 : 0)
+                        | (srcY[y * yStride + x] << 10) | srcU[c] | (srcV[c] << 20);
+            }
+        }
+
+        auto dst = unwritten<uint32_t>(yStride * kHeight);
+        convertYUV420Planar16ToY410(dst.data(), srcY.data(), srcU.data(), srcV.data(), yStride,
+                                    uvStride, uvStride, yStride, width, kHeight);
+        EXPECT_EQ(expected, dst) << "width " << width;
+    }
+}
+
+TEST(C2SoftColorConversionTest, RGBA1010102ToYUV420Planar16) {
+    for (size_t width = kMinWidth; width <= kMaxWidth; ++width) {
+        const size_t stride = paddedStride(width);
+        const auto src = randomPlane<uint32_t>(stride * kHeight, 0xFFFFFFFF, width);
+        for (C2Color::matrix_t matrix : kMatrices) {
+            for (C2Color::range_t range : kRanges) {
+                const bool isFullRange = range == C2Color::RANGE_FULL;
+                const int32_t zeroLvl = isFullRange ? 0 : 64;
+                const int32_t maxLvlLuma = isFullRange ? 1023 : 940;
+                const int32_t maxLvlChroma = isFullRange ? 1023 : 960;
+                const int16_t (*w)[3] = weights10Bit(matrix, range);
+
+                // the luma rows are packed, the chroma of each pair of rows
+                // starts width / 2 samples after the previous one.
+                auto expectedY = unwritten<uint16_t>(stride * kHeight);
+                auto expectedU = unwritten<uint16_t>(stride * kHeight);
+                auto expectedV = unwritten<uint16_t>(stride * kHeight);
+                for (size_t y = 0; y < kHeight; ++y) {
+                    for (size_t x = 0; x < width; ++x) {
+                        int32_t yuv[3];
+                        scalarFromRGBA1010102(src[y * stride + x], w, yuv);
+                        expectedY[y * width + x] = CLIP3(zeroLvl, yuv[0] + zeroLvl, maxLvlLuma);
+                        if (y % 2 == 0 && x % 2 == 0) {
+                            const size_t c = y / 2 * (width / 2) + x / 2;
+                            expectedU[c] = CLIP3(zeroLvl, yuv[1] + 512, maxLvlChroma);
+                            expectedV[c] = CLIP3(zeroLvl, yuv[2] + 512, maxLvlChroma);
+                        }
+                    }
+                }
+
+                auto dstY = unwritten<uint16_t>(stride * kHeight);
+                auto dstU = unwritten<uint16_t>(stride * kHeight);
+                auto dstV = unwritten<uint16_t>(stride * kHeight);
+                convertRGBA1010102ToYUV420Planar16(dstY.data(), dstU.data(), dstV.data(),
+                                                   src.data(), stride, width, kHeight, matrix,
+                                                   range);
+                EXPECT_EQ(expectedY, dstY) << "width " << width << ", matrix " << matrix
+                                           << ", range " << range;
+                EXPECT_EQ(expectedU, dstU) << "width " << width << ", matrix " << matrix
+                                           << ", range " << range;
+                EXPECT_EQ(expectedV, dstV) << "width " << width << ", matrix " << matrix
+                                           << ", range " << range;
+            }
+        }
+    }
+}
+
+TEST(C2SoftColorConversionTest, RGBA1010102ToP210) {
+    for (size_t width = kMinWidth; width <= kMaxWidth; ++width) {
+        const size_t stride = paddedStride(width);
+        const auto src = randomPlane<uint32_t>(stride * kHeight, 0xFFFFFFFF, width);
+        for (C2Color::matrix_t matrix : kMatrices) {
+            for (C2Color::range_t range : kRanges) {
+                const bool isFullRange = range == C2Color::RANGE_FULL;
+                const int32_t zeroLvl = isFullRange ? 0 : 64;
+                const int32_t maxLvlLuma = isFullRange ? 1023 : 940;
+                const int32_t maxLvlChroma = isFullRange ? 1023 : 960;
+                const int16_t (*w)[3] = weights10Bit(matrix, range);
+
+                auto expectedY = unwritten<uint16_t>(stride * kHeight);
+                auto expectedUV = unwritten<uint16_t>(stride * kHeight);
+                for (size_t y = 0; y < kHeight; ++y) {
+                    for (size_t x = 0; x < width; ++x) {
+                        int32_t yuv[3];
+                        scalarFromRGBA1010102(src[y * stride + x], w, yuv);
+                        const size_t i = y * stride + x;
+                        expectedY[i] = (CLIP3(zeroLvl, yuv[0] + zeroLvl, maxLvlLuma) << 6)
+                                & 0xFFC0;
+                        if (x % 2 == 0) {
+                            expectedUV[i] = (CLIP3(zeroLvl, yuv[1] + 512, maxLvlChroma) << 6)
+                                    & 0xFFC0;
+                            expectedUV[i + 1] = (CLIP3(zeroLvl, yuv[2] + 512, maxLvlChroma) << 6)
+                                    & 0xFFC0;
+                        }
+                    }
+                }
+
+                auto dstY = unwritten<uint16_t>(stride * kHeight);
+                auto dstUV = unwritten<uint16_t>(stride * kHeight);
+                convertRGBA1010102ToP210(dstY.data(), dstUV.data(), src.data(), stride, stride,
+                                         stride, width, kHeight, matrix, range);
+                EXPECT_EQ(expectedY, dstY) << "width " << width << ", matrix " << matrix
+                                           << ", range " << range;
+                EXPECT_EQ(expectedUV, dstUV) << "width " << width << ", matrix " << matrix
+                                             << ", range " << range;
+            }
+        }
+    }
+}
+
+TEST(C2SoftColorConversionTest, RGBToP210) {
+    for (size_t width = kMinWidth; width <= kMaxWidth; ++width) {
+        const size_t stride = paddedStride(width);
+        const auto src = randomPlane<uint32_t>(stride * kHeight, 0xFFFFFFFF, width);
+        for (C2Color::matrix_t matrix : kMatrices) {
+            for (C2Color::range_t range : kRanges) {
+                const bool isFullRange = range == C2Color::RANGE_FULL;
+                const uint8_t zeroLvl = isFullRange ? 0 : 16;
+                const uint8_t maxLvlLuma = isFullRange ? 255 : 235;
+                const uint8_t maxLvlChroma = isFullRange ? 255 : 240;
+                const int16_t (*w)[3] = matrix == C2Color::MATRIX_BT709
+                        ? kBt709Matrix8Bit[isFullRange ? 0 : 1]
+                        : kBt601Matrix8Bit[isFullRange ? 0 : 1];
+
+                auto expectedY = unwritten<uint16_t>(stride * kHeight);
+                auto expectedUV = unwritten<uint16_t>(stride * kHeight);
+                for (size_t y = 0; y < kHeight; ++y) {
+                    for (size_t x = 0; x < width; ++x) {
+                        const uint32_t rgba = src[y * stride + x];
+                        const int32_t b = (rgba >> 16) & 0xFF;
+                        const int32_t g = (rgba >> 8) & 0xFF;
+                        const int32_t r = rgba & 0xFF;
+                        int32_t yuv[3];
+                        for (int i = 0; i < 3; ++i) {
+                            yuv[i] = (r * w[i][0] + g * w[i][1] + b * w[i][2]) >> 8;
+                        }
+                        const size_t i = y * stride + x;
+                        expectedY[i] = scalarScale8To10Msb(
+                                CLIP3(zeroLvl, yuv[0] + zeroLvl, maxLvlLuma));
+                        if (x % 2 == 0) {
+                            expectedUV[i] = scalarScale8To10Msb(
+                                    CLIP3(zeroLvl, yuv[1] + 128, maxLvlChroma));
+                            expectedUV[i + 1] = scalarScale8To10Msb(
+                                    CLIP3(zeroLvl, yuv[2] + 128, maxLvlChroma));
+                        }
+                    }
+                }
+
+                auto dstY = unwritten<uint16_t>(stride * kHeight);
+                auto dstUV = unwritten<uint16_t>(stride * kHeight);
+                convertRGBToP210(dstY.data(), dstUV.data(), src.data(), stride, stride, stride,
+                                 width, kHeight, matrix, range);
+                EXPECT_EQ(expectedY, dstY) << "width " << width << ", matrix " << matrix
+                                           << ", range " << range;
+                EXPECT_EQ(expectedUV, dstUV) << "width " << width << ", matrix " << matrix
+                                             << ", range " << range;
+            }
+        }
+    }
+}
+
+// Every 8 bit value, in each plane, for NV12 and NV21.
+TEST(C2SoftColorConversionTest, SemiPlanar8ToP210) {
+    for (bool isNV12 : {true, false}) {
+        for (size_t width = kMinWidth; width <= kMaxWidth; ++width) {
+            const size_t stride = paddedStride(width);
+            const size_t height = 2 * (256 / width + 1);
+            std::vector<uint8_t> srcY(stride * height), srcUV(stride * height);
+            for (size_t i = 0; i < srcY.size(); ++i) {
+                srcY[i] = i;
+                srcUV[i] = 255 - i;
+            }
+
+            auto expectedY = unwritten<uint16_t>(stride * (height + 1));
+            auto expectedUV = unwritten<uint16_t>(stride * (height + 1));
+            for (size_t y = 0; y < height; ++y) {
+                for (size_t x = 0; x < width; ++x) {
+                    expectedY[y * stride + x] = scalarScale8To10Msb(srcY[y * stride + x]);
+                }
+            }
+            for (size_t y = 0; y < (height + 1) / 2; ++y) {
+                for (size_t x = 0; x < width; x += isNV12 ? 1 : 2) {
+                    const uint8_t *uv = &srcUV[y * stride + x];
+                    for (size_t row = 2 * y; row < 2 * y + 2; ++row) {
+                        if (isNV12) {
+                            expectedUV[row * stride + x] = scalarScale8To10Msb(uv[0]);
+                        } else {
+                            expectedUV[row * stride + x + 1] = scalarScale8To10Msb(uv[0]);
+                            expectedUV[row * stride + x] = scalarScale8To10Msb(uv[1]);
+                        }
+                    }
+                }
+            }
+
+            auto dstY = unwritten<uint16_t>(stride * (height + 1));
+            auto dstUV = unwritten<uint16_t>(stride * (height + 1));
+            convertSemiPlanar8ToP210(dstY.data(), dstUV.data(), srcY.data(), srcUV.data(), stride,
+                                     stride, stride, stride, width, height, CONV_FORMAT_I420,
+                                     isNV12);
+            EXPECT_EQ(expectedY, dstY) << "width " << width << ", NV12 " << isNV12;
+            EXPECT_EQ(expectedUV, dstUV) << "width " << width << ", NV12 " << isNV12;
+        }
+    }
+}
+
+TEST(C2SoftColorConversionTest, Planar8ToP210) {
+    for (size_t width = kMinWidth; width <= kMaxWidth; ++width) {
+        const size_t yStride = paddedStride(width), uvStride = paddedStride(width / 2);
+        const size_t height = 2 * (256 / (width / 2) + 1);
+        std::vector<uint8_t> srcY(yStride * height), srcU(uvStride * height / 2),
+                srcV(uvStride * height / 2);
+        for (size_t i = 0; i < srcY.size(); ++i) {
+            srcY[i] = i;
+        }
+        for (size_t i = 0; i < srcU.size(); ++i) {
+            srcU[i] = i;
+            srcV[i] = 255 - i;
+        }
+
+        auto expectedY = unwritten<uint16_t>(yStride * height);
+        auto expectedUV = unwritten<uint16_t>(yStride * height);
+        for (size_t y = 0; y < height; ++y) {
+            for (size_t x = 0; x < width; ++x) {
+                expectedY[y * yStride + x] = scalarScale8To10Msb(srcY[y * yStride + x]);
+            }
+        }
+        for (size_t y = 0; y < height / 2; ++y) {
+            for (size_t x = 0; x < width / 2; ++x) {
+                for (size_t row = 2 * y; row < 2 * y + 2; ++row) {
+                    expectedUV[row * yStride + 2 * x] =
+                            scalarScale8To10Msb(srcU[y * uvStride + x]);
+                    expectedUV[row * yStride + 2 * x + 1] =
+                            scalarScale8To10Msb(srcV[y * uvStride + x]);
+                }
+            }
+        }
+
+        auto dstY = unwritten<uint16_t>(yStride * height);
+        auto dstUV = unwritten<uint16_t>(yStride * height);
+        convertPlanar8ToP210(dstY.data(), dstUV.data(), srcY.data(), srcU.data(), srcV.data(),
+                             yStride, uvStride, uvStride, yStride, yStride, width, height,
+                             CONV_FORMAT_I420);
+        EXPECT_EQ(expectedY, dstY) << "width " << width;
+        EXPECT_EQ(expectedUV, dstUV) << "width " << width;
+    }
+}
+
+}  // namespace
+
+}  // namespace android
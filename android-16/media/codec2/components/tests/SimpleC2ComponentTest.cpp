@@ -0,0 +1,394 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SimpleC2ComponentTest"
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <android-base/properties.h>
+#include <C2PlatformSupport.h>
+#include <SimpleC2Component.h>
+#include <SimpleC2Interface.h>
+#include <gtest/gtest.h>
+#include <media/stagefright/foundation/MediaDefs.h>
+#include <util/C2InterfaceHelper.h>
+
+namespace android {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr char kPipelineThreadsProperty[] = "debug.stagefright.c2.sw_pipeline_threads";
+constexpr auto kTimeout = 5s;
+// marks a drain in the order of processing
+constexpr int64_t kDrain = -1;
+
+class FakeIntf : public SimpleInterface<void>::BaseParams {
+public:
+    explicit FakeIntf(const std::shared_ptr<C2ReflectorHelper> &helper)
+        : SimpleInterface<void>::BaseParams(
+                helper,
+                "c2.android.fake.encoder",
+                C2Component::KIND_ENCODER,
+                C2Component::DOMAIN_VIDEO,
+                MEDIA_MIMETYPE_VIDEO_AVC) {
+        noPrivateBuffers();
+        noInputReferences();
+        noOutputReferences();
+        noInputLatency();
+        noTimeStretch();
+        setDerivedInstance(this);
+    }
+};
+
+// Records the order in which works are prepared and processed. onPrepare() can
+// be held until release() to test the transitions while a work is prepared.
+class FakeComponent : public SimpleC2Component {
+public:
+    struct Prepared : public PreparedWork {
+        int64_t frameIndex;
+    };
+
+    FakeComponent(size_t numThreads, size_t maxInFlight)
+        : SimpleC2Component(std::make_shared<SimpleInterface<FakeIntf>>(
+                "c2.android.fake.encoder", 0,
+                std::make_shared<FakeIntf>(std::static_pointer_cast<C2ReflectorHelper>(
+                        GetCodec2PlatformComponentStore()->getParamReflector())))) {
+        enablePipeline(numThreads, maxInFlight);
+    }
+
+    void holdPrepare() {
+        std::lock_guard l(mMutex);
+        mHold = true;
+    }
+
+    void releasePrepare() {
+        std::lock_guard l(mMutex);
+        mHold = false;
+        mCondition.notify_all();
+    }
+
+    // waits until onPrepare() has started for |count| works.
+    bool waitForPrepareStarted(size_t count) {
+        std::unique_lock l(mMutex);
+        return mCondition.wait_for(l, kTimeout, [&] { return mPrepareStarted >= count; });
+    }
+
+    size_t preparing() {
+        std::lock_guard l(mMutex);
+        return mPreparing;
+    }
+
+    size_t prepareStarted() {
+        std::lock_guard l(mMutex);
+        return mPrepareStarted;
+    }
+
+    size_t maxPreparing() {
+        std::lock_guard l(mMutex);
+        return mMaxPreparing;
+    }
+
+    bool waitForProcessed(size_t count) {
+        std::unique_lock l(mMutex);
+        return mCondition.wait_for(l, kTimeout, [&] { return mProcessed.size() >= count; });
+    }
+
+    std::vector<int64_t> processed() {
+        std::lock_guard l(mMutex);
+        return mProcessed;
+    }
+
+    size_t missingPrepared() {
+        std::lock_guard l(mMutex);
+        return mMissingPrepared;
+    }
+
+    bool releasedWhilePreparing() {
+        std::lock_guard l(mMutex);
+        return mReleasedWhilePreparing;
+    }
+
+protected:
+    c2_status_t onInit() override { return C2_OK; }
+    c2_status_t onStop() override { return C2_OK; }
+    void onReset() override {}
+    void onRelease() override {
+        std::lock_guard l(mMutex);
+        mReleasedWhilePreparing |= mPreparing > 0;
+    }
+    c2_status_t onFlush_sm() override { return C2_OK; }
+
+    std::shared_ptr<PreparedWork> onPrepare(const std::unique_ptr<C2Work> &work) override {
+        const int64_t frameIndex = work->input.ordinal.frameIndex.peekll();
+        {
+            std::unique_lock l(mMutex);
+            ++mPrepareStarted;
+            ++mPreparing;
+            mMaxPreparing = std::max(mMaxPreparing, mPreparing);
+            mCondition.notify_all();
+            mCondition.wait(l, [this] { return !mHold; });
+        }
+        // later works finish first
+        std::this_thread::sleep_for(std::chrono::milliseconds(3 - frameIndex % 3));
+        std::shared_ptr<Prepared> prepared = std::make_shared<Prepared>();
+        prepared->frameIndex = frameIndex;
+        std::lock_guard l(mMutex);
+        --mPreparing;
+        return prepared;
+    }
+
+    void process(const std::unique_ptr<C2Work> &work,
+                 const std::shared_ptr<C2BlockPool> &) override {
+        const int64_t frameIndex = work->input.ordinal.frameIndex.peekll();
+        std::shared_ptr<Prepared> prepared = std::static_pointer_cast<Prepared>(preparedWork());
+        std::lock_guard l(mMutex);
+        if (!prepared || prepared->frameIndex != frameIndex) {
+            ++mMissingPrepared;
+        }
+        mProcessed.push_back(frameIndex);
+        mCondition.notify_all();
+        work->result = C2_OK;
+        work->workletsProcessed = 1u;
+    }
+
+    c2_status_t drain(uint32_t, const std::shared_ptr<C2BlockPool> &) override {
+        std::lock_guard l(mMutex);
+        mProcessed.push_back(kDrain);
+        mCondition.notify_all();
+        return C2_OK;
+    }
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mHold = false;
+    size_t mPrepareStarted = 0;
+    size_t mPreparing = 0;
+    size_t mMaxPreparing = 0;
+    size_t mMissingPrepared = 0;
+    bool mReleasedWhilePreparing = false;
+    std::vector<int64_t> mProcessed;
+};
+
+class Listener : public C2Component::Listener {
+public:
+    void onWorkDone_nb(std::weak_ptr<C2Component>,
+                       std::list<std::unique_ptr<C2Work>> workItems) override {
+        std::lock_guard l(mMutex);
+        for (const std::unique_ptr<C2Work> &work : workItems) {
+            mDone.push_back(work->input.ordinal.frameIndex.peekll());
+        }
+        mCondition.notify_all();
+    }
+
+    void onTripped_nb(std::weak_ptr<C2Component>,
+                      std::vector<std::shared_ptr<C2SettingResult>>) override {}
+
+    void onError_nb(std::weak_ptr<C2Component>, uint32_t errorCode) override {
+        ADD_FAILURE() << "component error " << errorCode;
+    }
+
+    bool waitForDone(size_t count) {
+        std::unique_lock l(mMutex);
+        return mCondition.wait_for(l, kTimeout, [&] { return mDone.size() >= count; });
+    }
+
+    std::vector<int64_t> done() {
+        std::lock_guard l(mMutex);
+        return mDone;
+    }
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::vector<int64_t> mDone;
+};
+
+std::list<std::unique_ptr<C2Work>> makeWorks(int64_t first, int64_t count) {
+    std::list<std::unique_ptr<C2Work>> works;
+    for (int64_t i = first; i < first + count; ++i) {
+        std::unique_ptr<C2Work> work = std::make_unique<C2Work>();
+        work->input.ordinal.frameIndex = i;
+        work->input.ordinal.timestamp = i * 33333;
+        work->input.flags = (C2FrameData::flags_t)0;
+        work->worklets.emplace_back(new C2Worklet);
+        works.push_back(std::move(work));
+    }
+    return works;
+}
+
+std::vector<int64_t> sequence(int64_t first, int64_t count) {
+    std::vector<int64_t> indices;
+    for (int64_t i = first; i < first + count; ++i) {
+        indices.push_back(i);
+    }
+    return indices;
+}
+
+class SimpleC2ComponentTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mSavedThreads = base::GetProperty(kPipelineThreadsProperty, "");
+        base::SetProperty(kPipelineThreadsProperty, "");
+    }
+
+    void TearDown() override {
+        if (mComponent) {
+            mComponent->release();
+        }
+        base::SetProperty(kPipelineThreadsProperty, mSavedThreads);
+    }
+
+    void start(size_t numThreads, size_t maxInFlight) {
+        mComponent = std::make_shared<FakeComponent>(numThreads, maxInFlight);
+        mListener = std::make_shared<Listener>();
+        ASSERT_EQ(C2_OK, mComponent->setListener_vb(mListener, C2_MAY_BLOCK));
+        ASSERT_EQ(C2_OK, mComponent->start());
+    }
+
+    void queue(int64_t first, int64_t count) {
+        std::list<std::unique_ptr<C2Work>> works = makeWorks(first, count);
+        ASSERT_EQ(C2_OK, mComponent->queue_nb(&works));
+    }
+
+    std::string mSavedThreads;
+    std::shared_ptr<FakeComponent> mComponent;
+    std::shared_ptr<Listener> mListener;
+};
+
+TEST_F(SimpleC2ComponentTest, OutputsInOrder) {
+    start(2 /* numThreads */, 3 /* maxInFlight */);
+    constexpr int64_t kNumWorks = 30;
+    for (int64_t i = 0; i < kNumWorks; ++i) {
+        queue(i, 1);
+    }
+    ASSERT_TRUE(mListener->waitForDone(kNumWorks));
+
+    EXPECT_EQ(sequence(0, kNumWorks), mComponent->processed());
+    EXPECT_EQ(sequence(0, kNumWorks), mListener->done());
+    EXPECT_EQ(0u, mComponent->missingPrepared());
+    EXPECT_EQ((size_t)kNumWorks, mComponent->prepareStarted());
+    EXPECT_LE(mComponent->maxPreparing(), 2u);
+}
+
+TEST_F(SimpleC2ComponentTest, DrainBehindPreparedWorks) {
+    start(1 /* numThreads */, 2 /* maxInFlight */);
+    mComponent->holdPrepare();
+    queue(0, 2);
+    ASSERT_EQ(C2_OK, mComponent->drain_nb(C2Component::DRAIN_COMPONENT_WITH_EOS));
+    queue(2, 1);
+    ASSERT_TRUE(mComponent->waitForPrepareStarted(1));
+
+    // neither the works nor the drain behind them run while the first is prepared
+    std::this_thread::sleep_for(50ms);
+    EXPECT_TRUE(mComponent->processed().empty());
+
+    mComponent->releasePrepare();
+    ASSERT_TRUE(mListener->waitForDone(3));
+    EXPECT_EQ((std::vector<int64_t>{0, 1, kDrain, 2}), mComponent->processed());
+    EXPECT_EQ(0u, mComponent->missingPrepared());
+}
+
+enum class Transition { FLUSH, STOP, RESET, RELEASE };
+
+class SimpleC2ComponentTransitionTest
+    : public SimpleC2ComponentTest,
+      public ::testing::WithParamInterface<Transition> {};
+
+TEST_P(SimpleC2ComponentTransitionTest, WaitsForPrepare) {
+    start(1 /* numThreads */, 2 /* maxInFlight */);
+    mComponent->holdPrepare();
+    constexpr int64_t kNumWorks = 4;
+    queue(0, kNumWorks);
+    ASSERT_TRUE(mComponent->waitForPrepareStarted(1));
+
+    std::list<std::unique_ptr<C2Work>> flushed;
+    std::future<c2_status_t> result = std::async(std::launch::async, [&] {
+        switch (GetParam()) {
+            case Transition::FLUSH:
+                return mComponent->flush_sm(C2Component::FLUSH_COMPONENT, &flushed);
+            case Transition::STOP:
+                return mComponent->stop();
+            case Transition::RESET:
+                return mComponent->reset();
+            case Transition::RELEASE:
+                return mComponent->release();
+        }
+        return C2_CORRUPTED;
+    });
+
+    // the queue is not cleared while a work is prepared
+    EXPECT_EQ(std::future_status::timeout, result.wait_for(50ms));
+    mComponent->releasePrepare();
+    ASSERT_EQ(std::future_status::ready, result.wait_for(kTimeout));
+    EXPECT_EQ(C2_OK, result.get());
+    EXPECT_FALSE(mComponent->releasedWhilePreparing());
+
+    // the works behind are not prepared once the queue is to be cleared
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(0u, mComponent->preparing());
+    EXPECT_EQ(1u, mComponent->prepareStarted());
+
+    if (GetParam() == Transition::FLUSH) {
+        // each work is either processed before the flush or flushed, in order
+        std::vector<int64_t> indices = mComponent->processed();
+        for (const std::unique_ptr<C2Work> &work : flushed) {
+            indices.push_back(work->input.ordinal.frameIndex.peekll());
+        }
+        EXPECT_EQ(sequence(0, kNumWorks), indices);
+
+        // and the component keeps preparing the works queued after the flush
+        const size_t done = mListener->done().size();
+        queue(kNumWorks, 2);
+        ASSERT_TRUE(mListener->waitForDone(done + 2));
+        EXPECT_EQ(3u, mComponent->prepareStarted());
+    } else if (GetParam() == Transition::RELEASE) {
+        mComponent.reset();
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        Transitions, SimpleC2ComponentTransitionTest,
+        ::testing::Values(Transition::FLUSH, Transition::STOP, Transition::RESET,
+                          Transition::RELEASE));
+
+TEST_F(SimpleC2ComponentTest, PropertyDisablesPipeline) {
+    ASSERT_TRUE(base::SetProperty(kPipelineThreadsProperty, "0"));
+    start(2 /* numThreads */, 3 /* maxInFlight */);
+    constexpr int64_t kNumWorks = 10;
+    queue(0, kNumWorks);
+    ASSERT_EQ(C2_OK, mComponent->drain_nb(C2Component::DRAIN_COMPONENT_WITH_EOS));
+    ASSERT_TRUE(mComponent->waitForProcessed(kNumWorks + 1));
+
+    // works go straight to process(), as without enablePipeline()
+    std::vector<int64_t> expected = sequence(0, kNumWorks);
+    expected.push_back(kDrain);
+    EXPECT_EQ(expected, mComponent->processed());
+    EXPECT_EQ(0u, mComponent->prepareStarted());
+    EXPECT_EQ((size_t)kNumWorks, mComponent->missingPrepared());
+}
+
+}  // namespace
+
+}  // namespace android
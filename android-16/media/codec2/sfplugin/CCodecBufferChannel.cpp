@@ -540,10 +540,9 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
         ScopedTrace trace(ATRACE_TAG, android::base::StringPrintf(
                 "CCodecBufferChannel::queue(%s@ts=%lld)", mName, (long long)timeUs).c_str());
         {
-            Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
             PipelineWatcher::Clock::time_point now = PipelineWatcher::Clock::now();
             for (const std::unique_ptr<C2Work> &work : items) {
-                watcher->onWorkQueued(
+                mPipelineWatcher.onWorkQueued(
                         work->input.ordinal.frameIndex.peeku(),
                         std::vector(work->input.buffers),
                         now);
@@ -552,9 +551,8 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
         err = std::atomic_load(&mComponent)->queue(&items);
     }
     if (err != C2_OK) {
-        Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
         for (const std::unique_ptr<C2Work> &work : items) {
-            watcher->onWorkDone(work->input.ordinal.frameIndex.peeku());
+            mPipelineWatcher.onWorkDone(work->input.ordinal.frameIndex.peeku());
         }
     } else {
         Mutexed<Input>::Locked input(mInput);
@@ -1219,7 +1217,7 @@ void CCodecBufferChannel::feedInputBufferIfAvailableInternal() {
         return;
     }
     size_t numActiveSlots = 0;
-    while (!mPipelineWatcher.lock()->pipelineFull()) {
+    while (!mPipelineWatcher.pipelineFull()) {
         sp<MediaCodecBuffer> inBuffer;
         size_t index;
         {
@@ -2108,14 +2106,9 @@ status_t CCodecBufferChannel::start(
                     padding = 0;
                 }
                 if (delay || padding) {
-                    // We need write access to the buffers, so turn them into array mode.
-                    // TODO: b/321930152 - define SkipCutOutputBuffers that takes output from
-                    // component, runs it through SkipCutBuffer and allocate local buffer to be
-                    // used by fwk. Make initSkipCutBuffer() return OutputBuffers similar to
-                    // toArrayMode().
-                    if (!output->buffers->isArrayMode()) {
-                        output->buffers = output->buffers->toArrayMode(numOutputSlots);
-                    }
+                    // Linear output buffers skip the delay without copying the
+                    // component's output, and only copy it to local buffers
+                    // while holding back the data to cut the padding.
                     output->buffers->initSkipCutBuffer(delay, padding, sampleRate, channelCount);
                 }
             }
@@ -2134,13 +2127,12 @@ status_t CCodecBufferChannel::start(
     // newly initialized pipeline capacity.
 
     if (inputFormat || outputFormat) {
-        Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
-        watcher->inputDelay(inputDelayValue)
+        mPipelineWatcher.inputDelay(inputDelayValue)
                 .pipelineDelay(pipelineDelayValue)
                 .outputDelay(outputDelayValue)
                 .smoothnessFactor(kSmoothnessFactor)
                 .tunneled(mTunneled);
-        watcher->flush();
+        mPipelineWatcher.flush();
     }
 
     mInputMetEos = false;
@@ -2212,10 +2204,9 @@ status_t CCodecBufferChannel::requestInitialInputBuffers(
     mFlushedConfigs.lock()->swap(flushedConfigs);
     if (!flushedConfigs.empty()) {
         {
-            Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
             PipelineWatcher::Clock::time_point now = PipelineWatcher::Clock::now();
             for (const std::unique_ptr<C2Work> &work : flushedConfigs) {
-                watcher->onWorkQueued(
+                mPipelineWatcher.onWorkQueued(
                         work->input.ordinal.frameIndex.peeku(),
                         std::vector(work->input.buffers),
                         now);
@@ -2286,7 +2277,7 @@ void CCodecBufferChannel::stopUseOutputSurface(bool pushBlankBuffer) {
 
 void CCodecBufferChannel::reset() {
     stop();
-    mPipelineWatcher.lock()->flush();
+    mPipelineWatcher.flush();
     {
         mHasInputSurface = false;
         Mutexed<InputSurface>::Locked inputSurface(mInputSurface);
@@ -2324,41 +2315,39 @@ void CCodecBufferChannel::flush(const std::list<std::unique_ptr<C2Work>> &flushe
     ALOGV("[%s] flush", mName);
     std::list<std::unique_ptr<C2Work>> configs;
     mInput.lock()->lastFlushIndex = mFrameIndex.load(std::memory_order_relaxed);
-    {
-        Mutexed<PipelineWatcher>::Locked watcher(mPipelineWatcher);
-        for (const std::unique_ptr<C2Work> &work : flushedWork) {
-            uint64_t frameIndex = work->input.ordinal.frameIndex.peeku();
-            if (!(work->input.flags & C2FrameData::FLAG_CODEC_CONFIG)) {
-                watcher->onWorkDone(frameIndex);
-                continue;
-            }
-            if (work->input.buffers.empty()
-                    || work->input.buffers.front() == nullptr
-                    || work->input.buffers.front()->data().linearBlocks().empty()) {
-                ALOGD("[%s] no linear codec config data found", mName);
-                watcher->onWorkDone(frameIndex);
-                continue;
-            }
-            std::unique_ptr<C2Work> copy(new C2Work);
-            copy->input.flags = C2FrameData::flags_t(
-                    work->input.flags | C2FrameData::FLAG_DROP_FRAME);
-            copy->input.ordinal = work->input.ordinal;
-            copy->input.ordinal.frameIndex = mFrameIndex++;
-            for (size_t i = 0; i < work->input.buffers.size(); ++i) {
-                copy->input.buffers.push_back(watcher->onInputBufferReleased(frameIndex, i));
-            }
-            for (const std::unique_ptr<C2Param> &param : work->input.configUpdate) {
-                copy->input.configUpdate.push_back(C2Param::Copy(*param));
-            }
-            copy->input.infoBuffers.insert(
-                    copy->input.infoBuffers.begin(),
-                    work->input.infoBuffers.begin(),
-                    work->input.infoBuffers.end());
-            copy->worklets.emplace_back(new C2Worklet);
-            configs.push_back(std::move(copy));
-            watcher->onWorkDone(frameIndex);
-            ALOGV("[%s] stashed flushed codec config data", mName);
-        }
+    for (const std::unique_ptr<C2Work> &work : flushedWork) {
+        uint64_t frameIndex = work->input.ordinal.frameIndex.peeku();
+        if (!(work->input.flags & C2FrameData::FLAG_CODEC_CONFIG)) {
+            mPipelineWatcher.onWorkDone(frameIndex);
+            continue;
+        }
+        if (work->input.buffers.empty()
+                || work->input.buffers.front() == nullptr
+                || work->input.buffers.front()->data().linearBlocks().empty()) {
+            ALOGD("[%s] no linear codec config data found", mName);
+            mPipelineWatcher.onWorkDone(frameIndex);
+            continue;
+        }
+        std::unique_ptr<C2Work> copy(new C2Work);
+        copy->input.flags = C2FrameData::flags_t(
+                work->input.flags | C2FrameData::FLAG_DROP_FRAME);
+        copy->input.ordinal = work->input.ordinal;
+        copy->input.ordinal.frameIndex = mFrameIndex++;
+        for (size_t i = 0; i < work->input.buffers.size(); ++i) {
+            copy->input.buffers.push_back(
+                    mPipelineWatcher.onInputBufferReleased(frameIndex, i));
+        }
+        for (const std::unique_ptr<C2Param> &param : work->input.configUpdate) {
+            copy->input.configUpdate.push_back(C2Param::Copy(*param));
+        }
+        copy->input.infoBuffers.insert(
+                copy->input.infoBuffers.begin(),
+                work->input.infoBuffers.begin(),
+                work->input.infoBuffers.end());
+        copy->worklets.emplace_back(new C2Worklet);
+        configs.push_back(std::move(copy));
+        mPipelineWatcher.onWorkDone(frameIndex);
+        ALOGV("[%s] stashed flushed codec config data", mName);
     }
     mFlushedConfigs.lock()->swap(configs);
     {
@@ -2395,7 +2384,7 @@ void CCodecBufferChannel::onWorkDone(
 void CCodecBufferChannel::onInputBufferDone(
         uint64_t frameIndex, size_t arrayIndex) {
     std::shared_ptr<C2Buffer> buffer =
-            mPipelineWatcher.lock()->onInputBufferReleased(frameIndex, arrayIndex);
+            mPipelineWatcher.onInputBufferReleased(frameIndex, arrayIndex);
     bool newInputSlotAvailable = false;
     {
         Mutexed<Input>::Locked input(mInput);
@@ -2459,7 +2448,7 @@ bool CCodecBufferChannel::handleWork(
             || !work->worklets.front()
             || !(work->worklets.front()->output.flags &
                  C2FrameData::FLAG_INCOMPLETE))) {
-        mPipelineWatcher.lock()->onWorkDone(
+        mPipelineWatcher.onWorkDone(
                 work->input.ordinal.frameIndex.peeku());
     }
 
@@ -2526,7 +2515,7 @@ bool CCodecBufferChannel::handleWork(
                         ALOGV("[%s] onWorkDone: updating pipeline delay %u",
                               mName, pipelineDelay.value);
                         newPipelineDelay = pipelineDelay.value;
-                        (void)mPipelineWatcher.lock()->pipelineDelay(
+                        (void)mPipelineWatcher.pipelineDelay(
                                 pipelineDelay.value);
                     }
                 }
@@ -2536,7 +2525,7 @@ bool CCodecBufferChannel::handleWork(
                         ALOGV("[%s] onWorkDone: updating input delay %u",
                               mName, inputDelay.value);
                         newInputDelay = inputDelay.value;
-                        (void)mPipelineWatcher.lock()->inputDelay(
+                        (void)mPipelineWatcher.inputDelay(
                                 inputDelay.value);
                     }
                 }
@@ -2545,7 +2534,7 @@ bool CCodecBufferChannel::handleWork(
                     if (outputDelay.updateFrom(*param)) {
                         ALOGV("[%s] onWorkDone: updating output delay %u",
                               mName, outputDelay.value);
-                        (void)mPipelineWatcher.lock()->outputDelay(outputDelay.value);
+                        (void)mPipelineWatcher.outputDelay(outputDelay.value);
                         newOutputDelay = outputDelay.value;
                         needMaxDequeueBufferCountUpdate = true;
 
@@ -2942,7 +2931,7 @@ PipelineWatcher::Clock::duration CCodecBufferChannel::elapsed() {
         Mutexed<Input>::Locked input(mInput);
         n = input->inputDelay + input->pipelineDelay + outputDelay;
     }
-    return mPipelineWatcher.lock()->elapsed(PipelineWatcher::Clock::now(), n);
+    return mPipelineWatcher.elapsed(PipelineWatcher::Clock::now(), n);
 }
 
 void CCodecBufferChannel::setMetaMode(MetaMode mode) {
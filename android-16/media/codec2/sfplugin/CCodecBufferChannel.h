@@ -414,7 +414,7 @@ private:
 
     MetaMode mMetaMode;
 
-    Mutexed<PipelineWatcher> mPipelineWatcher;
+    PipelineWatcher mPipelineWatcher;
 
     std::atomic_bool mInputMetEos;
     std::once_flag mRenderWarningFlag;
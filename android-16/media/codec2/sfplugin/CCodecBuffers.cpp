@@ -174,13 +174,33 @@ public:
 
     }
 
+    // Whether buffers can be submitted in place, without writing to them. This
+    // is the case unless data has to be held back to cut the end of the stream.
+    bool canSubmitInPlace() {
+        return mCutBuffer == nullptr
+                || (mBackPadding == 0 && SkipCutBuffer::size() == 0);
+    }
+
+    // Skips the front padding by only moving the start of the buffer. Must only
+    // be used if canSubmitInPlace().
+    void submitInPlace(const sp<MediaCodecBuffer>& buffer) {
+        if (mCutBuffer == nullptr) {
+            // passthrough mode
+            return;
+        }
+        int32_t toDrop = std::min((int32_t)buffer->size(), mFrontPadding);
+        buffer->setRange(buffer->offset() + toDrop, buffer->size() - toDrop);
+        mFrontPadding -= toDrop;
+    }
+
     void submitMultiAccessUnits(
             const sp<MediaCodecBuffer>& buffer,
             int32_t sampleRate, size_t num16BitChannels,
-            std::shared_ptr<const C2AccessUnitInfos::output> &infos) {
+            std::shared_ptr<const C2AccessUnitInfos::output> &infos,
+            bool inPlace = false) {
         if (infos == nullptr) {
             // there is nothing to do more.
-            SkipCutBuffer::submit(buffer);
+            submitData(buffer, inPlace);
             return;
         }
         typedef WrapperObject<std::vector<AccessUnitInfo>> BufferInfosWrapper;
@@ -289,13 +309,21 @@ public:
                 }
             }
         }
-        SkipCutBuffer::submit(buffer);
+        submitData(buffer, inPlace);
         infos = nullptr;
         if (!bufferInfos->value.empty()) {
             buffer->meta()->setObject("accessUnitInfo", bufferInfos);
         }
     }
 protected:
+    void submitData(const sp<MediaCodecBuffer>& buffer, bool inPlace) {
+        if (inPlace) {
+            submitInPlace(buffer);
+        } else {
+            SkipCutBuffer::submit(buffer);
+        }
+    }
+
     // Flags can come with individual BufferInfos
     // when used with large frame audio
     constexpr static std::initializer_list<std::pair<uint32_t, uint32_t>> flagList = {
@@ -366,21 +394,44 @@ void OutputBuffers::updateSkipCutBuffer(const sp<AMessage> &format) {
     }
 }
 
-void OutputBuffers::submit(const sp<MediaCodecBuffer> &buffer) {
-    if (mSkipCutBuffer != nullptr) {
-        mSkipCutBuffer->submit(buffer);
-    }
-}
-
-bool OutputBuffers::submit(const sp<MediaCodecBuffer> &buffer, int32_t sampleRate,
-            int32_t channelCount, std::shared_ptr<const C2AccessUnitInfos::output> &infos) {
+bool OutputBuffers::submit(
+        const sp<MediaCodecBuffer> &clientBuffer,
+        const std::shared_ptr<C2Buffer> &buffer,
+        bool readOnly) {
     if (mSkipCutBuffer == nullptr) {
+        return true;
+    }
+    if (readOnly && !mSkipCutBuffer->canSubmitInPlace()) {
         return false;
     }
-    mSkipCutBuffer->submitMultiAccessUnits(buffer, sampleRate, channelCount, infos);
+    if (buffer && buffer->hasInfo(C2AccessUnitInfos::output::PARAM_TYPE)) {
+        std::shared_ptr<const C2AccessUnitInfos::output> bufferMetadata =
+                std::static_pointer_cast<const C2AccessUnitInfos::output>(
+                buffer->getInfo(C2AccessUnitInfos::output::PARAM_TYPE));
+        mSkipCutBuffer->submitMultiAccessUnits(
+                clientBuffer, mSampleRate, mChannelCount, bufferMetadata, readOnly);
+        buffer->removeInfo(C2AccessUnitInfos::output::PARAM_TYPE);
+    } else if (readOnly) {
+        mSkipCutBuffer->submitInPlace(clientBuffer);
+    } else {
+        mSkipCutBuffer->submit(clientBuffer);
+    }
     return true;
 }
 
+sp<ABuffer> OutputBuffers::allocateLocalBuffer(size_t capacity) {
+    if (!mLocalLinearBufferPool) {
+        mLocalLinearBufferPool = LocalBufferPool::Create();
+    }
+    sp<ABuffer> buffer = mLocalLinearBufferPool->newBuffer(capacity);
+    if (buffer == nullptr) {
+        // the client holds on to too many buffers
+        ALOGD("[%s] local buffer pool exhausted; allocating %zu bytes", mName, capacity);
+        buffer = new ABuffer(capacity);
+    }
+    return buffer;
+}
+
 void OutputBuffers::setSkipCutBuffer(int32_t skip, int32_t cut) {
     if (mSkipCutBuffer != nullptr) {
         size_t prevSize = mSkipCutBuffer->size();
@@ -434,7 +485,7 @@ bool OutputBuffers::convert(
     if (!*dst) {
         *dst = new Codec2Buffer(
                 mFormat,
-                new ABuffer(mDataConverter->targetSize(srcBuffer->size())));
+                allocateLocalBuffer(mDataConverter->targetSize(srcBuffer->size())));
     }
     sp<MediaCodecBuffer> dstBuffer = *dst;
     status_t err = mDataConverter->convert(srcBuffer, dstBuffer);
@@ -1341,16 +1392,7 @@ status_t OutputBuffersArray::registerBuffer(
         ALOGD("[%s] copy buffer failed", mName);
         return WOULD_BLOCK;
     }
-    if (buffer && buffer->hasInfo(C2AccessUnitInfos::output::PARAM_TYPE)) {
-        std::shared_ptr<const C2AccessUnitInfos::output> bufferMetadata =
-                        std::static_pointer_cast<const C2AccessUnitInfos::output>(
-                        buffer->getInfo(C2AccessUnitInfos::output::PARAM_TYPE));
-        if (submit(c2Buffer, mSampleRate, mChannelCount, bufferMetadata)) {
-            buffer->removeInfo(C2AccessUnitInfos::output::PARAM_TYPE);
-        }
-    } else {
-        submit(c2Buffer);
-    }
+    submit(c2Buffer, buffer, false /* readOnly */);
     handleImageData(c2Buffer);
     *clientBuffer = c2Buffer;
     ALOGV("[%s] grabbed buffer %zu", mName, *index);
@@ -1463,7 +1505,9 @@ status_t FlexOutputBuffers::registerBuffer(
         size_t *index,
         sp<MediaCodecBuffer> *clientBuffer) {
     sp<Codec2Buffer> newBuffer;
-    if (!convert(buffer, &newBuffer)) {
+    if (convert(buffer, &newBuffer)) {
+        submit(newBuffer, buffer, false /* readOnly */);
+    } else {
         newBuffer = wrap(buffer);
         if (newBuffer == nullptr) {
             return NO_MEMORY;
@@ -1575,8 +1619,18 @@ sp<Codec2Buffer> LinearOutputBuffers::wrap(const std::shared_ptr<C2Buffer> &buff
         ALOGD("[%s] ConstLinearBlockBuffer::Allocate failed", mName);
         return nullptr;
     }
-    submit(clientBuffer);
-    return clientBuffer;
+    if (submit(clientBuffer, buffer, true /* readOnly */)) {
+        return clientBuffer;
+    }
+    // The end of the data is held back until it is known whether it is cut
+    // at the end of the stream, so the data is output from a local buffer that
+    // also has room for the data held back from previous buffers.
+    sp<Codec2Buffer> localBuffer = new LocalLinearBuffer(
+            mFormat, allocateLocalBuffer(clientBuffer->size() + mSkipCutBuffer->size()));
+    memcpy(localBuffer->base(), clientBuffer->data(), clientBuffer->size());
+    localBuffer->setRange(0, clientBuffer->size());
+    submit(localBuffer, buffer, false /* readOnly */);
+    return localBuffer;
 }
 
 std::function<sp<Codec2Buffer>()> LinearOutputBuffers::getAlloc() {
@@ -32,6 +32,7 @@
 namespace android {
 
 struct ICrypto;
+class LocalBufferPool;
 class MemoryDealer;
 class SkipCutBuffer;
 class MultiAccessUnitSkipCutBuffer;
@@ -393,13 +394,27 @@ protected:
      */
     void updateSkipCutBuffer(int32_t sampleRate, int32_t channelCount);
 
-    bool submit(const sp<MediaCodecBuffer> &buffer, int32_t sampleRate,
-            int32_t channelCount, std::shared_ptr<const C2AccessUnitInfos::output> &infos);
+    /**
+     * Submit |clientBuffer| holding the data of |buffer| to SkipCutBuffer
+     * object, with the access unit infos of |buffer| if any. No-op if
+     * SkipCutBuffer is not initialized.
+     *
+     * \param readOnly  whether |clientBuffer| is a read-only view of the data of
+     *                  |buffer|, in which case only its range may be changed.
+     * \return  false if |clientBuffer| is read-only and some of its data has to
+     *          be held back, in which case nothing was done and the data must be
+     *          submitted in a writable buffer instead; true otherwise.
+     */
+    bool submit(
+            const sp<MediaCodecBuffer> &clientBuffer,
+            const std::shared_ptr<C2Buffer> &buffer,
+            bool readOnly);
 
     /**
-     * Submit buffer to SkipCutBuffer object, if initialized.
+     * Return a buffer of at least |capacity| bytes to hold output data locally,
+     * recycling the memory of such buffers released by the client.
      */
-    void submit(const sp<MediaCodecBuffer> &buffer);
+    sp<ABuffer> allocateLocalBuffer(size_t capacity);
 
     /**
      * Apply DataConverter from |src| to |*dst| if needed. If |*dst| is nullptr,
@@ -418,6 +433,9 @@ private:
 
     void setSkipCutBuffer(int32_t skip, int32_t cut);
 
+    // Lazily created pool for allocateLocalBuffer().
+    std::shared_ptr<LocalBufferPool> mLocalLinearBufferPool;
+
     // DataConverter
     sp<DataConverter> mDataConverter;
     sp<AMessage> mFormatWithConverter;
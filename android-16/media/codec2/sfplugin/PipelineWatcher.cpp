@@ -17,6 +17,7 @@
 //#define LOG_NDEBUG 0
 #define LOG_TAG "PipelineWatcher"
 
+#include <algorithm>
 #include <numeric>
 
 #include <log/log.h>
@@ -25,6 +26,25 @@
 
 namespace android {
 
+namespace {
+
+// enough for the delays of most components without growing the ring
+constexpr size_t kInitialRingSize = 32;
+// beyond this, frames held much longer than the others are kept aside instead
+constexpr size_t kMaxRingSize = 1024;
+
+}  // namespace
+
+PipelineWatcher::PipelineWatcher()
+    : mInputDelay(0),
+      mPipelineDelay(0),
+      mOutputDelay(0),
+      mSmoothnessFactor(0),
+      mTunneled(false),
+      mFrames(kInitialRingSize),
+      mNumFrames(0),
+      mNumFramesWithInputReleased(0) {}
+
 PipelineWatcher &PipelineWatcher::inputDelay(uint32_t value) {
     mInputDelay = value;
     return *this;
@@ -50,6 +70,48 @@ PipelineWatcher &PipelineWatcher::tunneled(bool value) {
     return *this;
 }
 
+PipelineWatcher::Frame *PipelineWatcher::find_l(uint64_t frameIndex) {
+    Frame &frame = mFrames[frameIndex & (mFrames.size() - 1)];
+    if (frame.inPipeline && frame.frameIndex == frameIndex) {
+        return &frame;
+    }
+    if (!mOutliers.empty()) {
+        auto it = mOutliers.find(frameIndex);
+        if (it != mOutliers.end()) {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+void PipelineWatcher::remove_l(Frame *frame) {
+    if (frame->numPendingInputs == 0) {
+        --mNumFramesWithInputReleased;
+    }
+    --mNumFrames;
+    frame->inPipeline = false;
+    // keeps the capacity for the next frame using this entry
+    frame->buffers.clear();
+    frame->numPendingInputs = 0;
+    if (!mOutliers.empty()) {
+        auto it = mOutliers.find(frame->frameIndex);
+        if (it != mOutliers.end() && &it->second == frame) {
+            mOutliers.erase(it);
+        }
+    }
+}
+
+void PipelineWatcher::grow_l() {
+    std::vector<Frame> frames(mFrames.size() * 2);
+    for (Frame &frame : mFrames) {
+        if (frame.inPipeline) {
+            frames[frame.frameIndex & (frames.size() - 1)] = std::move(frame);
+        }
+    }
+    mFrames.swap(frames);
+    ALOGV("grow: %zu frames in pipeline, ring size %zu", mNumFrames.load(), mFrames.size());
+}
+
 void PipelineWatcher::onWorkQueued(
         uint64_t frameIndex,
         std::vector<std::shared_ptr<C2Buffer>> &&buffers,
@@ -58,40 +120,71 @@ void PipelineWatcher::onWorkQueued(
           (unsigned long long)frameIndex,
           buffers.size(),
           (long long)queuedAt.time_since_epoch().count());
-    auto it = mFramesInPipeline.find(frameIndex);
-    if (it != mFramesInPipeline.end()) {
+    std::lock_guard<std::mutex> lock(mLock);
+    Frame *frame = find_l(frameIndex);
+    if (frame) {
         ALOGD("onWorkQueued: Duplicate frame index (%llu); previous entry removed",
               (unsigned long long)frameIndex);
-        (void)mFramesInPipeline.erase(it);
+        remove_l(frame);
     }
-    (void)mFramesInPipeline.try_emplace(frameIndex, std::move(buffers), queuedAt);
+    // Frame indices are sequential, so this only happens when the frames in the
+    // pipeline span more indices than the ring has entries.
+    frame = &mFrames[frameIndex & (mFrames.size() - 1)];
+    while (frame->inPipeline) {
+        if (mFrames.size() >= kMaxRingSize || mNumFrames * 2 < mFrames.size()) {
+            // a few frames held for long; growing would not make room for long
+            ALOGV("onWorkQueued: frame %llu kept aside for frame %llu",
+                  (unsigned long long)frame->frameIndex, (unsigned long long)frameIndex);
+            mOutliers[frame->frameIndex] = std::move(*frame);
+            *frame = Frame();
+            break;
+        }
+        grow_l();
+        frame = &mFrames[frameIndex & (mFrames.size() - 1)];
+    }
+    frame->inPipeline = true;
+    frame->frameIndex = frameIndex;
+    frame->buffers = std::move(buffers);
+    frame->numPendingInputs = std::count_if(
+            frame->buffers.begin(), frame->buffers.end(),
+            [](const std::shared_ptr<C2Buffer> &buffer) { return buffer != nullptr; });
+    frame->queuedAt = queuedAt;
+    if (frame->numPendingInputs == 0) {
+        ++mNumFramesWithInputReleased;
+    }
+    ++mNumFrames;
 }
 
 std::shared_ptr<C2Buffer> PipelineWatcher::onInputBufferReleased(
         uint64_t frameIndex, size_t arrayIndex) {
     ALOGV("onInputBufferReleased(frameIndex=%llu, arrayIndex=%zu)",
           (unsigned long long)frameIndex, arrayIndex);
-    auto it = mFramesInPipeline.find(frameIndex);
-    if (it == mFramesInPipeline.end()) {
+    std::lock_guard<std::mutex> lock(mLock);
+    Frame *frame = find_l(frameIndex);
+    if (!frame) {
         ALOGD("onInputBufferReleased: frameIndex not found (%llu); ignored",
               (unsigned long long)frameIndex);
         return nullptr;
     }
-    if (it->second.buffers.size() <= arrayIndex) {
+    if (frame->buffers.size() <= arrayIndex) {
         ALOGD("onInputBufferReleased: buffers at %llu: size %zu, requested index: %zu",
-              (unsigned long long)frameIndex, it->second.buffers.size(), arrayIndex);
+              (unsigned long long)frameIndex, frame->buffers.size(), arrayIndex);
         return nullptr;
     }
-    std::shared_ptr<C2Buffer> buffer(std::move(it->second.buffers[arrayIndex]));
+    std::shared_ptr<C2Buffer> buffer(std::move(frame->buffers[arrayIndex]));
     ALOGD_IF(!buffer, "onInputBufferReleased: buffer already released (%llu:%zu)",
              (unsigned long long)frameIndex, arrayIndex);
+    if (buffer && --frame->numPendingInputs == 0) {
+        ++mNumFramesWithInputReleased;
+    }
     return buffer;
 }
 
 void PipelineWatcher::onWorkDone(uint64_t frameIndex) {
     ALOGV("onWorkDone(frameIndex=%llu)", (unsigned long long)frameIndex);
-    auto it = mFramesInPipeline.find(frameIndex);
-    if (it == mFramesInPipeline.end()) {
+    std::lock_guard<std::mutex> lock(mLock);
+    Frame *frame = find_l(frameIndex);
+    if (!frame) {
         if (!mTunneled) {
             ALOGD("onWorkDone: frameIndex not found (%llu); ignored",
                   (unsigned long long)frameIndex);
@@ -101,65 +194,82 @@ void PipelineWatcher::onWorkDone(uint64_t frameIndex) {
         }
         return;
     }
-    (void)mFramesInPipeline.erase(it);
+    remove_l(frame);
 }
 
 void PipelineWatcher::flush() {
     ALOGV("flush");
-    mFramesInPipeline.clear();
+    std::lock_guard<std::mutex> lock(mLock);
+    for (Frame &frame : mFrames) {
+        if (frame.inPipeline) {
+            remove_l(&frame);
+        }
+    }
+    while (!mOutliers.empty()) {
+        remove_l(&mOutliers.begin()->second);
+    }
 }
 
 bool PipelineWatcher::pipelineFull() const {
-    if (mFramesInPipeline.size() >=
-            mInputDelay + mPipelineDelay + mOutputDelay + mSmoothnessFactor) {
-        ALOGV("pipelineFull: too many frames in pipeline (%zu)", mFramesInPipeline.size());
+    // The counters are read without the lock, as a snapshot that may be slightly
+    // out of date like the result of this method.
+    const size_t size = mNumFrames.load(std::memory_order_relaxed);
+    const size_t sizeWithInputReleased =
+            std::min(size, mNumFramesWithInputReleased.load(std::memory_order_relaxed));
+    const uint32_t inputDelay = mInputDelay.load(std::memory_order_relaxed);
+    const uint32_t pipelineDelay = mPipelineDelay.load(std::memory_order_relaxed);
+    const uint32_t outputDelay = mOutputDelay.load(std::memory_order_relaxed);
+    const uint32_t smoothnessFactor = mSmoothnessFactor.load(std::memory_order_relaxed);
+    if (size >= inputDelay + pipelineDelay + outputDelay + smoothnessFactor) {
+        ALOGV("pipelineFull: too many frames in pipeline (%zu)", size);
         return true;
     }
-    size_t sizeWithInputReleased = std::count_if(
-            mFramesInPipeline.begin(),
-            mFramesInPipeline.end(),
-            [](const decltype(mFramesInPipeline)::value_type &value) {
-                for (const std::shared_ptr<C2Buffer> &buffer : value.second.buffers) {
-                    if (buffer) {
-                        return false;
-                    }
-                }
-                return true;
-            });
-    if (sizeWithInputReleased >=
-            mPipelineDelay + mOutputDelay + mSmoothnessFactor) {
+    if (sizeWithInputReleased >= pipelineDelay + outputDelay + smoothnessFactor) {
         ALOGV("pipelineFull: too many frames in pipeline, with input released (%zu)",
               sizeWithInputReleased);
         return true;
     }
 
-    size_t sizeWithInputsPending = mFramesInPipeline.size() - sizeWithInputReleased;
-    if (sizeWithInputsPending > mPipelineDelay + mInputDelay + mSmoothnessFactor) {
+    size_t sizeWithInputsPending = size - sizeWithInputReleased;
+    if (sizeWithInputsPending > pipelineDelay + inputDelay + smoothnessFactor) {
         ALOGV("pipelineFull: too many inputs pending (%zu) in pipeline, with inputs released (%zu)",
               sizeWithInputsPending, sizeWithInputReleased);
         return true;
     }
     ALOGV("pipeline has room (total: %zu, input released: %zu)",
-          mFramesInPipeline.size(), sizeWithInputReleased);
+          size, sizeWithInputReleased);
     return false;
 }
 
 PipelineWatcher::Clock::duration PipelineWatcher::elapsed(
         const PipelineWatcher::Clock::time_point &now, size_t n) const {
-    if (mFramesInPipeline.size() <= n) {
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mNumFrames <= n) {
         return Clock::duration::zero();
     }
     std::vector<Clock::duration> durations;
-    for (const decltype(mFramesInPipeline)::value_type &value : mFramesInPipeline) {
-        Clock::duration elapsed = now - value.second.queuedAt;
+    auto add = [&](const Frame &frame) {
+        Clock::duration elapsed = now - frame.queuedAt;
         ALOGV("elapsed: frameIndex = %llu elapsed = %lldms",
-              (unsigned long long)value.first,
+              (unsigned long long)frame.frameIndex,
               std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
         durations.push_back(elapsed);
+    };
+    for (const Frame &frame : mFrames) {
+        if (frame.inPipeline) {
+            add(frame);
+        }
+    }
+    for (const auto &[frameIndex, frame] : mOutliers) {
+        add(frame);
     }
     std::nth_element(durations.begin(), durations.begin() + n, durations.end(),
                      std::greater<Clock::duration>());
     return durations[n];
 }
 
+size_t PipelineWatcher::size() const {
+    return mNumFrames.load(std::memory_order_relaxed);
+}
+
 }  // namespace android
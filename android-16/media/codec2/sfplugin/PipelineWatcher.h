@@ -17,9 +17,12 @@
 #ifndef PIPELINE_WATCHER_H_
 #define PIPELINE_WATCHER_H_
 
+#include <atomic>
 #include <chrono>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <C2Work.h>
 
@@ -28,17 +31,20 @@ namespace android {
 /**
  * PipelineWatcher watches the pipeline and infers the status of work items from
  * events.
+ *
+ * This class is thread-safe. Events are recorded under a short internal lock
+ * into a ring of frames indexed by frame index, which only allocates when more
+ * frames are in flight than it has room for. A frame held by the component
+ * long after the frames behind it is moved out of the ring, so that it does not
+ * make the ring grow with every index it spans. pipelineFull() does not lock, so
+ * that the client and the component listener do not contend on it for every
+ * buffer.
  */
 class PipelineWatcher {
 public:
     typedef std::chrono::steady_clock Clock;
 
-    PipelineWatcher()
-        : mInputDelay(0),
-          mPipelineDelay(0),
-          mOutputDelay(0),
-          mSmoothnessFactor(0),
-          mTunneled(false) {}
+    PipelineWatcher();
     ~PipelineWatcher() = default;
 
     /**
@@ -124,22 +130,44 @@ public:
      */
     Clock::duration elapsed(const Clock::time_point &now, size_t n) const;
 
+    /**
+     * \return  number of work items in the pipeline.
+     */
+    size_t size() const;
+
 private:
-    uint32_t mInputDelay;
-    uint32_t mPipelineDelay;
-    uint32_t mOutputDelay;
-    uint32_t mSmoothnessFactor;
-    bool mTunneled;
+    std::atomic<uint32_t> mInputDelay;
+    std::atomic<uint32_t> mPipelineDelay;
+    std::atomic<uint32_t> mOutputDelay;
+    std::atomic<uint32_t> mSmoothnessFactor;
+    std::atomic<bool> mTunneled;
 
     struct Frame {
-        Frame(std::vector<std::shared_ptr<C2Buffer>> &&b,
-              const Clock::time_point &q)
-            : buffers(b),
-              queuedAt(q) {}
+        bool inPipeline = false;
+        uint64_t frameIndex = 0;
         std::vector<std::shared_ptr<C2Buffer>> buffers;
-        const Clock::time_point queuedAt;
+        // number of non-null entries in |buffers|
+        size_t numPendingInputs = 0;
+        Clock::time_point queuedAt;
     };
-    std::map<uint64_t, Frame> mFramesInPipeline;
+
+    mutable std::mutex mLock;
+    // Frames in the pipeline, at |frameIndex| modulo the size of the ring, which
+    // is a power of 2. The ring grows if two frames in the pipeline would use
+    // the same entry while it is at least half full, up to a maximum size.
+    std::vector<Frame> mFrames;
+    // Frames in the pipeline moved out of the ring to make room for a newer
+    // frame, by frame index. Usually empty.
+    std::map<uint64_t, Frame> mOutliers;
+    // Updated under |mLock|, read without it by pipelineFull().
+    std::atomic<size_t> mNumFrames;
+    std::atomic<size_t> mNumFramesWithInputReleased;
+
+    Frame *find_l(uint64_t frameIndex);
+    void remove_l(Frame *frame);
+    void grow_l();
+
+    friend class PipelineWatcherTest;
 };
 
 }  // namespace android
@@ -914,4 +914,67 @@ TEST(LinearOutputBuffersTest, PcmConvertFormat) {
     ASSERT_TRUE(buffers->releaseBuffer(clientBuffer, &c2Buffer));
 }
 
+// Each byte of the returned buffer holds its offset in the stream.
+static std::shared_ptr<C2Buffer> CreatePcmBuffer(
+        const std::shared_ptr<C2BlockPool> &pool, uint32_t size, uint32_t offset) {
+    std::shared_ptr<C2LinearBlock> block;
+    if (pool->fetchLinearBlock(
+            size, C2MemoryUsage{C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE},
+            &block) != C2_OK) {
+        return nullptr;
+    }
+    C2WriteView view = block->map().get();
+    for (uint32_t i = 0; i < size; ++i) {
+        view.data()[i] = offset + i;
+    }
+    return C2Buffer::CreateLinearBuffer(block->share(0, size, C2Fence()));
+}
+
+TEST(LinearOutputBuffersTest, SkipCut) {
+    constexpr int32_t kSampleRate = 8000;
+    constexpr int32_t kChannelCount = 1;
+    // in frames of 16-bit samples
+    constexpr int32_t kDelay = 16;
+    constexpr int32_t kPadding = 8;
+    constexpr uint32_t kBufferSize = 1024;
+
+    std::shared_ptr<C2BlockPool> pool;
+    ASSERT_EQ(OK, GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool));
+
+    for (int32_t padding : {0, kPadding}) {
+        std::shared_ptr<LinearOutputBuffers> buffers =
+            std::make_shared<LinearOutputBuffers>("test");
+        sp<AMessage> format{new AMessage};
+        format->setString(KEY_MIME, MIMETYPE_AUDIO_RAW);
+        format->setInt32(KEY_CHANNEL_COUNT, kChannelCount);
+        format->setInt32(KEY_SAMPLE_RATE, kSampleRate);
+        buffers->setFormat(format);
+        buffers->initSkipCutBuffer(kDelay, padding, kSampleRate, kChannelCount);
+
+        std::vector<uint8_t> output;
+        for (uint32_t i = 0; i < 3; ++i) {
+            std::shared_ptr<C2Buffer> c2Buffer =
+                CreatePcmBuffer(pool, kBufferSize, i * kBufferSize);
+            ASSERT_NE(nullptr, c2Buffer);
+            size_t index;
+            sp<MediaCodecBuffer> clientBuffer;
+            ASSERT_EQ(OK, buffers->registerBuffer(c2Buffer, &index, &clientBuffer));
+            // Without padding to cut, the client reads the component's block.
+            sp<Codec2Buffer> codec2Buffer = static_cast<Codec2Buffer *>(clientBuffer.get());
+            EXPECT_EQ(padding == 0, codec2Buffer->asC2Buffer() == c2Buffer);
+            output.insert(output.end(),
+                          clientBuffer->data(), clientBuffer->data() + clientBuffer->size());
+            std::shared_ptr<C2Buffer> released;
+            ASSERT_TRUE(buffers->releaseBuffer(clientBuffer, &released));
+        }
+
+        // The padding is held back, and cut if the stream ends here.
+        const size_t skipped = kDelay * kChannelCount * 2;
+        ASSERT_EQ(3 * kBufferSize - skipped - padding * kChannelCount * 2, output.size());
+        for (size_t i = 0; i < output.size(); ++i) {
+            ASSERT_EQ((uint8_t)(skipped + i), output[i]) << "at " << i;
+        }
+    }
+}
+
 } // namespace android
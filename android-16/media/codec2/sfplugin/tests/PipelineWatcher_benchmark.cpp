@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <C2PlatformSupport.h>
+#include <benchmark/benchmark.h>
+
+#include "PipelineWatcher.h"
+
+using namespace android;
+
+constexpr uint64_t kNumFrames = 10000;
+// same as CCodecBufferChannel
+constexpr uint32_t kSmoothnessFactor = 4;
+
+static std::shared_ptr<C2Buffer> createInputBuffer() {
+    std::shared_ptr<C2BlockPool> pool;
+    if (GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool) != C2_OK) {
+        return nullptr;
+    }
+    std::shared_ptr<C2LinearBlock> block;
+    if (pool->fetchLinearBlock(
+            1024, C2MemoryUsage{C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE},
+            &block) != C2_OK) {
+        return nullptr;
+    }
+    return C2Buffer::CreateLinearBuffer(block->share(0, 1024, C2Fence()));
+}
+
+/*
+ * Drives the pipeline accounting of CCodecBufferChannel with a fake component
+ * that completes every work as soon as it is queued. The client thread queues
+ * a work whenever the pipeline has room, and the listener thread releases its
+ * input and reports it done, checking for room as onWorkDone() does to feed
+ * the next input buffer. The number of buffers going through the pipeline per
+ * second is reported as items_per_second.
+ *
+ * Args: input delay, pipeline delay, output delay.
+ */
+static void BM_PipelineWatcherFakeComponent(benchmark::State &state) {
+    std::shared_ptr<C2Buffer> buffer = createInputBuffer();
+    if (!buffer) {
+        state.SkipWithError("Unable to allocate an input buffer");
+        return;
+    }
+    for (auto _ : state) {
+        PipelineWatcher watcher;
+        watcher.inputDelay(state.range(0))
+                .pipelineDelay(state.range(1))
+                .outputDelay(state.range(2))
+                .smoothnessFactor(kSmoothnessFactor);
+        std::atomic<uint64_t> numQueued{0};
+
+        std::thread listener([&watcher, &numQueued] {
+            for (uint64_t frameIndex = 0; frameIndex < kNumFrames; ) {
+                if (frameIndex >= numQueued.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                benchmark::DoNotOptimize(watcher.onInputBufferReleased(frameIndex, 0));
+                watcher.onWorkDone(frameIndex);
+                benchmark::DoNotOptimize(watcher.pipelineFull());
+                ++frameIndex;
+            }
+        });
+
+        for (uint64_t frameIndex = 0; frameIndex < kNumFrames; ) {
+            if (watcher.pipelineFull()) {
+                std::this_thread::yield();
+                continue;
+            }
+            watcher.onWorkQueued(frameIndex, {buffer}, PipelineWatcher::Clock::now());
+            numQueued.store(++frameIndex, std::memory_order_release);
+        }
+        listener.join();
+    }
+    state.SetItemsProcessed(state.iterations() * kNumFrames);
+}
+
+// No delays, the delays of a typical hardware decoder, and a deep pipeline as
+// used for high frame rate recording.
+BENCHMARK(BM_PipelineWatcherFakeComponent)
+        ->Args({0, 0, 0})
+        ->Args({4, 2, 16})
+        ->Args({16, 8, 64})
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
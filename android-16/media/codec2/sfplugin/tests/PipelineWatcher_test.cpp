@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PipelineWatcher.h"
+
+#include <gtest/gtest.h>
+
+#include <C2PlatformSupport.h>
+
+namespace android {
+
+class PipelineWatcherTest : public ::testing::Test {
+public:
+    void SetUp() override {
+        std::shared_ptr<C2BlockPool> pool;
+        ASSERT_EQ(C2_OK, GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool));
+        std::shared_ptr<C2LinearBlock> block;
+        ASSERT_EQ(C2_OK, pool->fetchLinearBlock(
+                1024, C2MemoryUsage{C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE},
+                &block));
+        mBuffer = C2Buffer::CreateLinearBuffer(block->share(0, 1024, C2Fence()));
+    }
+
+    void queue(uint64_t frameIndex) {
+        mWatcher.onWorkQueued(frameIndex, {mBuffer}, PipelineWatcher::Clock::now());
+    }
+
+    size_t ringSize() const {
+        return mWatcher.mFrames.size();
+    }
+
+    PipelineWatcher mWatcher;
+    std::shared_ptr<C2Buffer> mBuffer;
+};
+
+TEST_F(PipelineWatcherTest, PipelineFull) {
+    mWatcher.inputDelay(1).pipelineDelay(1).outputDelay(2).smoothnessFactor(1);
+
+    // more inputs pending than input + pipeline delay + smoothness factor
+    for (uint64_t i = 0; i < 3; ++i) {
+        queue(i);
+        EXPECT_FALSE(mWatcher.pipelineFull()) << "frame " << i;
+    }
+    queue(3);
+    EXPECT_TRUE(mWatcher.pipelineFull());
+
+    // as many frames with input released as pipeline + output delay + smoothness factor
+    for (uint64_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(mBuffer, mWatcher.onInputBufferReleased(i, 0)) << "frame " << i;
+        EXPECT_FALSE(mWatcher.pipelineFull()) << "frame " << i;
+    }
+    EXPECT_EQ(mBuffer, mWatcher.onInputBufferReleased(3, 0));
+    EXPECT_TRUE(mWatcher.pipelineFull());
+    EXPECT_EQ(nullptr, mWatcher.onInputBufferReleased(3, 0));
+
+    // as many frames as all delays + smoothness factor
+    mWatcher.onWorkDone(0);
+    EXPECT_FALSE(mWatcher.pipelineFull());
+    queue(4);
+    EXPECT_FALSE(mWatcher.pipelineFull());
+    queue(5);
+    EXPECT_EQ(5u, mWatcher.size());
+    EXPECT_TRUE(mWatcher.pipelineFull());
+
+    mWatcher.flush();
+    EXPECT_EQ(0u, mWatcher.size());
+    EXPECT_FALSE(mWatcher.pipelineFull());
+    EXPECT_EQ(nullptr, mWatcher.onInputBufferReleased(4, 0));
+}
+
+TEST_F(PipelineWatcherTest, ManyFramesInPipeline) {
+    constexpr uint64_t kNumFrames = 1000;
+
+    // frames completed out of order, and the first frame held until the end so
+    // that the frames in the pipeline span many more indices than they count
+    queue(0);
+    for (uint64_t i = 1; i < kNumFrames; ++i) {
+        queue(i);
+        if (i % 2 == 0) {
+            mWatcher.onWorkDone(i - 1);
+        }
+    }
+    EXPECT_EQ(kNumFrames / 2 + 1, mWatcher.size());
+    for (uint64_t i = 0; i < kNumFrames; ++i) {
+        if (i % 2 == 1 && i != kNumFrames - 1) {
+            EXPECT_EQ(nullptr, mWatcher.onInputBufferReleased(i, 0)) << "frame " << i;
+        } else {
+            EXPECT_EQ(mBuffer, mWatcher.onInputBufferReleased(i, 0)) << "frame " << i;
+        }
+    }
+    for (uint64_t i = 0; i < kNumFrames; ++i) {
+        mWatcher.onWorkDone(i);
+    }
+    EXPECT_EQ(0u, mWatcher.size());
+}
+
+TEST_F(PipelineWatcherTest, FrameHeldAcrossManyIndices) {
+    constexpr uint64_t kNumFrames = 20000;
+    constexpr uint64_t kInFlight = 4;
+    const size_t initialRingSize = ringSize();
+    const PipelineWatcher::Clock::time_point start = PipelineWatcher::Clock::now();
+
+    // the first frame is held while the others go through a short pipeline
+    mWatcher.onWorkQueued(0, {mBuffer}, start - std::chrono::seconds(1));
+    for (uint64_t i = 1; i < kNumFrames; ++i) {
+        queue(i);
+        if (i >= kInFlight) {
+            mWatcher.onWorkDone(i - kInFlight + 1);
+        }
+    }
+    EXPECT_EQ(kInFlight, mWatcher.size());
+    EXPECT_EQ(initialRingSize, ringSize());
+
+    // the held frame is still tracked
+    EXPECT_GE(mWatcher.elapsed(PipelineWatcher::Clock::now(), 0), std::chrono::seconds(1));
+    EXPECT_EQ(mBuffer, mWatcher.onInputBufferReleased(0, 0));
+    queue(0);
+    EXPECT_EQ(kInFlight, mWatcher.size());
+    mWatcher.onWorkDone(0);
+    EXPECT_EQ(kInFlight - 1, mWatcher.size());
+
+    queue(kNumFrames);
+    mWatcher.flush();
+    EXPECT_EQ(0u, mWatcher.size());
+    EXPECT_EQ(nullptr, mWatcher.onInputBufferReleased(kNumFrames, 0));
+    EXPECT_EQ(initialRingSize, ringSize());
+}
+
+TEST_F(PipelineWatcherTest, DuplicateFrameIndex) {
+    queue(0);
+    queue(0);
+    EXPECT_EQ(1u, mWatcher.size());
+    EXPECT_EQ(mBuffer, mWatcher.onInputBufferReleased(0, 0));
+    EXPECT_EQ(nullptr, mWatcher.onInputBufferReleased(0, 1));
+    mWatcher.onWorkDone(0);
+    EXPECT_EQ(0u, mWatcher.size());
+}
+
+TEST_F(PipelineWatcherTest, Elapsed) {
+    const PipelineWatcher::Clock::time_point now = PipelineWatcher::Clock::now();
+    for (uint64_t i = 0; i < 3; ++i) {
+        mWatcher.onWorkQueued(i, {mBuffer}, now - std::chrono::milliseconds(10 * (i + 1)));
+    }
+    EXPECT_EQ(std::chrono::milliseconds(30), mWatcher.elapsed(now, 0));
+    EXPECT_EQ(std::chrono::milliseconds(10), mWatcher.elapsed(now, 2));
+    EXPECT_EQ(PipelineWatcher::Clock::duration::zero(), mWatcher.elapsed(now, 3));
+}
+
+}  // namespace android
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <unistd.h>
+#include <media/VolumeRamp.h>
 #include "FlowGraphNode.h"
 #include "RampLinear.h"
 
@@ -69,14 +70,12 @@ int32_t RampLinear::onProcess(int32_t numFrames) {
     if (mRemaining > 0) { // Ramping? This doesn't happen very often.
         int32_t framesToRamp = std::min(framesLeft, mRemaining);
         framesLeft -= framesToRamp;
-        while (framesToRamp > 0) {
-            float currentLevel = interpolateCurrent();
-            for (int ch = 0; ch < channelCount; ch++) {
-                *outputBuffer++ = *inputBuffer++ * currentLevel;
-            }
-            mRemaining--;
-            framesToRamp--;
-        }
+        float currentLevel = interpolateCurrent();
+        android::volumeRamp<android::VOLUME_RAMP_LINEAR>(outputBuffer, inputBuffer,
+                framesToRamp, channelCount, &currentLevel, &mScaler);
+        outputBuffer += framesToRamp * channelCount;
+        inputBuffer += framesToRamp * channelCount;
+        mRemaining -= framesToRamp;
     }
 
     // Process any frames after the ramp.
@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <utility>
 
 #include <audio_utils/clock.h>
 #include <media/AidlConversion.h>
@@ -267,6 +268,8 @@ status_t StreamHalAidl::standby() {
     AUGMENT_LOG(D);
     TIME_CHECK();
     if (!mStream) return NO_INIT;
+    // A region obtained before standby must not be committed after it.
+    mTransferBuffer = nullptr;
     const auto state = getState();
     StreamDescriptor::Reply reply;
     switch (state) {
@@ -448,10 +451,7 @@ status_t StreamHalAidl::getXruns(int32_t *frames) {
     return OK;
 }
 
-status_t StreamHalAidl::transfer(void *buffer, size_t bytes, size_t *transferred) {
-    AUGMENT_LOG(V);
-    // TIME_CHECK();  // TODO(b/243839867) reenable only when optimized.
-    if (!mStream || mContext.getDataMQ() == nullptr) return NO_INIT;
+status_t StreamHalAidl::exitStandbyIfNeeded() {
     mWorkerTid.store(gettid(), std::memory_order_release);
     // Switch the stream into an active state if needed.
     // Note: in future we may add support for priming the audio pipeline
@@ -466,6 +466,16 @@ status_t StreamHalAidl::transfer(void *buffer, size_t bytes, size_t *transferred
             return INVALID_OPERATION;
         }
     }
+    return OK;
+}
+
+status_t StreamHalAidl::transfer(void *buffer, size_t bytes, size_t *transferred) {
+    AUGMENT_LOG(V);
+    // TIME_CHECK();  // TODO(b/243839867) reenable only when optimized.
+    if (!mStream || mContext.getDataMQ() == nullptr) return NO_INIT;
+    // The caller writes instead of committing an obtained region, e.g. when it was too short.
+    mTransferBuffer = nullptr;
+    RETURN_STATUS_IF_ERROR(exitStandbyIfNeeded());
     if (!mIsInput) {
         bytes = std::min(bytes, mContext.getDataMQ()->availableToWrite());
     }
@@ -498,6 +508,55 @@ status_t StreamHalAidl::transfer(void *buffer, size_t bytes, size_t *transferred
     return OK;
 }
 
+status_t StreamHalAidl::obtainTransferBuffer(size_t bytes, void **buffer, size_t *available) {
+    AUGMENT_LOG(V);
+    if (mIsInput) return INVALID_OPERATION;
+    if (!mStream || mContext.getDataMQ() == nullptr) return NO_INIT;
+    RETURN_STATUS_IF_ERROR(exitStandbyIfNeeded());
+    StreamContextAidl::DataMQ* dataMQ = mContext.getDataMQ();
+    bytes = std::min(bytes, dataMQ->availableToWrite());
+    StreamContextAidl::DataMQ::MemTransaction transaction;
+    if (bytes == 0 || !dataMQ->beginWrite(bytes, &transaction)) {
+        mTransferBuffer = nullptr;
+        *buffer = nullptr;
+        *available = 0;
+        return OK;
+    }
+    // Only the first region is returned, the caller falls back to 'write' if it is too short.
+    const auto region = transaction.getFirstRegion();
+    mTransferBuffer = region.getAddress();
+    *buffer = mTransferBuffer;
+    *available = std::min(bytes, region.getLength());
+    return OK;
+}
+
+status_t StreamHalAidl::commitTransfer(size_t bytes, size_t *transferred) {
+    AUGMENT_LOG(V);
+    if (mIsInput) return INVALID_OPERATION;
+    if (!mStream || mContext.getDataMQ() == nullptr) return NO_INIT;
+    if (mTransferBuffer == nullptr) {
+        AUGMENT_LOG(E, "no buffer obtained");
+        return INVALID_OPERATION;
+    }
+    void* const buffer = std::exchange(mTransferBuffer, nullptr);
+    if (!mContext.getDataMQ()->commitWrite(bytes)) {
+        AUGMENT_LOG(E, "failed to commit %zu bytes to data MQ", bytes);
+        return NOT_ENOUGH_DATA;
+    }
+    StreamDescriptor::Command burst =
+            StreamDescriptor::Command::make<StreamDescriptor::Command::Tag::burst>(bytes);
+    StreamDescriptor::Reply reply;
+    RETURN_STATUS_IF_ERROR(sendCommand(burst, &reply));
+    *transferred = reply.fmqByteCount;
+    if (*transferred > bytes) {
+        ALOGW("%s: HAL module wrote %zu bytes, which exceeds requested count %zu",
+                __func__, *transferred, bytes);
+        *transferred = bytes;
+    }
+    mStreamPowerLog.log(buffer, *transferred);
+    return OK;
+}
+
 status_t StreamHalAidl::pause(StreamDescriptor::Reply* reply) {
     AUGMENT_LOG(D);
     TIME_CHECK();
@@ -927,6 +986,20 @@ status_t StreamOutHalAidl::write(const void *buffer, size_t bytes, size_t *writt
     return transfer(const_cast<void*>(buffer), bytes, written);
 }
 
+status_t StreamOutHalAidl::obtainWriteBuffer(size_t bytes, void **buffer, size_t *available) {
+    if (buffer == nullptr || available == nullptr) {
+        return BAD_VALUE;
+    }
+    return obtainTransferBuffer(bytes, buffer, available);
+}
+
+status_t StreamOutHalAidl::commitWriteBuffer(size_t bytes, size_t *written) {
+    if (written == nullptr) {
+        return BAD_VALUE;
+    }
+    return commitTransfer(bytes, written);
+}
+
 status_t StreamOutHalAidl::getRenderPosition(uint64_t *dspFrames) {
     if (dspFrames == nullptr) {
         return BAD_VALUE;
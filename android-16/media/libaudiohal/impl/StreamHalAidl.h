@@ -262,8 +262,16 @@ class StreamHalAidl : public virtual StreamHalInterface, public ConversionHelper
     // Always returns non-negative values.
     status_t getXruns(int32_t *frames);
 
+    status_t exitStandbyIfNeeded();
+
     status_t transfer(void *buffer, size_t bytes, size_t *transferred);
 
+    // Zero-copy variant of 'transfer' for output streams. The region obtained by
+    // 'obtainTransferBuffer' is filled in by the caller, then written by 'commitTransfer'.
+    status_t obtainTransferBuffer(size_t bytes, void **buffer, size_t *available);
+
+    status_t commitTransfer(size_t bytes, size_t *transferred);
+
     status_t pause(
             ::aidl::android::hardware::audio::core::StreamDescriptor::Reply* reply = nullptr);
 
@@ -345,6 +353,10 @@ class StreamHalAidl : public virtual StreamHalInterface, public ConversionHelper
     // mStreamPowerLog is used for audio signal power logging.
     StreamPowerLog mStreamPowerLog;
     std::atomic<pid_t> mWorkerTid = -1;
+    // Region of the data MQ returned by 'obtainTransferBuffer', only used by the worker thread.
+    // Cleared by 'transfer' and 'standby', so that only the region obtained last, with no
+    // write in between, can be committed.
+    int8_t* mTransferBuffer = nullptr;
     int32_t mAidlInterfaceVersion = -1;
     bool mSupportsCreateMmapBuffer = false;
 };
@@ -370,6 +382,11 @@ class StreamOutHalAidl : public virtual StreamOutHalInterface,
     // Write audio buffer to driver.
     status_t write(const void *buffer, size_t bytes, size_t *written) override;
 
+    // Obtain a region of the data MQ, only supported for streams using an FMQ.
+    status_t obtainWriteBuffer(size_t bytes, void **buffer, size_t *available) override;
+
+    status_t commitWriteBuffer(size_t bytes, size_t *written) override;
+
     // Return the number of audio frames written by the audio dsp to DAC since
     // the output has exited standby.
     status_t getRenderPosition(uint64_t *dspFrames) override;
@@ -591,6 +591,15 @@ status_t StreamOutHalHidl::prepareForWriting(size_t bufferSize) {
     return OK;
 }
 
+status_t StreamOutHalHidl::obtainWriteBuffer(
+        size_t /*bytes*/, void** /*buffer*/, size_t* /*available*/) {
+    return INVALID_OPERATION;
+}
+
+status_t StreamOutHalHidl::commitWriteBuffer(size_t /*bytes*/, size_t* /*written*/) {
+    return INVALID_OPERATION;
+}
+
 status_t StreamOutHalHidl::getRenderPosition(uint64_t *dspFrames) {
     // TIME_CHECK();  // TODO(b/243839867) reenable only when optimized.
     if (mStream == 0) return NO_INIT;
@@ -139,6 +139,10 @@ class StreamOutHalHidl : public StreamOutHalInterface, public StreamHalHidl {
     // Write audio buffer to driver.
     virtual status_t write(const void *buffer, size_t bytes, size_t *written);
 
+    // Not supported, returns INVALID_OPERATION.
+    virtual status_t obtainWriteBuffer(size_t bytes, void **buffer, size_t *available);
+    virtual status_t commitWriteBuffer(size_t bytes, size_t *written);
+
     // Return the number of audio frames written by the audio dsp to DAC since
     // the output has exited standby.
     virtual status_t getRenderPosition(uint64_t *dspFrames);
@@ -152,6 +152,15 @@ status_t StreamOutHalLocal::write(const void *buffer, size_t bytes, size_t *writ
     }
 }
 
+status_t StreamOutHalLocal::obtainWriteBuffer(
+        size_t /*bytes*/, void** /*buffer*/, size_t* /*available*/) {
+    return INVALID_OPERATION;
+}
+
+status_t StreamOutHalLocal::commitWriteBuffer(size_t /*bytes*/, size_t* /*written*/) {
+    return INVALID_OPERATION;
+}
+
 status_t StreamOutHalLocal::getRenderPosition(uint64_t *dspFrames) {
     uint32_t halPosition;
     status_t status = mStream->get_render_position(mStream, &halPosition);
@@ -107,6 +107,10 @@ class StreamOutHalLocal : public StreamOutHalInterface, public StreamHalLocal {
     // Write audio buffer to driver.
     status_t write(const void *buffer, size_t bytes, size_t *written) override;
 
+    // Not supported, returns INVALID_OPERATION.
+    status_t obtainWriteBuffer(size_t bytes, void **buffer, size_t *available) override;
+    status_t commitWriteBuffer(size_t bytes, size_t *written) override;
+
     // Return the number of audio frames written by the audio dsp to DAC since
     // the output has exited standby.
     status_t getRenderPosition(uint64_t *dspFrames) override;
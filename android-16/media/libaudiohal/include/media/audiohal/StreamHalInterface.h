@@ -181,6 +181,16 @@ class StreamOutHalInterface : public virtual StreamHalInterface {
     // Write audio buffer to driver.
     virtual status_t write(const void *buffer, size_t bytes, size_t *written) = 0;
 
+    // Zero-copy alternative to write(). Obtains a contiguous region of the driver's buffer
+    // of at most 'bytes', returned in '*buffer' and '*available'. After filling in the region,
+    // commitWriteBuffer() has the same effect as write() of that data. A region which is not
+    // committed is discarded by the next call. Returns INVALID_OPERATION if not supported,
+    // in which case write() must be used.
+    virtual status_t obtainWriteBuffer(size_t bytes, void **buffer, size_t *available) = 0;
+
+    // Write the first 'bytes' of the region returned by obtainWriteBuffer() to the driver.
+    virtual status_t commitWriteBuffer(size_t bytes, size_t *written) = 0;
+
     // Return the number of audio frames written by the audio dsp to DAC since
     // the output has exited standby.
     virtual status_t getRenderPosition(uint64_t *dspFrames) = 0;
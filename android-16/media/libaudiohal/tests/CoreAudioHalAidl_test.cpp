@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <numeric>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -346,6 +347,95 @@ class StreamOutMock : public ::aidl::android::hardware::audio::core::BnStreamOut
     std::shared_ptr<StreamCommonMock> mCommon;
 };
 
+// Plays the HAL side of the stream worker: replies to the commands and drains the data MQ.
+class StreamOutWorkerMock {
+  public:
+    using Descriptor = ::aidl::android::hardware::audio::core::StreamDescriptor;
+
+    explicit StreamOutWorkerMock(size_t dataMQSizeBytes)
+        : mCommandMQ(1, true /*configureEventFlagWord*/),
+          mReplyMQ(1, true /*configureEventFlagWord*/),
+          mDataMQ(dataMQSizeBytes) {}
+    ~StreamOutWorkerMock() { stop(); }
+
+    void fillDescriptor(Descriptor* desc) {
+        desc->command = mCommandMQ.dupeDesc();
+        desc->reply = mReplyMQ.dupeDesc();
+        desc->frameSizeBytes = 2;
+        desc->bufferSizeFrames = mDataMQ.getQuantumCount() / desc->frameSizeBytes;
+        desc->audio.set<Descriptor::AudioBuffer::Tag::fmq>(mDataMQ.dupeDesc());
+    }
+    void start() {
+        mThread = std::thread([this] { run(); });
+    }
+    void stop() {
+        if (!mThread.joinable()) return;
+        const auto exit = Descriptor::Command::make<Descriptor::Command::Tag::halReservedExit>(0);
+        mCommandMQ.writeBlocking(&exit, 1);
+        mThread.join();
+    }
+    std::vector<int8_t> getReceivedData() {
+        std::lock_guard l(mLock);
+        return mReceivedData;
+    }
+    size_t getBurstCount() {
+        std::lock_guard l(mLock);
+        return mBurstCount;
+    }
+
+  private:
+    void run() {
+        Descriptor::Command command;
+        while (mCommandMQ.readBlocking(&command, 1)) {
+            Descriptor::Reply reply{};
+            reply.status = STATUS_OK;
+            switch (command.getTag()) {
+                case Descriptor::Command::Tag::halReservedExit:
+                    return;
+                case Descriptor::Command::Tag::start:
+                case Descriptor::Command::Tag::flush:
+                    mState = Descriptor::State::IDLE;
+                    break;
+                case Descriptor::Command::Tag::burst: {
+                    const size_t bytes = std::min(
+                            static_cast<size_t>(command.get<Descriptor::Command::Tag::burst>()),
+                            mDataMQ.availableToRead());
+                    std::vector<int8_t> data(bytes);
+                    if (bytes != 0 && !mDataMQ.read(data.data(), bytes)) {
+                        reply.status = STATUS_NOT_ENOUGH_DATA;
+                        break;
+                    }
+                    std::lock_guard l(mLock);
+                    mReceivedData.insert(mReceivedData.end(), data.begin(), data.end());
+                    ++mBurstCount;
+                    reply.fmqByteCount = bytes;
+                    mState = Descriptor::State::ACTIVE;
+                    break;
+                }
+                case Descriptor::Command::Tag::pause:
+                    mState = Descriptor::State::PAUSED;
+                    break;
+                case Descriptor::Command::Tag::standby:
+                    mState = Descriptor::State::STANDBY;
+                    break;
+                default:
+                    break;
+            }
+            reply.state = mState;
+            mReplyMQ.writeBlocking(&reply, 1);
+        }
+    }
+
+    StreamContext::CommandMQ mCommandMQ;
+    StreamContext::ReplyMQ mReplyMQ;
+    StreamContext::DataMQ mDataMQ;
+    Descriptor::State mState = Descriptor::State::STANDBY;
+    std::mutex mLock;
+    std::vector<int8_t> mReceivedData;
+    size_t mBurstCount = 0;
+    std::thread mThread;
+};
+
 class ModuleMock : public ::aidl::android::hardware::audio::core::BnModule,
                    public VendorParameterMock {
   public:
@@ -1069,6 +1159,120 @@ TEST_F(StreamHalAidlVendorParametersTest, SetInvalidVendorParameters) {
     EXPECT_EQ(0UL, mStreamCommon->getSyncParameters().size());
 }
 
+class StreamOutHalAidlTransferBufferTest : public testing::Test {
+  public:
+    static constexpr size_t kDataMQSizeBytes = 96;
+
+    void SetUp() override {
+        mWorker = std::make_unique<StreamOutWorkerMock>(kDataMQSizeBytes);
+        ::aidl::android::hardware::audio::core::StreamDescriptor descriptor;
+        mWorker->fillDescriptor(&descriptor);
+        StreamContextAidl context(descriptor, false /*isAsynchronous*/, 0,
+                                  false /*hasClipTransitionSupport*/);
+        ASSERT_TRUE(context.isValid());
+        mWorker->start();
+        struct audio_config config = AUDIO_CONFIG_INITIALIZER;
+        mStream = sp<StreamOutHalAidl>::make(
+                config, std::move(context), 0 /*nominalLatency*/,
+                ndk::SharedRefBase::make<StreamOutMock>(StreamContext()),
+                ndk::SharedRefBase::make<TestHalAdapterVendorExtension>(),
+                nullptr /*callbackBroker*/);
+    }
+    void TearDown() override {
+        mStream.clear();
+        mWorker.reset();
+    }
+
+  protected:
+    static std::vector<int8_t> makeData(size_t bytes, int8_t first) {
+        std::vector<int8_t> data(bytes);
+        std::iota(data.begin(), data.end(), first);
+        return data;
+    }
+    // Obtains a region of the data MQ and fills it from 'data', returns the available size.
+    size_t obtainAndFill(const std::vector<int8_t>& data) {
+        void* buffer = nullptr;
+        size_t available = 0;
+        EXPECT_EQ(OK, mStream->obtainWriteBuffer(data.size(), &buffer, &available));
+        EXPECT_NE(nullptr, buffer);
+        std::copy_n(data.begin(), std::min(available, data.size()), static_cast<int8_t*>(buffer));
+        return available;
+    }
+
+    std::unique_ptr<StreamOutWorkerMock> mWorker;
+    sp<StreamOutHalAidl> mStream;
+};
+
+TEST_F(StreamOutHalAidlTransferBufferTest, Commit) {
+    const auto data = makeData(32, 1);
+    EXPECT_EQ(data.size(), obtainAndFill(data));
+    size_t written = 0;
+    EXPECT_EQ(OK, mStream->commitWriteBuffer(data.size(), &written));
+    EXPECT_EQ(data.size(), written);
+    EXPECT_EQ(data, mWorker->getReceivedData());
+    EXPECT_EQ(1UL, mWorker->getBurstCount());
+}
+
+TEST_F(StreamOutHalAidlTransferBufferTest, PartialCommit) {
+    const auto data = makeData(64, 1);
+    EXPECT_EQ(data.size(), obtainAndFill(data));
+    size_t written = 0;
+    EXPECT_EQ(OK, mStream->commitWriteBuffer(20, &written));
+    EXPECT_EQ(20UL, written);
+    std::vector<int8_t> expected(data.begin(), data.begin() + 20);
+    EXPECT_EQ(expected, mWorker->getReceivedData());
+
+    // The data MQ is empty again, but only the part up to its end is contiguous.
+    const auto more = makeData(kDataMQSizeBytes, 21);
+    const size_t available = obtainAndFill(more);
+    EXPECT_EQ(kDataMQSizeBytes - 20, available);
+    EXPECT_EQ(OK, mStream->commitWriteBuffer(available, &written));
+    EXPECT_EQ(available, written);
+    expected.insert(expected.end(), more.begin(), more.begin() + available);
+    EXPECT_EQ(expected, mWorker->getReceivedData());
+    EXPECT_EQ(2UL, mWorker->getBurstCount());
+}
+
+TEST_F(StreamOutHalAidlTransferBufferTest, CommitWithoutObtain) {
+    size_t written = 0;
+    EXPECT_EQ(INVALID_OPERATION, mStream->commitWriteBuffer(16, &written));
+    const auto data = makeData(16, 1);
+    EXPECT_EQ(data.size(), obtainAndFill(data));
+    EXPECT_EQ(OK, mStream->commitWriteBuffer(data.size(), &written));
+    // A region can only be committed once.
+    EXPECT_EQ(INVALID_OPERATION, mStream->commitWriteBuffer(data.size(), &written));
+    EXPECT_EQ(data, mWorker->getReceivedData());
+    EXPECT_EQ(1UL, mWorker->getBurstCount());
+}
+
+TEST_F(StreamOutHalAidlTransferBufferTest, WriteDropsObtainedBuffer) {
+    const auto obtained = makeData(32, 1);
+    EXPECT_EQ(obtained.size(), obtainAndFill(obtained));
+    const auto data = makeData(16, 64);
+    size_t written = 0;
+    EXPECT_EQ(OK, mStream->write(data.data(), data.size(), &written));
+    EXPECT_EQ(data.size(), written);
+    EXPECT_EQ(INVALID_OPERATION, mStream->commitWriteBuffer(obtained.size(), &written));
+    EXPECT_EQ(data, mWorker->getReceivedData());
+    EXPECT_EQ(1UL, mWorker->getBurstCount());
+}
+
+TEST_F(StreamOutHalAidlTransferBufferTest, StandbyDropsObtainedBuffer) {
+    const auto obtained = makeData(32, 1);
+    EXPECT_EQ(obtained.size(), obtainAndFill(obtained));
+    EXPECT_EQ(OK, mStream->standby());
+    size_t written = 0;
+    EXPECT_EQ(INVALID_OPERATION, mStream->commitWriteBuffer(obtained.size(), &written));
+    EXPECT_TRUE(mWorker->getReceivedData().empty());
+    EXPECT_EQ(0UL, mWorker->getBurstCount());
+
+    // The stream leaves standby when a buffer is obtained again.
+    const auto data = makeData(16, 64);
+    EXPECT_EQ(data.size(), obtainAndFill(data));
+    EXPECT_EQ(OK, mStream->commitWriteBuffer(data.size(), &written));
+    EXPECT_EQ(data, mWorker->getReceivedData());
+}
+
 class Hal2AidlMapperTest : public testing::Test {
   public:
     void SetUp() override {
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_ACCUMULATE_OPS_H
+#define ANDROID_AUDIO_MIXER_ACCUMULATE_OPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define ACCUMULATE_USE_NEON (true)
+#include <arm_neon.h>
+#else
+#define ACCUMULATE_USE_NEON (false)
+#endif
+
+#if defined(__AVX2__)
+#define ACCUMULATE_USE_AVX2 (true)
+#define ACCUMULATE_USE_SSE (true)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#define ACCUMULATE_USE_AVX2 (false)
+#define ACCUMULATE_USE_SSE (true)
+#include <emmintrin.h>
+#else
+#define ACCUMULATE_USE_AVX2 (false)
+#define ACCUMULATE_USE_SSE (false)
+#endif
+
+namespace android {
+
+/*
+ * Multi-track accumulation.
+ *
+ * The per-track mixer hooks in AudioMixerOps.h walk the shared output buffer once
+ * per track.  With many active tracks on a thread the output buffer is loaded and
+ * stored as many times as there are tracks, and the channel position logic
+ * in stereoVolumeHelper() is re-evaluated on every frame of every track.
+ *
+ * accumulateTracks() instead mixes a block of up to kAccumulateMaxTracks tracks
+ * in one pass over the output buffer.  The volume for each track is supplied as a
+ * precomputed "gain row" of channels * kAccumulateGainFrames gains, which is the
+ * per output channel volume repeated kAccumulateGainFrames times.  Since the row
+ * length is a multiple of every vector width used here, the kernels can use
+ * straight vector loads for the gains regardless of the channel count.
+ *
+ * The accumulation order per sample is the same as calling the per-track hooks
+ * one after another (out += in0 * g0, then out += in1 * g1, ...), and no fused
+ * multiply-add is used, so the result is bit-exact with the scalar mixer.
+ *
+ *   TO: int32_t (Q4.27) or float
+ *   TI: int16_t (Q0.15) or float
+ *   TV: int16_t (U4.12) or float, the gain row type.
+ */
+
+// Maximum number of tracks accumulated per pass over the output buffer.
+constexpr size_t kAccumulateMaxTracks = 4;
+
+// Number of frames represented by one gain row.  Must be a multiple of 8.
+constexpr size_t kAccumulateGainFrames = 8;
+
+template <size_t NTRACKS, typename TO, typename TI, typename TV>
+static inline void accumulateTracksScalar(TO* out, size_t sampleCount,
+        const TI* const* in, const TV* const* gains, size_t inOffset, size_t gainOffset)
+{
+    for (size_t i = 0; i < sampleCount; ++i) {
+        TO acc = out[i];
+        for (size_t k = 0; k < NTRACKS; ++k) {
+            acc += static_cast<TO>(in[k][inOffset + i])
+                    * static_cast<TO>(gains[k][gainOffset + i]);
+        }
+        out[i] = acc;
+    }
+}
+
+#if ACCUMULATE_USE_NEON
+
+template <size_t NTRACKS>
+static inline void accumulateRowVector(float* out, size_t rowSamples,
+        const float* const* in, const float* const* gains, size_t inOffset)
+{
+    for (size_t j = 0; j < rowSamples; j += 4) {
+        float32x4_t acc = vld1q_f32(out + j);
+        for (size_t k = 0; k < NTRACKS; ++k) {
+            acc = vaddq_f32(acc,
+                    vmulq_f32(vld1q_f32(in[k] + inOffset + j), vld1q_f32(gains[k] + j)));
+        }
+        vst1q_f32(out + j, acc);
+    }
+}
+
+template <size_t NTRACKS>
+static inline void accumulateRowVector(int32_t* out, size_t rowSamples,
+        const int16_t* const* in, const int16_t* const* gains, size_t inOffset)
+{
+    for (size_t j = 0; j < rowSamples; j += 8) {
+        int32x4_t accLo = vld1q_s32(out + j);
+        int32x4_t accHi = vld1q_s32(out + j + 4);
+        for (size_t k = 0; k < NTRACKS; ++k) {
+            const int16x8_t samples = vld1q_s16(in[k] + inOffset + j);
+            const int16x8_t volume = vld1q_s16(gains[k] + j);
+            accLo = vmlal_s16(accLo, vget_low_s16(samples), vget_low_s16(volume));
+            accHi = vmlal_s16(accHi, vget_high_s16(samples), vget_high_s16(volume));
+        }
+        vst1q_s32(out + j, accLo);
+        vst1q_s32(out + j + 4, accHi);
+    }
+}
+
+#elif ACCUMULATE_USE_SSE
+
+template <size_t NTRACKS>
+static inline void accumulateRowVector(float* out, size_t rowSamples,
+        const float* const* in, const float* const* gains, size_t inOffset)
+{
+#if ACCUMULATE_USE_AVX2
+    for (size_t j = 0; j < rowSamples; j += 8) {
+        __m256 acc = _mm256_loadu_ps(out + j);
+        for (size_t k = 0; k < NTRACKS; ++k) {
+            // _mm256_fmadd_ps() would not be bit-exact with the scalar mixer.
+            acc = _mm256_add_ps(acc,
+                    _mm256_mul_ps(_mm256_loadu_ps(in[k] + inOffset + j),
+                            _mm256_loadu_ps(gains[k] + j)));
+        }
+        _mm256_storeu_ps(out + j, acc);
+    }
+#else
+    for (size_t j = 0; j < rowSamples; j += 4) {
+        __m128 acc = _mm_loadu_ps(out + j);
+        for (size_t k = 0; k < NTRACKS; ++k) {
+            acc = _mm_add_ps(acc,
+                    _mm_mul_ps(_mm_loadu_ps(in[k] + inOffset + j), _mm_loadu_ps(gains[k] + j)));
+        }
+        _mm_storeu_ps(out + j, acc);
+    }
+#endif
+}
+
+template <size_t NTRACKS>
+static inline void accumulateRowVector(int32_t* out, size_t rowSamples,
+        const int16_t* const* in, const int16_t* const* gains, size_t inOffset)
+{
+    for (size_t j = 0; j < rowSamples; j += 8) {
+        __m128i accLo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + j));
+        __m128i accHi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + j + 4));
+        for (size_t k = 0; k < NTRACKS; ++k) {
+            const __m128i samples =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(in[k] + inOffset + j));
+            const __m128i volume =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(gains[k] + j));
+            // full 32 bit products from the low and high halves of the 16 bit multiply.
+            const __m128i lo = _mm_mullo_epi16(samples, volume);
+            const __m128i hi = _mm_mulhi_epi16(samples, volume);
+            accLo = _mm_add_epi32(accLo, _mm_unpacklo_epi16(lo, hi));
+            accHi = _mm_add_epi32(accHi, _mm_unpackhi_epi16(lo, hi));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), accLo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j + 4), accHi);
+    }
+}
+
+#endif // ACCUMULATE_USE_SSE
+
+template <size_t NTRACKS, typename TO, typename TI, typename TV>
+static inline void accumulateTracksN(TO* out, size_t frameCount, uint32_t channels,
+        const TI* const* in, const TV* const* gains)
+{
+    const size_t rowSamples = channels * kAccumulateGainFrames;
+    size_t offset = 0;
+    for (size_t frames = frameCount; frames >= kAccumulateGainFrames;
+            frames -= kAccumulateGainFrames) {
+#if ACCUMULATE_USE_NEON || ACCUMULATE_USE_SSE
+        accumulateRowVector<NTRACKS>(out + offset, rowSamples, in, gains, offset);
+#else
+        accumulateTracksScalar<NTRACKS>(out + offset, rowSamples, in, gains, offset, 0);
+#endif
+        offset += rowSamples;
+    }
+    // The remaining frames are less than a gain row.
+    const size_t remaining = frameCount * channels - offset;
+    if (remaining > 0) {
+        accumulateTracksScalar<NTRACKS>(out + offset, remaining, in, gains, offset, 0);
+    }
+}
+
+/*
+ * Accumulates trackCount (1 to kAccumulateMaxTracks) interleaved tracks
+ * of the same channel count into out.
+ *
+ *   out:        output buffer of frameCount * channels samples, accumulated into.
+ *   in:         trackCount input pointers, each frameCount * channels samples.
+ *   gains:      trackCount gain rows, each channels * kAccumulateGainFrames gains.
+ */
+template <typename TO, typename TI, typename TV>
+inline void accumulateTracks(TO* out, size_t frameCount, uint32_t channels,
+        const TI* const* in, const TV* const* gains, size_t trackCount)
+{
+    switch (trackCount) {
+    case 1:
+        accumulateTracksN<1>(out, frameCount, channels, in, gains);
+        break;
+    case 2:
+        accumulateTracksN<2>(out, frameCount, channels, in, gains);
+        break;
+    case 3:
+        accumulateTracksN<3>(out, frameCount, channels, in, gains);
+        break;
+    case 4:
+        accumulateTracksN<4>(out, frameCount, channels, in, gains);
+        break;
+    default:
+        break;
+    }
+    static_assert(kAccumulateMaxTracks == 4, "update accumulateTracks() dispatch");
+}
+
+/*
+ * Fills a gain row from a per output channel volume array of channels entries.
+ */
+template <typename TV>
+inline void fillAccumulateGainRow(TV* row, const TV* channelVolume, uint32_t channels)
+{
+    for (size_t i = 0; i < kAccumulateGainFrames; ++i) {
+        for (uint32_t j = 0; j < channels; ++j) {
+            *row++ = channelVolume[j];
+        }
+    }
+}
+
+} // namespace android
+
+#endif /* ANDROID_AUDIO_MIXER_ACCUMULATE_OPS_H */
@@ -27,6 +27,7 @@
 #include <media/AudioMixerBase.h>
 #include <utils/Log.h>
 
+#include "AudioMixerAccumulateOps.h"
 #include "AudioMixerOps.h"
 
 // The FCC_2 macro refers to the Fixed Channel Count of 2 for the legacy integer mixer.
@@ -706,7 +707,15 @@ void AudioMixerBase::process__validate()
     // select the processing hooks
     mHook = &AudioMixerBase::process__nop;
     if (mEnabled.size() > 0) {
-        if (resampling) {
+        if (kUseAccumulateMixer && mEnabled.size() > 1) {
+            if (mOutputTemp.get() == nullptr) {
+                mOutputTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+            }
+            if (resampling && mResampleTemp.get() == nullptr) {
+                mResampleTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+            }
+            mHook = &AudioMixerBase::process__accumulate;
+        } else if (resampling) {
             if (mOutputTemp.get() == nullptr) {
                 mOutputTemp.reset(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
             }
@@ -1222,6 +1231,209 @@ void AudioMixerBase::process__genericResampling()
     }
 }
 
+// generic code for two or more tracks, with or without resampling.
+// Tracks which only need a constant volume are summed in blocks of up to
+// kAccumulateMaxTracks with a single pass over the mix buffer,
+// the others are mixed one by one with their track hook.
+void AudioMixerBase::process__accumulate()
+{
+    ALOGVV("process__accumulate\n");
+    int32_t * const outTemp = mOutputTemp.get(); // naked ptr
+
+    for (const auto &pair : mGroups) {
+        const auto &group = pair.second;
+        const std::shared_ptr<TrackBase> &t1 = mTracks[group[0]];
+
+        // clear temp buffer
+        memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
+
+        // Tracks are summed in group order, as the generic hooks do, so that float
+        // output stays bit-exact: a pending block is flushed before a track is
+        // mixed with its own hook.
+        TrackBase *block[kAccumulateMaxTracks];
+        size_t blockCount = 0;
+        for (const int name : group) {
+            TrackBase * const t = mTracks[name].get();
+            if (t->needs & NEEDS_RESAMPLE) {
+                if (blockCount > 0) {
+                    accumulateTrackBlock(outTemp, block, blockCount);
+                    blockCount = 0;
+                }
+                // the resampler acquires and releases the buffers itself.
+                mixTrack(t, outTemp);
+                continue;
+            }
+            t->buffer.frameCount = mFrameCount;
+            t->bufferProvider->getNextBuffer(&t->buffer);
+            t->mIn = t->buffer.raw;
+            // t->mIn == nullptr can happen if the track was flushed just after having
+            // been enabled for mixing.
+            if (t->mIn == nullptr) continue;
+
+            // only a full period can be accumulated, otherwise use the track hook.
+            if (t->buffer.frameCount == mFrameCount
+                    && t->mMixerInFormat == t1->mMixerInFormat
+                    && t->canAccumulate()) {
+                block[blockCount++] = t;
+                if (blockCount == kAccumulateMaxTracks) {
+                    accumulateTrackBlock(outTemp, block, blockCount);
+                    blockCount = 0;
+                }
+            } else {
+                if (blockCount > 0) {
+                    accumulateTrackBlock(outTemp, block, blockCount);
+                    blockCount = 0;
+                }
+                mixTrack(t, outTemp);
+            }
+        }
+        if (blockCount > 0) {
+            accumulateTrackBlock(outTemp, block, blockCount);
+        }
+        convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
+                outTemp, t1->mMixerInFormat, mFrameCount * t1->mMixerChannelCount);
+    }
+}
+
+// Mixes a single track into out with its track hook.
+// For a track without resampling, the first buffer must already be acquired in t->buffer.
+void AudioMixerBase::mixTrack(TrackBase *t, int32_t *out)
+{
+    int32_t *aux = NULL;
+    if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
+        aux = t->auxBuffer;
+    }
+    if (t->needs & NEEDS_RESAMPLE) {
+        (t->*t->hook)(out, mFrameCount, mResampleTemp.get() /* naked ptr */, aux);
+        return;
+    }
+    size_t outFrames = 0;
+    while (true) {
+        (t->*t->hook)(
+                out + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
+                mResampleTemp.get() /* naked ptr */,
+                aux != nullptr ? aux + outFrames : nullptr);
+        outFrames += t->buffer.frameCount;
+        t->bufferProvider->releaseBuffer(&t->buffer);
+        if (outFrames >= mFrameCount) break;
+
+        t->buffer.frameCount = mFrameCount - outFrames;
+        t->bufferProvider->getNextBuffer(&t->buffer);
+        t->mIn = t->buffer.raw;
+        if (t->mIn == nullptr) break;
+    }
+}
+
+// Accumulates a block of tracks holding a full period of input into out,
+// then releases their buffers.
+void AudioMixerBase::accumulateTrackBlock(
+        int32_t *out, TrackBase * const *tracks, size_t trackCount)
+{
+    const uint32_t channels = tracks[0]->mMixerChannelCount;
+    switch (tracks[0]->mMixerInFormat) {
+    case AUDIO_FORMAT_PCM_FLOAT: {
+        float gainRows[kAccumulateMaxTracks][MAX_NUM_CHANNELS * kAccumulateGainFrames];
+        const float *in[kAccumulateMaxTracks];
+        const float *gains[kAccumulateMaxTracks];
+        for (size_t i = 0; i < trackCount; ++i) {
+            tracks[i]->getAccumulateGainRow(gainRows[i]);
+            in[i] = static_cast<const float *>(tracks[i]->mIn);
+            gains[i] = gainRows[i];
+        }
+        accumulateTracks(reinterpret_cast<float *>(out), mFrameCount, channels,
+                in, gains, trackCount);
+        } break;
+    case AUDIO_FORMAT_PCM_16_BIT: {
+        int16_t gainRows[kAccumulateMaxTracks][MAX_NUM_CHANNELS * kAccumulateGainFrames];
+        const int16_t *in[kAccumulateMaxTracks];
+        const int16_t *gains[kAccumulateMaxTracks];
+        for (size_t i = 0; i < trackCount; ++i) {
+            tracks[i]->getAccumulateGainRow(gainRows[i]);
+            in[i] = static_cast<const int16_t *>(tracks[i]->mIn);
+            gains[i] = gainRows[i];
+        }
+        accumulateTracks(out, mFrameCount, channels, in, gains, trackCount);
+        } break;
+    default:
+        LOG_ALWAYS_FATAL("bad mixerInFormat: %#x", tracks[0]->mMixerInFormat);
+        break;
+    }
+    for (size_t i = 0; i < trackCount; ++i) {
+        tracks[i]->bufferProvider->releaseBuffer(&tracks[i]->buffer);
+    }
+}
+
+bool AudioMixerBase::TrackBase::canAccumulate()
+{
+    if ((needs & (NEEDS_MUTE | NEEDS_RESAMPLE | NEEDS_AUX)) != 0 || needsRamp()) {
+        return false;
+    }
+    // MONO_HACK: mono tracks are expanded by the track hook.
+    if (channelMask == AUDIO_CHANNEL_OUT_MONO && isAudioChannelPositionMask(mMixerChannelMask)) {
+        return false;
+    }
+    // the stereo volume hooks ignore channel counts without a canonical mask.
+    if (useStereoVolume()
+            && canonicalChannelMaskFromCount(mMixerChannelCount) == AUDIO_CHANNEL_NONE) {
+        return false;
+    }
+    return mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT
+            || mMixerInFormat == AUDIO_FORMAT_PCM_16_BIT;
+}
+
+/* The per output channel volume matches the MIXTYPE chosen by getTrackHook()
+ * for TRACKTYPE_NORESAMPLE and TRACKTYPE_NORESAMPLESTEREO:
+ *
+ *   MIXTYPE_MULTI_STEREOVOL: left, right or center (average) volume by channel position.
+ *   MIXTYPE_MULTI:           volume[i] for 1 or 2 channels, volume[0] otherwise.
+ *
+ * TV: float (mVolume) or int16_t (volume, U4.12).
+ */
+template <typename TV>
+void AudioMixerBase::TrackBase::getAccumulateGainRow(TV *row) const
+{
+    const TV *vol;
+    if constexpr (std::is_same_v<TV, float>) {
+        vol = mVolume;
+    } else {
+        vol = volume;
+    }
+    TV channelVolume[MAX_NUM_CHANNELS];
+    if (useStereoVolume()) {
+        using namespace audio_utils::channels;
+        TV center;
+        if constexpr (std::is_floating_point_v<TV>) {
+            center = (vol[0] + vol[1]) * 0.5;       // do not use divide
+        } else {
+            center = (vol[0] >> 1) + (vol[1] >> 1); // rounds to 0.
+        }
+        constexpr uint32_t LFE_LFE2 =
+                AUDIO_CHANNEL_OUT_LOW_FREQUENCY | AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2;
+        uint32_t mask = canonicalChannelMaskFromCount(mMixerChannelCount);
+        const bool hasLfeLfe2 = (mask & LFE_LFE2) == LFE_LFE2;
+        for (size_t i = 0; mask != 0; ++i) {
+            const int index = __builtin_ctz(mask);
+            const uint32_t bit = 1u << index;
+            const AUDIO_GEOMETRY_SIDE side = sideFromChannelIdx(index);
+            if (side == AUDIO_GEOMETRY_SIDE_LEFT
+                    || (hasLfeLfe2 && bit == AUDIO_CHANNEL_OUT_LOW_FREQUENCY)) {
+                channelVolume[i] = vol[0];
+            } else if (side == AUDIO_GEOMETRY_SIDE_RIGHT
+                    || (hasLfeLfe2 && bit == AUDIO_CHANNEL_OUT_LOW_FREQUENCY_2)) {
+                channelVolume[i] = vol[1];
+            } else {
+                channelVolume[i] = center;
+            }
+            mask &= ~bit;
+        }
+    } else {
+        for (uint32_t i = 0; i < mMixerChannelCount; ++i) {
+            channelVolume[i] = vol[mMixerChannelCount <= FCC_2 ? i : 0];
+        }
+    }
+    fillAccumulateGainRow(row, channelVolume, mMixerChannelCount);
+}
+
 // one track, 16 bits stereo without resampling is the most common case
 void AudioMixerBase::process__oneTrack16BitsStereoNoResampling()
 {
@@ -19,6 +19,7 @@
 
 #include <audio_utils/channels.h>
 #include <audio_utils/primitives.h>
+#include <media/VolumeRamp.h>
 #include <system/audio.h>
 
 namespace android {
@@ -437,6 +438,32 @@ inline void volumeRampMulti(TO* out, size_t frameCount,
 #ifdef ALOGVV
     ALOGVV("volumeRampMulti, MIXTYPE:%d\n", MIXTYPE);
 #endif
+    // Float ramps without aux, where each output channel takes its own input channel and
+    // volume or volume[0], use the vectorized ramp of VolumeRamp.h.  It computes the volume
+    // of each frame as vol + volinc * n, rather than by adding volinc frame by frame as the
+    // loops below do, so the ramped samples may differ from the loops in the last bits.
+    //
+    // The other variants keep the loops below:
+    // - integer mixing works in Q4.27 with U4.12 or U4.28 volumes and no saturation,
+    //   while volumeRamp() takes Q0.15 or Q0.31 samples and saturates them.
+    // - aux ramps also accumulate the mean of each frame into the aux buffer, at its own
+    //   ramped volume, which volumeRamp() has no output for.
+    // - the STEREOVOL and EXPAND variants map the channels through stereoVolumeHelper().
+    if constexpr (std::is_same_v<TO, float> && std::is_same_v<TI, float>
+            && std::is_same_v<TV, float>
+            && (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY
+                    || MIXTYPE == MIXTYPE_MULTI_MONOVOL
+                    || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL)) {
+        if (aux == NULL) {
+            constexpr bool ACCUMULATE =
+                    MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_MONOVOL;
+            constexpr size_t volumeCount =
+                    MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY ? NCHAN : 1;
+            volumeRamp<VOLUME_RAMP_LINEAR, ACCUMULATE>(
+                    out, in, frameCount, NCHAN, vol, volinc, volumeCount);
+            return;
+        }
+    }
     if (aux != NULL) {
         do {
             TA auxaccum = 0;
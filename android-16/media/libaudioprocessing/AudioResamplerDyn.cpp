@@ -18,11 +18,17 @@
 //#define LOG_NDEBUG 0
 
 #include <malloc.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <dlfcn.h>
 #include <math.h>
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
 #include <cutils/compiler.h>
 #include <cutils/properties.h>
 #include <utils/Log.h>
@@ -32,6 +38,8 @@
 #include "AudioResamplerFirProcess.h"
 #include "AudioResamplerFirProcessNeon.h"
 #include "AudioResamplerFirProcessSSE.h"
+#include "AudioResamplerFirProcessAVX.h"
+#include "AudioResamplerFirProcessMulti.h"
 #include "AudioResamplerFirGen.h" // requires math.h
 #include "AudioResamplerDyn.h"
 
@@ -42,6 +50,129 @@ constexpr size_t CACHE_LINE_SIZE = 64;
 
 namespace android {
 
+/*
+ * FilterCache shares the polyphase filter banks designed by createKaiserFir()
+ * between all the AudioResamplerDyn instances of the process.
+ *
+ * A filter bank depends only on the coefficient type and the design parameters
+ * which setSampleRate() derives from the sample rate ratio and the quality.
+ * Once designed it is immutable, and it is freed when the last resampler using
+ * it releases its reference: the cache only holds weak references.
+ */
+class FilterCache {
+public:
+    enum coef_type {
+        COEF_INT16,
+        COEF_INT32,
+        COEF_FLOAT,
+    };
+
+    template<typename TC>
+    static constexpr coef_type coefTypeOf() {
+        if constexpr (is_same<TC, int16_t>::value) {
+            return COEF_INT16;
+        } else if constexpr (is_same<TC, int32_t>::value) {
+            return COEF_INT32;
+        } else {
+            static_assert(is_same<TC, float>::value, "unsupported coefficient type");
+            return COEF_FLOAT;
+        }
+    }
+
+    struct Key {
+        coef_type coefType;
+        int phases;
+        int halfLength;
+        double stopBandAtten;
+        double fcr;
+
+        bool operator<(const Key& other) const {
+            return std::tie(coefType, phases, halfLength, stopBandAtten, fcr)
+                    < std::tie(other.coefType, other.phases, other.halfLength,
+                            other.stopBandAtten, other.fcr);
+        }
+    };
+
+    static FilterCache& getInstance() {
+        // never deleted, as resamplers may be destroyed after static destructors run.
+        static FilterCache* const cache = new FilterCache();
+        return *cache;
+    }
+
+    // Returns the filter bank for key, or nullptr if it must be designed by the caller.
+    std::shared_ptr<const void> find(const Key& key) {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = mFilters.find(key);
+        if (it != mFilters.end()) {
+            std::shared_ptr<const void> filter = it->second.filter.lock();
+            if (filter != nullptr) {
+                ++mHits;
+                return filter;
+            }
+        }
+        ++mMisses;
+        return nullptr;
+    }
+
+    // Adds a newly designed filter bank of the given size in bytes.
+    // The filter is designed without holding the lock, so another resampler may
+    // have added the same one meanwhile; the filter to use is returned.
+    std::shared_ptr<const void> insert(const Key& key,
+            std::shared_ptr<const void> filter, size_t bytes) {
+        std::lock_guard<std::mutex> lock(mLock);
+        for (auto it = mFilters.begin(); it != mFilters.end(); ) {
+            if (it->second.filter.expired()) {
+                it = mFilters.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        auto [it, inserted] = mFilters.try_emplace(key, Entry{filter, bytes});
+        if (!inserted) {
+            std::shared_ptr<const void> existing = it->second.filter.lock();
+            if (existing != nullptr) {
+                return existing;
+            }
+            it->second = Entry{filter, bytes};
+        }
+        return filter;
+    }
+
+    std::string toString() {
+        std::lock_guard<std::mutex> lock(mLock);
+        size_t filters = 0;
+        size_t bytes = 0;
+        for (const auto& [key, entry] : mFilters) {
+            if (!entry.filter.expired()) {
+                ++filters;
+                bytes += entry.bytes;
+            }
+        }
+        char buffer[128];
+        snprintf(buffer, sizeof(buffer),
+                "Resampler filter cache: %zu filters %zu bytes, %llu hits %llu misses\n",
+                filters, bytes, (unsigned long long)mHits, (unsigned long long)mMisses);
+        return buffer;
+    }
+
+private:
+    struct Entry {
+        std::weak_ptr<const void> filter;
+        size_t bytes;
+    };
+
+    std::mutex mLock;
+    std::map<Key, Entry> mFilters;  // guarded by mLock
+    uint64_t mHits = 0;             // guarded by mLock
+    uint64_t mMisses = 0;           // guarded by mLock
+};
+
+/* static */
+std::string AudioResampler::filterCacheToString()
+{
+    return FilterCache::getInstance().toString();
+}
+
 /*
  * InBuffer is a type agnostic input buffer.
  *
@@ -181,8 +312,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +337,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -263,24 +392,32 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     const int phases = c.mL;
     const int halfLength = c.mHalfNumCoefs;
 
-    // create buffer
-    TC *coefs = nullptr;
-    int ret = posix_memalign(
-            reinterpret_cast<void **>(&coefs),
-            CACHE_LINE_SIZE /* alignment */,
-            (phases + 1) * halfLength * sizeof(TC));
-    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
-
     // square the computed minimum passband value (extra safety).
     double attenuation =
             computeWindowedSincMinimumPassbandValue(stopBandAtten);
     attenuation *= attenuation;
 
-    // design filter
-    firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    // reuse the filter of another resampler with the same design, if any.
+    FilterCache& cache = FilterCache::getInstance();
+    const FilterCache::Key key{
+            FilterCache::coefTypeOf<TC>(), phases, halfLength, stopBandAtten, fcr};
+    std::shared_ptr<const void> filter = cache.find(key);
+    if (filter == nullptr) {
+        // create buffer
+        TC *coefs = nullptr;
+        const size_t bytes = (phases + 1) * halfLength * sizeof(TC);
+        int ret = posix_memalign(
+                reinterpret_cast<void **>(&coefs),
+                CACHE_LINE_SIZE /* alignment */,
+                bytes);
+        LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
+
+        // design filter
+        firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+        filter = cache.insert(key, std::shared_ptr<const void>(coefs, free), bytes);
+    }
+    mCoefs = std::static_pointer_cast<const TC>(filter);
+    c.mFirCoefs = mCoefs.get();
 
     // update the design criteria
     mNormalizedCutoffFrequency = fcr;
@@ -306,7 +443,7 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
 
     const int32_t passSteps = 1000;
 
-    testFir(coefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
+    testFir(c.mFirCoefs, c.mL, c.mHalfNumCoefs, fp, fs, passSteps, passSteps * c.mL /*stopSteps*/,
             passMin, passMax, passRipple, stopMax, stopRipple);
     ALOGD("passband(%lf, %lf): %.8lf %.8lf %.8lf\n", 0., fp, passMin, passMax, passRipple);
     ALOGD("stopband(%lf, %lf): %.8lf %.3lf\n", fs, 0.5, stopMax, stopRipple);
@@ -615,6 +752,41 @@ void AudioResamplerDyn<TC, TI, TO>::setSampleRate(int32_t inSampleRate)
     }
 #pragma pop_macro("AUDIORESAMPLERDYN_CASE")
 
+#if USE_FIR_KERNEL_X86
+    // Replace the compile time selected float kernel with a wider one if the CPU has it.
+    if constexpr (is_same<TC, float>::value && is_same<TI, float>::value
+            && is_same<TO, float>::value) {
+        const int kernel = firKernelX86();
+        if (kernel == FIR_KERNEL_X86_AVX512) {
+            switch (mChannelCount) {
+            case 1:
+                mResampleFunc = locked
+                        ? &AudioResamplerDyn<TC, TI, TO>::resampleAVX512<1, true>
+                        : &AudioResamplerDyn<TC, TI, TO>::resampleAVX512<1, false>;
+                break;
+            case 2:
+                mResampleFunc = locked
+                        ? &AudioResamplerDyn<TC, TI, TO>::resampleAVX512<2, true>
+                        : &AudioResamplerDyn<TC, TI, TO>::resampleAVX512<2, false>;
+                break;
+            }
+        } else if (kernel == FIR_KERNEL_X86_AVX2) {
+            switch (mChannelCount) {
+            case 1:
+                mResampleFunc = locked
+                        ? &AudioResamplerDyn<TC, TI, TO>::resampleAVX2<1, true>
+                        : &AudioResamplerDyn<TC, TI, TO>::resampleAVX2<1, false>;
+                break;
+            case 2:
+                mResampleFunc = locked
+                        ? &AudioResamplerDyn<TC, TI, TO>::resampleAVX2<2, true>
+                        : &AudioResamplerDyn<TC, TI, TO>::resampleAVX2<2, false>;
+                break;
+            }
+        }
+    }
+#endif
+
 #ifdef DEBUG_RESAMPLER
     printf("channels:%d  %s  stride:%d  %s  coef:%d  shift:%d\n",
             mChannelCount, locked ? "locked" : "interpolated",
@@ -633,6 +805,37 @@ template<typename TC, typename TI, typename TO>
 template<int CHANNELS, bool LOCKED, int STRIDE>
 size_t AudioResamplerDyn<TC, TI, TO>::resample(TO* out, size_t outFrameCount,
         AudioBufferProvider* provider)
+{
+    return resampleKernel<CHANNELS, LOCKED, STRIDE, 0 /* default fir() */>(
+            out, outFrameCount, provider);
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+template<typename TC, typename TI, typename TO>
+template<int CHANNELS, bool LOCKED>
+__attribute__((target("avx2,fma")))
+size_t AudioResamplerDyn<TC, TI, TO>::resampleAVX2(TO* out, size_t outFrameCount,
+        AudioBufferProvider* provider)
+{
+    return resampleKernel<CHANNELS, LOCKED, 16, FIR_KERNEL_X86_AVX2>(
+            out, outFrameCount, provider);
+}
+
+template<typename TC, typename TI, typename TO>
+template<int CHANNELS, bool LOCKED>
+__attribute__((target("avx512f,avx2,fma")))
+size_t AudioResamplerDyn<TC, TI, TO>::resampleAVX512(TO* out, size_t outFrameCount,
+        AudioBufferProvider* provider)
+{
+    return resampleKernel<CHANNELS, LOCKED, 16, FIR_KERNEL_X86_AVX512>(
+            out, outFrameCount, provider);
+}
+#endif
+
+template<typename TC, typename TI, typename TO>
+template<int CHANNELS, bool LOCKED, int STRIDE, int KERNEL>
+size_t AudioResamplerDyn<TC, TI, TO>::resampleKernel(TO* out, size_t outFrameCount,
+        AudioBufferProvider* provider)
 {
     // TODO Mono -> Mono is not supported. OUTPUT_CHANNELS reflects minimum of stereo out.
     const int OUTPUT_CHANNELS = (CHANNELS < 2) ? 2 : CHANNELS;
@@ -719,11 +922,38 @@ size_t AudioResamplerDyn<TC, TI, TO>::resample(TO* out, size_t outFrameCount,
             //        "  phaseFraction:%u  phaseWrapLimit:%u",
             //        inFrameCount, outputIndex, outFrameCount, phaseFraction, phaseWrapLimit);
             ALOG_ASSERT(phaseFraction < phaseWrapLimit);
-            fir<CHANNELS, LOCKED, STRIDE>(
-                    &out[outputIndex],
-                    phaseFraction, phaseWrapLimit,
-                    coefShift, halfNumCoefs, coefs,
-                    impulse, volumeSimd);
+#if USE_FIR_KERNEL_X86
+            if constexpr (KERNEL == FIR_KERNEL_X86_AVX512) {
+                firAVX512<CHANNELS, LOCKED>(
+                        &out[outputIndex],
+                        phaseFraction, phaseWrapLimit,
+                        coefShift, halfNumCoefs, coefs,
+                        impulse, volumeSimd);
+            } else if constexpr (KERNEL == FIR_KERNEL_X86_AVX2) {
+                firAVX2<CHANNELS, LOCKED>(
+                        &out[outputIndex],
+                        phaseFraction, phaseWrapLimit,
+                        coefShift, halfNumCoefs, coefs,
+                        impulse, volumeSimd);
+            } else
+#endif
+#if USE_FIR_MULTI
+            if constexpr (CHANNELS > 2 && is_same<TC, float>::value
+                    && is_same<TI, float>::value && is_same<TO, float>::value) {
+                firMulti<CHANNELS, LOCKED>(
+                        &out[outputIndex],
+                        phaseFraction, phaseWrapLimit,
+                        coefShift, halfNumCoefs, coefs,
+                        impulse, volumeSimd);
+            } else
+#endif
+            {
+                fir<CHANNELS, LOCKED, STRIDE>(
+                        &out[outputIndex],
+                        phaseFraction, phaseWrapLimit,
+                        coefShift, halfNumCoefs, coefs,
+                        impulse, volumeSimd);
+            }
 
             outputIndex += OUTPUT_CHANNELS;
 
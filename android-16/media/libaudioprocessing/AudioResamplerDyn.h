@@ -21,6 +21,8 @@
 #include <sys/types.h>
 #include <android/log.h>
 
+#include <memory>
+
 #include <media/AudioResampler.h>
 
 namespace android {
@@ -65,6 +67,10 @@ public:
         return mConstants.mHalfNumCoefs;
     }
 
+    int getFilterLength() const override {
+        return mConstants.mHalfNumCoefs * 2;
+    }
+
     const TC *getFilterCoefs() const {
         return mConstants.mFirCoefs;
     }
@@ -155,6 +161,23 @@ private:
     template<int CHANNELS, bool LOCKED, int STRIDE>
     size_t resample(TO* out, size_t outFrameCount, AudioBufferProvider* provider);
 
+    // Shared body of the resample() variants; KERNEL selects the fir() implementation.
+    template<int CHANNELS, bool LOCKED, int STRIDE, int KERNEL>
+    inline __attribute__((always_inline))
+    size_t resampleKernel(TO* out, size_t outFrameCount, AudioBufferProvider* provider);
+
+#if defined(__i386__) || defined(__x86_64__)
+    // float resample() using the AVX2 or AVX-512 fir kernels, for 1 or 2 channels.
+    // These are selected at runtime in setSampleRate() when supported by the CPU.
+    template<int CHANNELS, bool LOCKED>
+    __attribute__((target("avx2,fma")))
+    size_t resampleAVX2(TO* out, size_t outFrameCount, AudioBufferProvider* provider);
+
+    template<int CHANNELS, bool LOCKED>
+    __attribute__((target("avx512f,avx2,fma")))
+    size_t resampleAVX512(TO* out, size_t outFrameCount, AudioBufferProvider* provider);
+#endif
+
     // define a pointer to member function type for resample
     typedef size_t (AudioResamplerDyn<TC, TI, TO>::*resample_ABP_t)(TO* out,
             size_t outFrameCount, AudioBufferProvider* provider);
@@ -166,7 +189,8 @@ private:
      resample_ABP_t mResampleFunc;     // called function for resampling
             int32_t mFilterSampleRate; // designed filter sample rate.
         src_quality mFilterQuality;    // designed filter quality.
-              void* mCoefBuffer;       // if a filter is created, this is not null
+    std::shared_ptr<const TC> mCoefs;  // if a filter is created, this is not null,
+                                       // shared with resamplers of the same design
 
     // Property selected design parameters.
               // This will enable fixed high quality resampling.
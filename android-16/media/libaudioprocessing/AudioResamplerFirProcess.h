@@ -434,6 +434,35 @@ void fir(TO* const out,
     }
 }
 
+/*
+ * Computes the filter coefficient pointers and interpolation fraction as done by fir()
+ * for float coefficients.  Used by firAVX2(), firAVX512() and firMulti().
+ *
+ * For a locked phase, coefsP1 and coefsN1 are set to coefsP and coefsN, and lerpP is 0.
+ */
+template<bool LOCKED>
+static inline void firSetupFloat(const uint32_t phase, const uint32_t phaseWrapLimit,
+        const int coefShift, const int halfNumCoefs, const float* const coefs,
+        const float*& coefsP, const float*& coefsN,
+        const float*& coefsP1, const float*& coefsN1, float& lerpP)
+{
+    coefsP = coefs + (phase >> coefShift) * halfNumCoefs;
+    if (LOCKED) {
+        // locked polyphase (no interpolation)
+        coefsN = coefs + ((phaseWrapLimit - phase) >> coefShift) * halfNumCoefs;
+        coefsP1 = coefsP; // unused
+        coefsN1 = coefsN;
+        lerpP = 0.f;
+    } else {
+        // interpolated polyphase
+        coefsN = coefs + ((phaseWrapLimit - phase - 1) >> coefShift) * halfNumCoefs;
+        coefsP1 = coefsP + halfNumCoefs;
+        coefsN1 = coefsN + halfNumCoefs;
+        static const float scale = 1. / (65536. * 65536.); // scale phase bits to [0.0, 1.0)
+        lerpP = float(phase << (sizeof(phase)*8 - coefShift)) * scale;
+    }
+}
+
 } // namespace android
 
 #endif /*ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_H*/
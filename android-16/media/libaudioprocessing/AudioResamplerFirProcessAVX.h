@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX_H
+#define ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX_H
+
+namespace android {
+
+// depends on AudioResamplerFirOps.h, AudioResamplerFirProcess.h
+
+#if defined(__i386__) || defined(__x86_64__)
+#define USE_FIR_KERNEL_X86 (true)
+#else
+#define USE_FIR_KERNEL_X86 (false)
+#endif
+
+#if USE_FIR_KERNEL_X86
+// included in the namespace as the SSE headers are by AudioResamplerFirOps.h.
+#include <immintrin.h>
+
+//
+// AVX2 and AVX-512 kernels for the float polyphase filter, 1 or 2 channels.
+//
+// Unlike the NEON and SSE kernels, which are selected at compile time by specializing
+// Process() and ProcessL(), these are compiled with a function target attribute and
+// selected at runtime by AudioResamplerDyn::setSampleRate() through firKernelX86().
+// This allows a generic x86 build to use the full vector width of the host.
+//
+// The AVX2 kernel processes 8 positive and 8 negative coefficients per loop iteration,
+// which matches the existing requirement that halfNumCoefs is a multiple of 8.
+// The AVX-512 kernel processes 16 per iteration, with an AVX2 iteration for the remainder.
+//
+
+enum {
+    FIR_KERNEL_X86_DEFAULT, // the compile time selected SSE (or C++) kernel.
+    FIR_KERNEL_X86_AVX2,
+    FIR_KERNEL_X86_AVX512,
+};
+
+// Returns the best kernel supported by the CPU, determined once per process.
+static inline int firKernelX86()
+{
+    static const int kernel = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return FIR_KERNEL_X86_AVX512;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            return FIR_KERNEL_X86_AVX2;
+        }
+        return FIR_KERNEL_X86_DEFAULT;
+    }();
+    return kernel;
+}
+
+#define FIR_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define FIR_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+
+// Horizontal sum of the 8 lanes.
+FIR_TARGET_AVX2
+static inline float sumAVX2(__m256 v)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_movehdup_ps(s));
+    return _mm_cvtss_f32(s);
+}
+
+// One loop iteration of 8 positive and 8 negative coefficients.
+// sP points to the last (oldest) positive sample of the iteration.
+template <int CHANNELS, bool FIXED>
+FIR_TARGET_AVX2
+static inline void macAVX2(__m256& accL, __m256& accR,
+        const float* coefsP, const float* coefsN,
+        const float* coefsP1, const float* coefsN1,
+        const float* sP, const float* sN, __m256 interp)
+{
+    __m256 posCoef = _mm256_loadu_ps(coefsP);
+    __m256 negCoef = _mm256_loadu_ps(coefsN);
+    if (!FIXED) { // interpolate
+        const __m256 posCoef1 = _mm256_loadu_ps(coefsP1);
+        const __m256 negCoef1 = _mm256_loadu_ps(coefsN1);
+        // posCoef = interp * (posCoef1 - posCoef) + posCoef
+        // negCoef = interp * (negCoef - negCoef1) + negCoef1
+        posCoef = _mm256_fmadd_ps(_mm256_sub_ps(posCoef1, posCoef), interp, posCoef);
+        negCoef = _mm256_fmadd_ps(_mm256_sub_ps(negCoef, negCoef1), interp, negCoef1);
+    }
+    if (CHANNELS == 1) {
+        const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+        const __m256 posSamp = _mm256_permutevar8x32_ps(_mm256_loadu_ps(sP), reverse);
+        const __m256 negSamp = _mm256_loadu_ps(sN);
+        accL = _mm256_fmadd_ps(posSamp, posCoef, accL);
+        accL = _mm256_fmadd_ps(negSamp, negCoef, accL);
+    } else {
+        // deinterleave everything and reverse the positives.
+        const __m256i posIndex = _mm256_setr_epi32(6, 4, 2, 0, 7, 5, 3, 1);
+        const __m256i negIndex = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+        const __m256 posSamp0 = _mm256_permutevar8x32_ps(_mm256_loadu_ps(sP), posIndex);
+        const __m256 posSamp1 = _mm256_permutevar8x32_ps(_mm256_loadu_ps(sP + 8), posIndex);
+        const __m256 negSamp0 = _mm256_permutevar8x32_ps(_mm256_loadu_ps(sN), negIndex);
+        const __m256 negSamp1 = _mm256_permutevar8x32_ps(_mm256_loadu_ps(sN + 8), negIndex);
+        const __m256 posSampL = _mm256_permute2f128_ps(posSamp1, posSamp0, 0x20);
+        const __m256 posSampR = _mm256_permute2f128_ps(posSamp1, posSamp0, 0x31);
+        const __m256 negSampL = _mm256_permute2f128_ps(negSamp0, negSamp1, 0x20);
+        const __m256 negSampR = _mm256_permute2f128_ps(negSamp0, negSamp1, 0x31);
+        accL = _mm256_fmadd_ps(posSampL, posCoef, accL);
+        accR = _mm256_fmadd_ps(posSampR, posCoef, accR);
+        accL = _mm256_fmadd_ps(negSampL, negCoef, accL);
+        accR = _mm256_fmadd_ps(negSampR, negCoef, accR);
+    }
+}
+
+template <int CHANNELS, bool FIXED>
+FIR_TARGET_AVX2
+static inline void ProcessAVX2Intrinsic(float* out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* sP,
+        const float* sN,
+        const float* volumeLR,
+        float lerpP,
+        const float* coefsP1,
+        const float* coefsN1)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+
+    sP -= CHANNELS*(8-1);   // adjust sP for a loop iteration of eight
+
+    const __m256 interp = _mm256_set1_ps(lerpP);
+    __m256 accL = _mm256_setzero_ps();
+    __m256 accR = _mm256_setzero_ps();
+    do {
+        macAVX2<CHANNELS, FIXED>(accL, accR, coefsP, coefsN, coefsP1, coefsN1, sP, sN, interp);
+        coefsP += 8;
+        coefsN += 8;
+        coefsP1 += 8;
+        coefsN1 += 8;
+        sP -= CHANNELS*8;
+        sN += CHANNELS*8;
+    } while (count -= 8);
+
+    // multiply by volume and save
+    const float l = sumAVX2(accL);
+    const float r = CHANNELS == 2 ? sumAVX2(accR) : l;
+    out[0] += l * volumeLR[0];
+    out[1] += r * volumeLR[1];
+}
+
+template <int CHANNELS, bool FIXED>
+FIR_TARGET_AVX512
+static inline void ProcessAVX512Intrinsic(float* out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* sP,
+        const float* sN,
+        const float* volumeLR,
+        float lerpP,
+        const float* coefsP1,
+        const float* coefsN1)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+
+    sP -= CHANNELS*(16-1);  // adjust sP for a loop iteration of sixteen
+
+    const __m512 interp = _mm512_set1_ps(lerpP);
+    __m512 accL = _mm512_setzero_ps();
+    __m512 accR = _mm512_setzero_ps();
+    for (; count >= 16; count -= 16) {
+        __m512 posCoef = _mm512_loadu_ps(coefsP);
+        __m512 negCoef = _mm512_loadu_ps(coefsN);
+        if (!FIXED) { // interpolate
+            const __m512 posCoef1 = _mm512_loadu_ps(coefsP1);
+            const __m512 negCoef1 = _mm512_loadu_ps(coefsN1);
+            posCoef = _mm512_fmadd_ps(_mm512_sub_ps(posCoef1, posCoef), interp, posCoef);
+            negCoef = _mm512_fmadd_ps(_mm512_sub_ps(negCoef, negCoef1), interp, negCoef1);
+        }
+        if (CHANNELS == 1) {
+            const __m512i reverse = _mm512_setr_epi32(
+                    15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+            const __m512 posSamp = _mm512_permutexvar_ps(reverse, _mm512_loadu_ps(sP));
+            const __m512 negSamp = _mm512_loadu_ps(sN);
+            accL = _mm512_fmadd_ps(posSamp, posCoef, accL);
+            accL = _mm512_fmadd_ps(negSamp, negCoef, accL);
+        } else {
+            // deinterleave everything and reverse the positives.
+            // index bit 4 selects the second source register.
+            const __m512i posIndexL = _mm512_setr_epi32(
+                    14, 12, 10, 8, 6, 4, 2, 0, 30, 28, 26, 24, 22, 20, 18, 16);
+            const __m512i posIndexR = _mm512_setr_epi32(
+                    15, 13, 11, 9, 7, 5, 3, 1, 31, 29, 27, 25, 23, 21, 19, 17);
+            const __m512i negIndexL = _mm512_setr_epi32(
+                    0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+            const __m512i negIndexR = _mm512_setr_epi32(
+                    1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+            const __m512 posSamp0 = _mm512_loadu_ps(sP);
+            const __m512 posSamp1 = _mm512_loadu_ps(sP + 16);
+            const __m512 negSamp0 = _mm512_loadu_ps(sN);
+            const __m512 negSamp1 = _mm512_loadu_ps(sN + 16);
+            accL = _mm512_fmadd_ps(
+                    _mm512_permutex2var_ps(posSamp1, posIndexL, posSamp0), posCoef, accL);
+            accR = _mm512_fmadd_ps(
+                    _mm512_permutex2var_ps(posSamp1, posIndexR, posSamp0), posCoef, accR);
+            accL = _mm512_fmadd_ps(
+                    _mm512_permutex2var_ps(negSamp0, negIndexL, negSamp1), negCoef, accL);
+            accR = _mm512_fmadd_ps(
+                    _mm512_permutex2var_ps(negSamp0, negIndexR, negSamp1), negCoef, accR);
+        }
+        coefsP += 16;
+        coefsN += 16;
+        coefsP1 += 16;
+        coefsN1 += 16;
+        sP -= CHANNELS*16;
+        sN += CHANNELS*16;
+    }
+
+    float l = _mm512_reduce_add_ps(accL);
+    float r = CHANNELS == 2 ? _mm512_reduce_add_ps(accR) : l;
+    if (count > 0) { // remaining 8 coefficients
+        __m256 accL8 = _mm256_setzero_ps();
+        __m256 accR8 = _mm256_setzero_ps();
+        sP += CHANNELS*8;   // adjust sP for a loop iteration of eight
+        macAVX2<CHANNELS, FIXED>(accL8, accR8, coefsP, coefsN, coefsP1, coefsN1, sP, sN,
+                _mm256_set1_ps(lerpP));
+        l += sumAVX2(accL8);
+        r = CHANNELS == 2 ? r + sumAVX2(accR8) : l;
+    }
+
+    // multiply by volume and save
+    out[0] += l * volumeLR[0];
+    out[1] += r * volumeLR[1];
+}
+
+/*
+ * Equivalents of fir() for float coefficients and samples using the AVX2 and AVX-512
+ * kernels.  The caller must be compiled with the matching FIR_TARGET_* attribute
+ * for the kernel to be inlined.
+ */
+template<int CHANNELS, bool LOCKED>
+FIR_TARGET_AVX2
+static inline void firAVX2(float* const out,
+        const uint32_t phase, const uint32_t phaseWrapLimit,
+        const int coefShift, const int halfNumCoefs, const float* const coefs,
+        const float* const samples, const float* const volumeLR)
+{
+    const float *coefsP, *coefsN, *coefsP1, *coefsN1;
+    float lerpP;
+    firSetupFloat<LOCKED>(phase, phaseWrapLimit, coefShift, halfNumCoefs, coefs,
+            coefsP, coefsN, coefsP1, coefsN1, lerpP);
+    ProcessAVX2Intrinsic<CHANNELS, LOCKED>(out, halfNumCoefs, coefsP, coefsN,
+            samples, samples + CHANNELS, volumeLR, lerpP, coefsP1, coefsN1);
+}
+
+template<int CHANNELS, bool LOCKED>
+FIR_TARGET_AVX512
+static inline void firAVX512(float* const out,
+        const uint32_t phase, const uint32_t phaseWrapLimit,
+        const int coefShift, const int halfNumCoefs, const float* const coefs,
+        const float* const samples, const float* const volumeLR)
+{
+    const float *coefsP, *coefsN, *coefsP1, *coefsN1;
+    float lerpP;
+    firSetupFloat<LOCKED>(phase, phaseWrapLimit, coefShift, halfNumCoefs, coefs,
+            coefsP, coefsN, coefsP1, coefsN1, lerpP);
+    ProcessAVX512Intrinsic<CHANNELS, LOCKED>(out, halfNumCoefs, coefsP, coefsN,
+            samples, samples + CHANNELS, volumeLR, lerpP, coefsP1, coefsN1);
+}
+
+#endif // USE_FIR_KERNEL_X86
+
+} // namespace android
+
+#endif /*ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX_H*/
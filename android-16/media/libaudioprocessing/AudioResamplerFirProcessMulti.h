@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_MULTI_H
+#define ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_MULTI_H
+
+namespace android {
+
+// depends on AudioResamplerFirOps.h, AudioResamplerFirProcess.h
+
+#define USE_FIR_MULTI (USE_NEON || USE_SSE)
+
+#if USE_FIR_MULTI
+
+//
+// Channel-interleaved kernel for float multichannel (CHANNELS > 2) polyphase filtering.
+//
+// The generic ProcessBase() keeps one scalar accumulator per channel.  Here the
+// samples of one input frame are contiguous, so each (interpolated) coefficient is
+// computed once, broadcast, and multiplied with up to kFirMultiBlock channels held
+// in 4 lane vector accumulators.  Channel counts above kFirMultiBlock are processed
+// in additional passes over the same filter phase, which is still in the L1 cache.
+// Channels that do not fill a vector use scalar accumulators.
+//
+// The per channel summation order is the same as ProcessBase().
+//
+
+// Maximum number of channels accumulated per pass; 4 vector accumulators.
+constexpr int kFirMultiBlock = 16;
+
+#if USE_NEON
+typedef float32x4_t fir_multi_vec_t;
+
+static inline fir_multi_vec_t firMultiDup(float value) {
+    return vdupq_n_f32(value);
+}
+
+static inline fir_multi_vec_t firMultiLoad(const float* p) {
+    return vld1q_f32(p);
+}
+
+static inline fir_multi_vec_t firMultiMac(fir_multi_vec_t acc, fir_multi_vec_t a,
+        fir_multi_vec_t b) {
+    return vmlaq_f32(acc, a, b);
+}
+
+static inline void firMultiAccumulate(float* out, fir_multi_vec_t acc, fir_multi_vec_t volume) {
+    vst1q_f32(out, vmlaq_f32(vld1q_f32(out), acc, volume));
+}
+#else // USE_SSE
+typedef __m128 fir_multi_vec_t;
+
+static inline fir_multi_vec_t firMultiDup(float value) {
+    return _mm_set1_ps(value);
+}
+
+static inline fir_multi_vec_t firMultiLoad(const float* p) {
+    return _mm_loadu_ps(p);
+}
+
+static inline fir_multi_vec_t firMultiMac(fir_multi_vec_t acc, fir_multi_vec_t a,
+        fir_multi_vec_t b) {
+#if USE_AVX2
+    return _mm_fmadd_ps(a, b, acc);
+#else
+    return _mm_add_ps(acc, _mm_mul_ps(a, b));
+#endif
+}
+
+static inline void firMultiAccumulate(float* out, fir_multi_vec_t acc, fir_multi_vec_t volume) {
+    _mm_storeu_ps(out, firMultiMac(_mm_loadu_ps(out), acc, volume));
+}
+#endif // USE_SSE
+
+/*
+ * Filters channels [OFFSET, OFFSET + BLOCK) of one output frame and recurses
+ * for the remaining channels.  Parameters are as ProcessSSEIntrinsic(), with a single
+ * volume applied to all channels as in ProcessBase().
+ */
+template <int CHANNELS, int OFFSET, bool FIXED>
+static inline void ProcessMultiIntrinsic(float* const out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* coefsP1,
+        const float* coefsN1,
+        const float* sP,
+        const float* sN,
+        float lerpP,
+        float volume)
+{
+    constexpr int BLOCK = CHANNELS - OFFSET < kFirMultiBlock ? CHANNELS - OFFSET : kFirMultiBlock;
+    constexpr int VECTORS = BLOCK / 4;
+    constexpr int SCALARS = BLOCK % 4;
+
+    fir_multi_vec_t accV[VECTORS > 0 ? VECTORS : 1];
+    float accS[SCALARS > 0 ? SCALARS : 1];
+    for (int j = 0; j < VECTORS; ++j) {
+        accV[j] = firMultiDup(0.f);
+    }
+    for (int j = 0; j < SCALARS; ++j) {
+        accS[j] = 0.f;
+    }
+
+    const float* posSamp = sP + OFFSET;
+    const float* negSamp = sN + OFFSET;
+    for (int i = 0; i < count; ++i) {
+        float posCoef = coefsP[i];
+        float negCoef = coefsN[i];
+        if (!FIXED) { // interpolate, as InterpCompute
+            posCoef = lerpP * (coefsP1[i] - posCoef) + posCoef;
+            negCoef = lerpP * (negCoef - coefsN1[i]) + coefsN1[i];
+        }
+        const fir_multi_vec_t posCoefV = firMultiDup(posCoef);
+        const fir_multi_vec_t negCoefV = firMultiDup(negCoef);
+        for (int j = 0; j < VECTORS; ++j) {
+            accV[j] = firMultiMac(accV[j], firMultiLoad(posSamp + j * 4), posCoefV);
+            accV[j] = firMultiMac(accV[j], firMultiLoad(negSamp + j * 4), negCoefV);
+        }
+        for (int j = 0; j < SCALARS; ++j) {
+            accS[j] += posSamp[VECTORS * 4 + j] * posCoef;
+            accS[j] += negSamp[VECTORS * 4 + j] * negCoef;
+        }
+        posSamp -= CHANNELS;
+        negSamp += CHANNELS;
+    }
+
+    // multiply by volume and save
+    const fir_multi_vec_t volumeV = firMultiDup(volume);
+    for (int j = 0; j < VECTORS; ++j) {
+        firMultiAccumulate(out + OFFSET + j * 4, accV[j], volumeV);
+    }
+    for (int j = 0; j < SCALARS; ++j) {
+        out[OFFSET + VECTORS * 4 + j] += accS[j] * volume;
+    }
+
+    if constexpr (OFFSET + BLOCK < CHANNELS) {
+        ProcessMultiIntrinsic<CHANNELS, OFFSET + BLOCK, FIXED>(out, count,
+                coefsP, coefsN, coefsP1, coefsN1, sP, sN, lerpP, volume);
+    }
+}
+
+/*
+ * Equivalent of fir() for float multichannel (CHANNELS > 2) coefficients and samples.
+ */
+template<int CHANNELS, bool LOCKED>
+static inline void firMulti(float* const out,
+        const uint32_t phase, const uint32_t phaseWrapLimit,
+        const int coefShift, const int halfNumCoefs, const float* const coefs,
+        const float* const samples, const float* const volumeLR)
+{
+    static_assert(CHANNELS > 2, "use fir() for mono and stereo");
+    const float *coefsP, *coefsN, *coefsP1, *coefsN1;
+    float lerpP;
+    firSetupFloat<LOCKED>(phase, phaseWrapLimit, coefShift, halfNumCoefs, coefs,
+            coefsP, coefsN, coefsP1, coefsN1, lerpP);
+    ProcessMultiIntrinsic<CHANNELS, 0 /* OFFSET */, LOCKED>(out, halfNumCoefs,
+            coefsP, coefsN, coefsP1, coefsN1, samples, samples + CHANNELS, lerpP, volumeLR[0]);
+}
+
+#endif // USE_FIR_MULTI
+
+} // namespace android
+
+#endif /*ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_MULTI_H*/
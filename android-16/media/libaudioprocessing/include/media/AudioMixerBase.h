@@ -148,6 +148,11 @@ public:
     // If kUseNewMixer is false, this is ignored or may be overridden internally
     static constexpr bool kUseFloat = true;
 
+    // Set kUseAccumulateMixer to true to mix groups of two or more tracks with
+    // process__accumulate(), which sums blocks of tracks in a single pass over the
+    // mix buffer (see AudioMixerAccumulateOps.h).
+    static constexpr bool kUseAccumulateMixer = true;
+
 #ifdef FLOAT_AUX
     using TYPE_AUX = float;
     static_assert(kUseNewMixer && kUseFloat,
@@ -233,6 +238,13 @@ public:
         bool        useStereoVolume() const { return channelMask == AUDIO_CHANNEL_OUT_STEREO
                                         && isAudioChannelPositionMask(mMixerChannelMask); }
 
+        // Returns true if the track can be mixed by the multi-track accumulate path:
+        // no resampling, aux send, volume ramp or mono expansion.
+        bool        canAccumulate();
+        // Fills a gain row (see AudioMixerAccumulateOps.h) from the current track volume.
+        template <typename TV>
+        void        getAccumulateGainRow(TV *row) const;
+
         static hook_t getTrackHook(int trackType, uint32_t channelCount,
                 audio_format_t mixerInFormat, audio_format_t mixerOutFormat);
 
@@ -351,6 +363,11 @@ public:
     void process__genericNoResampling();
     void process__genericResampling();
     void process__oneTrack16BitsStereoNoResampling();
+    void process__accumulate();
+
+    // Helpers for process__accumulate().
+    void mixTrack(TrackBase *t, int32_t *out);
+    void accumulateTrackBlock(int32_t *out, TrackBase * const *tracks, size_t trackCount);
 
     template <int MIXTYPE, typename TO, typename TI, typename TA>
     void process__noResampleOneTrack();
@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <string>
+
 #include <cutils/compiler.h>
 #include <utils/Compat.h>
 
@@ -54,6 +56,10 @@ public:
     static AudioResampler* create(audio_format_t format, int inChannelCount,
             int32_t sampleRate, src_quality quality=DEFAULT_QUALITY);
 
+    // Returns the usage of the filter coefficients cache shared by the
+    // dynamic resamplers of the process, for dumpsys.
+    static std::string filterCacheToString();
+
     virtual ~AudioResampler();
 
     virtual void init() = 0;
@@ -80,6 +86,10 @@ public:
     virtual void reset();
     virtual size_t getUnreleasedFrames() const { return mInputIndex; }
 
+    // Returns the number of filter taps per output sample for each channel,
+    // or 0 if the resampler is not FIR based.  Used for throughput measurements.
+    virtual int getFilterLength() const { return 0; }
+
     // called from destructor, so must not be virtual
     src_quality getQuality() const { return mQuality; }
 
@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_VOLUME_RAMP_H
+#define ANDROID_VOLUME_RAMP_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <type_traits>
+
+#include <audio_utils/primitives.h>
+#include <system/audio.h>
+
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define VOLUME_RAMP_USE_NEON (true)
+#include <arm_neon.h>
+#else
+#define VOLUME_RAMP_USE_NEON (false)
+#endif
+
+#if defined(__SSE2__)
+#define VOLUME_RAMP_USE_SSE (true)
+#include <emmintrin.h>
+#else
+#define VOLUME_RAMP_USE_SSE (false)
+#endif
+
+namespace android {
+
+/*
+ * Volume ramps applied to interleaved PCM, shared by the mixers.
+ *
+ * A ramp has a volume for each channel, or a single volume for all channels, which is
+ * applied to the first frame, and a step by which it changes for each following frame:
+ *
+ * VOLUME_RAMP_LINEAR: the step is added to the volume, see volumeRampLinearStep().
+ * VOLUME_RAMP_DB:     the volume is multiplied by the step, so that the volume changes by
+ *                     the same number of dB each frame, see volumeRampDbStep().
+ *
+ * On return the volumes are those of the frame after the last, so that consecutive buffers
+ * continue the same ramp.  A step of 0 (linear) or 1 (dB) applies a constant volume
+ * at the same cost.
+ *
+ * Float samples are processed with 4 lane vectors.  With 1, 2 or 4 channels the lanes hold
+ * whole frames each with its own volume, otherwise each frame is processed with its volume
+ * broadcast across the channels.  Integer samples, int16_t (Q0.15) and int32_t (Q0.31),
+ * are converted to float in blocks, and saturated on conversion back.
+ */
+
+enum VolumeRampType {
+    VOLUME_RAMP_LINEAR,
+    VOLUME_RAMP_DB,
+};
+
+// Returns the per frame step of a linear ramp from volume "from" to "to" over frameCount.
+static inline float volumeRampLinearStep(float from, float to, size_t frameCount) {
+    return frameCount > 0 ? (to - from) / frameCount : 0.f;
+}
+
+// Returns the per frame step of a dB ramp from volume "from" to "to" over frameCount.
+// Both volumes must be > 0; ramps to or from silence should use a linear ramp or
+// a floor such as -96 dB.
+static inline float volumeRampDbStep(float from, float to, size_t frameCount) {
+    return frameCount > 0 && from > 0.f && to > 0.f
+            ? powf(to / from, 1.f / frameCount) : 1.f;
+}
+
+namespace volume_ramp_detail {
+
+template <VolumeRampType TYPE>
+static inline float advance(float volume, float step, size_t frames) {
+    if constexpr (TYPE == VOLUME_RAMP_LINEAR) {
+        return volume + step * frames;
+    } else {
+        return volume * powf(step, frames);
+    }
+}
+
+template <VolumeRampType TYPE>
+static inline float next(float volume, float step) {
+    if constexpr (TYPE == VOLUME_RAMP_LINEAR) {
+        return volume + step;
+    } else {
+        return volume * step;
+    }
+}
+
+#if VOLUME_RAMP_USE_NEON
+typedef float32x4_t vec_t;
+static inline vec_t vload(const float* p) { return vld1q_f32(p); }
+static inline void vstore(float* p, vec_t v) { vst1q_f32(p, v); }
+static inline vec_t vdup(float value) { return vdupq_n_f32(value); }
+static inline vec_t vadd(vec_t a, vec_t b) { return vaddq_f32(a, b); }
+static inline vec_t vmul(vec_t a, vec_t b) { return vmulq_f32(a, b); }
+static inline vec_t vmla(vec_t acc, vec_t a, vec_t b) { return vmlaq_f32(acc, a, b); }
+#elif VOLUME_RAMP_USE_SSE
+typedef __m128 vec_t;
+static inline vec_t vload(const float* p) { return _mm_loadu_ps(p); }
+static inline void vstore(float* p, vec_t v) { _mm_storeu_ps(p, v); }
+static inline vec_t vdup(float value) { return _mm_set1_ps(value); }
+static inline vec_t vadd(vec_t a, vec_t b) { return _mm_add_ps(a, b); }
+static inline vec_t vmul(vec_t a, vec_t b) { return _mm_mul_ps(a, b); }
+static inline vec_t vmla(vec_t acc, vec_t a, vec_t b) {
+    return _mm_add_ps(acc, _mm_mul_ps(a, b));
+}
+#endif
+
+#if VOLUME_RAMP_USE_NEON || VOLUME_RAMP_USE_SSE
+template <VolumeRampType TYPE>
+static inline vec_t vnext(vec_t volume, vec_t step) {
+    if constexpr (TYPE == VOLUME_RAMP_LINEAR) {
+        return vadd(volume, step);
+    } else {
+        return vmul(volume, step);
+    }
+}
+
+template <bool ACCUMULATE>
+static inline void vapply(float* out, const float* in, vec_t volume) {
+    if constexpr (ACCUMULATE) {
+        vstore(out, vmla(vload(out), vload(in), volume));
+    } else {
+        vstore(out, vmul(vload(in), volume));
+    }
+}
+#endif
+
+template <bool ACCUMULATE>
+static inline void apply(float* out, float in, float volume) {
+    if constexpr (ACCUMULATE) {
+        *out += in * volume;
+    } else {
+        *out = in * volume;
+    }
+}
+
+// 1, 2 or 4 channels: each lane holds one sample, 4 / channelCount frames per vector.
+template <VolumeRampType TYPE, bool ACCUMULATE>
+static inline void rampLanes(float* out, const float* in, size_t frameCount,
+        size_t channelCount, const float* volume, const float* step, size_t volumeCount) {
+    const size_t framesPerVector = 4 / channelCount;
+    float laneVolume[4];
+    float laneStep[4];
+    for (size_t i = 0; i < 4; ++i) {
+        const size_t channel = volumeCount == 1 ? 0 : i % channelCount;
+        laneVolume[i] = advance<TYPE>(volume[channel], step[channel], i / channelCount);
+        laneStep[i] = TYPE == VOLUME_RAMP_LINEAR
+                ? step[channel] * framesPerVector : powf(step[channel], framesPerVector);
+    }
+    const size_t sampleCount = frameCount * channelCount;
+    size_t i = 0;
+#if VOLUME_RAMP_USE_NEON || VOLUME_RAMP_USE_SSE
+    vec_t volumeV = vload(laneVolume);
+    const vec_t stepV = vload(laneStep);
+    for (; i + 4 <= sampleCount; i += 4) {
+        vapply<ACCUMULATE>(out + i, in + i, volumeV);
+        volumeV = vnext<TYPE>(volumeV, stepV);
+    }
+    vstore(laneVolume, volumeV);
+#else
+    for (; i + 4 <= sampleCount; i += 4) {
+        for (size_t j = 0; j < 4; ++j) {
+            apply<ACCUMULATE>(out + i + j, in[i + j], laneVolume[j]);
+            laneVolume[j] = next<TYPE>(laneVolume[j], laneStep[j]);
+        }
+    }
+#endif
+    // the remaining samples start a vector, so lane j holds the volume of sample j.
+    for (size_t j = 0; i < sampleCount; ++i, ++j) {
+        apply<ACCUMULATE>(out + i, in[i], laneVolume[j]);
+    }
+}
+
+// Any channel count with a single volume, broadcast to each frame.
+template <VolumeRampType TYPE, bool ACCUMULATE>
+static inline void rampFrames(float* out, const float* in, size_t frameCount,
+        size_t channelCount, float volume, float step) {
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        size_t i = 0;
+#if VOLUME_RAMP_USE_NEON || VOLUME_RAMP_USE_SSE
+        const vec_t volumeV = vdup(volume);
+        for (; i + 4 <= channelCount; i += 4) {
+            vapply<ACCUMULATE>(out + i, in + i, volumeV);
+        }
+#endif
+        for (; i < channelCount; ++i) {
+            apply<ACCUMULATE>(out + i, in[i], volume);
+        }
+        volume = next<TYPE>(volume, step);
+        out += channelCount;
+        in += channelCount;
+    }
+}
+
+// Any channel count with a volume for each channel.
+template <VolumeRampType TYPE, bool ACCUMULATE>
+static inline void rampChannels(float* out, const float* in, size_t frameCount,
+        size_t channelCount, float* volume, const float* step) {
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        for (size_t i = 0; i < channelCount; ++i) {
+            apply<ACCUMULATE>(out + i, in[i], volume[i]);
+            volume[i] = next<TYPE>(volume[i], step[i]);
+        }
+        out += channelCount;
+        in += channelCount;
+    }
+}
+
+template <VolumeRampType TYPE, bool ACCUMULATE>
+static inline void rampFloat(float* out, const float* in, size_t frameCount,
+        size_t channelCount, const float* volume, const float* step, size_t volumeCount) {
+    if (channelCount == 1 || channelCount == 2 || channelCount == 4) {
+        rampLanes<TYPE, ACCUMULATE>(out, in, frameCount, channelCount, volume, step, volumeCount);
+    } else if (volumeCount == 1) {
+        rampFrames<TYPE, ACCUMULATE>(out, in, frameCount, channelCount, volume[0], step[0]);
+    } else {
+        // rampChannels() updates its copy, the caller's volumes are advanced exactly below.
+        float channelVolume[FCC_LIMIT];
+        for (size_t i = 0; i < channelCount; ++i) {
+            channelVolume[i] = volume[i];
+        }
+        rampChannels<TYPE, ACCUMULATE>(out, in, frameCount, channelCount, channelVolume, step);
+    }
+}
+
+template <typename T>
+static inline void toFloat(float* dst, const T* src, size_t count) {
+    if constexpr (std::is_same_v<T, int16_t>) {
+        memcpy_to_float_from_i16(dst, src, count);
+    } else {
+        memcpy_to_float_from_i32(dst, src, count);
+    }
+}
+
+template <typename T>
+static inline void fromFloat(T* dst, const float* src, size_t count) {
+    if constexpr (std::is_same_v<T, int16_t>) {
+        memcpy_to_i16_from_float(dst, src, count);
+    } else {
+        memcpy_to_i32_from_float(dst, src, count);
+    }
+}
+
+} // namespace volume_ramp_detail
+
+/*
+ * Applies a volume ramp to frameCount frames of channelCount interleaved channels
+ * from in to out, which may be the same buffer.
+ *
+ * TYPE        VOLUME_RAMP_LINEAR or VOLUME_RAMP_DB.
+ * ACCUMULATE  true to add to out, false to overwrite out.
+ * T           float, int16_t (Q0.15) or int32_t (Q0.31).
+ * volume      volumeCount volumes of the first frame, updated to those of the next frame.
+ * step        volumeCount steps.
+ * volumeCount 1 for the same volume on all channels, or channelCount (at most FCC_LIMIT).
+ */
+template <VolumeRampType TYPE, bool ACCUMULATE = false, typename T>
+void volumeRamp(T* out, const T* in, size_t frameCount, size_t channelCount,
+        float* volume, const float* step, size_t volumeCount = 1)
+{
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, int16_t>
+            || std::is_same_v<T, int32_t>, "unsupported sample type");
+    using namespace volume_ramp_detail;
+    if (frameCount == 0 || channelCount == 0 || channelCount > FCC_LIMIT
+            || (volumeCount != 1 && volumeCount != channelCount)) {
+        return;
+    }
+    if constexpr (std::is_same_v<T, float>) {
+        rampFloat<TYPE, ACCUMULATE>(out, in, frameCount, channelCount, volume, step, volumeCount);
+    } else {
+        constexpr size_t kBlockSamples = 256;
+        float inFloat[kBlockSamples];
+        float outFloat[kBlockSamples];
+        const size_t blockFrames = kBlockSamples / channelCount;
+        float blockVolume[FCC_LIMIT];
+        for (size_t i = 0; i < volumeCount; ++i) {
+            blockVolume[i] = volume[i];
+        }
+        for (size_t frame = 0; frame < frameCount; frame += blockFrames) {
+            const size_t frames = std::min(blockFrames, frameCount - frame);
+            const size_t samples = frames * channelCount;
+            const size_t offset = frame * channelCount;
+            toFloat(inFloat, in + offset, samples);
+            if constexpr (ACCUMULATE) {
+                toFloat(outFloat, out + offset, samples);
+            }
+            rampFloat<TYPE, ACCUMULATE>(outFloat, inFloat, frames, channelCount,
+                    blockVolume, step, volumeCount);
+            fromFloat(out + offset, outFloat, samples);
+            for (size_t i = 0; i < volumeCount; ++i) {
+                blockVolume[i] = advance<TYPE>(blockVolume[i], step[i], frames);
+            }
+        }
+    }
+    for (size_t i = 0; i < volumeCount; ++i) {
+        volume[i] = advance<TYPE>(volume[i], step[i], frameCount);
+    }
+}
+
+} // namespace android
+
+#endif // ANDROID_VOLUME_RAMP_H
@@ -14,10 +14,13 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <inttypes.h>
 #include <type_traits>
+#include <vector>
 #define LOG_ALWAYS_FATAL(...)
 
+#include <../AudioMixerAccumulateOps.h>
 #include <../AudioMixerOps.h>
 #include <benchmark/benchmark.h>
 
@@ -101,4 +104,73 @@ BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, 8);
 BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
 
+// Mixes TRACKS stereo volume tracks of NCHAN channels into one buffer, one track at a time,
+// as done by the per-track hooks.
+template <int NCHAN>
+static void BM_MixTracksPerTrack(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 960;  // 20 ms at 48 kHz
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+    const size_t tracks = state.range(0);
+
+    std::vector<float> out(SAMPLE_COUNT);
+    std::vector<std::vector<float>> in(tracks, std::vector<float>(SAMPLE_COUNT, 0.5f));
+    const float vol[2] = {0.5f, 0.25f};
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out.data());
+        for (size_t i = 0; i < tracks; ++i) {
+            volumeMulti<MIXTYPE_MULTI_STEREOVOL, NCHAN>(
+                    out.data(), FRAME_COUNT, in[i].data(), (float *)nullptr, vol, 0.f);
+        }
+        benchmark::ClobberMemory();
+    }
+    // time per mixed output frame, the inverse of the frame rate.
+    state.counters["time_per_frame"] = benchmark::Counter(FRAME_COUNT,
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+// Same mix as BM_MixTracksPerTrack, with up to kAccumulateMaxTracks tracks per pass.
+template <int NCHAN>
+static void BM_MixTracksAccumulate(benchmark::State& state) {
+    constexpr size_t FRAME_COUNT = 960;  // 20 ms at 48 kHz
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+    const size_t tracks = state.range(0);
+
+    std::vector<float> out(SAMPLE_COUNT);
+    std::vector<std::vector<float>> in(tracks, std::vector<float>(SAMPLE_COUNT, 0.5f));
+    const float channelVolume[NCHAN] = {[0 ... (NCHAN - 1)] = 0.5f};
+    float gainRow[NCHAN * kAccumulateGainFrames];
+    fillAccumulateGainRow(gainRow, channelVolume, NCHAN);
+
+    const float *inp[kAccumulateMaxTracks];
+    const float *gains[kAccumulateMaxTracks];
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out.data());
+        for (size_t i = 0; i < tracks; i += kAccumulateMaxTracks) {
+            const size_t count = std::min(tracks - i, kAccumulateMaxTracks);
+            for (size_t j = 0; j < count; ++j) {
+                inp[j] = in[i + j].data();
+                gains[j] = gainRow;
+            }
+            accumulateTracks(out.data(), FRAME_COUNT, NCHAN, inp, gains, count);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.counters["time_per_frame"] = benchmark::Counter(FRAME_COUNT,
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+static void TrackCountArgs(benchmark::internal::Benchmark* b) {
+    for (int tracks : {1, 2, 4, 8, 12, 16}) {
+        b->Arg(tracks);
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_MixTracksPerTrack, 2)->Apply(TrackCountArgs);
+BENCHMARK_TEMPLATE(BM_MixTracksAccumulate, 2)->Apply(TrackCountArgs);
+BENCHMARK_TEMPLATE(BM_MixTracksPerTrack, 8)->Apply(TrackCountArgs);
+BENCHMARK_TEMPLATE(BM_MixTracksAccumulate, 8)->Apply(TrackCountArgs);
+BENCHMARK_TEMPLATE(BM_MixTracksPerTrack, 12)->Apply(TrackCountArgs);
+BENCHMARK_TEMPLATE(BM_MixTracksAccumulate, 12)->Apply(TrackCountArgs);
+
 BENCHMARK_MAIN();
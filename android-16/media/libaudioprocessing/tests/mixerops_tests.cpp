@@ -18,9 +18,14 @@
 #define LOG_TAG "mixerop_tests"
 #include <log/log.h>
 
+#include <algorithm>
+#include <array>
 #include <inttypes.h>
+#include <math.h>
 #include <type_traits>
+#include <vector>
 
+#include <../AudioMixerAccumulateOps.h>
 #include <../AudioMixerOps.h>
 #include <gtest/gtest.h>
 
@@ -176,3 +181,57 @@ TEST(mixerops, channel_equivalence) {
         EXPECT_EQ(system, actual);
     }
 }
+
+// accumulateTracks() must be bit-exact with mixing the tracks one at a time.
+template <int NCHAN>
+static void testAccumulate(size_t trackCount) {
+    constexpr size_t FRAME_COUNT = 253; // not a multiple of kAccumulateGainFrames.
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+    constexpr int MIXTYPE = NCHAN <= 2 ? MIXTYPE_MULTI : MIXTYPE_MULTI_MONOVOL;
+
+    std::vector<std::vector<float>> in(trackCount, std::vector<float>(SAMPLE_COUNT));
+    std::vector<std::array<float, 2>> vol(trackCount);
+    for (size_t i = 0; i < trackCount; ++i) {
+        for (size_t j = 0; j < SAMPLE_COUNT; ++j) {
+            in[i][j] = sinf(0.01f * (j + 1) * (i + 1));
+        }
+        vol[i] = {0.1f * (i + 1), 0.07f * (i + 2)};
+    }
+
+    std::vector<float> expected(SAMPLE_COUNT, 0.125f);
+    for (size_t i = 0; i < trackCount; ++i) {
+        volumeMulti<MIXTYPE, NCHAN>(expected.data(), FRAME_COUNT, in[i].data(),
+                (float *)nullptr, vol[i].data(), 0.f);
+    }
+
+    std::vector<float> out(SAMPLE_COUNT, 0.125f);
+    std::vector<std::array<float, NCHAN * kAccumulateGainFrames>> gainRows(trackCount);
+    for (size_t i = 0; i < trackCount; i += kAccumulateMaxTracks) {
+        const float *inp[kAccumulateMaxTracks];
+        const float *gains[kAccumulateMaxTracks];
+        const size_t count = std::min(trackCount - i, kAccumulateMaxTracks);
+        for (size_t j = 0; j < count; ++j) {
+            float channelVolume[NCHAN];
+            for (size_t k = 0; k < NCHAN; ++k) {
+                channelVolume[k] = vol[i + j][NCHAN <= 2 ? k : 0];
+            }
+            fillAccumulateGainRow(gainRows[i + j].data(), channelVolume, NCHAN);
+            inp[j] = in[i + j].data();
+            gains[j] = gainRows[i + j].data();
+        }
+        accumulateTracks(out.data(), FRAME_COUNT, NCHAN, inp, gains, count);
+    }
+    for (size_t i = 0; i < SAMPLE_COUNT; ++i) {
+        ASSERT_EQ(expected[i], out[i]) << "sample " << i << " tracks " << trackCount;
+    }
+}
+
+TEST(mixerops, accumulate) {
+    for (size_t tracks = 1; tracks <= 9; ++tracks) {
+        testAccumulate<1>(tracks);
+        testAccumulate<2>(tracks);
+        testAccumulate<6>(tracks);
+        testAccumulate<8>(tracks);
+        testAccumulate<12>(tracks);
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/AudioBufferProvider.h>
+#include <media/AudioResampler.h>
+
+using namespace android;
+
+// Provides the same input buffer repeatedly.
+template <typename T>
+class LoopProvider : public AudioBufferProvider {
+public:
+    LoopProvider(size_t channels, size_t frames)
+        : mChannels(channels), mFrames(frames), mData(channels * frames) {
+        for (size_t i = 0; i < mData.size(); ++i) {
+            const int value = static_cast<int>(i * 7919 % 2048) - 1024;
+            mData[i] = static_cast<T>(value) / static_cast<T>(4);
+        }
+    }
+
+    status_t getNextBuffer(Buffer* buffer) override {
+        if (mNextFrame == mFrames) {
+            mNextFrame = 0;
+        }
+        buffer->frameCount = std::min(buffer->frameCount, mFrames - mNextFrame);
+        buffer->raw = &mData[mNextFrame * mChannels];
+        return NO_ERROR;
+    }
+
+    void releaseBuffer(Buffer* buffer) override {
+        mNextFrame += buffer->frameCount;
+        buffer->frameCount = 0;
+        buffer->raw = nullptr;
+    }
+
+private:
+    const size_t mChannels;
+    const size_t mFrames;
+    std::vector<T> mData;
+    size_t mNextFrame = 0;
+};
+
+/*
+ * Resamples 44.1kHz (interpolated phase) or 32kHz (locked phase) to 48kHz.
+ *
+ * Args: channel count, resampler quality, input sample rate.
+ */
+template <typename TI, typename TO>
+static void BM_Resample(benchmark::State& state) {
+    constexpr size_t kFrameCount = 960; // 20ms at 48kHz
+    constexpr int32_t kOutputRate = 48000;
+    const int channels = state.range(0);
+    const auto quality = static_cast<AudioResampler::src_quality>(state.range(1));
+    const int32_t inputRate = state.range(2);
+    const audio_format_t format = std::is_same_v<TI, float>
+            ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
+
+    LoopProvider<TI> provider(channels, inputRate);
+    std::vector<TO> out(kFrameCount * std::max(channels, 2));
+    std::unique_ptr<AudioResampler> resampler(
+            AudioResampler::create(format, channels, kOutputRate, quality));
+    resampler->setSampleRate(inputRate);
+    resampler->setVolume(AudioResampler::UNITY_GAIN_FLOAT, AudioResampler::UNITY_GAIN_FLOAT);
+
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(out.data());
+        resampler->resample(reinterpret_cast<int32_t*>(out.data()), kFrameCount, &provider);
+        benchmark::ClobberMemory();
+    }
+    state.counters["time_per_frame"] = benchmark::Counter(kFrameCount,
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    // one multiply and one add per tap, channel and output frame.
+    state.counters["flops"] = benchmark::Counter(
+            2. * resampler->getFilterLength() * channels * kFrameCount,
+            benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void ResampleArgs(benchmark::internal::Benchmark* b) {
+    for (int quality : {AudioResampler::DYN_MED_QUALITY, AudioResampler::DYN_HIGH_QUALITY}) {
+        for (int channels : {1, 2, 6, 8, 12, 16, 24}) {
+            for (int inputRate : {32000, 44100}) {
+                b->Args({channels, quality, inputRate});
+            }
+        }
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_Resample, float, float)->Apply(ResampleArgs);
+BENCHMARK_TEMPLATE(BM_Resample, int16_t, int32_t)->Apply(ResampleArgs);
+
+BENCHMARK_MAIN();
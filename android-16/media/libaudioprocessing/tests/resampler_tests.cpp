@@ -65,8 +65,10 @@ void resample(int channels, void *output,
         if (thisFrames == 0 || thisFrames > outputFrames - i) {
             thisFrames = outputFrames - i;
         }
+        // mono input is resampled to stereo output.
+        const int outputChannels = channels == 1 ? 2 : channels;
         size_t framesResampled = resampler->resample(
-                (int32_t*) output + channels*i, thisFrames, provider);
+                (int32_t*) output + outputChannels*i, thisFrames, provider);
         // we should have enough buffer space, so there is no short count.
         ASSERT_EQ(thisFrames, framesResampled);
         i += thisFrames;
@@ -371,6 +373,23 @@ TEST(audioflinger_resampler, bufferincrement_interpolatedphase_multi_float) {
     }
 }
 
+TEST(audioflinger_resampler, bufferincrement_float) {
+    // mono and stereo float use the runtime selected AVX2 or AVX-512 kernels on x86,
+    // more than 2 channels use the multichannel kernel, in passes of up to 16 channels.
+    static const enum android::AudioResampler::src_quality kQualityArray[] = {
+            android::AudioResampler::DYN_LOW_QUALITY,
+            android::AudioResampler::DYN_MED_QUALITY,
+            android::AudioResampler::DYN_HIGH_QUALITY,
+    };
+
+    for (size_t channels : {1, 2, 6, 12, 24}) {
+        for (size_t i = 0; i < ARRAY_SIZE(kQualityArray); ++i) {
+            testBufferIncrement(channels, true, 48000, 32000, kQualityArray[i]);
+            testBufferIncrement(channels, true, 22050, 48000, kQualityArray[i]);
+        }
+    }
+}
+
 /* Simple aliasing test
  *
  * This checks stopband response of the chirp signal to make sure frequencies
@@ -601,3 +620,40 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+// Resamplers with the same filter design share the coefficients of the filter cache.
+// The output rate is below ro.audio.resampler.psd.enable_at_samplerate so that
+// the design depends on the quality.
+TEST(audioflinger_resampler, filtercache) {
+    using ResamplerType = android::AudioResamplerDyn<float, float, float>;
+    auto create = [](android::AudioResampler::src_quality quality, int inSampleRate) {
+        std::unique_ptr<ResamplerType> rdyn(
+                static_cast<ResamplerType *>(
+                        android::AudioResampler::create(
+                                AUDIO_FORMAT_PCM_FLOAT, 2 /* channels */, 44100, quality)));
+        rdyn->setSampleRate(inSampleRate);
+        return rdyn;
+    };
+
+    auto first = create(android::AudioResampler::DYN_MED_QUALITY, 48000);
+    auto second = create(android::AudioResampler::DYN_MED_QUALITY, 48000);
+    EXPECT_EQ(first->getFilterCoefs(), second->getFilterCoefs());
+    EXPECT_EQ(first->getHalfLength(), second->getHalfLength());
+    EXPECT_EQ(first->getPhases(), second->getPhases());
+
+    // a different quality or ratio needs another filter.
+    auto other = create(android::AudioResampler::DYN_LOW_QUALITY, 48000);
+    EXPECT_NE(first->getFilterCoefs(), other->getFilterCoefs());
+    other->setSampleRate(96000);
+    EXPECT_NE(first->getFilterCoefs(), other->getFilterCoefs());
+
+    // the filter remains valid while one resampler uses it.
+    const float* coefs = first->getFilterCoefs();
+    first.reset();
+    EXPECT_EQ(coefs, second->getFilterCoefs());
+    auto third = create(android::AudioResampler::DYN_MED_QUALITY, 48000);
+    EXPECT_EQ(coefs, third->getFilterCoefs());
+
+    const std::string dump = android::AudioResampler::filterCacheToString();
+    EXPECT_NE(std::string::npos, dump.find("hits")) << dump;
+}
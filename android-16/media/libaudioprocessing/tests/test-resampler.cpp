@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -38,7 +39,7 @@ using namespace android;
 static bool gVerbose = false;
 
 static int usage(const char* name) {
-    fprintf(stderr,"Usage: %s [-p] [-f] [-F] [-v] [-c channels]"
+    fprintf(stderr,"Usage: %s [-p] [-f] [-F] [-t] [-v] [-c channels]"
                    " [-q {dq|lq|mq|hq|vhq|dlq|dmq|dhq}]"
                    " [-i input-sample-rate] [-o output-sample-rate]"
                    " [-O csv] [-P csv] [<input-file>]"
@@ -46,6 +47,8 @@ static int usage(const char* name) {
     fprintf(stderr,"    -p    enable profiling\n");
     fprintf(stderr,"    -f    enable filter profiling\n");
     fprintf(stderr,"    -F    enable floating point -q {dlq|dmq|dhq} only");
+    fprintf(stderr,"    -t    throughput : report MFLOPS for each dynamic quality and channel count\n");
+    fprintf(stderr,"              (no files are read or written)\n");
     fprintf(stderr,"    -v    verbose : log buffer provider calls\n");
     fprintf(stderr,"    -c    # channels (1-2 for lq|mq|hq; 1-8 for dlq|dmq|dhq)\n");
     fprintf(stderr,"    -q    resampler quality\n");
@@ -103,10 +106,101 @@ int parseCSV(const char *string, Vector<int>& values)
     }
 }
 
+// Measures resample() throughput for each dynamic quality and channel count.
+//
+// MFLOPS counts one multiply and one add per filter tap, channel and output frame;
+// the coefficient interpolation of a non-locked phase is not counted.
+static int profileThroughput(bool useFloat, int input_freq, int output_freq) {
+    const audio_format_t format = useFloat ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
+    const size_t kMaxChannels = 8;
+    const size_t input_frames = input_freq; // 1 second of input
+    const size_t output_frames = ((int64_t) input_frames * output_freq) / input_freq;
+    const size_t sampleSize = useFloat ? sizeof(float) : sizeof(int32_t);
+    std::unique_ptr<char[]> input(new char[input_frames * kMaxChannels * sampleSize]());
+    std::unique_ptr<char[]> output(new char[output_frames * kMaxChannels * sampleSize]());
+
+    // provides the same input buffer repeatedly.
+    class LoopProvider: public AudioBufferProvider {
+        const char*     mAddr;
+        const size_t    mNumFrames;
+        const size_t    mFrameSize;
+        size_t          mNextFrame = 0;
+    public:
+        LoopProvider(const char* addr, size_t frames, size_t frameSize)
+            : mAddr(addr), mNumFrames(frames), mFrameSize(frameSize) {
+        }
+        status_t getNextBuffer(Buffer* buffer) override {
+            if (mNextFrame == mNumFrames) {
+                mNextFrame = 0;
+            }
+            buffer->frameCount = std::min(buffer->frameCount, mNumFrames - mNextFrame);
+            buffer->raw = const_cast<char*>(mAddr) + mFrameSize * mNextFrame;
+            return NO_ERROR;
+        }
+        void releaseBuffer(Buffer* buffer) override {
+            mNextFrame += buffer->frameCount;
+            buffer->frameCount = 0;
+            buffer->raw = NULL;
+        }
+    };
+
+    printf("input: %d  output: %d  format: %s\n",
+            input_freq, output_freq, useFloat ? "float" : "int16");
+    for (int quality = AudioResampler::DYN_LOW_QUALITY;
+            quality <= AudioResampler::DYN_HIGH_QUALITY; ++quality) {
+        for (size_t channels = 1; channels <= kMaxChannels; ++channels) {
+            // white noise at -6dB, the content does not affect the timing.
+            const size_t samples = input_frames * channels;
+            if (useFloat) {
+                float* in = reinterpret_cast<float*>(input.get());
+                for (size_t i = 0; i < samples; ++i) {
+                    in[i] = (rand() / (float) RAND_MAX - 0.5f);
+                }
+            } else {
+                int16_t* in = reinterpret_cast<int16_t*>(input.get());
+                for (size_t i = 0; i < samples; ++i) {
+                    in[i] = rand() % 32768 - 16384;
+                }
+            }
+            LoopProvider provider(input.get(), input_frames,
+                    channels * (useFloat ? sizeof(float) : sizeof(int16_t)));
+            std::unique_ptr<AudioResampler> resampler(AudioResampler::create(format, channels,
+                    output_freq, (AudioResampler::src_quality) quality));
+            resampler->setSampleRate(input_freq);
+            resampler->setVolume(AudioResampler::UNITY_GAIN_FLOAT,
+                    AudioResampler::UNITY_GAIN_FLOAT);
+
+            // best of a few trials, see the comment on profiling in main().
+            const int trials = 4;
+            int64_t time = 0;
+            for (int n = 0; n < trials; ++n) {
+                timespec start, end;
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                resampler->resample(reinterpret_cast<int32_t*>(output.get()),
+                        output_frames, &provider);
+                clock_gettime(CLOCK_MONOTONIC, &end);
+                const int64_t diff_ns = (end.tv_sec - start.tv_sec) * 1000000000LL
+                        + (end.tv_nsec - start.tv_nsec);
+                if (n == 0 || diff_ns < time) {
+                    time = diff_ns;
+                }
+            }
+            const double seconds = time / 1e9;
+            const int filterLength = resampler->getFilterLength();
+            printf("quality: %d  channels: %zu  taps: %d  Mfrms/s: %.2lf  MFLOPS: %.1lf\n",
+                    quality, channels, filterLength,
+                    output_frames / seconds / 1e6,
+                    2. * filterLength * channels * output_frames / seconds / 1e6);
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char* argv[]) {
     const char* const progname = argv[0];
     bool profileResample = false;
     bool profileFilter = false;
+    bool profileThroughputOnly = false;
     bool useFloat = false;
     int channels = 1;
     int input_freq = 0;
@@ -116,7 +210,7 @@ int main(int argc, char* argv[]) {
     Vector<int> Pvalues;
 
     int ch;
-    while ((ch = getopt(argc, argv, "pfFvc:q:i:o:O:P:")) != -1) {
+    while ((ch = getopt(argc, argv, "pfFtvc:q:i:o:O:P:")) != -1) {
         switch (ch) {
         case 'p':
             profileResample = true;
@@ -127,6 +221,9 @@ int main(int argc, char* argv[]) {
         case 'F':
             useFloat = true;
             break;
+        case 't':
+            profileThroughputOnly = true;
+            break;
         case 'v':
             gVerbose = true;
             break;
@@ -180,6 +277,11 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (profileThroughputOnly) {
+        return profileThroughput(useFloat,
+                input_freq > 0 ? input_freq : 44100, output_freq > 0 ? output_freq : 48000);
+    }
+
     if (channels < 1
             || channels > (quality < AudioResampler::DYN_LOW_QUALITY ? 2 : 8)) {
         fprintf(stderr, "invalid number of audio channels %d\n", channels);
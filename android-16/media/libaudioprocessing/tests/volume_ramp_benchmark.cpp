@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/VolumeRamp.h>
+
+using namespace android;
+
+static constexpr size_t kFrameCount = 960; // 20ms at 48kHz
+
+// The per sample ramp loop previously used by the mixers, for comparison.
+static void BM_VolumeRampScalar(benchmark::State& state) {
+    const size_t channelCount = state.range(0);
+    std::vector<float> in(kFrameCount * channelCount, 0.5f);
+    std::vector<float> out(in.size());
+    const float step = volumeRampLinearStep(0.f, 1.f, kFrameCount);
+
+    while (state.KeepRunning()) {
+        float volume = 0.f;
+        const float* inp = in.data();
+        float* outp = out.data();
+        for (size_t frame = 0; frame < kFrameCount; ++frame) {
+            for (size_t channel = 0; channel < channelCount; ++channel) {
+                *outp++ += *inp++ * volume;
+            }
+            volume += step;
+        }
+        benchmark::DoNotOptimize(volume);
+        benchmark::ClobberMemory();
+    }
+    state.counters["time_per_frame"] = benchmark::Counter(kFrameCount,
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+/*
+ * Args: channel count, 1 for a ramp or 0 for a constant volume.
+ */
+template <VolumeRampType TYPE, typename T>
+static void BM_VolumeRamp(benchmark::State& state) {
+    const size_t channelCount = state.range(0);
+    const bool ramp = state.range(1) != 0;
+    T half;
+    if constexpr (std::is_same_v<T, float>) {
+        half = 0.5f;
+    } else {
+        half = 1 << 14;
+    }
+    std::vector<T> in(kFrameCount * channelCount, half);
+    std::vector<T> out(in.size());
+    const float step = !ramp ? (TYPE == VOLUME_RAMP_LINEAR ? 0.f : 1.f)
+            : TYPE == VOLUME_RAMP_LINEAR ? volumeRampLinearStep(0.f, 1.f, kFrameCount)
+            : volumeRampDbStep(1e-3f, 1.f, kFrameCount);
+
+    while (state.KeepRunning()) {
+        float volume = TYPE == VOLUME_RAMP_LINEAR ? 0.f : 1e-3f;
+        volumeRamp<TYPE, true /* ACCUMULATE */>(out.data(), in.data(), kFrameCount,
+                channelCount, &volume, &step);
+        benchmark::DoNotOptimize(volume);
+        benchmark::ClobberMemory();
+    }
+    state.counters["time_per_frame"] = benchmark::Counter(kFrameCount,
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+static void ScalarArgs(benchmark::internal::Benchmark* b) {
+    for (int channels : {1, 2, 4, 6, 8}) {
+        b->Args({channels});
+    }
+}
+
+static void VolumeRampArgs(benchmark::internal::Benchmark* b) {
+    for (int channels : {1, 2, 4, 6, 8}) {
+        for (int ramp : {0, 1}) {
+            b->Args({channels, ramp});
+        }
+    }
+}
+
+BENCHMARK(BM_VolumeRampScalar)->Apply(ScalarArgs);
+BENCHMARK_TEMPLATE(BM_VolumeRamp, VOLUME_RAMP_LINEAR, float)->Apply(VolumeRampArgs);
+BENCHMARK_TEMPLATE(BM_VolumeRamp, VOLUME_RAMP_DB, float)->Apply(VolumeRampArgs);
+BENCHMARK_TEMPLATE(BM_VolumeRamp, VOLUME_RAMP_LINEAR, int16_t)->Apply(VolumeRampArgs);
+
+BENCHMARK_MAIN();
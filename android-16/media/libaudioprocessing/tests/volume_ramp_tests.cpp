@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/VolumeRamp.h>
+
+using namespace android;
+
+namespace {
+
+// Per sample reference, computing each volume from the start of the ramp.
+template <VolumeRampType TYPE, bool ACCUMULATE>
+void referenceRamp(float* out, const float* in, size_t frameCount, size_t channelCount,
+        const float* volume, const float* step, size_t volumeCount) {
+    for (size_t frame = 0; frame < frameCount; ++frame) {
+        for (size_t channel = 0; channel < channelCount; ++channel) {
+            const size_t v = volumeCount == 1 ? 0 : channel;
+            const float gain = TYPE == VOLUME_RAMP_LINEAR
+                    ? volume[v] + step[v] * frame : volume[v] * powf(step[v], frame);
+            const size_t i = frame * channelCount + channel;
+            out[i] = (ACCUMULATE ? out[i] : 0.f) + in[i] * gain;
+        }
+    }
+}
+
+std::vector<float> makeInput(size_t samples) {
+    std::vector<float> input(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        input[i] = sinf(i * 0.1f) * 0.9f;
+    }
+    return input;
+}
+
+template <VolumeRampType TYPE, bool ACCUMULATE>
+void testFloat(size_t channelCount, size_t volumeCount) {
+    constexpr size_t kFrameCount = 257; // not a multiple of the vector size
+    const std::vector<float> input = makeInput(kFrameCount * channelCount);
+    std::vector<float> volume(volumeCount);
+    std::vector<float> step(volumeCount);
+    for (size_t i = 0; i < volumeCount; ++i) {
+        volume[i] = 0.25f + 0.01f * i;
+        step[i] = TYPE == VOLUME_RAMP_LINEAR
+                ? volumeRampLinearStep(volume[i], 1.f - 0.02f * i, kFrameCount)
+                : volumeRampDbStep(volume[i], 1.f - 0.02f * i, kFrameCount);
+    }
+    std::vector<float> expected(input.size(), 0.5f);
+    std::vector<float> actual(input.size(), 0.5f);
+    referenceRamp<TYPE, ACCUMULATE>(expected.data(), input.data(), kFrameCount, channelCount,
+            volume.data(), step.data(), volumeCount);
+
+    // Two calls check that the ramp continues across buffers.
+    constexpr size_t kFirstFrames = 100;
+    std::vector<float> rampVolume = volume;
+    volumeRamp<TYPE, ACCUMULATE>(actual.data(), input.data(), kFirstFrames, channelCount,
+            rampVolume.data(), step.data(), volumeCount);
+    volumeRamp<TYPE, ACCUMULATE>(actual.data() + kFirstFrames * channelCount,
+            input.data() + kFirstFrames * channelCount, kFrameCount - kFirstFrames,
+            channelCount, rampVolume.data(), step.data(), volumeCount);
+
+    for (size_t i = 0; i < input.size(); ++i) {
+        ASSERT_NEAR(expected[i], actual[i], 1e-5f) << "sample " << i
+                << " channels " << channelCount << " volumes " << volumeCount;
+    }
+    // the rounding of a dB step accumulates over the ramp.
+    for (size_t i = 0; i < volumeCount; ++i) {
+        EXPECT_NEAR(1.f - 0.02f * i, rampVolume[i], 1e-4f) << "volume " << i;
+    }
+}
+
+} // namespace
+
+TEST(volume_ramp, float_linear) {
+    for (size_t channelCount = 1; channelCount <= FCC_LIMIT; ++channelCount) {
+        testFloat<VOLUME_RAMP_LINEAR, false>(channelCount, 1);
+        testFloat<VOLUME_RAMP_LINEAR, false>(channelCount, channelCount);
+        testFloat<VOLUME_RAMP_LINEAR, true>(channelCount, 1);
+        testFloat<VOLUME_RAMP_LINEAR, true>(channelCount, channelCount);
+    }
+}
+
+TEST(volume_ramp, float_db) {
+    for (size_t channelCount = 1; channelCount <= FCC_LIMIT; ++channelCount) {
+        testFloat<VOLUME_RAMP_DB, false>(channelCount, 1);
+        testFloat<VOLUME_RAMP_DB, false>(channelCount, channelCount);
+        testFloat<VOLUME_RAMP_DB, true>(channelCount, 1);
+        testFloat<VOLUME_RAMP_DB, true>(channelCount, channelCount);
+    }
+}
+
+TEST(volume_ramp, db_step) {
+    constexpr size_t kFrameCount = 480;
+    const float step = volumeRampDbStep(0.1f, 1.f, kFrameCount);
+    // 20 dB over the ramp
+    EXPECT_NEAR(20.f / kFrameCount, 20.f * log10f(step), 1e-5f);
+    // silence is not reachable in dB
+    EXPECT_EQ(1.f, volumeRampDbStep(0.f, 1.f, kFrameCount));
+}
+
+TEST(volume_ramp, int16) {
+    constexpr size_t kChannelCount = 2;
+    constexpr size_t kFrameCount = 1000; // more than one conversion block
+    std::vector<int16_t> input(kFrameCount * kChannelCount, 16384);
+    std::vector<int16_t> output(input.size(), 0);
+    float volume = 0.f;
+    const float step = volumeRampLinearStep(0.f, 1.f, kFrameCount);
+    volumeRamp<VOLUME_RAMP_LINEAR>(output.data(), input.data(), kFrameCount, kChannelCount,
+            &volume, &step);
+    for (size_t frame = 0; frame < kFrameCount; ++frame) {
+        const float expected = 16384.f * frame / kFrameCount;
+        EXPECT_NEAR(expected, output[frame * kChannelCount], 1.f) << "frame " << frame;
+        EXPECT_EQ(output[frame * kChannelCount], output[frame * kChannelCount + 1]);
+    }
+    EXPECT_NEAR(1.f, volume, 1e-5f);
+
+    // accumulation saturates
+    float gain = 1.5f;
+    const float zero = 0.f;
+    volumeRamp<VOLUME_RAMP_LINEAR, true /* ACCUMULATE */>(output.data(), input.data(),
+            kFrameCount, kChannelCount, &gain, &zero);
+    EXPECT_EQ(INT16_MAX, output.back());
+}
+
+TEST(volume_ramp, int32) {
+    constexpr size_t kChannelCount = 6;
+    constexpr size_t kFrameCount = 100;
+    std::vector<int32_t> input(kFrameCount * kChannelCount, INT32_MIN);
+    std::vector<int32_t> output(input.size(), 0);
+    float volume = 1.f;
+    const float step = volumeRampDbStep(1.f, 0.5f, kFrameCount);
+    volumeRamp<VOLUME_RAMP_DB>(output.data(), input.data(), kFrameCount, kChannelCount,
+            &volume, &step);
+    EXPECT_EQ(INT32_MIN, output[0]);
+    for (size_t frame = 0; frame < kFrameCount; ++frame) {
+        const double expected = INT32_MIN * pow(0.5, static_cast<double>(frame) / kFrameCount);
+        EXPECT_NEAR(expected, output[frame * kChannelCount], 1e-5 * -expected);
+    }
+    EXPECT_NEAR(0.5f, volume, 1e-5f);
+}
@@ -45,6 +45,12 @@ struct PageCache {
     void appendPage(Page *page);
     size_t releaseFromStart(size_t maxBytes);
 
+    // moves all the pages of "other" to the end of this cache.
+    void appendPages(PageCache *other);
+
+    // frees the pages kept for reuse by acquirePage().
+    void freeUnusedPages();
+
     size_t totalSize() const {
         return mTotalSize;
     }
@@ -136,6 +142,21 @@ size_t PageCache::releaseFromStart(size_t maxBytes) {
     return bytesReleased;
 }
 
+void PageCache::appendPages(PageCache *other) {
+    for (Page *page : other->mActivePages) {
+        mActivePages.push_back(page);
+    }
+    mTotalSize += other->mTotalSize;
+
+    other->mActivePages.clear();
+    other->mTotalSize = 0;
+}
+
+void PageCache::freeUnusedPages() {
+    freePages(&mFreePages);
+    mFreePages.clear();
+}
+
 void PageCache::copy(size_t from, void *data, size_t size) {
     ALOGV("copy from %zu size %zu", from, size);
 
@@ -179,6 +200,32 @@ void PageCache::copy(size_t from, void *data, size_t size) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Data cached from "mOffset" before the cache moved to another part of the
+// source.
+struct CachedRange {
+    CachedRange(off64_t offset, PageCache *pages)
+        : mOffset(offset),
+          mPages(pages) {
+    }
+
+    ~CachedRange() {
+        delete mPages;
+        mPages = NULL;
+    }
+
+    off64_t end() const {
+        return mOffset + mPages->totalSize();
+    }
+
+    off64_t mOffset;
+    PageCache *mPages;
+
+private:
+    DISALLOW_EVIL_CONSTRUCTORS(CachedRange);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 NuCachedSource2::NuCachedSource2(
         const sp<DataSource> &source,
         const char *cacheConfig,
@@ -188,6 +235,10 @@ NuCachedSource2::NuCachedSource2(
       mLooper(new ALooper),
       mCache(new PageCache(kPageSize)),
       mCacheOffset(0),
+      mRetainedBytes(0),
+      mNumHits(0),
+      mNumMisses(0),
+      mNumRetainedHits(0),
       mFinalStatus(OK),
       mLastAccessPos(0),
       mFetching(true),
@@ -196,6 +247,7 @@ NuCachedSource2::NuCachedSource2(
       mNumRetriesLeft(kMaxNumRetries),
       mHighwaterThresholdBytes(kDefaultHighWaterThreshold),
       mLowwaterThresholdBytes(kDefaultLowWaterThreshold),
+      mRetainedThresholdBytes(kDefaultRetainedThreshold),
       mKeepAliveIntervalUs(kDefaultKeepAliveIntervalUs),
       mDisconnectAtHighwatermark(disconnectAtHighwatermark) {
     // We are NOT going to support disconnect-at-highwatermark indefinitely
@@ -232,8 +284,17 @@ NuCachedSource2::~NuCachedSource2() {
     mLooper->stop();
     mLooper->unregisterHandler(mReflector->id());
 
+    ALOGV("%llu hits (%llu from retained ranges), %llu misses",
+          (unsigned long long)mNumHits, (unsigned long long)mNumRetainedHits,
+          (unsigned long long)mNumMisses);
+
     delete mCache;
     mCache = NULL;
+
+    for (CachedRange *range : mRetainedRanges) {
+        delete range;
+    }
+    mRetainedRanges.clear();
 }
 
 // static
@@ -394,6 +455,8 @@ void NuCachedSource2::fetchInternal() {
 
         page->mSize = n;
         mCache->appendPage(page);
+
+        mergeRetainedRanges_l();
     }
 }
 
@@ -533,10 +596,29 @@ ssize_t NuCachedSource2::readAt(off64_t offset, void *data, size_t size) {
         mCache->copy(delta, data, size);
 
         mLastAccessPos = offset + size;
+        ++mNumHits;
 
         return size;
     }
 
+    // Or from a range kept from before a seek. The prefetcher keeps filling
+    // the current range, so mLastAccessPos is left alone.
+    List<CachedRange *>::iterator it = findRetainedRange_l(offset, size);
+    if (it != mRetainedRanges.end()) {
+        CachedRange *range = *it;
+        range->mPages->copy(offset - range->mOffset, data, size);
+
+        mRetainedRanges.erase(it);
+        mRetainedRanges.push_front(range);
+
+        ++mNumHits;
+        ++mNumRetainedHits;
+
+        return size;
+    }
+
+    ++mNumMisses;
+
     sp<AMessage> msg = new AMessage(kWhatRead, mReflector);
     msg->setInt64("offset", offset);
     msg->setPointer("data", data);
@@ -583,6 +665,15 @@ size_t NuCachedSource2::approxDataRemaining(status_t *finalStatus) const {
     return approxDataRemaining_l(mLastAccessPos, finalStatus);
 }
 
+void NuCachedSource2::getCacheStats(CacheStats *stats) const {
+    Mutex::Autolock autoLock(mLock);
+    stats->mNumHits = mNumHits;
+    stats->mNumMisses = mNumMisses;
+    stats->mNumRetainedHits = mNumRetainedHits;
+    stats->mNumRetainedRanges = mRetainedRanges.size();
+    stats->mRetainedBytes = mRetainedBytes;
+}
+
 size_t NuCachedSource2::approxDataRemaining_l(off64_t offset, status_t *finalStatus) const {
     *finalStatus = mFinalStatus;
 
@@ -613,13 +704,6 @@ ssize_t NuCachedSource2::readInternal(off64_t offset, void *data, size_t size) {
         return ERROR_END_OF_STREAM;
     }
 
-    if (!mFetching) {
-        mLastAccessPos = offset;
-        restartPrefetcherIfNecessary_l(
-                false, // ignoreLowWaterThreshold
-                true); // force
-    }
-
     if (offset < mCacheOffset
             || offset >= (off64_t)(mCacheOffset + mCache->totalSize())) {
         static const off64_t kPadding = 256 * 1024;
@@ -630,7 +714,19 @@ ssize_t NuCachedSource2::readInternal(off64_t offset, void *data, size_t size) {
         // does not trigger another seek.
         off64_t seekOffset = (offset > kPadding) ? offset - kPadding : 0;
 
+        // Unless the data is still cached, in which case prefetching resumes
+        // at the end of it.
+        List<CachedRange *>::iterator it = findRetainedRange_l(offset, 1);
+        if (it != mRetainedRanges.end()) {
+            seekOffset = (*it)->mOffset;
+        }
+
         seekInternal_l(seekOffset);
+    } else if (!mFetching) {
+        mLastAccessPos = offset;
+        restartPrefetcherIfNecessary_l(
+                false, // ignoreLowWaterThreshold
+                true); // force
     }
 
     size_t delta = offset - mCacheOffset;
@@ -672,10 +768,24 @@ status_t NuCachedSource2::seekInternal_l(off64_t offset) {
 
     ALOGI("new range: offset= %lld", (long long)offset);
 
+    retainCache_l();
+
     mCacheOffset = offset;
 
-    size_t totalSize = mCache->totalSize();
-    CHECK_EQ(mCache->releaseFromStart(totalSize), totalSize);
+    List<CachedRange *>::iterator it = findRetainedRange_l(offset, 1);
+    if (it != mRetainedRanges.end() && (*it)->mOffset == offset) {
+        CachedRange *range = *it;
+        mRetainedRanges.erase(it);
+        mRetainedBytes -= range->mPages->totalSize();
+
+        ALOGI("resuming cached range %lld-%lld",
+              (long long)range->mOffset, (long long)range->end());
+
+        delete mCache;
+        mCache = range->mPages;
+        range->mPages = NULL;
+        delete range;
+    }
 
     mNumRetriesLeft = kMaxNumRetries;
     mFetching = true;
@@ -683,6 +793,106 @@ status_t NuCachedSource2::seekInternal_l(off64_t offset) {
     return OK;
 }
 
+List<CachedRange *>::iterator NuCachedSource2::findRetainedRange_l(
+        off64_t offset, size_t size) {
+    List<CachedRange *>::iterator it = mRetainedRanges.begin();
+    while (it != mRetainedRanges.end()) {
+        if (offset >= (*it)->mOffset && offset + (off64_t)size <= (*it)->end()) {
+            break;
+        }
+        ++it;
+    }
+    return it;
+}
+
+void NuCachedSource2::retainCache_l() {
+    size_t totalSize = mCache->totalSize();
+    if (totalSize == 0) {
+        return;
+    }
+
+    if (mRetainedThresholdBytes == 0) {
+        CHECK_EQ(mCache->releaseFromStart(totalSize), totalSize);
+        return;
+    }
+
+    // Ranges covered by the one being retained are no longer needed.
+    const off64_t end = mCacheOffset + totalSize;
+    List<CachedRange *>::iterator it = mRetainedRanges.begin();
+    while (it != mRetainedRanges.end()) {
+        CachedRange *range = *it;
+        if (range->mOffset >= mCacheOffset && range->end() <= end) {
+            mRetainedBytes -= range->mPages->totalSize();
+            delete range;
+            it = mRetainedRanges.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    mCache->freeUnusedPages();
+    mRetainedRanges.push_front(new CachedRange(mCacheOffset, mCache));
+    mRetainedBytes += totalSize;
+    mCache = new PageCache(kPageSize);
+
+    trimRetainedRanges_l();
+}
+
+void NuCachedSource2::mergeRetainedRanges_l() {
+    const off64_t end = mCacheOffset + mCache->totalSize();
+
+    List<CachedRange *>::iterator it = mRetainedRanges.begin();
+    while (it != mRetainedRanges.end()) {
+        CachedRange *range = *it;
+        if (range->mOffset > end || range->end() <= end) {
+            ++it;
+            continue;
+        }
+
+        // The prefetcher caught up with a retained range, skip ahead to the
+        // end of it instead of fetching the same data again.
+        size_t released = range->mPages->releaseFromStart(end - range->mOffset);
+        range->mOffset += released;
+        mRetainedBytes -= released;
+        if (range->mOffset != end) {
+            // The pages do not line up, fetch the data again.
+            ++it;
+            continue;
+        }
+
+        ALOGV("merging cached range %lld-%lld",
+              (long long)range->mOffset, (long long)range->end());
+
+        mRetainedBytes -= range->mPages->totalSize();
+        mCache->appendPages(range->mPages);
+        delete range;
+        mRetainedRanges.erase(it);
+        break;
+    }
+}
+
+void NuCachedSource2::trimRetainedRanges_l() {
+    // Drop the data at the start of the least recently used ranges first.
+    while (mRetainedBytes > mRetainedThresholdBytes && !mRetainedRanges.empty()) {
+        List<CachedRange *>::iterator it = --mRetainedRanges.end();
+        CachedRange *range = *it;
+
+        size_t maxBytes = mRetainedBytes - mRetainedThresholdBytes;
+        if (maxBytes < kPageSize) {
+            maxBytes = kPageSize;
+        }
+        size_t released = range->mPages->releaseFromStart(maxBytes);
+        range->mPages->freeUnusedPages();
+        range->mOffset += released;
+        mRetainedBytes -= released;
+
+        if (range->mPages->totalSize() == 0) {
+            delete range;
+            mRetainedRanges.erase(it);
+        }
+    }
+}
+
 void NuCachedSource2::resumeFetchingIfNecessary() {
     Mutex::Autolock autoLock(mLock);
 
@@ -709,9 +919,11 @@ void NuCachedSource2::updateCacheParamsFromSystemProperty() {
 void NuCachedSource2::updateCacheParamsFromString(const char *s) {
     ssize_t lowwaterMarkKb, highwaterMarkKb;
     int keepAliveSecs;
+    ssize_t retainedKb = -1;
 
-    if (sscanf(s, "%zd/%zd/%d",
-               &lowwaterMarkKb, &highwaterMarkKb, &keepAliveSecs) != 3) {
+    // The retained cache size is optional.
+    if (sscanf(s, "%zd/%zd/%d/%zd",
+               &lowwaterMarkKb, &highwaterMarkKb, &keepAliveSecs, &retainedKb) < 3) {
         ALOGE("Failed to parse cache parameters from '%s'.", s);
         return;
     }
@@ -741,10 +953,18 @@ void NuCachedSource2::updateCacheParamsFromString(const char *s) {
         mKeepAliveIntervalUs = kDefaultKeepAliveIntervalUs;
     }
 
-    ALOGV("lowwater = %zu bytes, highwater = %zu bytes, keepalive = %lld us",
+    if (retainedKb >= 0) {
+        mRetainedThresholdBytes = retainedKb * 1024;
+    } else {
+        mRetainedThresholdBytes = kDefaultRetainedThreshold;
+    }
+
+    ALOGV("lowwater = %zu bytes, highwater = %zu bytes, keepalive = %lld us, "
+          "retained = %zu bytes",
          mLowwaterThresholdBytes,
          mHighwaterThresholdBytes,
-         (long long)mKeepAliveIntervalUs);
+         (long long)mKeepAliveIntervalUs,
+         mRetainedThresholdBytes);
 }
 
 // static
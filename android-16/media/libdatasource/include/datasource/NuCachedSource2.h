@@ -21,10 +21,12 @@
 #include <media/DataSource.h>
 #include <media/stagefright/foundation/ABase.h>
 #include <media/stagefright/foundation/AHandlerReflector.h>
+#include <utils/List.h>
 
 namespace android {
 
 struct ALooper;
+struct CachedRange;
 struct PageCache;
 
 struct NuCachedSource2 : public DataSource {
@@ -59,6 +61,20 @@ struct NuCachedSource2 : public DataSource {
     size_t cachedSize();
     size_t approxDataRemaining(status_t *finalStatus) const;
 
+    struct CacheStats {
+        // reads served from the cache, and reads that had to wait for the
+        // source.
+        uint64_t mNumHits;
+        uint64_t mNumMisses;
+
+        // hits served by ranges kept from before a seek.
+        uint64_t mNumRetainedHits;
+
+        size_t mNumRetainedRanges;
+        size_t mRetainedBytes;
+    };
+    void getCacheStats(CacheStats *stats) const;
+
     void resumeFetchingIfNecessary();
 
     // The following methods are supported only if the
@@ -88,6 +104,10 @@ private:
         kDefaultHighWaterThreshold      = 20 * 1024 * 1024,
         kDefaultLowWaterThreshold       = 4 * 1024 * 1024,
 
+        // Data cached before a seek that is kept in case playback returns
+        // to it, e.g. the moov box at the end of a file or a seek back.
+        kDefaultRetainedThreshold       = 8 * 1024 * 1024,
+
         // Read data after a 15 sec timeout whether we're actively
         // fetching or not.
         kDefaultKeepAliveIntervalUs     = 15000000,
@@ -113,6 +133,15 @@ private:
 
     PageCache *mCache;
     off64_t mCacheOffset;
+
+    // Ranges cached before a seek, the most recently used first.
+    List<CachedRange *> mRetainedRanges;
+    size_t mRetainedBytes;
+
+    uint64_t mNumHits;
+    uint64_t mNumMisses;
+    uint64_t mNumRetainedHits;
+
     status_t mFinalStatus;
     off64_t mLastAccessPos;
     sp<AMessage> mAsyncResult;
@@ -124,6 +153,7 @@ private:
 
     size_t mHighwaterThresholdBytes;
     size_t mLowwaterThresholdBytes;
+    size_t mRetainedThresholdBytes;
 
     // If the keep-alive interval is 0, keep-alives are disabled.
     int64_t mKeepAliveIntervalUs;
@@ -138,6 +168,11 @@ private:
     ssize_t readInternal(off64_t offset, void *data, size_t size);
     status_t seekInternal_l(off64_t offset);
 
+    List<CachedRange *>::iterator findRetainedRange_l(off64_t offset, size_t size);
+    void retainCache_l();
+    void mergeRetainedRanges_l();
+    void trimRetainedRanges_l();
+
     size_t approxDataRemaining_l(off64_t offset, status_t *finalStatus) const;
 
     void restartPrefetcherIfNecessary_l(
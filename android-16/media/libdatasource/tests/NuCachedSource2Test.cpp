@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "NuCachedSource2Test"
+#include <utils/Log.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <vector>
+
+#include <datasource/FileSource.h>
+#include <datasource/HTTPBase.h>
+#include <datasource/NuCachedSource2.h>
+#include <gtest/gtest.h>
+
+using namespace android;
+
+constexpr size_t kFileSize = 16 * 1024 * 1024;
+
+// low water 1 MB, high water 4 MB, no keep-alive, 8 MB of retained ranges.
+constexpr char kCacheConfig[] = "1024/4096/0/8192";
+
+// Serves a local file as if it was downloaded over HTTP, counting the bytes
+// requested from it.
+class FileHTTPSource : public HTTPBase {
+public:
+    explicit FileHTTPSource(int fd) : mFile(new FileSource(fd, 0, kFileSize)) {}
+
+    status_t connect(const char * /* uri */, const KeyedVector<String8, String8> * /* headers */,
+                     off64_t /* offset */) override {
+        return OK;
+    }
+
+    void disconnect() override {}
+
+    // Called after the end of the file was reached to fetch another range.
+    status_t reconnectAtOffset(off64_t /* offset */) override { return OK; }
+
+    status_t initCheck() const override { return mFile->initCheck(); }
+
+    ssize_t readAt(off64_t offset, void *data, size_t size) override {
+        ssize_t n = mFile->readAt(offset, data, size);
+        if (n > 0) {
+            mBytesRead += n;
+        }
+        return n;
+    }
+
+    status_t getSize(off64_t *size) override { return mFile->getSize(size); }
+
+    uint32_t flags() override { return kWantsPrefetching | kIsHTTPBasedSource; }
+
+    size_t bytesRead() const { return mBytesRead; }
+
+private:
+    sp<FileSource> mFile;
+    std::atomic<size_t> mBytesRead{0};
+};
+
+class NuCachedSource2Test : public ::testing::Test {
+public:
+    void SetUp() override {
+        FILE *fp = tmpfile();
+        ASSERT_NE(fp, nullptr) << "Unable to create a temporary file";
+        srand(0);
+        mData.resize(kFileSize);
+        for (uint8_t &byte : mData) {
+            byte = rand();
+        }
+        ASSERT_EQ(fwrite(mData.data(), 1, mData.size(), fp), mData.size());
+        fflush(fp);
+
+        mHttpSource = new FileHTTPSource(dup(fileno(fp)));
+        fclose(fp);
+        ASSERT_EQ(mHttpSource->initCheck(), (status_t)OK);
+
+        mCachedSource = NuCachedSource2::Create(mHttpSource, kCacheConfig);
+    }
+
+    void TearDown() override {
+        if (mCachedSource != nullptr) {
+            mCachedSource->disconnect();
+        }
+        mCachedSource.clear();
+        mHttpSource.clear();
+    }
+
+    void readAndCompare(off64_t offset, size_t size) {
+        std::vector<uint8_t> buffer(size);
+        ASSERT_EQ(mCachedSource->readAt(offset, buffer.data(), size), (ssize_t)size)
+                << "Short read at " << offset;
+        ASSERT_EQ(memcmp(buffer.data(), mData.data() + offset, size), 0)
+                << "Mismatch at " << offset;
+    }
+
+    std::vector<uint8_t> mData;
+    sp<FileHTTPSource> mHttpSource;
+    sp<NuCachedSource2> mCachedSource;
+};
+
+TEST_F(NuCachedSource2Test, RandomReadsMatchSource) {
+    srand(1);
+    for (int i = 0; i < 50; ++i) {
+        size_t size = 1 + rand() % (256 * 1024);
+        off64_t offset = rand() % (kFileSize - size);
+        ASSERT_NO_FATAL_FAILURE(readAndCompare(offset, size));
+    }
+}
+
+// The moov box at the end of a file is read before playback starts at the
+// beginning, the data read before the seek must not be downloaded again.
+TEST_F(NuCachedSource2Test, SeekBackIsServedFromCache) {
+    ASSERT_NO_FATAL_FAILURE(readAndCompare(0, 64 * 1024));
+    ASSERT_NO_FATAL_FAILURE(readAndCompare(kFileSize - 512 * 1024, 256 * 1024));
+
+    const size_t bytesRead = mHttpSource->bytesRead();
+    NuCachedSource2::CacheStats before;
+    mCachedSource->getCacheStats(&before);
+    ASSERT_GE(before.mNumRetainedRanges, 1u);
+
+    ASSERT_NO_FATAL_FAILURE(readAndCompare(0, 64 * 1024));
+
+    NuCachedSource2::CacheStats after;
+    mCachedSource->getCacheStats(&after);
+    EXPECT_EQ(after.mNumRetainedHits, before.mNumRetainedHits + 1);
+    EXPECT_EQ(after.mNumMisses, before.mNumMisses);
+
+    // Only the prefetcher may have read more, beyond the data already cached.
+    ASSERT_NO_FATAL_FAILURE(readAndCompare(64 * 1024, 64 * 1024));
+    EXPECT_LE(mHttpSource->bytesRead() - bytesRead, 4u * 1024 * 1024 + 64 * 1024);
+}
+
+TEST_F(NuCachedSource2Test, RetainedRangesStayWithinLimit) {
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_NO_FATAL_FAILURE(readAndCompare(i * 2 * 1024 * 1024, 1024 * 1024));
+    }
+
+    NuCachedSource2::CacheStats stats;
+    mCachedSource->getCacheStats(&stats);
+    EXPECT_LE(stats.mRetainedBytes, 8u * 1024 * 1024);
+
+    // The retained ranges still serve reads correctly.
+    srand(2);
+    for (int i = 0; i < 50; ++i) {
+        size_t size = 1 + rand() % (64 * 1024);
+        off64_t offset = rand() % (kFileSize - size);
+        ASSERT_NO_FATAL_FAILURE(readAndCompare(offset, size));
+    }
+}
@@ -68,8 +68,46 @@ ssize_t AudioStreamOutSink::write(const void *buffer, size_t count)
         return NEGOTIATE;
     }
     ALOG_ASSERT(Format_isValid(mFormat));
+    mObtainedBuffer = nullptr;
     size_t written;
     status_t ret = mStream->write(buffer, count * mFrameSize, &written);
+    return onWritten(buffer, ret, written);
+}
+
+ssize_t AudioStreamOutSink::obtainWriteBuffer(void **buffer, size_t count)
+{
+    if (!mNegotiated) {
+        return NEGOTIATE;
+    }
+    ALOG_ASSERT(Format_isValid(mFormat));
+    mObtainedBuffer = nullptr;
+    size_t available;
+    status_t ret = mStream->obtainWriteBuffer(count * mFrameSize, &mObtainedBuffer, &available);
+    if (ret != OK) {
+        mObtainedBuffer = nullptr;
+        return ret;
+    }
+    *buffer = mObtainedBuffer;
+    return available / mFrameSize;
+}
+
+ssize_t AudioStreamOutSink::commitWriteBuffer(size_t count)
+{
+    if (!mNegotiated) {
+        return NEGOTIATE;
+    }
+    if (mObtainedBuffer == nullptr) {
+        return INVALID_OPERATION;
+    }
+    const void *buffer = mObtainedBuffer;
+    mObtainedBuffer = nullptr;
+    size_t written;
+    status_t ret = mStream->commitWriteBuffer(count * mFrameSize, &written);
+    return onWritten(buffer, ret, written);
+}
+
+ssize_t AudioStreamOutSink::onWritten(const void *buffer, status_t ret, size_t written)
+{
     if (ret == OK && written > 0) {
         // Send to MelProcessor for sound dose measurement.
         auto processor = mMelProcessor.load();
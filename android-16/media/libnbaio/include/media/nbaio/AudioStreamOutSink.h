@@ -46,6 +46,10 @@ public:
 
     virtual ssize_t write(const void *buffer, size_t count);
 
+    virtual ssize_t obtainWriteBuffer(void **buffer, size_t count);
+
+    virtual ssize_t commitWriteBuffer(size_t count);
+
     virtual status_t getTimestamp(ExtendedTimestamp &timestamp);
 
     // NBAIO_Sink end
@@ -59,8 +63,12 @@ public:
 #endif
 
 private:
+    // common completion of write() and commitWriteBuffer()
+    ssize_t onWritten(const void *buffer, status_t ret, size_t written);
+
     sp<StreamOutHalInterface> mStream;
     size_t              mStreamBufferSizeBytes; // as reported by get_buffer_size()
+    void*               mObtainedBuffer = nullptr; // as returned by obtainWriteBuffer()
     mediautils::atomic_sp<audio_utils::MelProcessor> mMelProcessor;
 };
 
@@ -217,6 +217,27 @@ public:
     //  < 0     status_t error occurred prior to the first frame transfer during this callback.
     virtual ssize_t writeVia(writeVia_t via, size_t total, void *user, size_t block = 0);
 
+    // Zero-copy alternative to write(), for sinks that expose their own buffer memory.
+    // Obtain a contiguous buffer owned by the sink for up to 'count' frames, which the provider
+    // fills in and then transfers with commitWriteBuffer().  A buffer which is not committed
+    // is discarded by the next call to the sink.
+    // Inputs:
+    //  buffer  Set to the buffer owned by sink, if the return value is > 0.
+    //  count   Maximum number of frames to obtain.
+    // Return value:
+    //  > 0     Number of frames that may be filled in, which may be less than count.
+    //  = 0     No frames can be obtained now, or count was zero.
+    //  < 0     status_t error occurred.
+    // Errors:
+    //  NEGOTIATE         (Re-)negotiation is needed.
+    //  INVALID_OPERATION Not supported by this sink, use write() instead.
+    virtual ssize_t obtainWriteBuffer(void** /*buffer*/, size_t /*count*/)
+            { return INVALID_OPERATION; }
+
+    // Transfer the first 'count' frames of the buffer returned by obtainWriteBuffer(), where
+    // 'count' must not exceed the value it returned.  Return value and errors are as write().
+    virtual ssize_t commitWriteBuffer(size_t /*count*/) { return INVALID_OPERATION; }
+
     // Returns NO_ERROR if a timestamp is available.  The timestamp includes the total number
     // of frames presented to an external observer, together with the value of CLOCK_MONOTONIC
     // as of this presentation count.  The timestamp parameter is undefined if error is returned.
@@ -31,6 +31,7 @@
 #include <utils/Log.h>
 
 #include <functional>
+#include <vector>
 
 #include <media/stagefright/MediaSource.h>
 #include <media/stagefright/foundation/ADebug.h>
@@ -171,6 +172,7 @@ public:
     bool isAvif() const { return mIsAvif; }
     bool isHeif() const { return mIsHeif; }
     bool isAudio() const { return mIsAudio; }
+    bool isVideo() const { return mIsVideo; }
     bool isMPEG4() const { return mIsMPEG4; }
     bool usePrefix() const { return mIsAvc || mIsHevc || mIsHeic || mIsDovi; }
     bool isExifData(MediaBufferBase *buffer, uint32_t *tiffHdrOffset) const;
@@ -191,6 +193,9 @@ public:
     uint16_t getImageItemId() { return mImageItemId; };
     uint16_t getGainmapItemId() { return mGainmapItemId; };
     uint16_t getGainmapMetaItemId() { return mGainmapMetadataItemId; };
+    int64_t getStartTimestampUs() const { return mStartTimestampUs; }
+    int32_t getTimeScale() const { return mTimeScale; }
+    int64_t getLastSampleDurationTicks() const { return mLastSampleDurationTicks; }
 
   private:
     // A helper class to handle faster write box with table entries
@@ -364,6 +369,9 @@ public:
     List<MediaBuffer *> mChunkSamples;
 
     bool mSamplesHaveSameSize;
+    uint32_t mSampleCount;
+    // Duration of the last sample, only kept for fragmented files which have no stts table.
+    int64_t mLastSampleDurationTicks;
     ListTableEntries<uint32_t, 1> *mStszTableEntries;
     ListTableEntries<off64_t, 1> *mCo64TableEntries;
     ListTableEntries<uint32_t, 3> *mStscTableEntries;
@@ -595,6 +603,12 @@ void MPEG4Writer::initInternal(int fd, bool isFirstSession) {
     mThread = 0;
     mDriftTimeUs = 0;
     mHasDolbyVision = false;
+    mFragmented = false;
+    mFragmentDurationUs = 0;
+    mFragmentSequenceNumber = 0;
+    mFragmentStartTimeUs = 0;
+    mFragmentBaseTimeUs = 0;
+    mFragmentInitWritten = false;
 
     // Following variables only need to be set for the first recording session.
     // And they will stay the same for all the recording sessions.
@@ -658,7 +672,7 @@ status_t MPEG4Writer::Track::dump(
     snprintf(buffer, SIZE, "       reached EOS: %s\n",
             mReachedEOS? "true": "false");
     result.append(buffer);
-    snprintf(buffer, SIZE, "       frames encoded : %d\n", mStszTableEntries->count());
+    snprintf(buffer, SIZE, "       frames encoded : %d\n", mSampleCount);
     result.append(buffer);
     snprintf(buffer, SIZE, "       duration encoded : %" PRId64 " us\n", mTrackDurationUs);
     result.append(buffer);
@@ -993,13 +1007,32 @@ status_t MPEG4Writer::start(MetaData *param) {
     CHECK_GT(mTimeScale, 0);
     ALOGV("movie time scale: %d", mTimeScale);
 
+    /*
+     * A fragmented file has an initial moov box without samples, followed by
+     * moof + mdat pairs that each hold about mFragmentDurationUs of media. The
+     * file can be read while it is being written, and the sample tables do
+     * not grow with the recording length.
+     */
+    int64_t fragmentDurationUs;
+    if (param && param->findInt64(kKeyFragmentDurationUs, &fragmentDurationUs) &&
+        fragmentDurationUs > 0) {
+        if (mHasFileLevelMeta) {
+            ALOGE("Image tracks are not supported in a fragmented file");
+            return ERROR_UNSUPPORTED;
+        }
+        mFragmented = true;
+        mFragmentDurationUs = fragmentDurationUs;
+        ALOGV("fragment duration: %" PRId64 " us", mFragmentDurationUs);
+    }
+
     /*
      * When the requested file size limit is small, the priority
      * is to meet the file size limit requirement, rather than
      * to make the file streamable. mStreamableFile does not tell
      * whether the actual recorded file is streamable or not.
+     * A fragmented file has no 'free' box to reserve.
      */
-    mStreamableFile =
+    mStreamableFile = !mFragmented &&
         (mMaxFileSizeLimitBytes != 0 &&
          mMaxFileSizeLimitBytes >= kMinStreamableFileSizeInBytes);
 
@@ -1108,7 +1141,10 @@ status_t MPEG4Writer::start(MetaData *param) {
 
     mOffset = mMdatOffset;
     seekOrPostError(mFd, mMdatOffset, SEEK_SET);
-    write("\x00\x00\x00\x01mdat????????", 16);
+    if (!mFragmented) {
+        // Movie fragments write their own 'mdat' boxes.
+        write("\x00\x00\x00\x01mdat????????", 16);
+    }
 
     /* Confirm whether the writing of the initial file atoms, ftyp and free,
      * are written to the file properly by posting kWhatNoIOErrorSoFar to the
@@ -1407,12 +1443,15 @@ status_t MPEG4Writer::reset(bool stopSource, bool waitForAnyPreviousCallToComple
         return mResetStatus;
     }
 
-    // Fix up the size of the 'mdat' chunk.
-    seekOrPostError(mFd, mMdatOffset + 8, SEEK_SET);
-    uint64_t size = mOffset - mMdatOffset;
-    size = hton64(size);
-    writeOrPostError(mFd, &size, 8);
-    seekOrPostError(mFd, mOffset, SEEK_SET);
+    // Fix up the size of the 'mdat' chunk. The moov box and the movie fragments
+    // of a fragmented file were already written out by the writer thread.
+    if (!mFragmented) {
+        seekOrPostError(mFd, mMdatOffset + 8, SEEK_SET);
+        uint64_t size = mOffset - mMdatOffset;
+        size = hton64(size);
+        writeOrPostError(mFd, &size, 8);
+        seekOrPostError(mFd, mOffset, SEEK_SET);
+    }
     mMdatEndOffset = mOffset;
 
     // Construct file-level meta and moov box now
@@ -1435,7 +1474,7 @@ status_t MPEG4Writer::reset(bool stopSource, bool waitForAnyPreviousCallToComple
         }
     }
 
-    if (mHasMoovBox) {
+    if (mHasMoovBox && !mFragmented) {
         writeMoovBox(maxDurationUs);
         // mWriteBoxToMemory could be set to false in
         // MPEG4Writer::write() method
@@ -1547,24 +1586,29 @@ void MPEG4Writer::writeMoovBox(int64_t durationUs) {
         writeUdtaBox();
     }
     writeMoovLevelMetaBox();
-    // Loop through all the tracks to get the global time offset if there is
-    // any ctts table appears in a video track.
-    int64_t minCttsOffsetTimeUs = kMaxCttsOffsetTimeUs;
-    for (List<Track *>::iterator it = mTracks.begin();
-        it != mTracks.end(); ++it) {
-        if (!(*it)->isHeif()) {
-            minCttsOffsetTimeUs =
-                std::min(minCttsOffsetTimeUs, (*it)->getMinCttsOffsetTimeUs());
+    // The moov box of a fragmented file is written before the samples of most
+    // of the movie are known. Its track fragment runs carry signed composition
+    // offsets instead.
+    if (!mFragmented) {
+        // Loop through all the tracks to get the global time offset if there is
+        // any ctts table appears in a video track.
+        int64_t minCttsOffsetTimeUs = kMaxCttsOffsetTimeUs;
+        for (List<Track *>::iterator it = mTracks.begin();
+            it != mTracks.end(); ++it) {
+            if (!(*it)->isHeif()) {
+                minCttsOffsetTimeUs =
+                    std::min(minCttsOffsetTimeUs, (*it)->getMinCttsOffsetTimeUs());
+            }
         }
-    }
-    ALOGI("Adjust the moov start time from %lld us -> %lld us", (long long)mStartTimestampUs,
-          (long long)(mStartTimestampUs + minCttsOffsetTimeUs - kMaxCttsOffsetTimeUs));
-    // Adjust movie start time.
-    mStartTimestampUs += minCttsOffsetTimeUs - kMaxCttsOffsetTimeUs;
+        ALOGI("Adjust the moov start time from %lld us -> %lld us", (long long)mStartTimestampUs,
+              (long long)(mStartTimestampUs + minCttsOffsetTimeUs - kMaxCttsOffsetTimeUs));
+        // Adjust movie start time.
+        mStartTimestampUs += minCttsOffsetTimeUs - kMaxCttsOffsetTimeUs;
 
-    // Add mStartTimeOffsetBFramesUs(-ve or zero) to the start offset of tracks.
-    mStartTimeOffsetBFramesUs = minCttsOffsetTimeUs - kMaxCttsOffsetTimeUs;
-    ALOGV("mStartTimeOffsetBFramesUs :%" PRId32, mStartTimeOffsetBFramesUs);
+        // Add mStartTimeOffsetBFramesUs(-ve or zero) to the start offset of tracks.
+        mStartTimeOffsetBFramesUs = minCttsOffsetTimeUs - kMaxCttsOffsetTimeUs;
+        ALOGV("mStartTimeOffsetBFramesUs :%" PRId32, mStartTimeOffsetBFramesUs);
+    }
 
     for (List<Track *>::iterator it = mTracks.begin();
         it != mTracks.end(); ++it) {
@@ -1572,9 +1616,27 @@ void MPEG4Writer::writeMoovBox(int64_t durationUs) {
             (*it)->writeTrackHeader();
         }
     }
+    if (mFragmented) {
+        writeMvexBox();
+    }
     endBox();  // moov
 }
 
+void MPEG4Writer::writeMvexBox() {
+    beginBox("mvex");
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        beginBox("trex");
+        writeInt32(0);             // version=0, flags=0
+        writeInt32((*it)->getTrackId().getId());
+        writeInt32(1);             // default sample description index
+        writeInt32(0);             // default sample duration
+        writeInt32(0);             // default sample size
+        writeInt32(0);             // default sample flags
+        endBox();  // trex
+    }
+    endBox();  // mvex
+}
+
 void MPEG4Writer::writeFtypBox(MetaData *param) {
     beginBox("ftyp");
 
@@ -1596,6 +1658,9 @@ void MPEG4Writer::writeFtypBox(MetaData *param) {
             } else {
                 writeFourcc("heic");
             }
+        } else if (mFragmented) {
+            // 'iso6' is the first brand with the track fragment decode time box.
+            writeFourcc("iso6");
         } else {
             writeFourcc("mp42");
         }
@@ -1614,8 +1679,15 @@ void MPEG4Writer::writeFtypBox(MetaData *param) {
             }
         }
         if (mHasMoovBox) {
+            if (mFragmented) {
+                writeFourcc("iso6");
+            }
             writeFourcc("isom");
             writeFourcc("mp42");
+            // A CMAF track file holds a single track.
+            if (mFragmented && mTracks.size() == 1) {
+                writeFourcc("cmfc");
+            }
         }
         // If an AV1 video track is present, write "av01" as one of the
         // compatible brands.
@@ -2265,6 +2337,8 @@ MPEG4Writer::Track::Track(MPEG4Writer* owner, const sp<MediaSource>& source, uin
       mTrackDurationUs(0),
       mEstimatedTrackSizeBytes(0),
       mSamplesHaveSameSize(true),
+      mSampleCount(0),
+      mLastSampleDurationTicks(0),
       mStszTableEntries(new ListTableEntries<uint32_t, 1>(1000)),
       mCo64TableEntries(new ListTableEntries<off64_t, 1>(1000)),
       mStscTableEntries(new ListTableEntries<uint32_t, 3>(1000)),
@@ -2359,6 +2433,8 @@ void MPEG4Writer::Track::resetInternal() {
     mTrackDurationUs = 0;
     mEstimatedTrackSizeBytes = 0;
     mSamplesHaveSameSize = false;
+    mSampleCount = 0;
+    mLastSampleDurationTicks = 0;
     if (mStszTableEntries != NULL) {
         delete mStszTableEntries;
         mStszTableEntries = new ListTableEntries<uint32_t, 1>(1000);
@@ -3010,16 +3086,203 @@ void MPEG4Writer::writeAllChunks() {
     size_t outstandingChunks = 0;
     Chunk chunk;
     while (findChunkToWrite(&chunk)) {
-        writeChunkToFile(&chunk);
+        if (mFragmented) {
+            addFragmentSample_l(&chunk);
+        } else {
+            writeChunkToFile(&chunk);
+        }
         ++outstandingChunks;
     }
 
+    if (mFragmented) {
+        if (!mFragmentInitWritten) {
+            mFragmentBaseTimeUs = mStartTimestampUs;
+        }
+        mLock.unlock();
+        writeFragment(INT64_MAX, true /* flushAll */);
+        mLock.lock();
+    }
+
     sendSessionSummary();
 
     mChunkInfos.clear();
     ALOGD("%zu chunks are written in the last batch", outstandingChunks);
 }
 
+void MPEG4Writer::addFragmentSample_l(Chunk *chunk) {
+    ChunkInfo *info = NULL;
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+         it != mChunkInfos.end(); ++it) {
+        if (it->mTrack == chunk->mTrack) {
+            info = &(*it);
+            break;
+        }
+    }
+    CHECK(info != NULL);
+    info->mFragmentSamples.push_back(*chunk);
+
+    // A new fragment starts at a sync sample of the lead track, once the
+    // fragment in progress is long enough.
+    if (chunk->mTrack != fragmentLeadTrack() || !chunk->mIsSyncSample ||
+            chunk->mTimeStampUs - mFragmentStartTimeUs < mFragmentDurationUs) {
+        return;
+    }
+    if (!mFragmentInitWritten) {
+        // The moov box needs the start time of every track.
+        for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+             it != mChunkInfos.end(); ++it) {
+            if (it->mFragmentSamples.empty() && it->mChunks.empty() &&
+                    !it->mTrack->reachedEOS()) {
+                return;
+            }
+        }
+        mFragmentBaseTimeUs = mStartTimestampUs;
+    }
+    mFragmentStartTimeUs = chunk->mTimeStampUs;
+    int64_t cutTimeUs = chunk->mTimeStampUs + fragmentStartOffsetUs(chunk->mTrack);
+
+    // Only the writer thread writes to the file, and writing the moov box
+    // acquires the lock.
+    mLock.unlock();
+    writeFragment(cutTimeUs, false /* flushAll */);
+    mLock.lock();
+}
+
+MPEG4Writer::Track *MPEG4Writer::fragmentLeadTrack() {
+    for (List<Track *>::iterator it = mTracks.begin(); it != mTracks.end(); ++it) {
+        if ((*it)->isVideo()) {
+            return *it;
+        }
+    }
+    return mTracks.empty() ? NULL : *mTracks.begin();
+}
+
+int64_t MPEG4Writer::fragmentStartOffsetUs(const Track *track) const {
+    // The same as the track start offset used for the edit list in the moov box.
+    return std::max((int64_t)0, track->getStartTimestampUs() - mFragmentBaseTimeUs);
+}
+
+void MPEG4Writer::writeFragment(int64_t cutTimeUs, bool flushAll) {
+    if (!mFragmentInitWritten) {
+        writeMoovBox(0 /* durationUs */);
+        mFragmentInitWritten = true;
+        ALOGI("MOOV atom was written to the file");
+    }
+
+    // Pick the pending samples of each track decoded before the cut. A sample is
+    // only written once the next one of its track is known, as its duration is
+    // the difference of their decoding times.
+    struct TrackRun {
+        ChunkInfo *mInfo;
+        uint32_t mSampleCount;
+    };
+    std::vector<TrackRun> runs;
+    for (List<ChunkInfo>::iterator it = mChunkInfos.begin();
+         it != mChunkInfos.end(); ++it) {
+        int64_t startOffsetUs = fragmentStartOffsetUs(it->mTrack);
+        uint32_t sampleCount = 0;
+        for (List<Chunk>::iterator chunkIt = it->mFragmentSamples.begin();
+             chunkIt != it->mFragmentSamples.end(); ++chunkIt) {
+            List<Chunk>::iterator next = chunkIt;
+            ++next;
+            if (!flushAll && (next == it->mFragmentSamples.end() ||
+                    chunkIt->mTimeStampUs + startOffsetUs >= cutTimeUs)) {
+                break;
+            }
+            ++sampleCount;
+        }
+        if (sampleCount > 0) {
+            runs.push_back({&(*it), sampleCount});
+        }
+    }
+    if (runs.empty()) {
+        return;
+    }
+
+    // Same as the sizes written by addSample_l().
+    auto sampleSize = [this](const Chunk &chunk) -> uint32_t {
+        size_t size = (*chunk.mSamples.begin())->range_length();
+        if (chunk.mTrack->usePrefix()) {
+            size += mUse4ByteNalLength ? 4 : 2;
+        }
+        return size;
+    };
+
+    // The sample data offsets are relative to the start of the moof box: its
+    // size is the moof and mfhd boxes, plus per track a traf box holding the
+    // tfhd, tfdt and trun boxes.
+    uint32_t moofSize = 8 + 16;
+    for (const TrackRun &run : runs) {
+        moofSize += 8 + 16 + 20 + 20 + 16 * run.mSampleCount;
+    }
+
+    off64_t moofOffset = mOffset;
+    beginBox("moof");
+    beginBox("mfhd");
+    writeInt32(0);             // version=0, flags=0
+    writeInt32(++mFragmentSequenceNumber);
+    endBox();  // mfhd
+    uint32_t dataOffset = moofSize + 8;  // following the mdat box header
+    for (const TrackRun &run : runs) {
+        Track *track = run.mInfo->mTrack;
+        int64_t timeScale = track->getTimeScale();
+        auto toTicks = [timeScale](int64_t timeUs) {
+            return (timeUs * timeScale + 500000LL) / 1000000LL;
+        };
+        List<Chunk>::iterator chunkIt = run.mInfo->mFragmentSamples.begin();
+        beginBox("traf");
+        beginBox("tfhd");
+        writeInt32(0x020000);      // version=0, flags=default-base-is-moof
+        writeInt32(track->getTrackId().getId());
+        endBox();  // tfhd
+        beginBox("tfdt");
+        writeInt32(1 << 24);       // version=1, flags=0
+        writeInt64(toTicks(chunkIt->mTimeStampUs));
+        endBox();  // tfdt
+        beginBox("trun");
+        // version=1 for signed composition offsets, flags=data-offset-present,
+        // sample-duration-present, sample-size-present, sample-flags-present and
+        // sample-composition-time-offsets-present
+        writeInt32((1 << 24) | 0x000f01);
+        writeInt32(run.mSampleCount);
+        writeInt32(dataOffset);
+        for (uint32_t i = 0; i < run.mSampleCount; ++i, ++chunkIt) {
+            List<Chunk>::iterator next = chunkIt;
+            ++next;
+            int64_t durationTicks = (next != run.mInfo->mFragmentSamples.end())
+                    ? toTicks(next->mTimeStampUs) - toTicks(chunkIt->mTimeStampUs)
+                    : track->getLastSampleDurationTicks();
+            uint32_t size = sampleSize(*chunkIt);
+            writeInt32(durationTicks);
+            writeInt32(size);
+            // sample_depends_on=2 for a sync sample, otherwise sample_depends_on=1
+            // and sample_is_non_sync_sample=1
+            writeInt32(chunkIt->mIsSyncSample ? 0x02000000 : 0x01010000);
+            writeInt32(toTicks(chunkIt->mTimeStampUs + chunkIt->mCompositionOffsetUs) -
+                    toTicks(chunkIt->mTimeStampUs));
+            dataOffset += size;
+        }
+        endBox();  // trun
+        endBox();  // traf
+    }
+    endBox();  // moof
+    CHECK_EQ(mOffset - moofOffset, (off64_t)moofSize);
+
+    beginBox("mdat");
+    for (const TrackRun &run : runs) {
+        List<Chunk> &samples = run.mInfo->mFragmentSamples;
+        for (uint32_t i = 0; i < run.mSampleCount; ++i) {
+            Chunk &chunk = *samples.begin();
+            MediaBuffer *buffer = *chunk.mSamples.begin();
+            size_t bytesWritten;
+            addSample_l(buffer, chunk.mTrack->usePrefix(), 0 /* tiffHdrOffset */, &bytesWritten);
+            buffer->release();
+            samples.erase(samples.begin());
+        }
+    }
+    endBox();  // mdat
+}
+
 bool MPEG4Writer::findChunkToWrite(Chunk *chunk) {
     ALOGV("findChunkToWrite");
 
@@ -3087,7 +3350,9 @@ void MPEG4Writer::threadFunc() {
         // to reduce the blocking time for media track threads.
         // Otherwise, hold the lock until the existing chunks get written to the
         // file.
-        if (chunkFound) {
+        if (chunkFound && mFragmented) {
+            addFragmentSample_l(&chunk);
+        } else if (chunkFound) {
             if (mIsRealTimeRecording) {
                 mLock.unlock();
             }
@@ -3698,6 +3963,7 @@ status_t MPEG4Writer::Track::threadEntry() {
     int64_t lastSampleDurationUs = -1;      // Duration calculated from EOS buffer and its timestamp
     int64_t lastSampleDurationTicks = -1;   // Timescale based ticks
     int64_t sampleFileOffset = -1;
+    const bool fragmented = mOwner->isFragmented();
 
     if (mIsAudio) {
         prctl(PR_SET_NAME, (unsigned long)"MP4WtrAudTrkThread", 0, 0, 0);
@@ -3903,6 +4169,14 @@ status_t MPEG4Writer::Track::threadEntry() {
             lastSample = -1;
         }
         ALOGV("sampleFileOffset:%lld", (long long)sampleFileOffset);
+        if (sampleFileOffset != -1 && fragmented) {
+            ALOGE("Samples already in the file are not supported in a fragmented file");
+            buffer->release();
+            buffer = nullptr;
+            mSource->stop();
+            mIsMalformed = true;
+            break;
+        }
 
         /*
          * Reserve space in the file for the current sample + to be written MOOV box. If reservation
@@ -3997,7 +4271,7 @@ status_t MPEG4Writer::Track::threadEntry() {
         }
 ////////////////////////////////////////////////////////////////////////////////
         if (!mIsHeif) {
-            if (mStszTableEntries->count() == 0) {
+            if (mSampleCount == 0) {
                 mFirstSampleTimeRealUs = systemTime() / 1000;
                 if (timestampUs < 0 && mFirstSampleStartOffsetUs == 0) {
                     if (WARN_UNLESS(timestampUs != INT64_MIN, "for %s track", trackName)) {
@@ -4097,7 +4371,9 @@ status_t MPEG4Writer::Track::threadEntry() {
                     break;
                 }
 
-                if (mStszTableEntries->count() == 0) {
+                if (fragmented) {
+                    // Composition offsets are written in the track fragment runs.
+                } else if (mSampleCount == 0) {
                     // Force the first ctts table entry to have one single entry
                     // so that we can do adjustment for the initial track start
                     // time offset easily in writeCttsBox().
@@ -4115,7 +4391,7 @@ status_t MPEG4Writer::Track::threadEntry() {
                 }
 
                 // Update ctts time offset range
-                if (mStszTableEntries->count() == 0) {
+                if (mSampleCount == 0) {
                     mMinCttsOffsetTicks = currCttsOffsetTimeTicks;
                     mMaxCttsOffsetTicks = currCttsOffsetTimeTicks;
                 } else {
@@ -4181,9 +4457,14 @@ status_t MPEG4Writer::Track::threadEntry() {
                     timestampUs += deltaUs;
                 }
             }
-            mStszTableEntries->add(htonl(sampleSize));
+            if (!fragmented) {
+                mStszTableEntries->add(htonl(sampleSize));
+            }
+            ++mSampleCount;
 
-            if (mStszTableEntries->count() > 2) {
+            if (fragmented) {
+                // Sample durations are written in the track fragment runs.
+            } else if (mSampleCount > 2) {
 
                 // Force the first sample to have its own stts entry so that
                 // we can adjust its value later to maintain the A/V sync.
@@ -4195,7 +4476,7 @@ status_t MPEG4Writer::Track::threadEntry() {
                 }
             }
             if (mSamplesHaveSameSize) {
-                if (mStszTableEntries->count() >= 2 && previousSampleSize != sampleSize) {
+                if (mSampleCount >= 2 && previousSampleSize != sampleSize) {
                     mSamplesHaveSameSize = false;
                 }
                 previousSampleSize = sampleSize;
@@ -4206,8 +4487,8 @@ status_t MPEG4Writer::Track::threadEntry() {
             lastDurationTicks = currDurationTicks;
             lastTimestampUs = timestampUs;
 
-            if (isSync != 0) {
-                addOneStssTableEntry(mStszTableEntries->count());
+            if (isSync != 0 && !fragmented) {
+                addOneStssTableEntry(mSampleCount);
             }
 
             if (mTrackingProgressStatus) {
@@ -4228,6 +4509,18 @@ status_t MPEG4Writer::Track::threadEntry() {
             continue;
         }
 
+        if (fragmented) {
+            // Each sample goes to the writer thread on its own, which groups the
+            // samples of all the tracks into movie fragments.
+            mChunkSamples.push_back(copy);
+            Chunk chunk(this, timestampUs, mChunkSamples);
+            chunk.mCompositionOffsetUs = mIsVideo ? cttsOffsetTimeUs - kMaxCttsOffsetTimeUs : 0;
+            chunk.mIsSyncSample = !mIsVideo || isSync;
+            mOwner->bufferChunk(chunk);
+            mChunkSamples.clear();
+            continue;
+        }
+
         if (!hasMultipleTracks) {
             size_t bytesWritten;
             off64_t offset = mOwner->addSample_l(
@@ -4282,16 +4575,25 @@ status_t MPEG4Writer::Track::threadEntry() {
     mOwner->trackProgressStatus(mTrackId.getId(), -1, err);
 
     // Add final entries only for non-empty tracks.
-    if (mStszTableEntries->count() > 0) {
+    if (mSampleCount > 0) {
         if (mIsHeif) {
             if (!mChunkSamples.empty()) {
                 bufferChunk(0);
                 ++nChunks;
             }
+        } else if (fragmented) {
+            // We don't know how long the last sample lasts either, see below.
+            if (lastSampleDurationUs >= 0) {
+                mLastSampleDurationTicks = lastSampleDurationTicks;
+                mTrackDurationUs += lastSampleDurationUs;
+            } else {
+                mLastSampleDurationTicks = lastDurationTicks;
+                mTrackDurationUs += lastDurationUs;
+            }
         } else {
             // Last chunk
             if (!hasMultipleTracks) {
-                addOneStscTableEntry(1, mStszTableEntries->count());
+                addOneStscTableEntry(1, mSampleCount);
             } else if (!mChunkSamples.empty()) {
                 addOneStscTableEntry(++nChunks, mChunkSamples.size());
                 bufferChunk(timestampUs);
@@ -4300,7 +4602,7 @@ status_t MPEG4Writer::Track::threadEntry() {
             // We don't really know how long the last frame lasts, since
             // there is no frame time after it, just repeat the previous
             // frame's duration.
-            if (mStszTableEntries->count() == 1) {
+            if (mSampleCount == 1) {
                 if (lastSampleDurationUs >= 0) {
                     addOneSttsTableEntry(sampleCount, lastSampleDurationTicks);
                 } else {
@@ -4335,7 +4637,7 @@ status_t MPEG4Writer::Track::threadEntry() {
     sendTrackSummary(hasMultipleTracks);
 
     ALOGI("Received total/0-length (%d/%d) buffers and encoded %d frames. - %s",
-            count, nZeroLengthFrames, mStszTableEntries->count(), trackName);
+            count, nZeroLengthFrames, mSampleCount, trackName);
     if (mIsAudio) {
         ALOGI("Audio track drift time: %" PRId64 " us", mOwner->getDriftTimeUs());
     }
@@ -4356,26 +4658,26 @@ bool MPEG4Writer::Track::isTrackMalFormed() {
         mOwner->mStartMeta->findInt32(kKeyEmptyTrackMalFormed, &emptyTrackMalformed) &&
         emptyTrackMalformed) {
         // MediaRecorder(sets kKeyEmptyTrackMalFormed by default) report empty tracks as malformed.
-        if (!mIsHeif && mStszTableEntries->count() == 0) {  // no samples written
+        if (!mIsHeif && mSampleCount == 0) {  // no samples written
             ALOGE("The number of recorded samples is 0");
             mIsMalformed = true;
             return true;
         }
-        if (mIsVideo && mStssTableEntries->count() == 0) {  // no sync frames for video
+        if (mIsVideo && !mGotStartKeyFrame) {  // no sync frames for video
             ALOGE("There are no sync frames for video track");
             mIsMalformed = true;
             return true;
         }
     } else {
         // Through MediaMuxer, empty tracks can be added. No sync frames for video.
-        if (mIsVideo && mStszTableEntries->count() > 0 && mStssTableEntries->count() == 0) {
+        if (mIsVideo && mSampleCount > 0 && !mGotStartKeyFrame) {
             ALOGE("There are no sync frames for video track");
             mIsMalformed = true;
             return true;
         }
     }
     // Don't check for CodecSpecificData when track is empty.
-    if (mStszTableEntries->count() > 0 && OK != checkCodecSpecificData()) {
+    if (mSampleCount > 0 && OK != checkCodecSpecificData()) {
         // No codec specific data.
         mIsMalformed = true;
         return true;
@@ -4403,7 +4705,7 @@ void MPEG4Writer::Track::sendTrackSummary(bool hasMultipleTracks) {
 
     mOwner->notify(MEDIA_RECORDER_TRACK_EVENT_INFO,
                     trackNum | MEDIA_RECORDER_TRACK_INFO_ENCODED_FRAMES,
-                    mStszTableEntries->count());
+                    mSampleCount);
 
     {
         // The system delay time excluding the requested initial delay that
@@ -4647,7 +4949,7 @@ int64_t MPEG4Writer::Track::getMinCttsOffsetTimeUs() {
 void MPEG4Writer::Track::writeStblBox() {
     mOwner->beginBox("stbl");
     // Add subboxes for only non-empty and well-formed tracks.
-    if (mStszTableEntries->count() > 0 && !isTrackMalFormed()) {
+    if (mSampleCount > 0 && !isTrackMalFormed()) {
         mOwner->beginBox("stsd");
         mOwner->writeInt32(0);               // version=0, flags=0
         mOwner->writeInt32(1);               // entry count
@@ -4660,9 +4962,13 @@ void MPEG4Writer::Track::writeStblBox() {
         }
         mOwner->endBox();  // stsd
         writeSttsBox();
+        // The sample tables of a fragmented file are empty, and an empty stss
+        // box would mean that no sample is a sync sample.
         if (mIsVideo) {
             writeCttsBox();
-            writeStssBox();
+            if (!mOwner->isFragmented()) {
+                writeStssBox();
+            }
         }
         writeStszBox();
         writeStscBox();
@@ -5036,7 +5342,8 @@ void MPEG4Writer::Track::writeTkhdBox(uint32_t now) {
     mOwner->writeInt32(now);           // modification time
     mOwner->writeInt32(mTrackId.getId()); // track id starts with 1
     mOwner->writeInt32(0);             // reserved
-    int64_t trakDurationUs = getDurationUs();
+    // The duration of a fragmented movie is not known when its moov box is written.
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int32_t mvhdTimeScale = mOwner->getTimeScale();
     int32_t tkhdDuration =
         (trakDurationUs * mvhdTimeScale + 5E5) / 1E6;
@@ -5125,7 +5432,10 @@ void MPEG4Writer::Track::writeEdtsBox() {
     ALOGV("movieStartOffsetBFramesUs:%" PRId32, movieStartOffsetBFramesUs);
 
     // This media/track's real duration (sum of duration of all samples in this track).
-    uint32_t tkhdDurationTicks = (mTrackDurationUs * mvhdTimeScale + 5E5) / 1E6;
+    // It is not known yet when the moov box of a fragmented file is written, and an
+    // edit with a zero duration then lasts until the end of the track.
+    uint32_t tkhdDurationTicks =
+            mOwner->isFragmented() ? 0 : (mTrackDurationUs * mvhdTimeScale + 5E5) / 1E6;
     ALOGV("mTrackDurationUs:%" PRId64 "us", mTrackDurationUs);
 
     int64_t movieStartTimeUs = mOwner->getStartTimestampUs();
@@ -5153,7 +5463,9 @@ void MPEG4Writer::Track::writeEdtsBox() {
             int32_t mediaTime = (mFirstSampleStartOffsetUs * mTimeScale + 5E5) / 1E6;
             int32_t firstSampleOffsetTicks =
                     (mFirstSampleStartOffsetUs * mvhdTimeScale + 5E5) / 1E6;
-            if (tkhdDurationTicks >= firstSampleOffsetTicks) {
+            if (mOwner->isFragmented()) {
+                addOneElstTableEntry(0, mediaTime, 1, 0);
+            } else if (tkhdDurationTicks >= firstSampleOffsetTicks) {
                 // samples before 0 don't count in for duration, hence subtract
                 // firstSampleOffsetTicks.
                 addOneElstTableEntry(tkhdDurationTicks - firstSampleOffsetTicks, mediaTime, 1, 0);
@@ -5254,7 +5566,7 @@ void MPEG4Writer::Track::writeEdtsBox() {
 }
 
 void MPEG4Writer::Track::writeMdhdBox(uint32_t now) {
-    int64_t trakDurationUs = getDurationUs();
+    int64_t trakDurationUs = mOwner->isFragmented() ? 0 : getDurationUs();
     int64_t mdhdDuration = (trakDurationUs * mTimeScale + 5E5) / 1E6;
     mOwner->beginBox("mdhd");
 
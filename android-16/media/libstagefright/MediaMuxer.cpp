@@ -47,9 +47,13 @@ namespace android {
 static bool isMp4Format(MediaMuxer::OutputFormat format) {
     return format == MediaMuxer::OUTPUT_FORMAT_MPEG_4 ||
            format == MediaMuxer::OUTPUT_FORMAT_THREE_GPP ||
-           format == MediaMuxer::OUTPUT_FORMAT_HEIF;
+           format == MediaMuxer::OUTPUT_FORMAT_HEIF ||
+           format == MediaMuxer::OUTPUT_FORMAT_MPEG_4_FRAGMENTED;
 }
 
+// Duration of the movie fragments of OUTPUT_FORMAT_MPEG_4_FRAGMENTED files.
+static const int64_t kFragmentDurationUs = 1000000LL;
+
 MediaMuxer* MediaMuxer::create(int fd, OutputFormat format) {
     bool isInputValid = true;
     if (isMp4Format(format)) {
@@ -92,6 +96,8 @@ MediaMuxer::MediaMuxer(int fd, OutputFormat format)
             mFileMeta->setInt32(kKeyFileType, output_format::OUTPUT_FORMAT_HEIF);
         } else if (format == OUTPUT_FORMAT_OGG) {
             mFileMeta->setInt32(kKeyFileType, output_format::OUTPUT_FORMAT_OGG);
+        } else if (format == OUTPUT_FORMAT_MPEG_4_FRAGMENTED) {
+            mFileMeta->setInt64(kKeyFragmentDurationUs, kFragmentDurationUs);
         }
         mState = INITIALIZED;
     }
@@ -167,11 +167,16 @@ private:
         int64_t             mTimeStampUs;   // Timestamp of the 1st sample
         List<MediaBuffer *> mSamples;       // Sample data
 
+        // Only used in fragmented mode, where each chunk holds a single sample.
+        int64_t             mCompositionOffsetUs;
+        bool                mIsSyncSample;
+
         // Convenient constructor
-        Chunk(): mTrack(NULL), mTimeStampUs(0) {}
+        Chunk(): mTrack(NULL), mTimeStampUs(0), mCompositionOffsetUs(0), mIsSyncSample(false) {}
 
         Chunk(Track *track, int64_t timeUs, List<MediaBuffer *> samples)
-            : mTrack(track), mTimeStampUs(timeUs), mSamples(samples) {
+            : mTrack(track), mTimeStampUs(timeUs), mSamples(samples),
+              mCompositionOffsetUs(0), mIsSyncSample(false) {
         }
 
     };
@@ -185,6 +190,10 @@ private:
         // Max time interval between neighboring chunks
         int64_t mMaxInterChunkDurUs;
 
+        // Fragmented mode: samples waiting for the next movie fragment.
+        // Only accessed by the writer thread.
+        List<Chunk> mFragmentSamples;
+
     };
 
     bool            mIsFirstChunk;
@@ -253,6 +262,14 @@ private:
 
     bool mHasDolbyVision;
 
+    // Fragmented MP4 writing
+    bool mFragmented;
+    int64_t mFragmentDurationUs;
+    uint32_t mFragmentSequenceNumber;
+    int64_t mFragmentStartTimeUs;   // Decoding time of the first sample of the next fragment
+    int64_t mFragmentBaseTimeUs;    // Movie start time, fixed when the first fragment is cut
+    bool mFragmentInitWritten;      // Whether the moov box has been written
+
     // Writer thread handling
     status_t startWriterThread();
     status_t stopWriterThread();
@@ -274,6 +291,21 @@ private:
     // Actually write the given chunk to the file.
     void writeChunkToFile(Chunk* chunk);
 
+    // Fragmented mode: queue the sample of the given chunk for the next movie
+    // fragment, and write out a fragment once enough samples are pending.
+    // Acquire lock before calling this method.
+    void addFragmentSample_l(Chunk* chunk);
+
+    // Fragmented mode: write the pending samples decoded before cutTimeUs as a
+    // moof + mdat pair, writing the moov box first if needed. When flushAll is
+    // set, all pending samples are written. Must be called without the lock held.
+    void writeFragment(int64_t cutTimeUs, bool flushAll);
+
+    // Fragmented mode: the track whose sync samples start new fragments.
+    Track *fragmentLeadTrack();
+    int64_t fragmentStartOffsetUs(const Track *track) const;
+    bool isFragmented() const { return mFragmented; }
+
     // Adjust other track media clock (presumably wall clock)
     // based on audio track media clock with the drift time.
     int64_t mDriftTimeUs;
@@ -323,6 +355,7 @@ private:
     void writeCompositionMatrix(int32_t degrees);
     void writeMvhdBox(int64_t durationUs);
     void writeMoovBox(int64_t durationUs);
+    void writeMvexBox();
     void writeFtypBox(MetaData *param);
     void writeUdtaBox();
     void writeGeoDataBox();
@@ -41,6 +41,8 @@ public:
         OUTPUT_FORMAT_THREE_GPP   = 2,
         OUTPUT_FORMAT_HEIF        = 3,
         OUTPUT_FORMAT_OGG         = 4,
+        // MPEG4 file made of movie fragments, which can be read while it is written.
+        OUTPUT_FORMAT_MPEG_4_FRAGMENTED = 5,
         OUTPUT_FORMAT_LIST_END // must be last - used to validate format type
     };
 
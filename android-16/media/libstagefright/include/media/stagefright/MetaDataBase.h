@@ -139,6 +139,10 @@ enum {
     kKeyRealTimeRecording = 'rtrc',  // bool (int32_t)
     kKeyBackgroundMode = 'bkmd',  // bool (int32_t)
 
+    // Duration of each movie fragment when authoring a fragmented MPEG4 file.
+    // The file is not fragmented if the key is missing or not positive.
+    kKeyFragmentDurationUs = 'mfdu',  // int64_t
+
     kKeyNumBuffers        = 'nbbf',  // int32_t
 
     // Ogg files can be tagged to be automatically looping...
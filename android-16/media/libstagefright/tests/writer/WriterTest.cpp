@@ -48,6 +48,8 @@
 constexpr int32_t kMpeg4MuxToleranceTimeUs = 100;
 // Tolerance value for other writers
 constexpr int32_t kMuxToleranceTimeUs = 1;
+// Short enough for the fragmented MPEG4 writer to write several movie fragments.
+constexpr int64_t kFragmentDurationUs = 500000;
 
 static WriterTestEnvironment *gEnv = nullptr;
 
@@ -149,7 +151,8 @@ class WriterTest {
         mDisableTest = false;
         static const std::map<std::string, standardWriters> mapWriter = {
                 {"ogg", OGG},     {"aac", AAC},      {"aac_adts", AAC_ADTS}, {"webm", WEBM},
-                {"mpeg4", MPEG4}, {"amrnb", AMR_NB}, {"amrwb", AMR_WB},      {"mpeg2Ts", MPEG2TS}};
+                {"mpeg4", MPEG4}, {"amrnb", AMR_NB}, {"amrwb", AMR_WB},      {"mpeg2Ts", MPEG2TS},
+                {"fragmentedMpeg4", FRAGMENTED_MPEG4}};
         // Find the component type
         if (mapWriter.find(writerFormat) != mapWriter.end()) {
             mWriterName = mapWriter.at(writerFormat);
@@ -180,6 +183,7 @@ class WriterTest {
         AAC_ADTS,
         WEBM,
         MPEG4,
+        FRAGMENTED_MPEG4,
         AMR_NB,
         AMR_WB,
         MPEG2TS,
@@ -250,6 +254,11 @@ int32_t WriterTest::createWriter(int32_t fd) {
             mWriter = new MPEG4Writer(fd);
             mFileMeta->setInt32(kKeyFileType, output_format::OUTPUT_FORMAT_MPEG_4);
             break;
+        case FRAGMENTED_MPEG4:
+            mWriter = new MPEG4Writer(fd);
+            mFileMeta->setInt32(kKeyFileType, output_format::OUTPUT_FORMAT_MPEG_4);
+            mFileMeta->setInt64(kKeyFragmentDurationUs, kFragmentDurationUs);
+            break;
         case AMR_NB:
             mWriter = new AMRWriter(fd);
             mFileMeta->setInt32(kKeyFileType, output_format::OUTPUT_FORMAT_AMR_NB);
@@ -448,7 +457,7 @@ void WriterTest::compareParams(configFormat srcParam, configFormat dstParam,
     }
 
     int32_t toleranceValueUs = kMuxToleranceTimeUs;
-    if (mWriterName == MPEG4) {
+    if (mWriterName == MPEG4 || mWriterName == FRAGMENTED_MPEG4) {
         toleranceValueUs = kMpeg4MuxToleranceTimeUs;
     }
     for (int32_t i = 0; i < dstBufInfo.size(); i++) {
@@ -1066,6 +1075,14 @@ INSTANTIATE_TEST_SUITE_P(
                 make_tuple("mpeg4", H263_1, AMR_NB_1, 0.50),
                 make_tuple("mpeg4", MPEG4_1, HEVC_1, 0.75),
 
+                make_tuple("fragmentedMpeg4", AAC_1, UNUSED_ID, 1),
+                make_tuple("fragmentedMpeg4", AVC_1, UNUSED_ID, 1),
+                make_tuple("fragmentedMpeg4", HEVC_1, UNUSED_ID, 1),
+                make_tuple("fragmentedMpeg4", MPEG4_1, UNUSED_ID, 1),
+                make_tuple("fragmentedMpeg4", AAC_1, AVC_1, 0.25),
+                make_tuple("fragmentedMpeg4", AVC_1, AAC_1, 0.75),
+                make_tuple("fragmentedMpeg4", HEVC_1, AMR_WB_1, 0.25),
+
                 make_tuple("ogg", OPUS_1, UNUSED_ID, 1),
 
                 make_tuple("webm", OPUS_1, UNUSED_ID, 1),
@@ -21,6 +21,7 @@
 #include "MP3Extractor.h"
 
 #include "ID3.h"
+#include "MP3FrameIndex.h"
 #include "VBRISeeker.h"
 #include "XINGSeeker.h"
 
@@ -28,6 +29,7 @@
 #include <media/stagefright/foundation/AMessage.h>
 #include <media/stagefright/foundation/avc_utils.h>
 #include <media/stagefright/foundation/ByteUtils.h>
+#include <media/stagefright/DataSourceBase.h>
 #include <media/stagefright/MediaBufferBase.h>
 #include <media/stagefright/MediaBufferGroup.h>
 #include <media/stagefright/MediaDefs.h>
@@ -212,7 +214,7 @@ public:
     MP3Source(
             AMediaFormat *meta, DataSourceHelper *source,
             off64_t first_frame_pos, uint32_t fixed_header,
-            MP3Seeker *seeker);
+            MP3Seeker *seeker, MP3FrameIndex *frameIndex);
 
     virtual media_status_t start();
     virtual media_status_t stop();
@@ -236,9 +238,22 @@ private:
     bool mStarted = false;
     MP3Seeker *mSeeker = NULL;
 
+    // Used to seek when there is no seeker.
+    MP3FrameIndex *mFrameIndex = NULL;
+    // Number of the frame at mCurrentPos, or -1 after a seek estimated from
+    // the bitrate.
+    int64_t mFrameNumber = -1;
+    int mSampleRate = 0;
+    int mSamplesPerFrame = 0;
+    // Whether the frame headers may be read up to the seek position to find
+    // the frame to seek to.
+    bool mCanScanToSeek = false;
+
     int64_t mBasisTimeUs = 0;
     int64_t mSamplesRead = 0;
 
+    bool seekWithFrameIndex(int64_t seekTimeUs);
+
     MP3Source(const MP3Source &);
     MP3Source &operator=(const MP3Source &);
 };
@@ -291,7 +306,9 @@ MP3Extractor::MP3Extractor(
         }
     }
 
-    if (mSeeker != NULL) {
+    if (mSeeker == NULL) {
+        mFrameIndex = new MP3FrameIndex(mFirstFramePos, mFixedHeader, kMask);
+    } else {
         // While it is safe to send the XING/VBRI frame to the decoder, this will
         // result in an extra 1152 samples being output. In addition, the bitrate
         // of the Xing header might not match the rest of the file, which could
@@ -401,6 +418,7 @@ MP3Extractor::MP3Extractor(
 
 MP3Extractor::~MP3Extractor() {
     delete mSeeker;
+    delete mFrameIndex;
     delete mDataSource;
     AMediaFormat_delete(mMeta);
 }
@@ -416,7 +434,7 @@ MediaTrackHelper *MP3Extractor::getTrack(size_t index) {
 
     return new MP3Source(
             mMeta, mDataSource, mFirstFramePos, mFixedHeader,
-            mSeeker);
+            mSeeker, mFrameIndex);
 }
 
 media_status_t MP3Extractor::getTrackMetaData(
@@ -441,12 +459,20 @@ const size_t MP3Source::kMaxFrameSize = (1 << 12); /* 4096 bytes */
 MP3Source::MP3Source(
         AMediaFormat *meta, DataSourceHelper *source,
         off64_t first_frame_pos, uint32_t fixed_header,
-        MP3Seeker *seeker)
+        MP3Seeker *seeker, MP3FrameIndex *frameIndex)
     : mMeta(meta),
       mDataSource(source),
       mFirstFramePos(first_frame_pos),
       mFixedHeader(fixed_header),
-      mSeeker(seeker) {
+      mSeeker(seeker),
+      mFrameIndex(frameIndex) {
+    size_t frame_size;
+    if (!GetMPEGAudioFrameSize(
+            fixed_header, &frame_size, &mSampleRate, NULL, NULL, &mSamplesPerFrame)
+            || mSampleRate <= 0 || mSamplesPerFrame <= 0) {
+        mFrameIndex = NULL;
+    }
+    mCanScanToSeek = MP3FrameIndex::CanScan(mDataSource);
 }
 
 MP3Source::~MP3Source() {
@@ -462,6 +488,7 @@ media_status_t MP3Source::start() {
 
     mCurrentPos = mFirstFramePos;
     mCurrentTimeUs = 0;
+    mFrameNumber = 0;
 
     mBasisTimeUs = mCurrentTimeUs;
     mSamplesRead = 0;
@@ -493,7 +520,10 @@ media_status_t MP3Source::read(
 
     if (options != NULL && options->getSeekTo(&seekTimeUs, &mode)) {
         int64_t actualSeekTimeUs = seekTimeUs;
-        if (mSeeker == NULL
+        if (mFrameIndex != NULL && seekWithFrameIndex(seekTimeUs)) {
+            ALOGV("seek to %lld: frame %lld at %lld", (long long)seekTimeUs,
+                    (long long)mFrameNumber, (long long)mCurrentPos);
+        } else if (mSeeker == NULL
                 || !mSeeker->getOffsetForTime(&actualSeekTimeUs, &mCurrentPos)) {
             int32_t bitrate;
             if (!AMediaFormat_getInt32(mMeta, AMEDIAFORMAT_KEY_BIT_RATE, &bitrate)) {
@@ -513,6 +543,7 @@ media_status_t MP3Source::read(
                 return AMEDIA_ERROR_UNSUPPORTED;
             }
             seekCBR = true;
+            mFrameNumber = -1;
         } else {
             mCurrentTimeUs = actualSeekTimeUs;
         }
@@ -588,6 +619,13 @@ media_status_t MP3Source::read(
 
     buffer->set_range(0, frame_size);
 
+    if (mFrameNumber >= 0) {
+        if (mFrameIndex != NULL) {
+            mFrameIndex->addFrame(mFrameNumber, mCurrentPos, bitrate);
+        }
+        ++mFrameNumber;
+    }
+
     AMediaFormat *meta = buffer->meta_data();
     AMediaFormat_setInt64(meta, AMEDIAFORMAT_KEY_TIME_US, mCurrentTimeUs);
     AMediaFormat_setInt32(meta, AMEDIAFORMAT_KEY_IS_SYNC_FRAME, 1);
@@ -602,6 +640,32 @@ media_status_t MP3Source::read(
     return AMEDIA_OK;
 }
 
+// Seeks to the frame playing at |seekTimeUs|, see MP3FrameIndex::seek(). Returns
+// false if the seek position has to be estimated instead.
+bool MP3Source::seekWithFrameIndex(int64_t seekTimeUs) {
+    int64_t targetFrame = 0;
+    if (seekTimeUs > 0) {
+        if (__builtin_mul_overflow(seekTimeUs, mSampleRate, &targetFrame)) {
+            return false;
+        }
+        targetFrame /= 1000000LL * mSamplesPerFrame;
+    }
+
+    int64_t frame;
+    off64_t pos;
+    if (!mFrameIndex->seek(mDataSource, targetFrame, mCanScanToSeek,
+            [this](off64_t *resyncPos) {
+                return Resync(mDataSource, mFixedHeader, resyncPos, NULL, NULL);
+            }, &frame, &pos)) {
+        return false;
+    }
+
+    mCurrentPos = pos;
+    mFrameNumber = frame;
+    mCurrentTimeUs = frame * mSamplesPerFrame * 1000000LL / mSampleRate;
+    return true;
+}
+
 media_status_t MP3Extractor::getMetaData(AMediaFormat *meta) {
     AMediaFormat_clear(meta);
     if (mInitCheck != OK) {
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MP3FrameIndex"
+#include <utils/Log.h>
+
+#include "MP3FrameIndex.h"
+
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/DataSourceBase.h>
+#include <media/stagefright/foundation/avc_utils.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+namespace android {
+
+MP3FrameIndex::MP3FrameIndex(off64_t firstFramePos, uint32_t fixedHeader, uint32_t headerMask)
+    : mFirstFramePos(firstFramePos),
+      mFixedHeader(fixedHeader),
+      mHeaderMask(headerMask) {
+}
+
+// static
+bool MP3FrameIndex::CanScan(DataSourceHelper *source) {
+    return !(source->flags()
+            & (DataSourceBase::kWantsPrefetching
+                | DataSourceBase::kIsCachingDataSource
+                | DataSourceBase::kIsHTTPBasedSource));
+}
+
+void MP3FrameIndex::addFrame(int64_t frame, off64_t pos, int bitrate) {
+    if (frame != mNumFrames) {
+        return;
+    }
+    if (frame % kFramesPerEntry == 0) {
+        mOffsets.push_back(pos);
+        ALOGV("frame %lld at %lld", (long long)frame, (long long)pos);
+    }
+    if (frame == 0) {
+        mBitrate = bitrate;
+    } else if (bitrate != mBitrate && !mVBR) {
+        ALOGV("frame %lld has bitrate %d instead of %d", (long long)frame, bitrate, mBitrate);
+        mVBR = true;
+    }
+    ++mNumFrames;
+}
+
+bool MP3FrameIndex::findFrame(int64_t frame, int64_t *foundFrame, off64_t *pos) const {
+    if (mNumFrames == 0 || frame < 0) {
+        return false;
+    }
+    if (frame >= mNumFrames) {
+        frame = mNumFrames - 1;
+    }
+    size_t entry = frame / kFramesPerEntry;
+    *foundFrame = entry * kFramesPerEntry;
+    *pos = mOffsets[entry];
+    return true;
+}
+
+bool MP3FrameIndex::seek(DataSourceHelper *source, int64_t targetFrame, bool canScan,
+        const std::function<bool(off64_t *pos)> &resync,
+        int64_t *foundFrame, off64_t *pos) {
+    if (targetFrame >= mNumFrames && !canScan) {
+        return false;
+    }
+
+    int64_t frame;
+    off64_t framePos;
+    if (!findFrame(targetFrame, &frame, &framePos)) {
+        frame = 0;
+        framePos = mFirstFramePos;
+    }
+
+    std::vector<uint8_t> scanBuffer;
+    off64_t scanPos = 0;
+    ssize_t scanSize = 0;
+    while (frame < targetFrame) {
+        if (frame >= mNumFrames && frame >= kMaxFramesToProbe && !mVBR) {
+            ALOGV("seek to frame %lld: CBR stream", (long long)targetFrame);
+            return false;
+        }
+        if (framePos < scanPos || framePos + 4 > scanPos + scanSize) {
+            scanBuffer.resize(kScanBufferSize);
+            scanPos = framePos;
+            scanSize = source->readAt(scanPos, scanBuffer.data(), scanBuffer.size());
+            if (scanSize < 4) {
+                // past the last frame
+                break;
+            }
+        }
+        uint32_t header = U32_AT(&scanBuffer[framePos - scanPos]);
+        size_t frameSize;
+        int bitrate;
+        if ((header & mHeaderMask) != (mFixedHeader & mHeaderMask)
+                || !GetMPEGAudioFrameSize(header, &frameSize, NULL, NULL, &bitrate)) {
+            ALOGV("lost sync while seeking at %lld", (long long)framePos);
+            if (!resync(&framePos)) {
+                break;
+            }
+            continue;
+        }
+        addFrame(frame, framePos, bitrate);
+        framePos += frameSize;
+        ++frame;
+    }
+
+    *foundFrame = frame;
+    *pos = framePos;
+    return true;
+}
+
+}  // namespace android
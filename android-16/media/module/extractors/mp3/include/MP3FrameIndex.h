@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MP3_FRAME_INDEX_H_
+
+#define MP3_FRAME_INDEX_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <functional>
+#include <vector>
+
+#include <media/stagefright/foundation/ABase.h>
+
+namespace android {
+
+class DataSourceHelper;
+
+// Offsets of the frames of a stream that has no XING or VBRI seek table,
+// recorded as the frames are read while playing or seeking. Frames are
+// numbered from the first audio frame. All frames of a stream have the same
+// number of samples, so the frame playing at a given time is known, and
+// seeking to a frame that was seen before only needs to read the headers of
+// the few frames following the closest frame kept.
+//
+// Seeking past the frames seen reads the headers of all the frames up to the
+// seek position, which only pays off for VBR streams. Once kMaxFramesToProbe
+// frames of the same bitrate were seen, the stream is taken as CBR and such
+// seeks are left to the bitrate estimate.
+struct MP3FrameIndex {
+    // Every nth frame has its offset kept.
+    static constexpr int64_t kFramesPerEntry = 32;
+    // Number of frames to see before a stream of a single bitrate is taken as CBR.
+    static constexpr int64_t kMaxFramesToProbe = 1024;
+
+    // |fixedHeader| is the header of the first frame, at |firstFramePos|, and
+    // |headerMask| the bits of it that all frames of the stream have.
+    MP3FrameIndex(off64_t firstFramePos, uint32_t fixedHeader, uint32_t headerMask);
+
+    // Whether the index may be extended by reading the frame headers of
+    // |source| up to the seek position, which would download a stream.
+    static bool CanScan(DataSourceHelper *source);
+
+    // Number of frames seen from the first frame on, without gap.
+    int64_t numFrames() const { return mNumFrames; }
+
+    // Whether frames of different bitrates were seen.
+    bool isVBR() const { return mVBR; }
+
+    // Records that frame |frame| starts at |pos| and has |bitrate|. Frames
+    // past numFrames() are ignored, so that the index has no gap.
+    void addFrame(int64_t frame, off64_t pos, int bitrate);
+
+    // Finds the last frame kept at or before frame |frame|, or before the
+    // last frame seen if |frame| was not seen yet. Returns false if no frame
+    // was seen.
+    bool findFrame(int64_t frame, int64_t *foundFrame, off64_t *pos) const;
+
+    // Finds frame |targetFrame| in |source| from the closest frame kept,
+    // extending the index if |canScan| and the stream may be VBR. Frames that
+    // lost sync are skipped with |resync|, which moves the position to the
+    // next frame. Returns the last frame found if the stream ends before.
+    // Returns false if the frame was not found and should be estimated.
+    bool seek(DataSourceHelper *source, int64_t targetFrame, bool canScan,
+            const std::function<bool(off64_t *pos)> &resync,
+            int64_t *foundFrame, off64_t *pos);
+
+private:
+    // Frame headers are read in chunks of this size when seeking.
+    static constexpr size_t kScanBufferSize = 1 << 16;
+
+    const off64_t mFirstFramePos;
+    const uint32_t mFixedHeader;
+    const uint32_t mHeaderMask;
+    // offsets of the frames at multiples of kFramesPerEntry
+    std::vector<off64_t> mOffsets;
+    int64_t mNumFrames = 0;
+    int mBitrate = 0;
+    bool mVBR = false;
+
+    DISALLOW_EVIL_CONSTRUCTORS(MP3FrameIndex);
+};
+
+}  // namespace android
+
+#endif  // MP3_FRAME_INDEX_H_
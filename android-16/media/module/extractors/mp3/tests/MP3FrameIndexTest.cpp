@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <MP3FrameIndex.h>
+#include <gtest/gtest.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/DataSourceBase.h>
+
+using namespace android;
+
+namespace {
+
+// MPEG-1 layer III, 44.1 kHz, stereo, as matched by MP3Extractor.
+constexpr uint32_t kFixedHeader = 0xfffb0000;
+constexpr uint32_t kHeaderMask = 0xfffe0c00;
+// bitrate indices of 128 and 192 kbps
+constexpr uint32_t k128kbps = 9;
+constexpr uint32_t k192kbps = 11;
+constexpr off64_t kFirstFramePos = 100;  // after an ID3 tag
+
+// An MP3 stream in memory, which counts the reads of its data.
+class Mp3Source : public DataSourceHelper {
+public:
+    // The frames have the bitrates at |bitrateIndices|, in turn.
+    Mp3Source(size_t numFrames, const std::vector<uint32_t> &bitrateIndices, uint32_t flags)
+        : DataSourceHelper((CDataSource *)nullptr), mData(kFirstFramePos), mFlags(flags) {
+        for (size_t i = 0; i < numFrames; ++i) {
+            const uint32_t index = bitrateIndices[i % bitrateIndices.size()];
+            const size_t size = 144 * (index == k128kbps ? 128000 : 192000) / 44100;
+            const uint32_t header = kFixedHeader | (index << 12);
+            mOffsets.push_back(mData.size());
+            mData.resize(mData.size() + size);
+            uint8_t *frame = &mData[mOffsets.back()];
+            frame[0] = header >> 24;
+            frame[1] = header >> 16;
+            frame[2] = header >> 8;
+            frame[3] = header;
+        }
+    }
+
+    ssize_t readAt(off64_t offset, void *data, size_t size) override {
+        ++mReads;
+        if (offset < 0 || (size_t)offset >= mData.size()) {
+            return 0;
+        }
+        size = std::min(size, mData.size() - (size_t)offset);
+        memcpy(data, mData.data() + offset, size);
+        return size;
+    }
+
+    status_t getSize(off64_t *size) override {
+        *size = mData.size();
+        return OK;
+    }
+
+    uint32_t flags() override {
+        return mFlags;
+    }
+
+    off64_t offset(size_t frame) const { return mOffsets[frame]; }
+    size_t reads() const { return mReads; }
+
+private:
+    std::vector<uint8_t> mData;
+    std::vector<off64_t> mOffsets;
+    const uint32_t mFlags;
+    size_t mReads = 0;
+};
+
+bool noResync(off64_t *) {
+    return false;
+}
+
+// Records the frames up to |numFrames|, as the track does when playing.
+void play(MP3FrameIndex *index, const Mp3Source &source, size_t numFrames, uint32_t bitrate) {
+    for (size_t i = 0; i < numFrames; ++i) {
+        index->addFrame(i, source.offset(i), bitrate);
+    }
+}
+
+TEST(MP3FrameIndexTest, LookupAndExtension) {
+    MP3FrameIndex index(kFirstFramePos, kFixedHeader, kHeaderMask);
+    int64_t frame;
+    off64_t pos;
+    EXPECT_FALSE(index.findFrame(0, &frame, &pos));
+
+    for (int64_t i = 0; i < 100; ++i) {
+        index.addFrame(i, 1000 * i, 128);
+    }
+    // frames past the index leave no gap
+    index.addFrame(101, 101000, 128);
+    EXPECT_EQ(100, index.numFrames());
+    EXPECT_FALSE(index.isVBR());
+
+    ASSERT_TRUE(index.findFrame(0, &frame, &pos));
+    EXPECT_EQ(0, frame);
+    EXPECT_EQ(0, pos);
+    ASSERT_TRUE(index.findFrame(70, &frame, &pos));
+    EXPECT_EQ(64, frame);
+    EXPECT_EQ(64000, pos);
+    ASSERT_TRUE(index.findFrame(1000, &frame, &pos));
+    EXPECT_EQ(96, frame);
+    EXPECT_EQ(96000, pos);
+    EXPECT_FALSE(index.findFrame(-1, &frame, &pos));
+
+    index.addFrame(100, 100000, 192);
+    EXPECT_EQ(101, index.numFrames());
+    EXPECT_TRUE(index.isVBR());
+}
+
+TEST(MP3FrameIndexTest, SeekInsideIndex) {
+    Mp3Source source(2000, {k128kbps, k192kbps, k128kbps}, 0 /* flags */);
+    MP3FrameIndex index(kFirstFramePos, kFixedHeader, kHeaderMask);
+    play(&index, source, 1500, 128);
+
+    for (int64_t target : {0, 31, 32, 777, 1499}) {
+        const size_t reads = source.reads();
+        int64_t frame;
+        off64_t pos;
+        ASSERT_TRUE(index.seek(&source, target, false /* canScan */, noResync, &frame, &pos));
+        EXPECT_EQ(target, frame);
+        EXPECT_EQ(source.offset(target), pos) << "frame " << target;
+        // the headers following the closest frame kept are in a single read
+        EXPECT_LE(source.reads() - reads, 1u) << "frame " << target;
+    }
+}
+
+TEST(MP3FrameIndexTest, SeekPastIndexScansVbr) {
+    Mp3Source source(5000, {k128kbps, k192kbps, k128kbps}, 0 /* flags */);
+    MP3FrameIndex index(kFirstFramePos, kFixedHeader, kHeaderMask);
+
+    int64_t frame;
+    off64_t pos;
+    ASSERT_TRUE(index.seek(&source, 4000, true /* canScan */, noResync, &frame, &pos));
+    EXPECT_EQ(4000, frame);
+    EXPECT_EQ(source.offset(4000), pos);
+    EXPECT_TRUE(index.isVBR());
+    EXPECT_EQ(4000, index.numFrames());
+
+    // seeks past the end land after the last frame
+    ASSERT_TRUE(index.seek(&source, 6000, true /* canScan */, noResync, &frame, &pos));
+    EXPECT_EQ(5000, frame);
+    EXPECT_EQ(5000, index.numFrames());
+}
+
+TEST(MP3FrameIndexTest, SeekPastIndexEstimatesCbr) {
+    Mp3Source source(20000, {k128kbps}, 0 /* flags */);
+    MP3FrameIndex index(kFirstFramePos, kFixedHeader, kHeaderMask);
+
+    int64_t frame;
+    off64_t pos;
+    ASSERT_TRUE(index.seek(&source, 500, true /* canScan */, noResync, &frame, &pos));
+    EXPECT_EQ(source.offset(500), pos);
+
+    // the scan stops once the stream is known to be CBR
+    EXPECT_FALSE(index.seek(&source, 19000, true /* canScan */, noResync, &frame, &pos));
+    EXPECT_EQ(MP3FrameIndex::kMaxFramesToProbe, index.numFrames());
+    const size_t reads = source.reads();
+    EXPECT_FALSE(index.seek(&source, 19000, true /* canScan */, noResync, &frame, &pos));
+    EXPECT_LE(source.reads() - reads, 1u);
+    RecordProperty("reads", (int)source.reads());
+}
+
+TEST(MP3FrameIndexTest, NoScanForStreams) {
+    for (uint32_t flags : std::vector<uint32_t>{DataSourceBase::kWantsPrefetching,
+            DataSourceBase::kIsCachingDataSource,
+            DataSourceBase::kIsHTTPBasedSource,
+            DataSourceBase::kIsCachingDataSource | DataSourceBase::kIsHTTPBasedSource}) {
+        Mp3Source source(2000, {k128kbps, k192kbps}, flags);
+        ASSERT_FALSE(MP3FrameIndex::CanScan(&source)) << "flags " << flags;
+        MP3FrameIndex index(kFirstFramePos, kFixedHeader, kHeaderMask);
+        play(&index, source, 100, 128);
+
+        int64_t frame;
+        off64_t pos;
+        EXPECT_FALSE(index.seek(&source, 1000, MP3FrameIndex::CanScan(&source), noResync,
+                &frame, &pos)) << "flags " << flags;
+        EXPECT_EQ(0u, source.reads()) << "flags " << flags;
+        // seeks inside the index still read frame headers
+        EXPECT_TRUE(index.seek(&source, 50, MP3FrameIndex::CanScan(&source), noResync,
+                &frame, &pos)) << "flags " << flags;
+        EXPECT_EQ(source.offset(50), pos);
+    }
+
+    Mp3Source local(10, {k128kbps}, 0 /* flags */);
+    EXPECT_TRUE(MP3FrameIndex::CanScan(&local));
+}
+
+}  // namespace
@@ -35,6 +35,7 @@
 #endif  //__ANDROID__
 #include "AC4Parser.h"
 #include "MPEG4Extractor.h"
+#include "SampleReadAhead.h"
 #include "SampleTable.h"
 #include "ItemTable.h"
 
@@ -87,6 +88,10 @@ enum {
     // maximum size of an atom. Some atoms can be bigger according to the spec,
     // but we only allow up to this size.
     kMaxAtomSize = 64 * 1024 * 1024,
+
+    // default size of the window of sample data read ahead for all the tracks,
+    // see SampleReadAhead.
+    kDefaultSampleReadAheadSize = 1024 * 1024,
 };
 
 static bool isAtLeastRelease([[maybe_unused]] int version,
@@ -108,9 +113,11 @@ static bool isAtLeastRelease([[maybe_unused]] int version,
 class MPEG4Source : public MediaTrackHelper {
 static const size_t  kMaxPcmFrameSize = 8192;
 public:
-    // Caller retains ownership of both "dataSource" and "sampleTable".
+    // Caller retains ownership of "dataSource", "readAhead" and "sampleTable".
+    // "readAhead" may be NULL.
     MPEG4Source(AMediaFormat *format,
                 DataSourceHelper *dataSource,
+                SampleReadAhead *readAhead,
                 int32_t timeScale,
                 const sp<SampleTable> &sampleTable,
                 Vector<SidxEntry> &sidx,
@@ -138,6 +145,7 @@ private:
 
     AMediaFormat *mFormat;
     DataSourceHelper *mDataSource;
+    SampleReadAhead *mReadAhead;
     int32_t mTimescale;
     sp<SampleTable> mSampleTable;
     uint32_t mCurrentSampleIndex;
@@ -199,6 +207,7 @@ private:
     uint64_t mElstInitialEmptyEditTicks;
 
     size_t parseNALSize(const uint8_t *data) const;
+    ssize_t readSampleData(off64_t offset, void *data, size_t size);
     status_t parseChunk(off64_t *offset);
     status_t parseTrackFragmentHeader(off64_t offset, off64_t size);
     status_t parseTrackFragmentRun(off64_t offset, off64_t size);
@@ -470,6 +479,7 @@ MPEG4Extractor::MPEG4Extractor(DataSourceHelper *source, const char *mime)
       mMoofFound(false),
       mMdatFound(false),
       mDataSource(source),
+      mSampleReadAhead(NULL),
       mInitCheck(NO_INIT),
       mHeaderTimescale(0),
       mIsQT(false),
@@ -498,6 +508,7 @@ MPEG4Extractor::~MPEG4Extractor() {
     }
     mPssh.clear();
 
+    delete mSampleReadAhead;
     delete mDataSource;
     AMediaFormat_delete(mFileMetaData);
 }
@@ -4692,7 +4703,8 @@ MediaTrackHelper *MPEG4Extractor::getTrack(size_t index) {
           elst_initial_empty_edit_ticks);
 
     MPEG4Source* source =
-            new MPEG4Source(track->meta, mDataSource, track->timescale, track->sampleTable,
+            new MPEG4Source(track->meta, mDataSource, getSampleReadAhead(),
+                            track->timescale, track->sampleTable,
                             mSidxEntries, trex, mMoofOffset, itemTable,
                             track->elst_shift_start_ticks, elst_initial_empty_edit_ticks);
     if (source->init() != OK) {
@@ -5191,6 +5203,7 @@ void MPEG4Extractor::adjustRawDefaultFrameSize() {
 MPEG4Source::MPEG4Source(
         AMediaFormat *format,
         DataSourceHelper *dataSource,
+        SampleReadAhead *readAhead,
         int32_t timeScale,
         const sp<SampleTable> &sampleTable,
         Vector<SidxEntry> &sidx,
@@ -5201,6 +5214,7 @@ MPEG4Source::MPEG4Source(
         uint64_t elstInitialEmptyEditTicks)
     : mFormat(format),
       mDataSource(dataSource),
+      mReadAhead(readAhead),
       mTimescale(timeScale),
       mSampleTable(sampleTable),
       mCurrentSampleIndex(0),
@@ -5426,9 +5440,20 @@ media_status_t MPEG4Source::stop() {
     mStarted = false;
     mCurrentSampleIndex = 0;
 
+    if (mReadAhead != NULL) {
+        mReadAhead->removeTrack(this);
+    }
+
     return AMEDIA_OK;
 }
 
+ssize_t MPEG4Source::readSampleData(off64_t offset, void *data, size_t size) {
+    if (mReadAhead != NULL) {
+        return mReadAhead->readAt(this, offset, data, size);
+    }
+    return mDataSource->readAt(offset, data, size);
+}
+
 status_t MPEG4Source::parseChunk(off64_t *offset) {
     uint32_t hdr[2];
     if (mDataSource->readAt(*offset, hdr, 8) < 8) {
@@ -6567,7 +6592,7 @@ media_status_t MPEG4Source::read(
                     return AMEDIA_ERROR_UNKNOWN;
                 }
                 uint8_t* buf = (uint8_t *)mBuffer->data();
-                ssize_t bytesRead = mDataSource->readAt(offset, buf, totalSize);
+                ssize_t bytesRead = readSampleData(offset, buf, totalSize);
                 if (bytesRead < (ssize_t)totalSize) {
                     mBuffer->release();
                     mBuffer = NULL;
@@ -6598,7 +6623,7 @@ media_status_t MPEG4Source::read(
                 mBuffer->set_range(0, totalSize);
             } else {
                 ssize_t num_bytes_read =
-                    mDataSource->readAt(offset, (uint8_t *)mBuffer->data(), size);
+                    readSampleData(offset, (uint8_t *)mBuffer->data(), size);
 
                 if (num_bytes_read < (ssize_t)size) {
                     mBuffer->release();
@@ -6668,7 +6693,7 @@ media_status_t MPEG4Source::read(
         dstData[dstOffset++] = (uint8_t)((size >> 8) & 0xFF);
         dstData[dstOffset++] = (uint8_t)((size >> 0) & 0xFF);
 
-        ssize_t numBytesRead = mDataSource->readAt(offset, dstData + dstOffset, size);
+        ssize_t numBytesRead = readSampleData(offset, dstData + dstOffset, size);
         if (numBytesRead != (ssize_t)size) {
             mBuffer->release();
             mBuffer = NULL;
@@ -6715,7 +6740,7 @@ media_status_t MPEG4Source::read(
         ssize_t num_bytes_read = 0;
         bool mSrcBufferFitsDataToRead = size <= mSrcBufferSize;
         if (mSrcBufferFitsDataToRead) {
-          num_bytes_read = mDataSource->readAt(offset, mSrcBuffer, size);
+          num_bytes_read = readSampleData(offset, mSrcBuffer, size);
         } else {
           // We are trying to read a sample larger than the expected max sample size.
           // Fall through and let the failure be handled by the following if.
@@ -7015,7 +7040,7 @@ media_status_t MPEG4Source::fragmentedRead(
             }
 
             ssize_t num_bytes_read =
-                mDataSource->readAt(offset, (uint8_t *)mBuffer->data(), size);
+                readSampleData(offset, (uint8_t *)mBuffer->data(), size);
 
             if (num_bytes_read < (ssize_t)size) {
                 mBuffer->release();
@@ -7083,7 +7108,7 @@ media_status_t MPEG4Source::fragmentedRead(
             }
             return AMEDIA_ERROR_MALFORMED;
         }
-        num_bytes_read = mDataSource->readAt(offset, data, size);
+        num_bytes_read = readSampleData(offset, data, size);
 
         if (num_bytes_read < (ssize_t)size) {
             mBuffer->release();
@@ -7179,6 +7204,23 @@ MPEG4Extractor::Track *MPEG4Extractor::findTrackByMimePrefix(
     return NULL;
 }
 
+SampleReadAhead *MPEG4Extractor::getSampleReadAhead() {
+    if (mSampleReadAhead == NULL) {
+        if (!SampleReadAhead::canReadAhead(mDataSource)) {
+            return NULL;
+        }
+        // 0 disables the read ahead.
+        size_t windowSize = base::GetUintProperty<size_t>(
+                "media.extractor.mp4.readahead_kb", kDefaultSampleReadAheadSize / 1024,
+                64 * 1024 /* max */) * 1024;
+        if (windowSize == 0) {
+            return NULL;
+        }
+        mSampleReadAhead = new SampleReadAhead(mDataSource, windowSize);
+    }
+    return mSampleReadAhead;
+}
+
 static bool LegacySniffMPEG4(DataSourceHelper *source, float *confidence) {
     uint8_t header[8];
 
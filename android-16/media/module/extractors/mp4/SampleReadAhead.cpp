@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "SampleReadAhead"
+//#define LOG_NDEBUG 0
+#include <utils/Log.h>
+
+#include "SampleReadAhead.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/DataSourceBase.h>
+#include <media/stagefright/foundation/AUtils.h>
+
+namespace android {
+
+SampleReadAhead::SampleReadAhead(DataSourceHelper *source, size_t windowSize)
+    : mSource(source),
+      mWindowSize(windowSize),
+      mWindow(NULL),
+      mWindowOffset(0),
+      mWindowFilled(0) {
+}
+
+SampleReadAhead::~SampleReadAhead() {
+    free(mWindow);
+    mWindow = NULL;
+}
+
+// static
+bool SampleReadAhead::canReadAhead(DataSourceHelper *source) {
+    return !(source->flags()
+            & (DataSourceBase::kWantsPrefetching
+                | DataSourceBase::kIsCachingDataSource
+                | DataSourceBase::kIsHTTPBasedSource));
+}
+
+ssize_t SampleReadAhead::readAt(const void *track, off64_t offset, void *data, size_t size) {
+    Mutex::Autolock autoLock(mLock);
+
+    if (offset >= 0 && size <= mWindowSize / 2) {
+        mTrackOffsets[track] = offset + size;
+    } else {
+        // Large samples would evict the data of the other tracks.
+        mTrackOffsets.erase(track);
+        return mSource->readAt(offset, data, size);
+    }
+
+    if (!isInRange(mWindowOffset, mWindowFilled, offset, size)) {
+        if (mWindow == NULL) {
+            mWindow = (uint8_t *)malloc(mWindowSize);
+            if (mWindow == NULL) {
+                return mSource->readAt(offset, data, size);
+            }
+        }
+
+        off64_t windowOffset = offset;
+        for (const auto &trackOffset : mTrackOffsets) {
+            if (trackOffset.second < windowOffset
+                    && offset + (off64_t)size - trackOffset.second <= (off64_t)mWindowSize) {
+                windowOffset = trackOffset.second;
+            }
+        }
+
+        ssize_t filled = mSource->readAt(windowOffset, mWindow, mWindowSize);
+        if (filled < 0 || windowOffset + filled < offset + (off64_t)size) {
+            // Let the source report the error, or a short read at the end of the file.
+            mWindowFilled = 0;
+            return mSource->readAt(offset, data, size);
+        }
+        mWindowOffset = windowOffset;
+        mWindowFilled = filled;
+    }
+
+    memcpy(data, mWindow + (offset - mWindowOffset), size);
+    return size;
+}
+
+void SampleReadAhead::removeTrack(const void *track) {
+    Mutex::Autolock autoLock(mLock);
+    mTrackOffsets.erase(track);
+}
+
+}  // namespace android
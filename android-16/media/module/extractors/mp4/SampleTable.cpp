@@ -18,6 +18,7 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <limits>
 
 #include "SampleTable.h"
@@ -129,6 +130,9 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mTimeToSampleCount(0),
       mTimeToSample(NULL),
       mSampleTimeEntries(NULL),
+      mTimeToSampleRuns(NULL),
+      mNumTimeToSampleRuns(0),
+      mCompositionTimeDeltaRuns(NULL),
       mCompositionTimeDeltaEntries(NULL),
       mNumCompositionTimeDeltaEntries(0),
       mCompositionDeltaLookup(new CompositionDeltaLookup),
@@ -160,6 +164,12 @@ SampleTable::~SampleTable() {
     delete[] mSampleTimeEntries;
     mSampleTimeEntries = NULL;
 
+    delete[] mTimeToSampleRuns;
+    mTimeToSampleRuns = NULL;
+
+    delete[] mCompositionTimeDeltaRuns;
+    mCompositionTimeDeltaRuns = NULL;
+
     delete mSampleIterator;
     mSampleIterator = NULL;
 }
@@ -632,13 +642,20 @@ int SampleTable::CompareIncreasingTime(const void *_a, const void *_b) {
 void SampleTable::buildSampleEntriesTable() {
     Mutex::Autolock autoLock(mLock);
 
-    if (mSampleTimeEntries != NULL || mNumSampleSizes == 0) {
+    if (mSampleTimeEntries != NULL || mTimeToSampleRuns != NULL || mNumSampleSizes == 0) {
         if (mNumSampleSizes == 0) {
             ALOGE("b/23247055, mNumSampleSizes(%u)", mNumSampleSizes);
         }
         return;
     }
 
+    // Unless frames are reordered, the samples are already sorted by
+    // composition time and their times can be found from the stts and ctts
+    // entries, without a table entry per sample.
+    if (buildTimeToSampleRuns_l()) {
+        return;
+    }
+
     mTotalSize += (uint64_t)mNumSampleSizes * sizeof(SampleTimeEntry);
     if (mTotalSize > kMaxTotalSize) {
         ALOGE("Sample entry table size would make sample table too large.\n"
@@ -714,12 +731,134 @@ void SampleTable::buildSampleEntriesTable() {
           CompareIncreasingTime);
 }
 
+bool SampleTable::buildTimeToSampleRuns_l() {
+    uint64_t allocSize = (uint64_t)mTimeToSampleCount * sizeof(TimeToSampleRun)
+            + (uint64_t)mNumCompositionTimeDeltaEntries * sizeof(uint32_t);
+    if (mTotalSize + allocSize > kMaxTotalSize) {
+        return false;
+    }
+
+    mTimeToSampleRuns = new (std::nothrow) TimeToSampleRun[mTimeToSampleCount];
+    if (!mTimeToSampleRuns) {
+        return false;
+    }
+
+    // Stop at the entry holding the last sample; the full table is used for
+    // tables that do not cover every sample, or whose times would overflow.
+    uint64_t sampleIndex = 0;
+    uint64_t sampleTime = 0;
+    mNumTimeToSampleRuns = 0;
+    while (mNumTimeToSampleRuns < mTimeToSampleCount && sampleIndex < mNumSampleSizes) {
+        uint32_t n = mTimeToSample[2 * mNumTimeToSampleRuns];
+        uint32_t delta = mTimeToSample[2 * mNumTimeToSampleRuns + 1];
+
+        TimeToSampleRun &run = mTimeToSampleRuns[mNumTimeToSampleRuns++];
+        run.mStartTime = sampleTime;
+        run.mFirstSample = sampleIndex;
+
+        uint64_t duration = (uint64_t)n * delta;
+        if (sampleTime > UINT64_MAX - INT32_MAX - duration) {
+            sampleIndex = 0;
+            break;
+        }
+        sampleIndex += n;
+        sampleTime += duration;
+    }
+
+    bool increasing = sampleIndex >= mNumSampleSizes;
+
+    if (increasing && mNumCompositionTimeDeltaEntries > 0) {
+        mCompositionTimeDeltaRuns =
+                new (std::nothrow) uint32_t[mNumCompositionTimeDeltaEntries];
+        increasing = mCompositionTimeDeltaRuns != NULL;
+    }
+
+    uint64_t compositionTimeDeltaEnd = 0;
+    for (size_t i = 0; increasing && i < mNumCompositionTimeDeltaEntries; ++i) {
+        mCompositionTimeDeltaRuns[i] = compositionTimeDeltaEnd;
+        compositionTimeDeltaEnd = std::min<uint64_t>(
+                compositionTimeDeltaEnd + (uint32_t)mCompositionTimeDeltaEntries[2 * i],
+                mNumSampleSizes);
+    }
+
+    // Samples sharing a ctts entry are in composition time order when they
+    // are in decode order, so only the first sample of each entry, and the
+    // first sample after the last one, need to be compared to the sample
+    // before them.
+    for (size_t i = 0; increasing && i <= mNumCompositionTimeDeltaEntries; ++i) {
+        sampleIndex = i < mNumCompositionTimeDeltaEntries ? mCompositionTimeDeltaRuns[i]
+                : compositionTimeDeltaEnd;
+        if (sampleIndex >= mNumSampleSizes) {
+            break;
+        }
+
+        int32_t compTimeDelta = findCompositionTimeOffset(sampleIndex);
+        if (compTimeDelta < 0
+                && getDecodeTime(sampleIndex) < (uint64_t)(-(int64_t)compTimeDelta)) {
+            increasing = false;
+        } else if (sampleIndex > 0
+                && getCompositionTime(sampleIndex - 1) > getCompositionTime(sampleIndex)) {
+            increasing = false;
+        }
+    }
+
+    if (!increasing) {
+        delete[] mTimeToSampleRuns;
+        mTimeToSampleRuns = NULL;
+        mNumTimeToSampleRuns = 0;
+
+        delete[] mCompositionTimeDeltaRuns;
+        mCompositionTimeDeltaRuns = NULL;
+        return false;
+    }
+
+    mTotalSize += allocSize;
+    return true;
+}
+
+uint64_t SampleTable::getDecodeTime(uint32_t sampleIndex) const {
+    const TimeToSampleRun *run = std::upper_bound(
+            mTimeToSampleRuns, mTimeToSampleRuns + mNumTimeToSampleRuns, sampleIndex,
+            [](uint32_t index, const TimeToSampleRun &r) { return index < r.mFirstSample; });
+    if (run == mTimeToSampleRuns) {
+        return 0;
+    }
+    --run;
+    uint32_t delta = mTimeToSample[2 * (run - mTimeToSampleRuns) + 1];
+    return run->mStartTime + (uint64_t)(sampleIndex - run->mFirstSample) * delta;
+}
+
+int32_t SampleTable::findCompositionTimeOffset(uint32_t sampleIndex) const {
+    if (mCompositionTimeDeltaRuns == NULL) {
+        return 0;
+    }
+    const uint32_t *run = std::upper_bound(mCompositionTimeDeltaRuns,
+            mCompositionTimeDeltaRuns + mNumCompositionTimeDeltaEntries, sampleIndex);
+    if (run == mCompositionTimeDeltaRuns) {
+        return 0;
+    }
+    size_t i = run - mCompositionTimeDeltaRuns - 1;
+    uint32_t sampleCount = mCompositionTimeDeltaEntries[2 * i];
+    if (sampleIndex - mCompositionTimeDeltaRuns[i] >= sampleCount) {
+        // past the last ctts entry
+        return 0;
+    }
+    return mCompositionTimeDeltaEntries[2 * i + 1];
+}
+
+uint64_t SampleTable::getCompositionTime(uint32_t sampleIndex) const {
+    int32_t compTimeDelta = findCompositionTimeOffset(sampleIndex);
+    uint64_t decodeTime = getDecodeTime(sampleIndex);
+    return compTimeDelta > 0 ? decodeTime + compTimeDelta
+            : decodeTime - (uint64_t)(-(int64_t)compTimeDelta);
+}
+
 status_t SampleTable::findSampleAtTime(
         uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
         uint32_t *sample_index, uint32_t flags) {
     buildSampleEntriesTable();
 
-    if (mSampleTimeEntries == NULL) {
+    if (mSampleTimeEntries == NULL && mTimeToSampleRuns == NULL) {
         return ERROR_OUT_OF_RANGE;
     }
 
@@ -727,7 +866,7 @@ status_t SampleTable::findSampleAtTime(
         if (req_time >= mNumSampleSizes) {
             return ERROR_OUT_OF_RANGE;
         }
-        *sample_index = mSampleTimeEntries[req_time].mSampleIndex;
+        *sample_index = getSampleIndexInTimeOrder(req_time);
         return OK;
     }
 
@@ -743,7 +882,7 @@ status_t SampleTable::findSampleAtTime(
         } else if (req_time > centerTime) {
             left = center + 1;
         } else {
-            *sample_index = mSampleTimeEntries[center].mSampleIndex;
+            *sample_index = getSampleIndexInTimeOrder(center);
             return OK;
         }
     }
@@ -792,7 +931,7 @@ status_t SampleTable::findSampleAtTime(
         }
     }
 
-    *sample_index = mSampleTimeEntries[closestIndex].mSampleIndex;
+    *sample_index = getSampleIndexInTimeOrder(closestIndex);
     return OK;
 }
 
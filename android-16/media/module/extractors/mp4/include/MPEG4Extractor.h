@@ -33,6 +33,7 @@ namespace android {
 struct AMessage;
 struct CDataSource;
 class DataSourceHelper;
+class SampleReadAhead;
 class SampleTable;
 class String8;
 namespace heif {
@@ -138,6 +139,8 @@ private:
     Vector<Trex> mTrex;
 
     DataSourceHelper *mDataSource;
+    // shared by the tracks, created with the first track.
+    SampleReadAhead *mSampleReadAhead;
     status_t mInitCheck;
     uint32_t mHeaderTimescale;
     bool mIsQT;
@@ -180,6 +183,8 @@ private:
 
     Track *findTrackByMimePrefix(const char *mimePrefix);
 
+    SampleReadAhead *getSampleReadAhead();
+
     status_t parseChannelCountSampleRate(
             off64_t *offset, uint16_t *channelCount, uint16_t *sampleRate);
     status_t parseAC3SpecificBox(off64_t offset);
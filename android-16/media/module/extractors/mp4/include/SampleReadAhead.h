@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SAMPLE_READ_AHEAD_H_
+
+#define SAMPLE_READ_AHEAD_H_
+
+#include <map>
+
+#include <sys/types.h>
+#include <utils/Mutex.h>
+
+namespace android {
+
+class DataSourceHelper;
+
+// Reads the sample data of all the tracks of a file through a window of the
+// file that is read ahead in a single request, instead of issuing one small
+// request per sample and track.
+// Each track records where its next sample starts. A read outside of the
+// window moves the window back to the first of these positions that still
+// leaves room for the read. In an interleaved file, the window then covers the
+// upcoming chunks of all the tracks being read.
+class SampleReadAhead {
+public:
+    SampleReadAhead(DataSourceHelper *source, size_t windowSize);
+    ~SampleReadAhead();
+
+    // Whether to read ahead from the source. Only local sources are read
+    // ahead: a caching or HTTP source would block each window fill until the
+    // whole window is downloaded, and caches ahead by itself.
+    static bool canReadAhead(DataSourceHelper *source);
+
+    ssize_t readAt(const void *track, off64_t offset, void *data, size_t size);
+
+    // the track no longer reads samples, until its next readAt().
+    void removeTrack(const void *track);
+
+private:
+    Mutex mLock;
+
+    DataSourceHelper *mSource;
+    const size_t mWindowSize;
+    uint8_t *mWindow;
+    off64_t mWindowOffset;
+    size_t mWindowFilled;
+
+    // offset following the last sample read by each track.
+    std::map<const void *, off64_t> mTrackOffsets;
+
+    SampleReadAhead(const SampleReadAhead &);
+    SampleReadAhead &operator=(const SampleReadAhead &);
+};
+
+}  // namespace android
+
+#endif  // SAMPLE_READ_AHEAD_H_
@@ -132,6 +132,18 @@ private:
     };
     SampleTimeEntry *mSampleTimeEntries;
 
+    // Decode time and index of the first sample of each stts entry. Used
+    // instead of mSampleTimeEntries when the composition times increase in
+    // decode order, with mCompositionTimeDeltaRuns holding the index of the
+    // first sample of each ctts entry.
+    struct TimeToSampleRun {
+        uint64_t mStartTime;
+        uint32_t mFirstSample;
+    };
+    TimeToSampleRun *mTimeToSampleRuns;
+    uint32_t mNumTimeToSampleRuns;
+    uint32_t *mCompositionTimeDeltaRuns;
+
     int32_t *mCompositionTimeDeltaEntries;
     size_t mNumCompositionTimeDeltaEntries;
     CompositionDeltaLookup *mCompositionDeltaLookup;
@@ -155,20 +167,38 @@ private:
 
     friend struct SampleIterator;
 
+    // sample_index is the rank of the sample in composition time order.
     // normally we don't round
     inline uint64_t getSampleTime(
             size_t sample_index, uint64_t scale_num, uint64_t scale_den) const {
-        return (sample_index < (size_t)mNumSampleSizes && mSampleTimeEntries != NULL
-                && scale_den != 0)
-                ? (mSampleTimeEntries[sample_index].mCompositionTime * scale_num) / scale_den : 0;
+        if (sample_index >= (size_t)mNumSampleSizes || scale_den == 0) {
+            return 0;
+        }
+        if (mSampleTimeEntries != NULL) {
+            return (mSampleTimeEntries[sample_index].mCompositionTime * scale_num) / scale_den;
+        }
+        if (mTimeToSampleRuns != NULL) {
+            return (getCompositionTime(sample_index) * scale_num) / scale_den;
+        }
+        return 0;
     }
 
+    // index of the sample of the given rank in composition time order.
+    inline uint32_t getSampleIndexInTimeOrder(size_t rank) const {
+        return mSampleTimeEntries != NULL ? mSampleTimeEntries[rank].mSampleIndex : rank;
+    }
+
+    uint64_t getDecodeTime(uint32_t sampleIndex) const;
+    uint64_t getCompositionTime(uint32_t sampleIndex) const;
+    int32_t findCompositionTimeOffset(uint32_t sampleIndex) const;
+
     status_t getSampleSize_l(uint32_t sample_index, size_t *sample_size);
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
 
     static int CompareIncreasingTime(const void *, const void *);
 
     void buildSampleEntriesTable();
+    bool buildTimeToSampleRuns_l();
 
     SampleTable(const SampleTable &);
     SampleTable &operator=(const SampleTable &);
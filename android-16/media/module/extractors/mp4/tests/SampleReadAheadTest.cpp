@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <SampleReadAhead.h>
+#include <gtest/gtest.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/DataSourceBase.h>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kWindowSize = 1024 * 1024;
+
+// A file in memory which counts the reads of its data.
+class CountingSource : public DataSourceHelper {
+public:
+    CountingSource(size_t size, uint32_t flags)
+        : DataSourceHelper((CDataSource *)nullptr), mData(size), mFlags(flags) {
+        for (size_t i = 0; i < size; ++i) {
+            mData[i] = (uint8_t)(i * 7 + (i >> 12));
+        }
+    }
+
+    ssize_t readAt(off64_t offset, void *data, size_t size) override {
+        ++mReads;
+        if (offset < 0 || (size_t)offset >= mData.size()) {
+            return 0;
+        }
+        size = std::min(size, mData.size() - (size_t)offset);
+        memcpy(data, mData.data() + offset, size);
+        return size;
+    }
+
+    status_t getSize(off64_t *size) override {
+        *size = mData.size();
+        return OK;
+    }
+
+    uint32_t flags() override {
+        return mFlags;
+    }
+
+    const uint8_t *data() const { return mData.data(); }
+    size_t reads() const { return mReads; }
+
+private:
+    std::vector<uint8_t> mData;
+    const uint32_t mFlags;
+    size_t mReads = 0;
+};
+
+struct Sample {
+    const void *track;
+    off64_t offset;
+    size_t size;
+};
+
+// The samples of a 30 fps video and a 48 kHz AAC audio track, interleaved
+// in chunks of half a second, in file order.
+std::vector<Sample> interleavedSamples(size_t durationS, size_t *fileSize) {
+    static const int kAudio = 0;
+    static const int kVideo = 0;
+    std::vector<Sample> samples;
+    off64_t offset = 4096;  // moov
+    for (size_t chunk = 0; chunk < 2 * durationS; ++chunk) {
+        for (size_t i = 0; i < 15; ++i) {
+            const size_t size = i == 0 ? 60000 : 12000 + 97 * i;
+            samples.push_back({&kVideo, offset, size});
+            offset += size;
+        }
+        for (size_t i = 0; i < 24; ++i) {
+            const size_t size = 370 + 3 * i;
+            samples.push_back({&kAudio, offset, size});
+            offset += size;
+        }
+    }
+    *fileSize = offset;
+    return samples;
+}
+
+// Reads the samples in file order, as the sources of both tracks do during
+// playback, and returns the number of samples read wrong.
+size_t readSamples(const std::vector<Sample> &samples, CountingSource *source,
+        SampleReadAhead *readAhead) {
+    std::vector<uint8_t> buffer;
+    size_t mismatches = 0;
+    for (const Sample &sample : samples) {
+        buffer.resize(sample.size);
+        const ssize_t n = readAhead != nullptr
+                ? readAhead->readAt(sample.track, sample.offset, buffer.data(), sample.size)
+                : source->readAt(sample.offset, buffer.data(), sample.size);
+        if (n != (ssize_t)sample.size
+                || memcmp(buffer.data(), source->data() + sample.offset, sample.size)) {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+TEST(SampleReadAheadTest, FewerReadsForInterleavedTracks) {
+    size_t fileSize;
+    const std::vector<Sample> samples = interleavedSamples(60 /* durationS */, &fileSize);
+
+    CountingSource direct(fileSize, 0 /* flags */);
+    EXPECT_EQ(0u, readSamples(samples, &direct, nullptr));
+
+    CountingSource source(fileSize, 0 /* flags */);
+    SampleReadAhead readAhead(&source, kWindowSize);
+    EXPECT_EQ(0u, readSamples(samples, &source, &readAhead));
+
+    // About one read per half window of data, instead of one per sample.
+    EXPECT_EQ(samples.size(), direct.reads());
+    EXPECT_LE(source.reads(), 2 * (fileSize / kWindowSize + 1));
+    RecordProperty("samples", (int)samples.size());
+    RecordProperty("direct_reads", (int)direct.reads());
+    RecordProperty("read_ahead_reads", (int)source.reads());
+}
+
+TEST(SampleReadAheadTest, LargeSamplesBypassWindow) {
+    CountingSource source(4 * kWindowSize, 0 /* flags */);
+    SampleReadAhead readAhead(&source, kWindowSize);
+    static const int kTrack = 0;
+
+    std::vector<uint8_t> buffer(kWindowSize);
+    ASSERT_EQ((ssize_t)buffer.size(), readAhead.readAt(&kTrack, 100, buffer.data(), buffer.size()));
+    EXPECT_EQ(0, memcmp(buffer.data(), source.data() + 100, buffer.size()));
+    EXPECT_EQ(1u, source.reads());
+}
+
+TEST(SampleReadAheadTest, ShortReadAtEndOfFile) {
+    CountingSource source(10000, 0 /* flags */);
+    SampleReadAhead readAhead(&source, kWindowSize);
+    static const int kTrack = 0;
+
+    uint8_t buffer[1000];
+    EXPECT_EQ(500, readAhead.readAt(&kTrack, 9500, buffer, sizeof(buffer)));
+    EXPECT_EQ(0, memcmp(buffer, source.data() + 9500, 500));
+}
+
+TEST(SampleReadAheadTest, OnlyLocalSources) {
+    CountingSource local(1000, 0 /* flags */);
+    EXPECT_TRUE(SampleReadAhead::canReadAhead(&local));
+
+    for (uint32_t flags : std::vector<uint32_t>{DataSourceBase::kWantsPrefetching,
+            DataSourceBase::kIsCachingDataSource,
+            DataSourceBase::kIsHTTPBasedSource,
+            DataSourceBase::kIsCachingDataSource | DataSourceBase::kIsHTTPBasedSource}) {
+        CountingSource remote(1000, flags);
+        EXPECT_FALSE(SampleReadAhead::canReadAhead(&remote)) << "flags " << flags;
+    }
+}
+
+}  // namespace
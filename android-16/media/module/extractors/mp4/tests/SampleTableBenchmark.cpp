@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <SampleTable.h>
+#include <benchmark/benchmark.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kSampleSize = 4096;
+constexpr uint32_t kFrameDuration = 1001;  // 29.97 fps with a 30000 timescale
+
+// The stsz, stts and optional ctts boxes of a synthetic video track, without
+// their box headers, as passed to the SampleTable setters.
+class SyntheticTrack : public DataSourceHelper {
+public:
+    // Args: number of samples, and whether the frames are reordered as with
+    // B-frames, which needs a ctts entry per sample.
+    SyntheticTrack(uint32_t numSamples, bool reordered)
+        : DataSourceHelper((CDataSource *)nullptr) {
+        mSampleSizeOffset = mData.size();
+        put32(0);
+        put32(kSampleSize);
+        put32(numSamples);
+        mSampleSizeSize = mData.size() - mSampleSizeOffset;
+
+        // a variable frame rate recording, where every 100th frame is late.
+        mTimeToSampleOffset = mData.size();
+        put32(0);
+        const uint32_t numRuns = numSamples / 100;
+        put32(2 * numRuns + (numSamples % 100 != 0));
+        for (uint32_t i = 0; i < numRuns; ++i) {
+            put32(99);
+            put32(kFrameDuration);
+            put32(1);
+            put32(kFrameDuration + 7);
+        }
+        if (numSamples % 100 != 0) {
+            put32(numSamples % 100);
+            put32(kFrameDuration);
+        }
+        mTimeToSampleSize = mData.size() - mTimeToSampleOffset;
+
+        // IPBB: the P frame is presented after the two B frames decoded after it.
+        mCompositionTimeOffset = -1;
+        if (reordered) {
+            mCompositionTimeOffset = mData.size();
+            put32(0);
+            put32(numSamples);
+            static const int32_t kOffsets[] = {1, 3, 0, 0};
+            for (uint32_t i = 0; i < numSamples; ++i) {
+                put32(1);
+                put32((kOffsets[i % 4] + 1) * kFrameDuration);
+            }
+            mCompositionTimeSize = mData.size() - mCompositionTimeOffset;
+        }
+    }
+
+    ssize_t readAt(off64_t offset, void *data, size_t size) override {
+        if (offset < 0 || (size_t)offset >= mData.size()) {
+            return 0;
+        }
+        size = std::min(size, mData.size() - (size_t)offset);
+        memcpy(data, mData.data() + offset, size);
+        return size;
+    }
+
+    status_t getSize(off64_t *size) override {
+        *size = mData.size();
+        return OK;
+    }
+
+    uint32_t flags() override {
+        return 0;
+    }
+
+    // Parses the boxes as MPEG4Extractor does when opening the file.
+    sp<SampleTable> open() {
+        sp<SampleTable> table = new SampleTable(this);
+        if (table->setSampleSizeParams(
+                    FOURCC("stsz"), mSampleSizeOffset, mSampleSizeSize) != OK
+                || table->setTimeToSampleParams(mTimeToSampleOffset, mTimeToSampleSize) != OK
+                || (mCompositionTimeOffset >= 0 && table->setCompositionTimeToSampleParams(
+                        mCompositionTimeOffset, mCompositionTimeSize) != OK)) {
+            return nullptr;
+        }
+        return table;
+    }
+
+private:
+    void put32(uint32_t x) {
+        mData.push_back(x >> 24);
+        mData.push_back(x >> 16);
+        mData.push_back(x >> 8);
+        mData.push_back(x);
+    }
+
+    std::vector<uint8_t> mData;
+    off64_t mSampleSizeOffset;
+    size_t mSampleSizeSize;
+    off64_t mTimeToSampleOffset;
+    size_t mTimeToSampleSize;
+    off64_t mCompositionTimeOffset;
+    size_t mCompositionTimeSize = 0;
+};
+
+size_t residentSetBytes() {
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (fp == nullptr) {
+        return 0;
+    }
+    unsigned long size = 0, resident = 0;
+    if (fscanf(fp, "%lu %lu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(fp);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+}  // namespace
+
+// Args: number of samples, 1 if the frames are reordered.
+static void BM_SampleTableOpen(benchmark::State &state) {
+    SyntheticTrack track(state.range(0), state.range(1) != 0);
+    for (auto _ : state) {
+        sp<SampleTable> table = track.open();
+        if (table == nullptr) {
+            state.SkipWithError("Unable to parse the sample table");
+            return;
+        }
+        benchmark::DoNotOptimize(table.get());
+    }
+}
+
+// Time of the first seek, which builds the index used to find samples by time.
+// Args: number of samples, 1 if the frames are reordered.
+static void BM_SampleTableFirstSeek(benchmark::State &state) {
+    const uint32_t numSamples = state.range(0);
+    SyntheticTrack track(numSamples, state.range(1) != 0);
+    const uint64_t seekTime = (uint64_t)numSamples / 2 * kFrameDuration;
+    for (auto _ : state) {
+        state.PauseTiming();
+        sp<SampleTable> table = track.open();
+        state.ResumeTiming();
+
+        uint32_t sampleIndex;
+        if (table == nullptr || table->findSampleAtTime(
+                seekTime, 1, 1, &sampleIndex, SampleTable::kFlagClosest) != OK) {
+            state.SkipWithError("Unable to seek");
+            return;
+        }
+        benchmark::DoNotOptimize(sampleIndex);
+
+        state.PauseTiming();
+        table.clear();
+        state.ResumeTiming();
+    }
+}
+
+/*
+ * Resident memory kept by the index built on the first seek, averaged over
+ * several tables kept alive so that freed memory is not reused. This runs
+ * first, before the heap holds memory freed by the other benchmarks.
+ *
+ * Args: number of samples, 1 if the frames are reordered.
+ */
+static void BM_SampleTableIndexMemory(benchmark::State &state) {
+    constexpr size_t kNumTables = 8;
+    const uint32_t numSamples = state.range(0);
+    SyntheticTrack track(numSamples, state.range(1) != 0);
+    const uint64_t seekTime = (uint64_t)numSamples / 2 * kFrameDuration;
+    size_t indexBytes = 0;
+    for (auto _ : state) {
+        std::vector<sp<SampleTable>> tables;
+        for (size_t i = 0; i < kNumTables; ++i) {
+            tables.push_back(track.open());
+            if (tables.back() == nullptr) {
+                state.SkipWithError("Unable to parse the sample table");
+                return;
+            }
+        }
+
+        const size_t residentBefore = residentSetBytes();
+        for (const sp<SampleTable> &table : tables) {
+            uint32_t sampleIndex;
+            if (table->findSampleAtTime(
+                    seekTime, 1, 1, &sampleIndex, SampleTable::kFlagClosest) != OK) {
+                state.SkipWithError("Unable to seek");
+                return;
+            }
+        }
+        const size_t residentAfter = residentSetBytes();
+        if (residentAfter > residentBefore) {
+            indexBytes = (residentAfter - residentBefore) / kNumTables;
+        }
+    }
+    state.counters["index_kb"] = indexBytes / 1024;
+}
+
+static void SampleTableArgs(benchmark::internal::Benchmark *b) {
+    // one hour and ten hours at 30 fps
+    for (int64_t numSamples : {108000, 1080000}) {
+        for (int64_t reordered : {0, 1}) {
+            b->Args({numSamples, reordered});
+        }
+    }
+}
+
+BENCHMARK(BM_SampleTableIndexMemory)->Apply(SampleTableArgs)->Iterations(1);
+BENCHMARK(BM_SampleTableOpen)->Apply(SampleTableArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SampleTableFirstSeek)->Apply(SampleTableArgs)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <SampleTable.h>
+#include <gtest/gtest.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+using namespace android;
+
+namespace {
+
+constexpr uint32_t kSampleSize = 100;
+
+// stts and ctts entries, as (sample count, delta).
+using TimeToSample = std::vector<std::pair<uint32_t, uint32_t>>;
+using CompositionOffsets = std::vector<std::pair<uint32_t, int32_t>>;
+
+// A track whose samples are all in one chunk, with the given stts and
+// optional ctts entries.
+class Track : public DataSourceHelper {
+public:
+    Track(uint32_t numSamples, const TimeToSample &stts, const CompositionOffsets &ctts)
+        : DataSourceHelper((CDataSource *)nullptr) {
+        mChunkOffsetOffset = mData.size();
+        put32(0);
+        put32(1);
+        put32(0x10000);
+        mChunkOffsetSize = mData.size() - mChunkOffsetOffset;
+
+        mSampleToChunkOffset = mData.size();
+        put32(0);
+        put32(1);
+        put32(1);
+        put32(numSamples);
+        put32(1);
+        mSampleToChunkSize = mData.size() - mSampleToChunkOffset;
+
+        mSampleSizeOffset = mData.size();
+        put32(0);
+        put32(kSampleSize);
+        put32(numSamples);
+        mSampleSizeSize = mData.size() - mSampleSizeOffset;
+
+        mTimeToSampleOffset = mData.size();
+        put32(0);
+        put32(stts.size());
+        for (const auto &[count, delta] : stts) {
+            put32(count);
+            put32(delta);
+        }
+        mTimeToSampleSize = mData.size() - mTimeToSampleOffset;
+
+        mCompositionTimeOffset = -1;
+        if (!ctts.empty()) {
+            mCompositionTimeOffset = mData.size();
+            put32(1 << 24);  // version 1, signed offsets
+            put32(ctts.size());
+            for (const auto &[count, offset] : ctts) {
+                put32(count);
+                put32((uint32_t)offset);
+            }
+            mCompositionTimeSize = mData.size() - mCompositionTimeOffset;
+        }
+    }
+
+    ssize_t readAt(off64_t offset, void *data, size_t size) override {
+        if (offset < 0 || (size_t)offset >= mData.size()) {
+            return 0;
+        }
+        size = std::min(size, mData.size() - (size_t)offset);
+        memcpy(data, mData.data() + offset, size);
+        return size;
+    }
+
+    status_t getSize(off64_t *size) override {
+        *size = mData.size();
+        return OK;
+    }
+
+    uint32_t flags() override {
+        return 0;
+    }
+
+    sp<SampleTable> open() {
+        sp<SampleTable> table = new SampleTable(this);
+        if (table->setChunkOffsetParams(
+                    FOURCC("stco"), mChunkOffsetOffset, mChunkOffsetSize) != OK
+                || table->setSampleToChunkParams(mSampleToChunkOffset, mSampleToChunkSize) != OK
+                || table->setSampleSizeParams(
+                        FOURCC("stsz"), mSampleSizeOffset, mSampleSizeSize) != OK
+                || table->setTimeToSampleParams(mTimeToSampleOffset, mTimeToSampleSize) != OK
+                || (mCompositionTimeOffset >= 0 && table->setCompositionTimeToSampleParams(
+                        mCompositionTimeOffset, mCompositionTimeSize) != OK)) {
+            return nullptr;
+        }
+        return table;
+    }
+
+private:
+    void put32(uint32_t x) {
+        mData.push_back(x >> 24);
+        mData.push_back(x >> 16);
+        mData.push_back(x >> 8);
+        mData.push_back(x);
+    }
+
+    std::vector<uint8_t> mData;
+    off64_t mChunkOffsetOffset;
+    size_t mChunkOffsetSize;
+    off64_t mSampleToChunkOffset;
+    size_t mSampleToChunkSize;
+    off64_t mSampleSizeOffset;
+    size_t mSampleSizeSize;
+    off64_t mTimeToSampleOffset;
+    size_t mTimeToSampleSize;
+    off64_t mCompositionTimeOffset;
+    size_t mCompositionTimeSize = 0;
+};
+
+struct SampleTime {
+    uint32_t sampleIndex;
+    uint64_t compositionTime;
+};
+
+// The composition time of each sample, sorted by time, as computed by the
+// per-sample table SampleTable built on the first seek before it could use
+// the stts and ctts entries directly.
+std::vector<SampleTime> sortedSampleTimes(
+        uint32_t numSamples, const TimeToSample &stts, const CompositionOffsets &ctts) {
+    std::vector<SampleTime> entries(numSamples, SampleTime{0, 0});
+    uint32_t sampleIndex = 0;
+    uint64_t sampleTime = 0;
+    for (const auto &[count, delta] : stts) {
+        for (uint32_t j = 0; j < count; ++j, ++sampleIndex, sampleTime += delta) {
+            if (sampleIndex >= numSamples) {
+                continue;
+            }
+            int32_t offset = 0;
+            uint32_t firstSample = 0;
+            for (const auto &[cttsCount, cttsOffset] : ctts) {
+                if (sampleIndex < firstSample + cttsCount) {
+                    offset = cttsOffset;
+                    break;
+                }
+                firstSample += cttsCount;
+            }
+            entries[sampleIndex] = {sampleIndex, sampleTime + offset};
+        }
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const SampleTime &a, const SampleTime &b) {
+        return a.compositionTime < b.compositionTime;
+    });
+    return entries;
+}
+
+// SampleTable::findSampleAtTime on the sorted per-sample table.
+status_t findSampleAtTime(const std::vector<SampleTime> &entries,
+        uint64_t reqTime, uint64_t scaleNum, uint64_t scaleDen, uint32_t flags,
+        uint32_t *sampleIndex) {
+    auto timeAt = [&](size_t i) { return entries[i].compositionTime * scaleNum / scaleDen; };
+    size_t left = 0;
+    size_t rightPlusOne = entries.size();
+    while (left < rightPlusOne) {
+        size_t center = left + (rightPlusOne - left) / 2;
+        if (reqTime < timeAt(center)) {
+            rightPlusOne = center;
+        } else if (reqTime > timeAt(center)) {
+            left = center + 1;
+        } else {
+            *sampleIndex = entries[center].sampleIndex;
+            return OK;
+        }
+    }
+
+    size_t closest = left;
+    if (closest == entries.size()) {
+        if (flags == SampleTable::kFlagAfter) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        flags = SampleTable::kFlagBefore;
+    } else if (closest == 0) {
+        flags = SampleTable::kFlagAfter;
+    }
+    if (flags == SampleTable::kFlagBefore) {
+        --closest;
+    } else if (flags == SampleTable::kFlagClosest) {
+        uint64_t after = timeAt(closest) - reqTime;
+        uint64_t before = reqTime - timeAt(closest - 1);
+        if (after > before) {
+            --closest;
+        }
+    }
+    *sampleIndex = entries[closest].sampleIndex;
+    return OK;
+}
+
+// Checks the times of the samples and seeks at, around and between each of
+// them, against the per-sample table.
+void checkSampleTimes(
+        uint32_t numSamples, const TimeToSample &stts, const CompositionOffsets &ctts) {
+    Track track(numSamples, stts, ctts);
+    sp<SampleTable> table = track.open();
+    ASSERT_NE(nullptr, table.get());
+
+    const std::vector<SampleTime> entries = sortedSampleTimes(numSamples, stts, ctts);
+    std::vector<uint64_t> times(numSamples);
+    for (const SampleTime &entry : entries) {
+        times[entry.sampleIndex] = entry.compositionTime;
+    }
+
+    // the time of each sample, before and after building the index
+    for (int pass = 0; pass < 2; ++pass) {
+        for (uint32_t i = 0; i < numSamples; ++i) {
+            uint64_t compositionTime;
+            ASSERT_EQ(OK, table->getMetaDataForSample(i, nullptr, nullptr, &compositionTime));
+            EXPECT_EQ(times[i], compositionTime) << "sample " << i << ", pass " << pass;
+        }
+        uint32_t sampleIndex;
+        ASSERT_EQ(OK, table->findSampleAtTime(0, 1, 1, &sampleIndex, SampleTable::kFlagClosest));
+    }
+
+    std::vector<uint64_t> reqTimes;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const uint64_t t = entries[i].compositionTime;
+        reqTimes.insert(reqTimes.end(), {t, t + 1});
+        if (t > 0) {
+            reqTimes.push_back(t - 1);
+        }
+        if (i + 1 < entries.size()) {
+            reqTimes.push_back((t + entries[i + 1].compositionTime) / 2);
+        }
+    }
+    reqTimes.push_back(0);
+
+    // in the track timescale, and in microseconds with a 30000 timescale
+    const std::pair<uint64_t, uint64_t> kScales[] = {{1, 1}, {1000000, 30000}};
+    for (const auto &[scaleNum, scaleDen] : kScales) {
+        for (uint64_t t : reqTimes) {
+            const uint64_t reqTime = t * scaleNum / scaleDen;
+            for (uint32_t flags : {SampleTable::kFlagBefore, SampleTable::kFlagAfter,
+                    SampleTable::kFlagClosest}) {
+                uint32_t expected = 0, sampleIndex = 0;
+                status_t expectedErr = findSampleAtTime(
+                        entries, reqTime, scaleNum, scaleDen, flags, &expected);
+                EXPECT_EQ(expectedErr, table->findSampleAtTime(
+                        reqTime, scaleNum, scaleDen, &sampleIndex, flags))
+                        << "time " << reqTime << ", scale " << scaleNum << "/" << scaleDen
+                        << ", flags " << flags;
+                EXPECT_EQ(expected, sampleIndex)
+                        << "time " << reqTime << ", scale " << scaleNum << "/" << scaleDen
+                        << ", flags " << flags;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < numSamples; ++i) {
+        uint32_t sampleIndex;
+        ASSERT_EQ(OK, table->findSampleAtTime(
+                i, 1, 1, &sampleIndex, SampleTable::kFlagFrameIndex));
+        EXPECT_EQ(entries[i].sampleIndex, sampleIndex) << "frame " << i;
+    }
+}
+
+TEST(SampleTableTest, ConstantFrameRate) {
+    checkSampleTimes(30, {{30, 1001}}, {});
+}
+
+TEST(SampleTableTest, ZeroCountTimeToSampleEntries) {
+    checkSampleTimes(35, {{0, 500}, {10, 1001}, {0, 7}, {24, 1002}, {1, 3000}, {0, 9}}, {});
+}
+
+TEST(SampleTableTest, TimeToSampleEntriesPastLastSample) {
+    checkSampleTimes(20, {{15, 1001}, {10, 1002}, {5, 1003}}, {});
+}
+
+TEST(SampleTableTest, ConstantCompositionOffset) {
+    checkSampleTimes(40, {{40, 1001}}, {{40, 2002}});
+}
+
+TEST(SampleTableTest, NegativeCompositionOffsets) {
+    checkSampleTimes(41, {{41, 1001}}, {{1, 0}, {20, -500}, {20, -1000}});
+}
+
+TEST(SampleTableTest, ZeroCountCompositionOffsetEntries) {
+    checkSampleTimes(20, {{20, 1001}}, {{0, 900}, {5, 300}, {0, -100}, {10, 200}, {0, 5000}});
+}
+
+// The samples past the last ctts entry have no offset.
+TEST(SampleTableTest, CompositionOffsetsForSomeSamples) {
+    checkSampleTimes(30, {{30, 1001}}, {{10, 500}});
+}
+
+// As above, with the samples past the last ctts entry presented before the
+// last one covered by it.
+TEST(SampleTableTest, CompositionOffsetsForSomeSamplesReordered) {
+    checkSampleTimes(30, {{30, 1001}}, {{10, 2000}});
+}
+
+// IPBB, with negative offsets for the B frames.
+TEST(SampleTableTest, ReorderedFrames) {
+    CompositionOffsets ctts;
+    static const int32_t kOffsets[] = {-1001, 2002, -1001};
+    for (uint32_t i = 0; i < 40; ++i) {
+        ctts.push_back({1, i == 0 ? 0 : kOffsets[i % 3]});
+    }
+    checkSampleTimes(40, {{40, 1001}}, ctts);
+}
+
+}  // namespace
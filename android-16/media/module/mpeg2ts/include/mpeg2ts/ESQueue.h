@@ -137,6 +137,10 @@ private:
             int32_t *pesOffset = NULL,
             int32_t *pesScramblingControl = NULL);
 
+    // drops the first "size" bytes of mBuffer. The data is not moved,
+    // the space is reclaimed by appendData() once the buffer runs out of room.
+    void consumeBuffer(size_t size);
+
     sp<ABuffer> dequeueScrambledAccessUnit();
 
     DISALLOW_EVIL_CONSTRUCTORS(ElementaryStreamQueue);
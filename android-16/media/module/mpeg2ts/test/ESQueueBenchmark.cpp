@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ESQueueBenchmark"
+
+#include <utils/Log.h>
+
+#include <getopt.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/MediaErrors.h>
+#include <media/stagefright/foundation/ABuffer.h>
+#include <mpeg2ts/ATSParser.h>
+#include <mpeg2ts/AnotherPacketSource.h>
+
+using namespace android;
+
+constexpr size_t kTSPacketSize = 188;
+
+// Files of the Mpeg2tsUnitTest resource bundle, see README.md.
+static const char *kInputFiles[] = {
+    "crowd_1920x1080_25fps_6700kbps_h264.ts",
+    "segment000001.ts",
+    "bbb_44100hz_2ch_128kbps_mp3_5mins.ts",
+};
+
+static bool readFile(const std::string &path, std::vector<uint8_t> *data) {
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (fp == nullptr) {
+        return false;
+    }
+    uint8_t packet[kTSPacketSize];
+    while (fread(packet, 1, kTSPacketSize, fp) == kTSPacketSize) {
+        data->insert(data->end(), packet, packet + kTSPacketSize);
+    }
+    fclose(fp);
+    return !data->empty();
+}
+
+static size_t drainSource(const sp<ATSParser> &parser, ATSParser::SourceType type) {
+    size_t count = 0;
+    sp<AnotherPacketSource> source = parser->getSource(type);
+    if (source == nullptr) {
+        return count;
+    }
+    status_t finalResult;
+    sp<ABuffer> accessUnit;
+    while (source->hasBufferAvailable(&finalResult)
+            && source->dequeueAccessUnit(&accessUnit) == OK) {
+        benchmark::DoNotOptimize(accessUnit->data());
+        ++count;
+    }
+    return count;
+}
+
+/*
+ * Demuxes a whole transport stream held in memory, dequeuing the access units
+ * assembled by the elementary stream queues as they become available, as the
+ * extractor does while playing.
+ */
+static void BM_DemuxTransportStream(benchmark::State &state, const std::vector<uint8_t> &data) {
+    size_t accessUnits = 0;
+    for (auto _ : state) {
+        sp<ATSParser> parser = new ATSParser;
+        accessUnits = 0;
+        for (size_t offset = 0; offset + kTSPacketSize <= data.size();
+                offset += kTSPacketSize) {
+            if (parser->feedTSPacket(&data[offset], kTSPacketSize) != OK) {
+                state.SkipWithError("Unable to feed TS packet");
+                return;
+            }
+            accessUnits += drainSource(parser, ATSParser::VIDEO);
+            accessUnits += drainSource(parser, ATSParser::AUDIO);
+            accessUnits += drainSource(parser, ATSParser::META);
+        }
+        parser->signalEOS(ERROR_END_OF_STREAM);
+        accessUnits += drainSource(parser, ATSParser::VIDEO);
+        accessUnits += drainSource(parser, ATSParser::AUDIO);
+        accessUnits += drainSource(parser, ATSParser::META);
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+    state.counters["access_units"] = accessUnits;
+    state.counters["time_per_access_unit"] = benchmark::Counter(accessUnits,
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+int main(int argc, char **argv) {
+    benchmark::Initialize(&argc, argv);
+
+    std::string res = "/data/local/tmp/";
+    static struct option options[] = {{"path", required_argument, 0, 'P'}, {0, 0, 0, 0}};
+    int c;
+    while ((c = getopt_long(argc, argv, "P:", options, nullptr)) != -1) {
+        if (c == 'P') {
+            res = optarg;
+        }
+    }
+
+    for (const char *file : kInputFiles) {
+        const std::string path = res + file;
+        std::vector<uint8_t> data;
+        if (!readFile(path, &data)) {
+            fprintf(stderr, "Skipping %s, unable to read it\n", path.c_str());
+            continue;
+        }
+        benchmark::RegisterBenchmark(("BM_DemuxTransportStream/" + std::string(file)).c_str(),
+                BM_DemuxTransportStream, data)->Unit(benchmark::kMillisecond);
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -43,6 +43,7 @@
 #include <com_android_media_audioserver.h>
 #include <media/AidlConversion.h>
 #include <media/AudioParameter.h>
+#include <media/AudioResampler.h>
 #include <media/AudioValidator.h>
 #include <media/IPermissionProvider.h>
 #include <media/MediaMetricsItem.h>
@@ -793,6 +794,7 @@ void AudioFlinger::dumpInternals_l(int fd) {
     }
     dprintf(fd, "Bluetooth latency modes are %senabled\n",
             mBluetoothLatencyModesEnabled ? "" : "not ");
+    writeStr(fd, AudioResampler::filterCacheToString());
 }
 
 void AudioFlinger::dumpStats(int fd) {
@@ -851,6 +853,8 @@ static void dump_printHelp(int fd) {
             "  --stats: Include call/lock/watchdog stats\n"
             "  --effects: Include effect definitions\n"
             "  --memory: Include memory dump\n"
+            "  --fastmixer: Include FastMixer cycle budget histograms\n"
+            "  --fastmixer-binary: Only write FastMixerCycleStatsRecord for each FastMixer\n"
             "  -a/--all: Print all except --memory\n"sv;
 
     write(fd, helpStr.data(), helpStr.length());
@@ -865,7 +869,8 @@ status_t AudioFlinger::dump(int fd, const Vector<String16>& args)
     }
     // Arg parsing
     struct {
-        bool shouldDumpMem, shouldDumpStats, shouldDumpHal, shouldDumpEffects;
+        bool shouldDumpMem, shouldDumpStats, shouldDumpHal, shouldDumpEffects,
+                shouldDumpFastMixerBinary;
     } parsedArgs {}; // zero-init
 
     for (const auto& arg : args) {
@@ -896,9 +901,22 @@ status_t AudioFlinger::dump(int fd, const Vector<String16>& args)
             parsedArgs.shouldDumpMem = true;
             continue;
         }
+        if (utf8arg == "--fastmixer-binary") {
+            parsedArgs.shouldDumpFastMixerBinary = true;
+            continue;
+        }
         // Unknown arg silently ignored
     }
 
+    if (parsedArgs.shouldDumpFastMixerBinary) {
+        // Binary records only, so the output can be parsed offline.
+        FallibleLockGuard l{mutex()};
+        for (size_t i = 0; i < mPlaybackThreads.size(); i++) {
+            mPlaybackThreads.valueAt(i)->dumpFastMixerCycleStatsBinary(fd);
+        }
+        return NO_ERROR;
+    }
+
     {
         std::string res;
         res.reserve(100);
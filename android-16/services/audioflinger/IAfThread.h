@@ -558,6 +558,8 @@ public:
 
     virtual bool hasFastMixer() const = 0;
     virtual FastTrackUnderruns getFastTrackUnderruns(size_t fastIndex) const = 0;
+    // writes a FastMixerCycleStatsRecord if there is a fast mixer, otherwise nothing
+    virtual void dumpFastMixerCycleStatsBinary(int fd) const = 0;
     virtual const std::atomic<int64_t>& framesWritten() const = 0;
 
     virtual bool usesHwAvSync() const = 0;
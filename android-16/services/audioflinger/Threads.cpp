@@ -6617,6 +6617,9 @@ void MixerThread::dumpInternals_l(int fd, const Vector<String16>& args)
         const std::unique_ptr<FastMixerDumpState> copy =
                 std::make_unique<FastMixerDumpState>(mFastMixerDumpState);
         copy->dump(fd);
+        if (FastMixerDumpState::isCycleStatsDumpRequested(args)) {
+            copy->dumpCycleStats(fd);
+        }
 
 #ifdef STATE_QUEUE_DUMP
         // Similar for state queue
@@ -7833,6 +7836,9 @@ DuplicatingThread::DuplicatingThread(const sp<IAfThreadCallback>& afThreadCallba
 
 DuplicatingThread::~DuplicatingThread()
 {
+    for (const auto& writer : mOutputWriters) {
+        writer->exit();
+    }
     for (size_t i = 0; i < mOutputTracks.size(); i++) {
         mOutputTracks[i]->destroy();
     }
@@ -7878,24 +7884,40 @@ void DuplicatingThread::threadLoop_sleepTime()
 
 ssize_t DuplicatingThread::threadLoop_write()
 {
+    // Each OutputTrack is written by its own OutputTrackWriter, so a slow output does not
+    // delay the others.  The mix is paced on its own period, as a MixerThread is by its sink.
+    const nsecs_t periodNs = (nsecs_t)mNormalFrameCount * NANOS_PER_SECOND / mSampleRate;
+    const nsecs_t delayNs = mWritePacer.delayNs(systemTime(), periodNs);
+    if (delayNs > 0) {
+        ATRACE_NAME("pace");
+        usleep(delayNs / 1000);
+    }
     ATRACE_BEGIN("write");
-    for (size_t i = 0; i < outputTracks.size(); i++) {
-        const ssize_t actualWritten = outputTracks[i]->write(mSinkBuffer, writeFrames);
+    for (size_t i = 0; i < outputWriters.size(); ++i) {
+        const auto& writer = outputWriters[i];
+        if (writeFrames == 0 || i >= mOutputsReady.size() || mOutputsReady[i]) {
+            writer->queue(mSinkBuffer, writeFrames);
+        } else {
+            // Wakes the output, without the mix it is not ready for.
+            writer->queueSilence(writeFrames);
+        }
 
         // Consider the first OutputTrack for timestamp and frame counting.
 
         // The threadLoop() generally assumes writing a full sink buffer size at a time.
-        // Here, we correct for writeFrames of 0 (a stop) or underruns because
-        // we always claim success.
-        if (i == 0) {
-            const ssize_t correction = mSinkBufferSize / mFrameSize - actualWritten;
-            ALOGD_IF(correction != 0 && writeFrames != 0,
-                    "%s: writeFrames:%u  actualWritten:%zd  correction:%zd  mFramesWritten:%lld",
-                    __func__, writeFrames, actualWritten, correction, (long long)mFramesWritten);
+        // Here, we correct for writeFrames of 0 (a stop), and for the frames of earlier
+        // writes which were dropped or underran, because we always claim success.
+        if (outputTracks.size() > 0 && writer->outputTrack() == outputTracks[0]) {
+            const int64_t notWritten = writer->takeFramesNotWritten();
+            const int64_t correction = mSinkBufferSize / mFrameSize - writeFrames + notWritten;
+            ALOGD_IF(notWritten != 0,
+                    "%s: writeFrames:%u  notWritten:%lld  correction:%lld  mFramesWritten:%lld",
+                    __func__, writeFrames, (long long)notWritten, (long long)correction,
+                    (long long)mFramesWritten);
             mFramesWritten -= correction;
         }
 
-        // TODO: Report correction for the other output tracks and show in the dump.
+        // Frames not written to the other output tracks are shown in the dump.
     }
     ATRACE_END();
     if (mStandby) {
@@ -7908,10 +7930,12 @@ ssize_t DuplicatingThread::threadLoop_write()
 
 void DuplicatingThread::threadLoop_standby()
 {
-    // DuplicatingThread implements standby by stopping all tracks
-    for (size_t i = 0; i < outputTracks.size(); i++) {
-        outputTracks[i]->stop();
+    // DuplicatingThread implements standby by stopping all tracks,
+    // after the buffers pending in their writers.
+    for (const auto& writer : outputWriters) {
+        writer->queueStop();
     }
+    mWritePacer.reset();
 }
 
 void DuplicatingThread::threadLoop_exit()
@@ -7921,14 +7945,26 @@ void DuplicatingThread::threadLoop_exit()
     // Do so here in the threadLoop_exit().
 
     SortedVector <sp<IAfOutputTrack>> localTracks;
+    std::vector<sp<OutputTrackWriter<IAfOutputTrack>>> localWriters;
     {
         audio_utils::lock_guard l(mutex());
         localTracks = std::move(mOutputTracks);
         mOutputTracks.clear();
+        localWriters = std::move(mOutputWriters);
+        mOutputWriters.clear();
+        for (const auto& writer : localWriters) {
+            writer->exit();
+        }
         for (size_t i = 0; i < localTracks.size(); ++i) {
             localTracks[i]->destroy();
         }
     }
+    // a writer may be in an OutputTrack write(), which is bounded by waitTimeMs().
+    for (const auto& writer : localWriters) {
+        writer->join();
+    }
+    localWriters.clear();
+    outputWriters.clear();
     localTracks.clear();
     outputTracks.clear();
     PlaybackThread::threadLoop_exit();
@@ -7957,16 +7993,21 @@ void DuplicatingThread::dumpInternals_l(int fd, const Vector<String16>& args)
     ss << "\n";
     std::string result = ss.str();
     write(fd, result.c_str(), result.size());
+    for (const auto& writer : mOutputWriters) {
+        writer->dump(fd);
+    }
 }
 
 void DuplicatingThread::saveOutputTracks()
 {
     outputTracks = mOutputTracks;
+    outputWriters = mOutputWriters;
 }
 
 void DuplicatingThread::clearOutputTracks()
 {
     outputTracks.clear();
+    outputWriters.clear();
 }
 
 void DuplicatingThread::addOutputTrack(IAfPlaybackThread* thread)
@@ -8005,6 +8046,8 @@ void DuplicatingThread::addOutputTrack(IAfPlaybackThread* thread)
     }
 
     mOutputTracks.add(outputTrack);
+    mOutputWriters.push_back(sp<OutputTrackWriter<IAfOutputTrack>>::make(
+            outputTrack, mFrameSize, mSinkBufferSize / mFrameSize));
     ALOGV("addOutputTrack() track %p, on thread %p", outputTrack.get(), thread);
     updateWaitTime_l();
 }
@@ -8014,6 +8057,14 @@ void DuplicatingThread::removeOutputTrack(IAfPlaybackThread* thread)
     audio_utils::lock_guard _l(mutex());
     for (size_t i = 0; i < mOutputTracks.size(); i++) {
         if (mOutputTracks[i]->thread() == thread) {
+            // the writer exits after any write() in progress, without waiting here.
+            for (auto it = mOutputWriters.begin(); it != mOutputWriters.end(); ++it) {
+                if ((*it)->outputTrack() == mOutputTracks[i]) {
+                    (*it)->exit();
+                    mOutputWriters.erase(it);
+                    break;
+                }
+            }
             mOutputTracks[i]->destroy();
             mOutputTracks.removeAt(i);
             updateWaitTime_l();
@@ -8049,22 +8100,31 @@ void DuplicatingThread::updateWaitTime_l()
 
 bool DuplicatingThread::outputsReady()
 {
-    for (size_t i = 0; i < outputTracks.size(); i++) {
-        const auto thread = outputTracks[i]->thread().promote();
+    // Each output is checked on its own, so that one output coming out of standby
+    // does not silence the others.
+    mOutputsReady.resize(outputWriters.size());
+    bool anyReady = outputWriters.empty();
+    for (size_t i = 0; i < outputWriters.size(); i++) {
+        const sp<IAfOutputTrack>& outputTrack = outputWriters[i]->outputTrack();
+        const auto thread = outputTrack->thread().promote();
         if (thread == 0) {
             ALOGW("DuplicatingThread::outputsReady() could not promote thread on output track %p",
-                    outputTracks[i].get());
-            return false;
+                    outputTrack.get());
+            mOutputsReady[i] = false;
+            continue;
         }
         IAfPlaybackThread* const playbackThread = thread->asIAfPlaybackThread().get();
         // see note at standby() declaration
         if (playbackThread->inStandby() && !playbackThread->isSuspended()) {
-            ALOGV("DuplicatingThread output track %p on thread %p Not Ready", outputTracks[i].get(),
+            ALOGV("DuplicatingThread output track %p on thread %p Not Ready", outputTrack.get(),
                     thread.get());
-            return false;
+            mOutputsReady[i] = false;
+            continue;
         }
+        mOutputsReady[i] = true;
+        anyReady = true;
     }
-    return true;
+    return anyReady;
 }
 
 void DuplicatingThread::sendMetadataToBackend_l(
@@ -28,6 +28,7 @@
 #include <afutils/NBAIO_Tee.h>
 #include <audio_utils/Balance.h>
 #include <audio_utils/SimpleLog.h>
+#include <datapath/OutputTrackWriter.h>
 #include <datapath/ThreadMetrics.h>
 #include <fastpath/FastCapture.h>
 #include <fastpath/FastMixer.h>
@@ -1566,6 +1567,7 @@ protected:
 public:
     FastTrackUnderruns getFastTrackUnderruns(size_t /* fastIndex */) const override
         { return {}; }
+    void dumpFastMixerCycleStatsBinary(int /* fd */) const override {}
     const std::atomic<int64_t>& framesWritten() const final { return mFramesWritten; }
 
 protected:
@@ -1710,6 +1712,14 @@ public:
                               ALOG_ASSERT(fastIndex < FastMixerState::sMaxFastTracks);
                               return mFastMixerDumpState.mTracks[fastIndex].mUnderruns;
                             }
+    void dumpFastMixerCycleStatsBinary(int fd) const override {
+        if (hasFastMixer()) {
+            // As in dumpInternals_l(), dump a copy that the fast mixer does not update.
+            const std::unique_ptr<FastMixerDumpState> copy =
+                    std::make_unique<FastMixerDumpState>(mFastMixerDumpState);
+            copy->dumpCycleStatsBinary(fd, mId);
+        }
+    }
 
     status_t threadloop_getHalTimestamp_l(
             ExtendedTimestamp *timestamp) const override
@@ -1923,6 +1933,8 @@ protected:
     void dumpInternals_l(int fd, const Vector<String16>& args) final REQUIRES(mutex());
 
 private:
+    // Sets mOutputsReady for outputWriters, and returns true if any output is ready
+    // or there is none.
     bool outputsReady() REQUIRES(ThreadBase_ThreadLoop);
 protected:
     // threadLoop snippets
@@ -1945,6 +1957,12 @@ private:
     // NO_THREAD_SAFETY_ANALYSIS  GUARDED_BY(ThreadBase_ThreadLoop)
     SortedVector <sp<IAfOutputTrack>> outputTracks;
     SortedVector <sp<IAfOutputTrack>> mOutputTracks GUARDED_BY(mutex());
+    // One writer per OutputTrack, threadLoop copy as for outputTracks.
+    std::vector<sp<OutputTrackWriter<IAfOutputTrack>>> mOutputWriters GUARDED_BY(mutex());
+    std::vector<sp<OutputTrackWriter<IAfOutputTrack>>> outputWriters;
+    // Whether the thread of each of outputWriters is ready for the mix, see outputsReady().
+    std::vector<bool> mOutputsReady;
+    WritePacer mWritePacer;
 public:
     virtual     bool        hasFastMixer() const { return false; }
                 status_t    threadloop_getHalTimestamp_l(
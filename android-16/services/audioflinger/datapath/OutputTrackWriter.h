@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <audio_utils/mutex.h>
+#include <utils/Log.h>
+#include <utils/StrongPointer.h>
+#include <utils/Thread.h>
+#include <utils/Timers.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+
+namespace android {
+
+/**
+ * WritePacer paces the writes of a DuplicatingThread to one buffer per mix
+ * period, on its own clock as a MixerThread is on its sink.
+ */
+class WritePacer {
+public:
+    // A write later than this many periods restarts the pacing, instead of
+    // writing the missed buffers back to back.
+    static constexpr nsecs_t kMaxLatePeriods = 2;
+
+    // Returns the time to wait from nowNs before writing the next buffer,
+    // for buffers of periodNs.
+    nsecs_t delayNs(nsecs_t nowNs, nsecs_t periodNs) {
+        if (!mStarted || nowNs - mNextWriteNs > kMaxLatePeriods * periodNs) {
+            mNextWriteNs = nowNs;
+            mStarted = true;
+        }
+        const nsecs_t delayNs = std::max(mNextWriteNs - nowNs, (nsecs_t)0);
+        mNextWriteNs += periodNs;
+        return delayNs;
+    }
+
+    // Restarts the pacing at the next write, after standby.
+    void reset() { mStarted = false; }
+
+private:
+    bool mStarted = false;
+    nsecs_t mNextWriteNs = 0;
+};
+
+/**
+ * OutputTrackWriter writes the buffers of a DuplicatingThread to one of its
+ * OutputTracks on its own thread, so a slow output does not delay the others.
+ *
+ * OutputTrack is IAfOutputTrack in AudioFlinger, it needs
+ * ssize_t write(void* data, uint32_t frames), void stop() and int id() const.
+ *
+ * The DuplicatingThread paces itself on its own mix period with a WritePacer,
+ * so no output, however slow, delays the others.  An output drops its oldest
+ * pending buffer when it falls kQueueDepth buffers behind.
+ */
+template <typename OutputTrack>
+class OutputTrackWriter : public Thread {
+public:
+    // Number of buffers which may be pending for the OutputTrack.
+    static constexpr size_t kQueueDepth = 3;
+    // Stops are queued without a buffer, and follow at most one buffer each.
+    static constexpr size_t kMaxEntries = 2 * kQueueDepth + 1;
+
+    OutputTrackWriter(const sp<OutputTrack>& outputTrack, size_t frameSize,
+            size_t bufferFrames)
+        :   Thread(false /*canCallJava*/),
+            mOutputTrack(outputTrack),
+            mFrameSize(frameSize),
+            mBufferFrames(bufferFrames),
+            mBuffers(new int8_t[(kQueueDepth + 1) * bufferFrames * frameSize]) {
+        for (size_t i = 0; i < kQueueDepth + 1; ++i) {
+            mFreeSlots[i] = i;
+        }
+    }
+
+    // Thread virtuals
+    bool threadLoop() final {
+        while (!exitPending()) {
+            Entry entry;
+            {
+                audio_utils::unique_lock _l(mMutex);
+                while (mQueueSize == 0 && !exitPending()) {
+                    mWaitWorkCV.wait(_l);
+                }
+                if (exitPending()) {
+                    break;
+                }
+                entry = mQueue[mQueueFront];
+                mQueueFront = (mQueueFront + 1) % kMaxEntries;
+                --mQueueSize;
+                if (!entry.mStop) {
+                    --mPendingBuffers;
+                }
+            }
+            if (entry.mStop) {
+                mOutputTrack->stop();
+                continue;
+            }
+            const nsecs_t startNs = systemTime();
+            const ssize_t written = mOutputTrack->write(slotData(entry.mSlot), entry.mFrames);
+            const nsecs_t writeNs = systemTime() - startNs;
+            {
+                audio_utils::lock_guard _l(mMutex);
+                if (written >= 0 && (size_t)written < entry.mFrames) {
+                    mFramesNotWritten += entry.mFrames - written;
+                }
+                mMaxWriteNs = std::max(mMaxWriteNs, writeNs);
+                mFreeSlots[mFreeSlotCount++] = entry.mSlot;
+            }
+        }
+        return false;
+    }
+
+    // RefBase
+    void onFirstRef() final {
+        run("Duplicating Wr", ANDROID_PRIORITY_URGENT_AUDIO);
+    }
+
+    void exit() {
+        audio_utils::lock_guard _l(mMutex);
+        requestExit();
+        mWaitWorkCV.notify_all();
+    }
+
+    // Queues a copy of frames for OutputTrack::write(), or the end of data
+    // if frames is 0.  Never blocks, the oldest pending buffer is dropped if the
+    // queue is full.
+    void queue(const void* data, uint32_t frames) {
+        audio_utils::lock_guard _l(mMutex);
+        queue_l(data, frames);
+    }
+
+    // Queues frames of silence, as queue() would queue a buffer of zeroes.
+    void queueSilence(uint32_t frames) {
+        audio_utils::lock_guard _l(mMutex);
+        queue_l(nullptr /* data */, frames);
+    }
+
+    // Queues OutputTrack::stop() after the pending buffers, without dropping any.
+    void queueStop() {
+        audio_utils::lock_guard _l(mMutex);
+        if (mQueueSize > 0 && mQueue[(mQueueFront + mQueueSize - 1) % kMaxEntries].mStop) {
+            return;  // already stopping
+        }
+        mQueue[(mQueueFront + mQueueSize) % kMaxEntries] = {0 /* mSlot */, 0 /* mFrames */, true};
+        ++mQueueSize;
+        mWaitWorkCV.notify_one();
+    }
+
+    // Returns and resets the number of queued frames which were not written,
+    // because they were dropped or not accepted by the OutputTrack.
+    int64_t takeFramesNotWritten() {
+        audio_utils::lock_guard _l(mMutex);
+        const int64_t frames = mFramesNotWritten;
+        mFramesNotWritten = 0;
+        return frames;
+    }
+
+    // Total number of frames dropped before reaching the OutputTrack.
+    int64_t framesDropped() const {
+        audio_utils::lock_guard _l(mMutex);
+        return mFramesDropped;
+    }
+
+    const sp<OutputTrack>& outputTrack() const { return mOutputTrack; }
+
+    void dump(int fd) const {
+        audio_utils::lock_guard _l(mMutex);
+        dprintf(fd, "    OutputTrack %d: pending %zu/%zu  frames queued %lld"
+                "  dropped %u buffers (%lld frames)  max write %.2f ms\n",
+                mOutputTrack->id(), mPendingBuffers, kQueueDepth, (long long)mFramesQueued,
+                mBuffersDropped, (long long)mFramesDropped, mMaxWriteNs * 1e-6);
+    }
+
+private:
+    struct Entry {
+        size_t   mSlot;     // buffer index, unused for a stop
+        uint32_t mFrames;
+        bool     mStop;
+    };
+
+    int8_t* slotData(size_t slot) const {
+        return mBuffers.get() + slot * mBufferFrames * mFrameSize;
+    }
+
+    void queue_l(const void* data, uint32_t frames) REQUIRES(mMutex) {
+        if (frames > mBufferFrames) {
+            ALOGW("%s(%d): %u frames exceed the buffer of %zu frames",
+                    __func__, mOutputTrack->id(), frames, mBufferFrames);
+            countDropped_l(frames - mBufferFrames);
+            frames = mBufferFrames;
+        }
+        if (mPendingBuffers == kQueueDepth) {
+            dropOldest_l();
+        }
+        // a free slot always remains, as at most kQueueDepth - 1 buffers are pending
+        // and one may be written.
+        const size_t slot = mFreeSlots[--mFreeSlotCount];
+        if (data != nullptr) {
+            memcpy(slotData(slot), data, frames * mFrameSize);
+        } else {
+            memset(slotData(slot), 0, frames * mFrameSize);
+        }
+        mQueue[(mQueueFront + mQueueSize) % kMaxEntries] = {slot, frames, false /* mStop */};
+        ++mQueueSize;
+        ++mPendingBuffers;
+        mFramesQueued += frames;
+        mWaitWorkCV.notify_one();
+    }
+
+    void countDropped_l(uint32_t frames) REQUIRES(mMutex) {
+        mFramesNotWritten += frames;
+        mFramesDropped += frames;
+    }
+
+    // Removes the oldest pending buffer to make room.  A stop left next to another
+    // stop is removed too, so at most kMaxEntries entries are queued.
+    void dropOldest_l() REQUIRES(mMutex) {
+        for (size_t i = 0; i < mQueueSize; ++i) {
+            const size_t index = (mQueueFront + i) % kMaxEntries;
+            const Entry dropped = mQueue[index];
+            if (dropped.mStop) {
+                continue;
+            }
+            // close the gap, the queue is at most kMaxEntries entries
+            for (size_t j = i; j > 0; --j) {
+                mQueue[(mQueueFront + j) % kMaxEntries] =
+                        mQueue[(mQueueFront + j - 1) % kMaxEntries];
+            }
+            mQueueFront = (mQueueFront + 1) % kMaxEntries;
+            --mQueueSize;
+            --mPendingBuffers;
+            mFreeSlots[mFreeSlotCount++] = dropped.mSlot;
+            countDropped_l(dropped.mFrames);
+            ++mBuffersDropped;
+            // only a single stop can precede the oldest buffer.
+            if (i == 1 && i < mQueueSize && mQueue[(mQueueFront + i) % kMaxEntries].mStop) {
+                mQueueFront = (mQueueFront + 1) % kMaxEntries;
+                --mQueueSize;
+            }
+            return;
+        }
+    }
+
+    const sp<OutputTrack>      mOutputTrack;
+    const size_t               mFrameSize;
+    const size_t               mBufferFrames;
+    // kQueueDepth buffers which may be pending, plus the one being written.
+    const std::unique_ptr<int8_t[]> mBuffers;
+
+    audio_utils::condition_variable mWaitWorkCV;
+    mutable audio_utils::mutex mMutex;
+
+    Entry                      mQueue[kMaxEntries] GUARDED_BY(mMutex);  // circular
+    size_t                     mQueueFront GUARDED_BY(mMutex) = 0;
+    size_t                     mQueueSize GUARDED_BY(mMutex) = 0;
+    size_t                     mPendingBuffers GUARDED_BY(mMutex) = 0;  // entries not stops
+    size_t                     mFreeSlots[kQueueDepth + 1] GUARDED_BY(mMutex);
+    size_t                     mFreeSlotCount GUARDED_BY(mMutex) = kQueueDepth + 1;
+
+    int64_t                    mFramesNotWritten GUARDED_BY(mMutex) = 0;
+    // for dump
+    int64_t                    mFramesQueued GUARDED_BY(mMutex) = 0;
+    int64_t                    mFramesDropped GUARDED_BY(mMutex) = 0;
+    uint32_t                   mBuffersDropped GUARDED_BY(mMutex) = 0;
+    int64_t                    mMaxWriteNs GUARDED_BY(mMutex) = 0;
+};
+
+} // namespace android
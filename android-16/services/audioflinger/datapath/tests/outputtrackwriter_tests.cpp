@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// #define LOG_NDEBUG 0
+#define LOG_TAG "outputtrackwriter_tests"
+
+#include "../OutputTrackWriter.h"
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kFrameSize = sizeof(int32_t);
+constexpr uint32_t kBufferFrames = 96;  // 2 ms at 48 kHz
+
+// Consumes buffers in real time like an OutputTrack on a MixerThread, or blocks
+// until released.  Records the first sample of each buffer written.
+class FakeOutputTrack : public RefBase {
+public:
+    explicit FakeOutputTrack(std::chrono::microseconds period) : mPeriod(period) {}
+
+    ssize_t write(void* data, uint32_t frames) {
+        std::unique_lock l(mMutex);
+        ++mWrites;
+        mCv.notify_all();
+        mCv.wait(l, [this] { return !mBlocked; });
+        l.unlock();
+        std::this_thread::sleep_for(mPeriod);
+        l.lock();
+        mBuffers.push_back(*static_cast<int32_t*>(data));
+        mFramesWritten += frames;
+        mCv.notify_all();
+        return frames;
+    }
+
+    void stop() {
+        std::lock_guard l(mMutex);
+        mStopped = true;
+        mCv.notify_all();
+    }
+
+    int id() const { return 1; }
+
+    void setBlocked(bool blocked) {
+        std::lock_guard l(mMutex);
+        mBlocked = blocked;
+        mCv.notify_all();
+    }
+
+    bool waitForStop() {
+        std::unique_lock l(mMutex);
+        return mCv.wait_for(l, std::chrono::seconds(5), [this] { return mStopped; });
+    }
+
+    bool waitForWrites(size_t count) {
+        std::unique_lock l(mMutex);
+        return mCv.wait_for(l, std::chrono::seconds(5),
+                [this, count] { return mWrites >= count; });
+    }
+
+    bool waitForBuffers(size_t count) {
+        std::unique_lock l(mMutex);
+        return mCv.wait_for(l, std::chrono::seconds(5),
+                [this, count] { return mBuffers.size() >= count; });
+    }
+
+    std::vector<int32_t> buffers() {
+        std::lock_guard l(mMutex);
+        return mBuffers;
+    }
+
+    int64_t framesWritten() {
+        std::lock_guard l(mMutex);
+        return mFramesWritten;
+    }
+
+private:
+    const std::chrono::microseconds mPeriod;
+    std::mutex mMutex;
+    std::condition_variable mCv;
+    bool mBlocked = false;
+    bool mStopped = false;
+    size_t mWrites = 0;
+    std::vector<int32_t> mBuffers;
+    int64_t mFramesWritten = 0;
+};
+
+using Writer = OutputTrackWriter<FakeOutputTrack>;
+
+constexpr nsecs_t kPeriodNs = 2000000;  // kBufferFrames at 48 kHz
+
+void queueBuffer(Writer& writer, int32_t index) {
+    std::vector<int32_t> buffer(kBufferFrames, index);
+    writer.queue(buffer.data(), kBufferFrames);
+}
+
+// Waits for the next buffer as DuplicatingThread::threadLoop_write() does.
+void pace(WritePacer& pacer) {
+    const nsecs_t delayNs = pacer.delayNs(systemTime(), kPeriodNs);
+    if (delayNs > 0) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(delayNs));
+    }
+}
+
+TEST(WritePacerTest, OneBufferPerPeriod) {
+    WritePacer pacer;
+    EXPECT_EQ(0, pacer.delayNs(1000, kPeriodNs));
+    // early writes wait for their period
+    EXPECT_EQ(kPeriodNs - 500, pacer.delayNs(1500, kPeriodNs));
+    EXPECT_EQ(2 * kPeriodNs - 1000, pacer.delayNs(2000, kPeriodNs));
+    // late writes catch up without waiting
+    EXPECT_EQ(0, pacer.delayNs(1000 + 4 * kPeriodNs, kPeriodNs));
+    EXPECT_EQ(0, pacer.delayNs(1000 + 4 * kPeriodNs, kPeriodNs));
+    EXPECT_EQ(kPeriodNs, pacer.delayNs(1000 + 4 * kPeriodNs, kPeriodNs));
+}
+
+TEST(WritePacerTest, RestartsWhenLate) {
+    WritePacer pacer;
+    EXPECT_EQ(0, pacer.delayNs(0, kPeriodNs));
+    // more than kMaxLatePeriods late: the missed buffers are not written back to back
+    const nsecs_t lateNs = (WritePacer::kMaxLatePeriods + 2) * kPeriodNs;
+    EXPECT_EQ(0, pacer.delayNs(lateNs, kPeriodNs));
+    EXPECT_EQ(kPeriodNs, pacer.delayNs(lateNs, kPeriodNs));
+
+    pacer.reset();
+    EXPECT_EQ(0, pacer.delayNs(lateNs + 10, kPeriodNs));
+}
+
+TEST(OutputTrackWriterTest, SteadyStateDropsNothing) {
+    // The output consumes a little faster than the mix.
+    const auto track = sp<FakeOutputTrack>::make(
+            std::chrono::microseconds(kPeriodNs * 9 / 10000));
+    const auto writer = sp<Writer>::make(track, kFrameSize, kBufferFrames);
+
+    WritePacer pacer;
+    constexpr int32_t kNumBuffers = 200;
+    for (int32_t i = 0; i < kNumBuffers; ++i) {
+        pace(pacer);
+        queueBuffer(*writer, i);
+    }
+    writer->queueStop();
+    ASSERT_TRUE(track->waitForStop());
+
+    EXPECT_EQ(0, writer->framesDropped());
+    EXPECT_EQ(0, writer->takeFramesNotWritten());
+    EXPECT_EQ(kNumBuffers * (int64_t)kBufferFrames, track->framesWritten());
+    const std::vector<int32_t> buffers = track->buffers();
+    ASSERT_EQ((size_t)kNumBuffers, buffers.size());
+    for (int32_t i = 0; i < kNumBuffers; ++i) {
+        EXPECT_EQ(i, buffers[i]);
+    }
+    writer->exit();
+    writer->join();
+}
+
+TEST(OutputTrackWriterTest, StalledOutputDropsOldest) {
+    const auto track = sp<FakeOutputTrack>::make(std::chrono::microseconds(0));
+    track->setBlocked(true);
+    const auto writer = sp<Writer>::make(track, kFrameSize, kBufferFrames);
+
+    // Buffer 0 is taken by the writer, which blocks in write().
+    queueBuffer(*writer, 0);
+    ASSERT_TRUE(track->waitForWrites(1));
+    int32_t index = 1;
+    for (; index <= (int32_t)Writer::kQueueDepth; ++index) {
+        queueBuffer(*writer, index);
+    }
+    EXPECT_EQ(0, writer->framesDropped());
+
+    // A full queue drops its oldest buffer, which counts as not written.
+    queueBuffer(*writer, index++);
+    EXPECT_EQ((int64_t)kBufferFrames, writer->framesDropped());
+    EXPECT_EQ((int64_t)kBufferFrames, writer->takeFramesNotWritten());
+    EXPECT_EQ(0, writer->takeFramesNotWritten());
+
+    track->setBlocked(false);
+    ASSERT_TRUE(track->waitForBuffers(Writer::kQueueDepth + 1));
+    const std::vector<int32_t> buffers = track->buffers();
+    EXPECT_EQ((std::vector<int32_t>{0, 2, 3, 4}), buffers);
+    writer->exit();
+    writer->join();
+}
+
+TEST(OutputTrackWriterTest, StalledFirstOutputDelaysNoOther) {
+    // The first output, which DuplicatingThread uses for timestamps, stalls.
+    const auto stalled = sp<FakeOutputTrack>::make(std::chrono::microseconds(0));
+    stalled->setBlocked(true);
+    const auto stalledWriter = sp<Writer>::make(stalled, kFrameSize, kBufferFrames);
+    const auto track = sp<FakeOutputTrack>::make(std::chrono::microseconds(kPeriodNs / 2000));
+    const auto writer = sp<Writer>::make(track, kFrameSize, kBufferFrames);
+
+    WritePacer pacer;
+    constexpr int32_t kNumBuffers = 100;
+    const nsecs_t startNs = systemTime();
+    for (int32_t i = 0; i < kNumBuffers; ++i) {
+        pace(pacer);
+        queueBuffer(*stalledWriter, i);
+        queueBuffer(*writer, i);
+    }
+    const nsecs_t elapsedNs = systemTime() - startNs;
+    writer->queueStop();
+    ASSERT_TRUE(track->waitForStop());
+
+    // The mix kept its pace, and the other output got every buffer.
+    EXPECT_LT(elapsedNs, 2 * kNumBuffers * kPeriodNs);
+    EXPECT_EQ(0, writer->framesDropped());
+    const std::vector<int32_t> buffers = track->buffers();
+    ASSERT_EQ((size_t)kNumBuffers, buffers.size());
+    for (int32_t i = 0; i < kNumBuffers; ++i) {
+        EXPECT_EQ(i, buffers[i]);
+    }
+    // The stalled output dropped all but its pending buffers and the one it is writing.
+    EXPECT_EQ((kNumBuffers - (int64_t)Writer::kQueueDepth - 1) * kBufferFrames,
+            stalledWriter->framesDropped());
+
+    stalled->setBlocked(false);
+    stalledWriter->exit();
+    stalledWriter->join();
+    writer->exit();
+    writer->join();
+}
+
+TEST(OutputTrackWriterTest, SilenceForOutputsNotReady) {
+    const auto track = sp<FakeOutputTrack>::make(std::chrono::microseconds(0));
+    const auto writer = sp<Writer>::make(track, kFrameSize, kBufferFrames);
+
+    queueBuffer(*writer, 1);
+    writer->queueSilence(kBufferFrames);
+    queueBuffer(*writer, 2);
+    ASSERT_TRUE(track->waitForBuffers(3));
+    EXPECT_EQ((std::vector<int32_t>{1, 0, 2}), track->buffers());
+    EXPECT_EQ(3 * (int64_t)kBufferFrames, track->framesWritten());
+    writer->exit();
+    writer->join();
+}
+
+TEST(OutputTrackWriterTest, StopKeepsPendingBuffers) {
+    const auto track = sp<FakeOutputTrack>::make(std::chrono::microseconds(0));
+    track->setBlocked(true);
+    const auto writer = sp<Writer>::make(track, kFrameSize, kBufferFrames);
+
+    queueBuffer(*writer, 0);
+    ASSERT_TRUE(track->waitForWrites(1));
+    for (int32_t i = 1; i <= (int32_t)Writer::kQueueDepth; ++i) {
+        queueBuffer(*writer, i);
+    }
+    // Standby stops the OutputTrack after the buffers of a full queue.
+    writer->queueStop();
+    track->setBlocked(false);
+    ASSERT_TRUE(track->waitForStop());
+    EXPECT_EQ(0, writer->framesDropped());
+    EXPECT_EQ((std::vector<int32_t>{0, 1, 2, 3}), track->buffers());
+    writer->exit();
+    writer->join();
+}
+
+} // namespace
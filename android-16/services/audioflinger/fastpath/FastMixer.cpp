@@ -351,6 +351,17 @@ void FastMixer::onWork()
     const FastMixerState::Command command = mCommand;
     const size_t frameCount = current->mFrameCount;
 
+    // Cycle budget statistics, see FastMixerDumpState::mCycleNs.
+    // systemTime() is a vDSO call, so the cost is a few clock reads per cycle and track.
+    nsecs_t stageNs[FAST_MIXER_STAGE_CNT]{};
+    nsecs_t stageStartNs = systemTime();
+    const auto endStage = [&stageNs, &stageStartNs](FastMixerStage stage) {
+        const nsecs_t nowNs = systemTime();
+        stageNs[stage] += nowNs - stageStartNs;
+        stageStartNs = nowNs;
+    };
+    unsigned enabledTrackMask = 0;
+
     if ((command & FastMixerState::MIX) && (mMixer != nullptr) && mIsWarm) {
         ALOG_ASSERT(mMixerBuffer != nullptr);
 
@@ -358,6 +369,10 @@ void FastMixer::onWork()
         // so we keep a side copy of enabledTracks
         bool anyEnabledTracks = false;
 
+        // Per track update times start after the setup above, which is only counted
+        // in the track stage.
+        endStage(FAST_MIXER_STAGE_TRACKS);
+
         // for each track, update volume and check for underrun
         unsigned currentTrackMask = current->mTrackMask;
         while (currentTrackMask != 0) {
@@ -423,6 +438,12 @@ void FastMixer::onWork()
             ftDump->mUnderruns = underruns;
             ftDump->mFramesReady = framesReady;
             ftDump->mFramesWritten = trackFramesWritten;
+            if (framesReady > 0) {
+                enabledTrackMask |= 1 << i;
+            }
+            const nsecs_t trackStartNs = stageStartNs;
+            endStage(FAST_MIXER_STAGE_TRACKS);
+            ftDump->mUpdateNs.add(stageStartNs - trackStartNs);
         }
 
         if (anyEnabledTracks) {
@@ -432,6 +453,7 @@ void FastMixer::onWork()
         } else if (mMixerBufferState != ZEROED) {
             mMixerBufferState = UNDEFINED;
         }
+        endStage(FAST_MIXER_STAGE_MIX);
 
     } else if (mMixerBufferState == MIXED) {
         mMixerBufferState = UNDEFINED;
@@ -453,12 +475,23 @@ void FastMixer::onWork()
         // mBalance detects zero balance within the class for speed (not needed here).
         mBalance.setBalance(mMasterBalance.load());
         mBalance.process((float *)mMixerBuffer, frameCount);
-
-        // prepare the buffer used to write to sink
-        void *buffer = mSinkBuffer != nullptr ? mSinkBuffer : mMixerBuffer;
+        endStage(FAST_MIXER_STAGE_EFFECTS);
+
+        // prepare the buffer used to write to sink.
+        // If the sink can provide a full period of its own buffer memory, for example the data
+        // FMQ of an AIDL HAL stream, then convert straight into it and commit it instead of
+        // write(), which saves a copy into mSinkBuffer and a copy by the sink.
+        void *buffer = nullptr;
+        const bool zeroCopy =
+                mOutputSink->obtainWriteBuffer(&buffer, frameCount) == (ssize_t) frameCount;
+        if (!zeroCopy) {
+            buffer = mSinkBuffer != nullptr ? mSinkBuffer : mMixerBuffer;
+        }
         if (mFormat.mFormat != mMixerBufferFormat) { // sink format not the same as mixer format
             memcpy_by_audio_format(buffer, mFormat.mFormat, mMixerBuffer, mMixerBufferFormat,
                     frameCount * Format_channelCount(mFormat));
+        } else if (zeroCopy) {
+            memcpy(buffer, mMixerBuffer, frameCount * Format_frameSize(mFormat));
         }
         if (mSinkChannelMask & AUDIO_CHANNEL_HAPTIC_ALL) {
             // When there are haptic channels, the sample data is partially interleaved.
@@ -467,6 +500,7 @@ void FastMixer::onWork()
                     audio_bytes_per_sample(mFormat.mFormat),
                     frameCount * audio_bytes_per_frame(mAudioChannelCount, mFormat.mFormat));
         }
+        endStage(FAST_MIXER_STAGE_CONVERT);
         // if non-nullptr, then duplicate write() to this non-blocking sink
 #ifdef TEE_SINK
         mTee.write(buffer, frameCount);
@@ -475,8 +509,10 @@ void FastMixer::onWork()
         //       but this code should be modified to handle both non-blocking and blocking sinks
         dumpState->mWriteSequence++;
         ATRACE_BEGIN("write");
-        const ssize_t framesWritten = mOutputSink->write(buffer, frameCount);
+        const ssize_t framesWritten = zeroCopy ? mOutputSink->commitWriteBuffer(frameCount)
+                : mOutputSink->write(buffer, frameCount);
         ATRACE_END();
+        endStage(FAST_MIXER_STAGE_WRITE);
         dumpState->mWriteSequence++;
         if (framesWritten >= 0) {
             ALOG_ASSERT((size_t) framesWritten <= frameCount);
@@ -536,6 +572,33 @@ void FastMixer::onWork()
             }
         }
     }
+
+    if (mIsWarm) {
+        updateCycleStats(dumpState, stageNs, enabledTrackMask);
+    }
+}
+
+void FastMixer::updateCycleStats(FastMixerDumpState *dumpState,
+        const nsecs_t (&stageNs)[FAST_MIXER_STAGE_CNT], unsigned enabledTrackMask)
+{
+    nsecs_t cycleNs = 0;
+    for (int i = 0; i < FAST_MIXER_STAGE_CNT; ++i) {
+        dumpState->mStageNs[i].add(stageNs[i]);
+        if (i != FAST_MIXER_STAGE_WRITE) {
+            cycleNs += stageNs[i];
+        }
+    }
+    dumpState->mCycleNs.add(cycleNs);
+    dumpState->mBudgetNs = mPeriodNs;
+    if (mPeriodNs > 0 && cycleNs > mPeriodNs) {
+        dumpState->mOverBudgetCycles++;
+        // Attribute the over budget cycle to every track that was mixed.
+        while (enabledTrackMask != 0) {
+            const int i = __builtin_ctz(enabledTrackMask);
+            enabledTrackMask &= ~(1 << i);
+            dumpState->mTracks[i].mOverBudgetCycles++;
+        }
+    }
 }
 
 }   // namespace android
@@ -46,7 +46,11 @@ public:
         mBoottimeOffset.store(boottimeOffset); /* memory_order_seq_cst */
     }
 private:
-            FastMixerStateQueue mSQ;
+    // Allows the normal mixer to push several state changes, such as a burst of
+    // track additions and removals, before the fast mixer acknowledges them.
+    static constexpr size_t kStateQueueDepth = 8;
+
+            FastMixerStateQueue mSQ{kStateQueueDepth};
 
     // callouts
     const FastThreadState *poll() override;
@@ -65,6 +69,10 @@ private:
     // called when a fast track of index has been removed, added, or modified
     void updateMixerTrack(int index, Reason reason);
 
+    // called at the end of a warm onWork() with the time spent in each stage
+    void updateCycleStats(FastMixerDumpState *dumpState,
+            const nsecs_t (&stageNs)[FAST_MIXER_STAGE_CNT], unsigned enabledTrackMask);
+
     // FIXME these former local variables need comments
     static const FastMixerState sInitial;
 
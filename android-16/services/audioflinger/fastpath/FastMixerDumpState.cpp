@@ -24,6 +24,8 @@
 #include <cpustats/ThreadCpuUsage.h>
 #endif
 #endif
+#include <string>
+#include <unistd.h>
 #include <utils/Log.h>
 #include "FastMixerDumpState.h"
 
@@ -191,4 +193,90 @@ void FastMixerDumpState::dump(int fd) const
     }
 }
 
+static const char *stageToString(FastMixerStage stage)
+{
+    switch (stage) {
+    case FAST_MIXER_STAGE_TRACKS:   return "tracks";
+    case FAST_MIXER_STAGE_MIX:      return "mix";
+    case FAST_MIXER_STAGE_EFFECTS:  return "effects";
+    case FAST_MIXER_STAGE_CONVERT:  return "convert";
+    case FAST_MIXER_STAGE_WRITE:    return "write";
+    default:                        return "?";
+    }
+}
+
+static void dumpHistogramHeader(int fd, const char *name)
+{
+    dprintf(fd, "    %-8s %10s %8s %8s", name, "count", "mean_us", "max_us");
+    // upper bound of each bucket in us, the last bucket is unbounded
+    for (uint32_t i = 0; i < FastMixerCycleHistogram::kBuckets - 1; ++i) {
+        dprintf(fd, " %5u", (FastMixerCycleHistogram::kMinNs << i) / 1000);
+    }
+    dprintf(fd, "   max\n");
+}
+
+static void dumpHistogram(int fd, const char *name, const FastMixerCycleHistogram& histogram)
+{
+    const double meanUs = histogram.mN > 0 ? histogram.mTotalNs * 1e-3 / histogram.mN : 0.;
+    dprintf(fd, "    %-8s %10u %8.1f %8.1f", name, histogram.mN, meanUs,
+            histogram.mMaxNs * 1e-3);
+    for (const uint32_t count : histogram.mCounts) {
+        dprintf(fd, " %5u", count);
+    }
+    dprintf(fd, "\n");
+}
+
+void FastMixerDumpState::dumpCycleStats(int fd) const
+{
+    dprintf(fd, "  FastMixer cycle budget: budget=%.2f ms overBudgetCycles=%u\n",
+            mBudgetNs * 1e-6, mOverBudgetCycles);
+    dumpHistogramHeader(fd, "stage");
+    dumpHistogram(fd, "cycle", mCycleNs);
+    for (int i = 0; i < FAST_MIXER_STAGE_CNT; ++i) {
+        dumpHistogram(fd, stageToString(static_cast<FastMixerStage>(i)), mStageNs[i]);
+    }
+    dprintf(fd, "  FastMixer per track update time and over budget cycles:\n");
+    dumpHistogramHeader(fd, "index");
+    for (uint32_t i = 0; i < FastMixerState::sMaxFastTracks; ++i) {
+        const FastTrackDump& ftDump = mTracks[i];
+        if (ftDump.mUpdateNs.mN == 0) {
+            continue;  // never active
+        }
+        const std::string index = std::to_string(i);
+        dumpHistogram(fd, index.c_str(), ftDump.mUpdateNs);
+        dprintf(fd, "    %-8s overBudgetCycles=%u\n", "", ftDump.mOverBudgetCycles);
+    }
+}
+
+// static
+bool FastMixerDumpState::isCycleStatsDumpRequested(const Vector<String16>& args)
+{
+    for (const auto& arg : args) {
+        if (arg == String16("--fastmixer") || arg == String16("-a") || arg == String16("--all")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FastMixerDumpState::dumpCycleStatsBinary(int fd, int32_t ioHandle) const
+{
+    FastMixerCycleStatsRecord record;
+    record.mIoHandle = ioHandle;
+    record.mSampleRate = mSampleRate;
+    record.mFrameCount = mFrameCount;
+    record.mBudgetNs = mBudgetNs;
+    record.mOverBudgetCycles = mOverBudgetCycles;
+    record.mTrackMask = mTrackMask;
+    record.mCycleNs = mCycleNs;
+    std::copy(std::begin(mStageNs), std::end(mStageNs), std::begin(record.mStageNs));
+    for (uint32_t i = 0; i < FastMixerState::kMaxFastTracks; ++i) {
+        record.mTracks[i].mUpdateNs = mTracks[i].mUpdateNs;
+        record.mTracks[i].mOverBudgetCycles = mTracks[i].mOverBudgetCycles;
+    }
+    if (write(fd, &record, sizeof(record)) != (ssize_t) sizeof(record)) {
+        ALOGW("%s: short write", __func__);
+    }
+}
+
 }  // namespace android
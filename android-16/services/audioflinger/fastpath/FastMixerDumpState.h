@@ -17,8 +17,11 @@
 #pragma once
 
 #include <stdint.h>
+#include <algorithm>
 #include <type_traits>
 #include <audio_utils/TimestampVerifier.h>
+#include <utils/String16.h>
+#include <utils/Vector.h>
 #include "Configuration.h"
 #include "FastThreadDumpState.h"
 #include "FastMixerState.h"
@@ -52,11 +55,53 @@ private:
     uint32_t mAtomic;
 };
 
+// Stages of a fast mixer cycle that are timed separately for the cycle budget statistics.
+enum FastMixerStage {
+    FAST_MIXER_STAGE_TRACKS,    // per track volume, timestamp and framesReady() updates
+    FAST_MIXER_STAGE_MIX,       // AudioMixer::process()
+    FAST_MIXER_STAGE_EFFECTS,   // master mono and balance
+    FAST_MIXER_STAGE_CONVERT,   // sink format conversion and haptic channel interleave
+    FAST_MIXER_STAGE_WRITE,     // write() to the output sink, usually blocks
+    FAST_MIXER_STAGE_CNT,
+};
+
+// Histogram of durations with fixed power of 2 buckets.
+// Bucket 0 counts durations less than kMinNs, and bucket i > 0 counts durations in
+// [kMinNs << (i - 1), kMinNs << i).  The last bucket also counts all longer durations.
+// Written only by the fast mixer thread, and read without a lock by dumpsys, so a
+// reader may observe counters from different cycles but never a torn 32-bit counter.
+struct FastMixerCycleHistogram {
+    static constexpr uint32_t kBuckets = 16;
+    static constexpr uint32_t kMinNs = 1 << 10;  // ~1 us
+
+    void add(int64_t ns) {
+        const uint64_t duration = ns > 0 ? ns : 0;
+        uint32_t bucket = 0;
+        if (duration >= kMinNs) {
+            // __builtin_clzll(kMinNs) == 53
+            bucket = std::min<uint32_t>(54 - __builtin_clzll(duration), kBuckets - 1);
+        }
+        ++mCounts[bucket];
+        ++mN;
+        mTotalNs += duration;
+        if (duration > mMaxNs) {
+            mMaxNs = std::min<uint64_t>(duration, UINT32_MAX);
+        }
+    }
+
+    uint64_t mTotalNs = 0;            // sum of all durations
+    uint32_t mN = 0;                  // number of durations
+    uint32_t mMaxNs = 0;              // longest duration
+    uint32_t mCounts[kBuckets]{};
+};
+
 // Represents the dump state of a fast track
 struct FastTrackDump {
     FastTrackUnderruns  mUnderruns;
     size_t              mFramesReady = 0;    // most recent value only; no long-term statistics kept
     int64_t             mFramesWritten = 0;  // last value from track
+    FastMixerCycleHistogram mUpdateNs;       // FAST_MIXER_STAGE_TRACKS time for this track
+    uint32_t            mOverBudgetCycles = 0; // over budget cycles while this track was enabled
 };
 
 // No virtuals.
@@ -64,6 +109,11 @@ static_assert(!std::is_polymorphic_v<FastTrackDump>);
 
 struct FastMixerDumpState : FastThreadDumpState {
     void dump(int fd) const;    // should only be called on a stable copy, not the original
+    void dumpCycleStats(int fd) const;  // should only be called on a stable copy
+    // Writes one FastMixerCycleStatsRecord, should only be called on a stable copy.
+    void dumpCycleStatsBinary(int fd, int32_t ioHandle) const;
+    // Whether the dumpsys arguments ask for dumpCycleStats().
+    static bool isCycleStatsDumpRequested(const Vector<String16>& args);
 
     double   mLatencyMs = 0.;     // measured latency, default of 0 if no valid timestamp read.
     uint32_t mWriteSequence = 0;  // incremented before and after each write()
@@ -77,8 +127,44 @@ struct FastMixerDumpState : FastThreadDumpState {
 
     // For timestamp statistics.
     TimestampVerifier<int64_t /* frame count */, int64_t /* time ns */> mTimestampVerifier;
+
+    // Cycle budget statistics.  A cycle is over budget when the time to prepare the
+    // sink buffer, that is all stages but FAST_MIXER_STAGE_WRITE, exceeds mBudgetNs.
+    uint32_t mBudgetNs = 0;             // mix period
+    uint32_t mOverBudgetCycles = 0;     // total number of cycles over budget
+    FastMixerCycleHistogram mCycleNs;   // all stages but FAST_MIXER_STAGE_WRITE
+    FastMixerCycleHistogram mStageNs[FAST_MIXER_STAGE_CNT];
+};
+
+// Binary export of the cycle budget statistics of one fast mixer, in host byte order.
+// Bump kVersion on any layout change.
+struct FastMixerCycleStatsRecord {
+    static constexpr uint32_t kMagic = 0x53434d46;  // "FMCS"
+    static constexpr uint32_t kVersion = 1;
+
+    uint32_t mMagic = kMagic;
+    uint32_t mVersion = kVersion;
+    uint32_t mSize = sizeof(FastMixerCycleStatsRecord);
+    int32_t  mIoHandle = 0;
+    uint32_t mSampleRate = 0;
+    uint32_t mFrameCount = 0;
+    uint32_t mBudgetNs = 0;
+    uint32_t mOverBudgetCycles = 0;
+    uint32_t mTrackMask = 0;
+    uint32_t mStageCount = FAST_MIXER_STAGE_CNT;
+    uint32_t mTrackCount = FastMixerState::kMaxFastTracks;
+    uint32_t mBucketCount = FastMixerCycleHistogram::kBuckets;
+    FastMixerCycleHistogram mCycleNs;
+    FastMixerCycleHistogram mStageNs[FAST_MIXER_STAGE_CNT];
+    struct Track {
+        FastMixerCycleHistogram mUpdateNs;
+        uint32_t mOverBudgetCycles = 0;
+        uint32_t mReserved = 0;
+    } mTracks[FastMixerState::kMaxFastTracks];
 };
 
+static_assert(std::is_trivially_copyable_v<FastMixerCycleStatsRecord>);
+
 // No virtuals.
 static_assert(!std::is_polymorphic_v<FastMixerDumpState>);
 
@@ -33,11 +33,19 @@ void StateQueueObserverDump::dump(int fd)
 
 void StateQueueMutatorDump::dump(int fd)
 {
-    dprintf(fd, "State queue mutator: pushDirty=%u pushAck=%u blockedSequence=%u\n",
-            mPushDirty, mPushAck, mBlockedSequence);
+    dprintf(fd, "State queue mutator: pushDirty=%u pushAck=%u blockedSequence=%u\n"
+                "                     pushFull=%u pushWait=%u maxPending=%u\n",
+            mPushDirty, mPushAck, mBlockedSequence, mPushFull, mPushWait, mMaxPending);
 }
 #endif
 
+template<typename T> StateQueue<T>::StateQueue(size_t depth)
+    : mDepth(depth), mStates(new T[depth]), mMutating(&mStates[0])
+{
+    LOG_ALWAYS_FATAL_IF(depth < kDefaultDepth, "%s: depth %zu < %zu",
+            __func__, depth, kDefaultDepth);
+}
+
 // Observer APIs
 
 template<typename T> const T* StateQueue<T>::poll()
@@ -45,6 +53,8 @@ template<typename T> const T* StateQueue<T>::poll()
     const T *next = (const T *) atomic_load_explicit(&mNext, memory_order_acquire);
 
     if (next != mCurrent) {
+        mAckPrevious = mCurrent;
+        atomic_thread_fence(memory_order_release);  // mAckPrevious before mAck
         mAck = next;    // no additional barrier needed
         mCurrent = next;
 #ifdef STATE_QUEUE_DUMP
@@ -74,6 +84,30 @@ template<typename T> void StateQueue<T>::end(bool didModify)
     mInMutation = false;
 }
 
+template<typename T> size_t StateQueue<T>::seqOf(const T* state) const
+{
+    // The state is the latest push in its slot, as the pushes
+    // from the acknowledged one onwards occupy fewer than mDepth slots.
+    const size_t slot = state - &mStates[0];
+    return mPushedSeq - 1 - ((mPushedSeq - 1 - slot) % mDepth);
+}
+
+template<typename T> bool StateQueue<T>::canPush() const
+{
+    const T *ack = (const T *) mAck;
+    atomic_thread_fence(memory_order_acquire);  // mAck before mAckPrevious
+    const T *previous = (const T *) mAckPrevious;
+
+    // Until the first acknowledgement, the observer may access any pushed state.
+    // The observer only moves forward, so a stale mAck is conservative, and if it has moved
+    // since mAck was read then mAckPrevious is the acknowledged state or a later push.
+    const size_t pending = ack != nullptr ? mPushedSeq - 1 - seqOf(ack) : mPushedSeq;
+    if (pending > mDepth - kDefaultDepth) {
+        return false;
+    }
+    return previous != &mStates[(mPushedSeq + 1) % mDepth];
+}
+
 template<typename T> bool StateQueue<T>::push(StateQueue<T>::block_t block)
 {
 #define PUSH_BLOCK_ACK_NS    3000000L   // 3 ms: time between checks for ack in push()
@@ -94,21 +128,19 @@ template<typename T> bool StateQueue<T>::push(StateQueue<T>::block_t block)
         mMutatorDump->mPushDirty++;
 #endif
 
-        // wait for prior push to be acknowledged
-        if (mExpecting != nullptr) {
+        // wait for a slot that the observer can no longer access
+        if (!canPush()) {
+            if (block == BLOCK_NEVER) {
+#ifdef STATE_QUEUE_DUMP
+                mMutatorDump->mPushFull++;
+#endif
+                return false;
+            }
 #ifdef STATE_QUEUE_DUMP
+            mMutatorDump->mPushWait++;
             unsigned count = 0;
 #endif
-            for (;;) {
-                const T *ack = (const T *) mAck;    // no additional barrier needed
-                if (ack == mExpecting) {
-                    // unnecessary as we're about to rewrite
-                    //mExpecting = nullptr;
-                    break;
-                }
-                if (block == BLOCK_NEVER) {
-                    return false;
-                }
+            do {
 #ifdef STATE_QUEUE_DUMP
                 if (count == 1) {
                     mMutatorDump->mBlockedSequence++;
@@ -116,7 +148,7 @@ template<typename T> bool StateQueue<T>::push(StateQueue<T>::block_t block)
                 ++count;
 #endif
                 nanosleep(&req, nullptr);
-            }
+            } while (!canPush());
 #ifdef STATE_QUEUE_DUMP
             if (count > 1) {
                 mMutatorDump->mBlockedSequence++;
@@ -129,12 +161,18 @@ template<typename T> bool StateQueue<T>::push(StateQueue<T>::block_t block)
         mExpecting = mMutating;
 
         // copy with circular wraparound
-        if (++mMutating >= &mStates[kN]) {
-            mMutating = &mStates[0];
-        }
+        mMutating = &mStates[++mPushedSeq % mDepth];
         *mMutating = *mExpecting;
         mIsDirty = false;
 
+#ifdef STATE_QUEUE_DUMP
+        const T *ack = (const T *) mAck;
+        const size_t pending = ack != nullptr ? mPushedSeq - 1 - seqOf(ack) : mPushedSeq;
+        if (pending > mMutatorDump->mMaxPending) {
+            mMutatorDump->mMaxPending = pending;
+        }
+#endif
+
     }
 
     // optionally wait for this push or a prior push to be acknowledged
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <memory>
 #include <stdatomic.h>
 
 // The state queue template class was originally driven by this use case / requirements:
@@ -59,11 +60,13 @@
 // It is not a requirement to work well if the roles were reversed,
 // and the mutator were to run more frequently than the observer.
 // In this case, the mutator could get blocked waiting for a slot to fill up for
-// it to work with. This could be solved somewhat by increasing the depth of the queue, but it would
-// still limit the mutator to a finite number of changes before it would block.  A future
-// possibility, not implemented here, would be to allow the mutator to safely overwrite an already
-// pushed state. This could be done by the mutator overwriting mNext, but then being prepared to
-// read an mAck which is actually for the earlier mNext (since there is a race).
+// it to work with. This is solved somewhat by increasing the depth of the queue, but it
+// still limits the mutator to a finite number of pushes before it would block.  Beyond that,
+// a push(BLOCK_NEVER) leaves the state dirty, and later mutations are coalesced into it until
+// a slot is available.  A future possibility, not implemented here, would be to allow the
+// mutator to safely overwrite an already pushed state. This could be done by the mutator
+// overwriting mNext, but then being prepared to read an mAck which is actually for the
+// earlier mNext (since there is a race).
 
 // Solution:
 //  Let's call the fast mixer thread the "observer" and normal mixer thread the "mutator".
@@ -89,6 +92,12 @@
 //  effectively in random order, that is the observer should not do address
 //  arithmetic on the state pointers.  However to the mutator, the state pointers
 //  are in a definite circular order.
+//  With a depth of 4, the mutator can only push after the observer has acknowledged the
+//  prior push.  With a larger depth the mutator can push up to (depth - 3) states ahead of the
+//  acknowledged one.  Along with each acknowledgement the observer publishes its previous
+//  state.  The mutator numbers its pushes, and does not reuse the slot of the observer's
+//  previous state, nor of the acknowledged state or any later push.  The limit on pushes ahead
+//  ensures that once the observer has caught up, its previous state is not in the next slot.
 
 #include "Configuration.h"
 
@@ -111,13 +120,18 @@ struct StateQueueObserverDump {
 };
 
 struct StateQueueMutatorDump {
-    StateQueueMutatorDump() : mPushDirty(0), mPushAck(0), mBlockedSequence(0) { }
+    StateQueueMutatorDump() : mPushDirty(0), mPushAck(0), mBlockedSequence(0),
+            mPushFull(0), mPushWait(0), mMaxPending(0) { }
     /*virtual*/ ~StateQueueMutatorDump() { }
     unsigned    mPushDirty;       // incremented each time push() is called with a dirty state
     unsigned    mPushAck;         // incremented each time push(BLOCK_UNTIL_ACKED) is called
     unsigned    mBlockedSequence; // incremented before and after each time that push()
                                   // blocks for more than one PUSH_BLOCK_ACK_NS;
                                   // if odd, then mutator is currently blocked inside push()
+    unsigned    mPushFull;        // incremented each time push(BLOCK_NEVER) finds no free slot,
+                                  // so the dirty state will be coalesced with later mutations
+    unsigned    mPushWait;        // incremented each time push() waits for a free slot
+    unsigned    mMaxPending;      // maximum number of pushed states not yet acknowledged
     void        dump(int fd);
 };
 #endif
@@ -127,6 +141,16 @@ struct StateQueueMutatorDump {
 template<typename T> class StateQueue final {
 
 public:
+    static constexpr size_t kDefaultDepth = 4;
+
+    // The depth is the number of states, and must be >= 4.
+    // Depth 4 allows one pushed state not yet acknowledged by the observer,
+    // and each additional state allows one more.
+    explicit StateQueue(size_t depth = kDefaultDepth);
+
+    StateQueue(const StateQueue&) = delete;
+    StateQueue& operator=(const StateQueue&) = delete;
+
     // Observer APIs
 
     // Poll for a state change.  Returns a pointer to a read-only state,
@@ -170,6 +194,9 @@ public:
     // Return whether the current state is dirty (modified and not pushed).
     bool    isDirty() const { return mIsDirty; }
 
+    // Return the number of states.
+    size_t  depth() const { return mDepth; }
+
 #ifdef STATE_QUEUE_DUMP
     // Register location of observer dump area
     void    setObserverDump(StateQueueObserverDump *dump)
@@ -181,20 +208,30 @@ public:
 #endif
 
 private:
-    static const unsigned kN = 4;       // values < 4 are not supported by this code
-    T                 mStates[kN];      // written by mutator, read by observer
+    // Return the sequence number of the acknowledged state or a later push.
+    size_t  seqOf(const T* state) const;
+
+    // Return whether the mutator can push now without reusing a state the observer may access.
+    bool    canPush() const;
+
+    const size_t      mDepth;           // values < 4 are not supported by this code
+    const std::unique_ptr<T[]> mStates; // written by mutator, read by observer
 
     // "volatile" is meaningless with SMP, but here it indicates that we're using atomic ops
     atomic_uintptr_t  mNext{}; // written by mutator to advance next, read by observer
     volatile const T* mAck = nullptr;  // written by observer to acknowledge advance of next,
                                        // read by mutator
+    volatile const T* mAckPrevious = nullptr; // written by observer before mAck with its
+                                       // previous state, read by mutator after mAck
 
     // only used by observer
     const T*    mCurrent = nullptr;     // most recent value returned by poll()
 
     // only used by mutator
-    T*          mMutating{&mStates[0]}; // where updates by mutator are done in place
+    T*          mMutating;              // where updates by mutator are done in place
     const T*    mExpecting = nullptr;   // what the mutator expects mAck to be set to
+    size_t      mPushedSeq = 0;         // sequence number of the next push, which is
+                                        // in slot mPushedSeq % mDepth
     bool        mInMutation = false;    // whether we're currently in the middle of a mutation
     bool        mIsDirty = false;       // whether mutating state has been modified since last push
     bool        mIsInitialized = false; // whether mutating state has been initialized yet
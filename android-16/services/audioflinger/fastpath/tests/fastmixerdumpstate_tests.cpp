@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <fastpath/FastMixerDumpState.h>
+#include <gtest/gtest.h>
+
+using namespace android;
+
+namespace {
+
+using Histogram = FastMixerCycleHistogram;
+
+// Returns the only bucket that counts a single added duration.
+int bucketOf(int64_t ns) {
+    Histogram histogram;
+    histogram.add(ns);
+    int bucket = -1;
+    for (uint32_t i = 0; i < Histogram::kBuckets; ++i) {
+        if (histogram.mCounts[i] != 0) {
+            EXPECT_EQ(-1, bucket) << "duration " << ns << " counted twice";
+            bucket = i;
+        }
+    }
+    return bucket;
+}
+
+// Runs a dump function on a temporary file and returns what it wrote.
+template <typename F>
+std::string dumpToString(F dump) {
+    const std::unique_ptr<FILE, decltype(&fclose)> file(tmpfile(), fclose);
+    if (file == nullptr) {
+        ADD_FAILURE() << "tmpfile: " << strerror(errno);
+        return {};
+    }
+    const int fd = fileno(file.get());
+    dump(fd);
+    std::string result(lseek(fd, 0, SEEK_END), '\0');
+    if (pread(fd, result.data(), result.size(), 0) != (ssize_t) result.size()) {
+        ADD_FAILURE() << "short read";
+    }
+    return result;
+}
+
+FastMixerDumpState makeDumpState() {
+    FastMixerDumpState dumpState;
+    dumpState.mSampleRate = 48000;
+    dumpState.mFrameCount = 96;
+    dumpState.mBudgetNs = 2000000;
+    dumpState.mOverBudgetCycles = 1;
+    dumpState.mTrackMask = 1 << 3;
+    dumpState.mCycleNs.add(500000);
+    dumpState.mCycleNs.add(3000000);
+    dumpState.mStageNs[FAST_MIXER_STAGE_MIX].add(2500000);
+    dumpState.mStageNs[FAST_MIXER_STAGE_WRITE].add(1000000);
+    dumpState.mTracks[3].mUpdateNs.add(4096);
+    dumpState.mTracks[3].mOverBudgetCycles = 1;
+    return dumpState;
+}
+
+}  // namespace
+
+TEST(FastMixerCycleHistogram, Buckets) {
+    constexpr int64_t kMinNs = Histogram::kMinNs;
+    constexpr int kLast = Histogram::kBuckets - 1;
+    EXPECT_EQ(0, bucketOf(-1));
+    EXPECT_EQ(0, bucketOf(0));
+    EXPECT_EQ(0, bucketOf(kMinNs - 1));
+    // Bucket i > 0 counts [kMinNs << (i - 1), kMinNs << i).
+    for (int i = 1; i < kLast; ++i) {
+        EXPECT_EQ(i, bucketOf(kMinNs << (i - 1))) << "bucket " << i;
+        EXPECT_EQ(i, bucketOf((kMinNs << i) - 1)) << "bucket " << i;
+    }
+    // The last bucket is unbounded.
+    EXPECT_EQ(kLast, bucketOf(kMinNs << (kLast - 1)));
+    EXPECT_EQ(kLast, bucketOf(kMinNs << kLast));
+    EXPECT_EQ(kLast, bucketOf(INT64_MAX));
+}
+
+TEST(FastMixerCycleHistogram, Totals) {
+    Histogram histogram;
+    histogram.add(-1000);  // counted as 0
+    histogram.add(3000);
+    histogram.add(1000);
+    EXPECT_EQ(3u, histogram.mN);
+    EXPECT_EQ(4000u, histogram.mTotalNs);
+    EXPECT_EQ(3000u, histogram.mMaxNs);
+    EXPECT_EQ(2u, histogram.mCounts[0]);
+    EXPECT_EQ(1u, histogram.mCounts[2]);
+
+    // The maximum saturates, the total does not.
+    const int64_t longNs = int64_t{UINT32_MAX} + 1;
+    histogram.add(longNs);
+    EXPECT_EQ(4u, histogram.mN);
+    EXPECT_EQ(4000u + longNs, histogram.mTotalNs);
+    EXPECT_EQ(UINT32_MAX, histogram.mMaxNs);
+}
+
+TEST(FastMixerDumpState, CycleStatsDumpRequested) {
+    const auto requested = [](std::initializer_list<const char*> list) {
+        Vector<String16> args;
+        for (const char* arg : list) args.add(String16(arg));
+        return FastMixerDumpState::isCycleStatsDumpRequested(args);
+    };
+    EXPECT_FALSE(requested({}));
+    EXPECT_FALSE(requested({"--fastmixer-binary"}));
+    EXPECT_FALSE(requested({"-b", "--all-threads"}));
+    EXPECT_TRUE(requested({"--fastmixer"}));
+    EXPECT_TRUE(requested({"-a"}));
+    EXPECT_TRUE(requested({"--all"}));
+    EXPECT_TRUE(requested({"--unreachable", "-a"}));
+}
+
+TEST(FastMixerDumpState, DumpCycleStats) {
+    const FastMixerDumpState dumpState = makeDumpState();
+    const std::string dump = dumpToString([&](int fd) { dumpState.dumpCycleStats(fd); });
+    EXPECT_NE(std::string::npos, dump.find("budget=2.00 ms overBudgetCycles=1\n")) << dump;
+    EXPECT_NE(std::string::npos, dump.find("cycle             2   1750.0   3000.0")) << dump;
+    EXPECT_NE(std::string::npos, dump.find("mix               1   2500.0   2500.0")) << dump;
+    EXPECT_NE(std::string::npos, dump.find("tracks            0      0.0      0.0")) << dump;
+    // Only tracks that were ever updated are listed.
+    EXPECT_NE(std::string::npos, dump.find("    3                 1      4.1      4.1")) << dump;
+    EXPECT_EQ(std::string::npos, dump.find("\n    0        ")) << dump;
+}
+
+TEST(FastMixerDumpState, DumpCycleStatsBinary) {
+    const FastMixerDumpState dumpState = makeDumpState();
+    const std::string dump =
+            dumpToString([&](int fd) { dumpState.dumpCycleStatsBinary(fd, 13 /*ioHandle*/); });
+    FastMixerCycleStatsRecord record;
+    ASSERT_EQ(sizeof(record), dump.size());
+    memcpy(&record, dump.data(), sizeof(record));
+    EXPECT_EQ(FastMixerCycleStatsRecord::kMagic, record.mMagic);
+    EXPECT_EQ(FastMixerCycleStatsRecord::kVersion, record.mVersion);
+    EXPECT_EQ(sizeof(record), record.mSize);
+    EXPECT_EQ(13, record.mIoHandle);
+    EXPECT_EQ(48000u, record.mSampleRate);
+    EXPECT_EQ(96u, record.mFrameCount);
+    EXPECT_EQ(2000000u, record.mBudgetNs);
+    EXPECT_EQ(1u, record.mOverBudgetCycles);
+    EXPECT_EQ(1u << 3, record.mTrackMask);
+    EXPECT_EQ(Histogram::kBuckets, record.mBucketCount);
+    EXPECT_EQ(0, memcmp(&dumpState.mCycleNs, &record.mCycleNs, sizeof(Histogram)));
+    for (int i = 0; i < FAST_MIXER_STAGE_CNT; ++i) {
+        EXPECT_EQ(0, memcmp(&dumpState.mStageNs[i], &record.mStageNs[i], sizeof(Histogram)))
+                << "stage " << i;
+    }
+    for (uint32_t i = 0; i < FastMixerState::kMaxFastTracks; ++i) {
+        EXPECT_EQ(0, memcmp(&dumpState.mTracks[i].mUpdateNs, &record.mTracks[i].mUpdateNs,
+                        sizeof(Histogram))) << "track " << i;
+        EXPECT_EQ(dumpState.mTracks[i].mOverBudgetCycles, record.mTracks[i].mOverBudgetCycles);
+    }
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+#include <fastpath/FastMixerState.h>
+#include <fastpath/StateQueue.h>
+
+using namespace android;
+
+using FastMixerStateQueue = StateQueue<FastMixerState>;
+
+namespace {
+
+// Polls the queue with a period similar to a fast mixer, and checks that each state it
+// observes, and the previous one, are not modified while it may still access them.
+class Observer {
+public:
+    Observer(FastMixerStateQueue& sq, std::chrono::microseconds period)
+        : mSQ(sq), mPeriod(period), mThread([this] { threadLoop(); }) { }
+
+    ~Observer() {
+        mExit = true;
+        mThread.join();
+    }
+
+    int64_t corruptStates() const { return mCorruptStates; }
+
+private:
+    // All the track generations of a state are written with the same value by the mutator.
+    static bool isConsistent(const FastMixerState* state, int gen) {
+        return std::all_of(std::begin(state->mFastTracks), std::end(state->mFastTracks),
+                [gen](const FastTrack& track) { return track.mGeneration == gen; });
+    }
+
+    void threadLoop() {
+        const FastMixerState* previous = nullptr;
+        const FastMixerState* current = nullptr;
+        int previousGen = 0;
+        int currentGen = 0;
+        while (!mExit) {
+            const FastMixerState* next = mSQ.poll();
+            if (next != current) {
+                previous = current;
+                previousGen = currentGen;
+                current = next;
+                currentGen = current->mFastTracksGen;
+            }
+            if ((current != nullptr && !isConsistent(current, currentGen)) ||
+                    (previous != nullptr && !isConsistent(previous, previousGen))) {
+                ++mCorruptStates;
+            }
+            std::this_thread::sleep_for(mPeriod);
+        }
+    }
+
+    FastMixerStateQueue& mSQ;
+    const std::chrono::microseconds mPeriod;
+    std::atomic<bool> mExit = false;
+    std::atomic<int64_t> mCorruptStates = 0;
+    std::thread mThread;
+};
+
+}  // namespace
+
+/*
+ * Pushes bursts of state changes, as done by the normal mixer when tracks are added
+ * and removed, while the observer polls every 2 ms.
+ *
+ * Args: queue depth, number of pushes in a burst.
+ */
+static void BM_StateQueuePushBurst(benchmark::State& state) {
+    const size_t depth = state.range(0);
+    const int burst = state.range(1);
+    FastMixerStateQueue sq(depth);
+    FastMixerState* mutating = sq.begin();
+    *mutating = FastMixerState();
+    sq.end();
+    sq.push(FastMixerStateQueue::BLOCK_UNTIL_ACKED);
+
+    Observer observer(sq, std::chrono::microseconds(2000));
+    int gen = 0;
+    double maxPushUs = 0.;
+    for (auto _ : state) {
+        for (int i = 0; i < burst; ++i) {
+            mutating = sq.begin();
+            ++gen;
+            mutating->mFastTracksGen = gen;
+            for (FastTrack& track : mutating->mFastTracks) {
+                track.mGeneration = gen;
+            }
+            sq.end();
+            const auto start = std::chrono::steady_clock::now();
+            sq.push(FastMixerStateQueue::BLOCK_UNTIL_PUSHED);
+            const std::chrono::duration<double, std::micro> pushUs =
+                    std::chrono::steady_clock::now() - start;
+            maxPushUs = std::max(maxPushUs, pushUs.count());
+        }
+        // let the observer catch up, as between normal mixer cycles
+        state.PauseTiming();
+        sq.push(FastMixerStateQueue::BLOCK_UNTIL_ACKED);
+        state.ResumeTiming();
+    }
+    state.counters["time_per_push"] = benchmark::Counter(burst,
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    state.counters["max_push_us"] = maxPushUs;
+    state.counters["corrupt_states"] = observer.corruptStates();
+}
+
+static void StateQueueArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t depth : {4, 8, 16}) {
+        for (int64_t burst : {1, 2, 4, 8}) {
+            b->Args({depth, burst});
+        }
+    }
+}
+
+BENCHMARK(BM_StateQueuePushBurst)->Apply(StateQueueArgs)->UseRealTime();
+
+BENCHMARK_MAIN();
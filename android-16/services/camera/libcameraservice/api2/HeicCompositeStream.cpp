@@ -50,6 +50,7 @@
 #include "utils/ExifUtils.h"
 #include "utils/SessionConfigurationUtils.h"
 #include "utils/Utils.h"
+#include "utils/YuvTileCopy.h"
 
 using aidl::android::hardware::camera::device::CameraBlob;
 using aidl::android::hardware::camera::device::CameraBlobId;
@@ -297,7 +298,6 @@ status_t HeicCompositeStream::createInternalStreams(const std::vector<SurfaceHol
         }
     }
 
-    initCopyRowFunction(width);
     return res;
 }
 
@@ -2172,116 +2172,12 @@ status_t HeicCompositeStream::copyOneYuvTile(sp<MediaCodecBuffer>& codecBuffer,
             imageInfo->mPlane[MediaImage2::U].mColInc,
             imageInfo->mPlane[MediaImage2::V].mColInc);
 
-    // Y
-    for (auto row = top; row < top+height; row++) {
-        uint8_t *dst = codecBuffer->data() + imageInfo->mPlane[MediaImage2::Y].mOffset +
-                imageInfo->mPlane[MediaImage2::Y].mRowInc * (row - top);
-        mFnCopyRow(yuvBuffer.data+row*yuvBuffer.stride+left, dst, width);
-    }
-
-    // U is Cb, V is Cr
-    bool codecUPlaneFirst = imageInfo->mPlane[MediaImage2::V].mOffset >
-            imageInfo->mPlane[MediaImage2::U].mOffset;
-    uint32_t codecUvOffsetDiff = codecUPlaneFirst ?
-            imageInfo->mPlane[MediaImage2::V].mOffset - imageInfo->mPlane[MediaImage2::U].mOffset :
-            imageInfo->mPlane[MediaImage2::U].mOffset - imageInfo->mPlane[MediaImage2::V].mOffset;
-    bool isCodecUvSemiplannar = (codecUvOffsetDiff == 1) &&
-            (imageInfo->mPlane[MediaImage2::U].mRowInc ==
-            imageInfo->mPlane[MediaImage2::V].mRowInc) &&
-            (imageInfo->mPlane[MediaImage2::U].mColInc == 2) &&
-            (imageInfo->mPlane[MediaImage2::V].mColInc == 2);
-    bool isCodecUvPlannar =
-            ((codecUPlaneFirst && codecUvOffsetDiff >=
-                    imageInfo->mPlane[MediaImage2::U].mRowInc * imageInfo->mHeight/2) ||
-            ((!codecUPlaneFirst && codecUvOffsetDiff >=
-                    imageInfo->mPlane[MediaImage2::V].mRowInc * imageInfo->mHeight/2))) &&
-            imageInfo->mPlane[MediaImage2::U].mColInc == 1 &&
-            imageInfo->mPlane[MediaImage2::V].mColInc == 1;
-    bool cameraUPlaneFirst = yuvBuffer.dataCr > yuvBuffer.dataCb;
-
-    if (isCodecUvSemiplannar && yuvBuffer.chromaStep == 2 &&
-            (codecUPlaneFirst == cameraUPlaneFirst)) {
-        // UV semiplannar
-        // The chrome plane could be either Cb first, or Cr first. Take the
-        // smaller address.
-        uint8_t *src = std::min(yuvBuffer.dataCb, yuvBuffer.dataCr);
-        MediaImage2::PlaneIndex dstPlane = codecUPlaneFirst ? MediaImage2::U : MediaImage2::V;
-        for (auto row = top/2; row < (top+height)/2; row++) {
-            uint8_t *dst = codecBuffer->data() + imageInfo->mPlane[dstPlane].mOffset +
-                    imageInfo->mPlane[dstPlane].mRowInc * (row - top/2);
-            mFnCopyRow(src+row*yuvBuffer.chromaStride+left, dst, width);
-        }
-    } else if (isCodecUvPlannar && yuvBuffer.chromaStep == 1) {
-        // U plane
-        for (auto row = top/2; row < (top+height)/2; row++) {
-            uint8_t *dst = codecBuffer->data() + imageInfo->mPlane[MediaImage2::U].mOffset +
-                    imageInfo->mPlane[MediaImage2::U].mRowInc * (row - top/2);
-            mFnCopyRow(yuvBuffer.dataCb+row*yuvBuffer.chromaStride+left/2, dst, width/2);
-        }
-
-        // V plane
-        for (auto row = top/2; row < (top+height)/2; row++) {
-            uint8_t *dst = codecBuffer->data() + imageInfo->mPlane[MediaImage2::V].mOffset +
-                    imageInfo->mPlane[MediaImage2::V].mRowInc * (row - top/2);
-            mFnCopyRow(yuvBuffer.dataCr+row*yuvBuffer.chromaStride+left/2, dst, width/2);
-        }
-    } else {
-        // Convert between semiplannar and plannar, or when UV orders are
-        // different.
-        uint8_t *dst = codecBuffer->data();
-        for (auto row = top/2; row < (top+height)/2; row++) {
-            for (auto col = left/2; col < (left+width)/2; col++) {
-                // U/Cb
-                int32_t dstIndex = imageInfo->mPlane[MediaImage2::U].mOffset +
-                        imageInfo->mPlane[MediaImage2::U].mRowInc * (row - top/2) +
-                        imageInfo->mPlane[MediaImage2::U].mColInc * (col - left/2);
-                int32_t srcIndex = row * yuvBuffer.chromaStride + yuvBuffer.chromaStep * col;
-                dst[dstIndex] = yuvBuffer.dataCb[srcIndex];
-
-                // V/Cr
-                dstIndex = imageInfo->mPlane[MediaImage2::V].mOffset +
-                        imageInfo->mPlane[MediaImage2::V].mRowInc * (row - top/2) +
-                        imageInfo->mPlane[MediaImage2::V].mColInc * (col - left/2);
-                srcIndex = row * yuvBuffer.chromaStride + yuvBuffer.chromaStep * col;
-                dst[dstIndex] = yuvBuffer.dataCr[srcIndex];
-            }
-        }
-    }
+    CameraYuvPlanes yuvPlanes = {yuvBuffer.data, yuvBuffer.dataCb, yuvBuffer.dataCr,
+            yuvBuffer.stride, yuvBuffer.chromaStride, yuvBuffer.chromaStep};
+    copyYuvTile(yuvPlanes, codecBuffer->data(), *imageInfo, top, left, width, height);
     return OK;
 }
 
-void HeicCompositeStream::initCopyRowFunction([[maybe_unused]] int32_t width)
-{
-    using namespace libyuv;
-
-    mFnCopyRow = CopyRow_C;
-#if defined(HAS_COPYROW_SSE2)
-    if (TestCpuFlag(kCpuHasSSE2)) {
-        mFnCopyRow = IS_ALIGNED(width, 32) ? CopyRow_SSE2 : CopyRow_Any_SSE2;
-    }
-#endif
-#if defined(HAS_COPYROW_AVX)
-    if (TestCpuFlag(kCpuHasAVX)) {
-        mFnCopyRow = IS_ALIGNED(width, 64) ? CopyRow_AVX : CopyRow_Any_AVX;
-    }
-#endif
-#if defined(HAS_COPYROW_ERMS)
-    if (TestCpuFlag(kCpuHasERMS)) {
-        mFnCopyRow = CopyRow_ERMS;
-    }
-#endif
-#if defined(HAS_COPYROW_NEON)
-    if (TestCpuFlag(kCpuHasNEON)) {
-        mFnCopyRow = IS_ALIGNED(width, 32) ? CopyRow_NEON : CopyRow_Any_NEON;
-    }
-#endif
-#if defined(HAS_COPYROW_MIPS)
-    if (TestCpuFlag(kCpuHasMIPS)) {
-        mFnCopyRow = CopyRow_MIPS;
-    }
-#endif
-}
-
 size_t HeicCompositeStream::calcAppSegmentMaxSize(const CameraMetadata& info) {
     camera_metadata_ro_entry_t entry = info.find(ANDROID_HEIC_INFO_MAX_JPEG_APP_SEGMENTS_COUNT);
     size_t maxAppsSegment = 1;
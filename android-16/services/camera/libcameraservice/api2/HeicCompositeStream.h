@@ -242,7 +242,6 @@ private:
     status_t copyOneYuvTile(sp<MediaCodecBuffer>& codecBuffer,
             const CpuConsumer::LockedBuffer& yuvBuffer,
             size_t top, size_t left, size_t width, size_t height);
-    void initCopyRowFunction(int32_t width);
     static size_t calcAppSegmentMaxSize(const CameraMetadata& info);
     void updateCodecQualityLocked(int32_t quality);
 
@@ -314,9 +313,6 @@ private:
     // Indexed by frame number. In most common use case, entries are accessed in order.
     std::map<int64_t, InputFrame> mPendingInputFrames;
 
-    // Function pointer of libyuv row copy.
-    void (*mFnCopyRow)(const uint8_t* src, uint8_t* dst, int width);
-
     // A set of APP_SEGMENT error frame numbers
     std::set<int64_t> mExifErrorFrameNumbers;
     void flagAnExifErrorFrameNumber(int64_t frameNumber);
@@ -1025,13 +1025,18 @@ status_t CameraProviderManager::dump(int fd, const Vector<String16>& args) {
 
 void CameraProviderManager::ProviderInfo::initializeProviderInfoCommon(
         const std::vector<std::string> &devices) {
-    for (auto& device : devices) {
-        std::string id;
-        status_t res = addDevice(device, CameraDeviceStatus::PRESENT, &id);
-        if (res != OK) {
-            ALOGE("%s: Unable to enumerate camera device '%s': %s (%d)",
-                    __FUNCTION__, device.c_str(), strerror(-res), res);
-            continue;
+    ATRACE_CALL();
+    if (flags::parallel_provider_device_init()) {
+        initializeDevicesConcurrently(devices);
+    } else {
+        for (auto& device : devices) {
+            std::string id;
+            status_t res = addDevice(device, CameraDeviceStatus::PRESENT, &id);
+            if (res != OK) {
+                ALOGE("%s: Unable to enumerate camera device '%s': %s (%d)",
+                        __FUNCTION__, device.c_str(), strerror(-res), res);
+                continue;
+            }
         }
     }
 
@@ -1057,6 +1062,43 @@ void CameraProviderManager::ProviderInfo::initializeProviderInfoCommon(
     }
 }
 
+void CameraProviderManager::ProviderInfo::initializeDevicesConcurrently(
+        const std::vector<std::string> &devices) {
+    // Initializing the info of a device takes several HAL calls and the derivation of the
+    // framework tags from its characteristics. Devices don't depend on each other, so initialize
+    // them in parallel, and add them in order.
+    std::vector<std::future<std::unique_ptr<DeviceInfo>>> deviceInfos(devices.size());
+    for (size_t i = 0; i < devices.size(); i++) {
+        const std::string& device = devices[i];
+        ALOGI("Enumerating new camera device: %s", device.c_str());
+
+        std::string id;
+        uint16_t minor;
+        status_t res = checkNewDevice(device, &id, &minor);
+        if (res != OK) {
+            ALOGE("%s: Unable to enumerate camera device '%s': %s (%d)",
+                    __FUNCTION__, device.c_str(), strerror(-res), res);
+            continue;
+        }
+        deviceInfos[i] = std::async(std::launch::async, [this, device, id, minor]() {
+            return initializeDeviceInfo(device, mProviderTagid, id, minor);
+        });
+    }
+
+    for (size_t i = 0; i < devices.size(); i++) {
+        if (!deviceInfos[i].valid()) {
+            continue;
+        }
+        status_t res = addDeviceInfo(deviceInfos[i].get(), CameraDeviceStatus::PRESENT,
+                /*parsedId*/ nullptr);
+        if (res != OK) {
+            ALOGE("%s: Unable to enumerate camera device '%s': %s (%d)",
+                    __FUNCTION__, devices[i].c_str(), strerror(-res), res);
+            continue;
+        }
+    }
+}
+
 CameraProviderManager::ProviderInfo::DeviceInfo* CameraProviderManager::findDeviceInfoLocked(
         const std::string& id) const {
     for (auto& provider : mProviders) {
@@ -2675,6 +2717,19 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
 
     ALOGI("Enumerating new camera device: %s", name.c_str());
 
+    std::string id;
+    uint16_t minor;
+    status_t res = checkNewDevice(name, &id, &minor);
+    if (res != OK) {
+        return res;
+    }
+
+    return addDeviceInfo(initializeDeviceInfo(name, mProviderTagid, id, minor), initialStatus,
+            parsedId);
+}
+
+status_t CameraProviderManager::ProviderInfo::checkNewDevice(const std::string& name,
+        /*out*/ std::string* parsedId, /*out*/ uint16_t* minorVersion) {
     uint16_t major, minor;
     std::string type, id;
     IPCTransport transport = getIPCTransport();
@@ -2695,7 +2750,6 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
         return BAD_VALUE;
     }
 
-    std::unique_ptr<DeviceInfo> deviceInfo;
     switch (transport) {
         case IPCTransport::HIDL:
             switch (major) {
@@ -2719,8 +2773,23 @@ status_t CameraProviderManager::ProviderInfo::addDevice(
             return BAD_VALUE;
     }
 
-    deviceInfo = initializeDeviceInfo(name, mProviderTagid, id, minor);
+    *parsedId = id;
+    *minorVersion = minor;
+    return OK;
+}
+
+status_t CameraProviderManager::ProviderInfo::addDeviceInfo(
+        std::unique_ptr<DeviceInfo> deviceInfo, CameraDeviceStatus initialStatus,
+        /*out*/ std::string* parsedId) {
     if (deviceInfo == nullptr) return BAD_VALUE;
+    // Not a reference, deviceInfo is moved from below
+    const std::string id = deviceInfo->mId;
+    // Devices initialized concurrently were checked before any was added
+    if (mManager->isValidDeviceLocked(id, deviceInfo->mVersion.get_major(), getIPCTransport())) {
+        ALOGE("%s: Device %s: ID %s is already in use for device major version %d", __FUNCTION__,
+                deviceInfo->mName.c_str(), id.c_str(), deviceInfo->mVersion.get_major());
+        return BAD_VALUE;
+    }
     deviceInfo->notifyDeviceStateChange(getDeviceState());
     deviceInfo->mStatus = initialStatus;
     bool isAPI1Compatible = deviceInfo->isAPI1Compatible();
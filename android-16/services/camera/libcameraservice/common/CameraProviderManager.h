@@ -565,6 +565,8 @@ private:
         status_t dump(int fd, const Vector<String16>& args) const;
 
         void initializeProviderInfoCommon(const std::vector<std::string> &devices);
+        // Initializes the infos of the devices in parallel, then adds them in order.
+        void initializeDevicesConcurrently(const std::vector<std::string> &devices);
         /**
          * Setup vendor tags for this provider
          */
@@ -873,6 +875,14 @@ private:
                 const std::string& name, CameraDeviceStatus initialStatus,
                 /*out*/ std::string* parsedId);
 
+        // Check that a new device can be added, before initializing its info
+        status_t checkNewDevice(const std::string& name,
+                /*out*/ std::string* parsedId, /*out*/ uint16_t* minorVersion);
+
+        // Add the initialized info of a new device
+        status_t addDeviceInfo(std::unique_ptr<DeviceInfo> deviceInfo,
+                CameraDeviceStatus initialStatus, /*out*/ std::string* parsedId);
+
         void cameraDeviceStatusChangeInternal(const std::string& cameraDeviceName,
                 CameraDeviceStatus newStatus);
 
@@ -55,6 +55,7 @@
 #include <camera/StringUtils.h>
 
 #include <android-base/properties.h>
+#include <android-base/file.h>
 #include <android/hardware/camera/device/3.7/ICameraInjectionSession.h>
 #include <android/hardware/camera2/ICameraDeviceUser.h>
 #include <com_android_internal_camera_flags.h>
@@ -69,6 +70,7 @@
 #include "device3/Camera3InputStream.h"
 #include "device3/Camera3OutputStream.h"
 #include "device3/Camera3SharedOutputStream.h"
+#include "utils/CameraMetadataCompare.h"
 #include "utils/CameraTraces.h"
 #include "utils/SchedulingPolicyUtils.h"
 #include "utils/SessionConfigurationUtils.h"
@@ -550,6 +552,7 @@ status_t Camera3Device::dump(int fd, [[maybe_unused]] const Vector<String16> &ar
             mId.c_str(), __FUNCTION__);
 
     bool dumpTemplates = false;
+    bool dumpMonitoredBinary = false;
 
     String16 templatesOption("-t");
     int n = args.size();
@@ -557,6 +560,9 @@ status_t Camera3Device::dump(int fd, [[maybe_unused]] const Vector<String16> &ar
         if (args[i] == templatesOption) {
             dumpTemplates = true;
         }
+        if (args[i] == toString16(TagMonitor::kMonitorBinaryDumpOption)) {
+            dumpMonitoredBinary = true;
+        }
         if (args[i] == toString16(TagMonitor::kMonitorOption)) {
             if (i + 1 < n) {
                 std::string monitorTags = toStdString(args[i + 1]);
@@ -693,7 +699,20 @@ status_t Camera3Device::dump(int fd, [[maybe_unused]] const Vector<String16> &ar
         }
     }
 
-    mTagMonitor.dumpMonitoredMetadata(fd);
+    if (dumpMonitoredBinary) {
+        // See TagMonitor::kMonitorBinaryDumpOption to extract the log
+        std::vector<uint8_t> log = mTagMonitor.getMonitoredMetadataBinary();
+        lines = fmt::sprintf("     Monitored tag event log (binary, %zu bytes):\n", log.size());
+        write(fd, lines.c_str(), lines.size());
+        // The size above must match what is written
+        if (!base::WriteFully(fd, log.data(), log.size())) {
+            ALOGE("%s: Unable to write the monitored tag event log: %s", __FUNCTION__,
+                    strerror(errno));
+        }
+        write(fd, "\n", 1);
+    } else {
+        mTagMonitor.dumpMonitoredMetadata(fd);
+    }
 
     if (mInterface->valid()) {
         lines = "     HAL device dump:\n";
@@ -3595,27 +3614,31 @@ void Camera3Device::RequestThread::updateNextRequest(NextRequest& nextRequest) {
     // Update the latest request sent to HAL
     camera_capture_request_t& halRequest = nextRequest.halRequest;
     sp<Camera3Device> parent = mParent.promote();
-    if (halRequest.settings != nullptr) { // Don't update if they were unchanged
+    {
         Mutex::Autolock al(mLatestRequestMutex);
 
-        // Fill in latest request and physical request
-        camera_metadata_t *cloned = clone_camera_metadata(halRequest.settings);
-        mLatestRequestInfo.requestSettings.acquire(cloned);
-
-        mLatestRequestInfo.physicalRequestSettings.clear();
-        mLatestRequestInfo.outputStreamIds.clear();
-        for (uint32_t i = 0; i < halRequest.num_physcam_settings; i++) {
-            cloned = clone_camera_metadata(halRequest.physcam_settings[i]);
-            mLatestRequestInfo.physicalRequestSettings.emplace(halRequest.physcam_id[i],
-                                           CameraMetadata(cloned));
+        // Fill in latest request and physical request, unless the settings were unchanged
+        // and the HAL reuses the latest ones
+        if (halRequest.settings != nullptr) {
+            camera_metadata_t *cloned = clone_camera_metadata(halRequest.settings);
+            mLatestRequestInfo.requestSettings.acquire(cloned);
+
+            mLatestRequestInfo.physicalRequestSettings.clear();
+            for (uint32_t i = 0; i < halRequest.num_physcam_settings; i++) {
+                cloned = clone_camera_metadata(halRequest.physcam_settings[i]);
+                mLatestRequestInfo.physicalRequestSettings.emplace(halRequest.physcam_id[i],
+                                               CameraMetadata(cloned));
+            }
         }
 
+        // The streams may change while the settings are reused
+        mLatestRequestInfo.outputStreamIds.clear();
         if (parent != nullptr) {
             int32_t inputStreamId = -1;
             if (halRequest.input_buffer != nullptr) {
               inputStreamId = Camera3Stream::cast(halRequest.input_buffer->stream)->getId();
-              mLatestRequestInfo.inputStreamId = inputStreamId;
             }
+            mLatestRequestInfo.inputStreamId = inputStreamId;
 
            for (size_t i = 0; i < halRequest.num_output_buffers; i++) {
                int32_t outputStreamId =
@@ -3642,6 +3665,40 @@ void Camera3Device::RequestThread::updateNextRequest(NextRequest& nextRequest) {
     cleanupPhysicalSettings(nextRequest.captureRequest, &halRequest);
 }
 
+bool Camera3Device::RequestThread::hasLatestRequestSettings(
+        const sp<CaptureRequest>& captureRequest) {
+    ATRACE_CALL();
+    Mutex::Autolock al(mLatestRequestMutex);
+
+    if (captureRequest->mSettingsList.size() !=
+            mLatestRequestInfo.physicalRequestSettings.size() + 1) {
+        return false;
+    }
+
+    auto isSame = [](CameraMetadata& settings, const CameraMetadata& latestSettings) {
+        settings.sort();
+        const camera_metadata_t* buffer = settings.getAndLock();
+        const camera_metadata_t* latestBuffer = latestSettings.getAndLock();
+        bool same = isSameCameraMetadata(buffer, latestBuffer);
+        latestSettings.unlock(latestBuffer);
+        settings.unlock(buffer);
+        return same;
+    };
+
+    auto it = captureRequest->mSettingsList.begin();
+    if (!isSame(it->metadata, mLatestRequestInfo.requestSettings)) {
+        return false;
+    }
+    for (it++; it != captureRequest->mSettingsList.end(); it++) {
+        auto latest = mLatestRequestInfo.physicalRequestSettings.find(it->cameraId);
+        if (latest == mLatestRequestInfo.physicalRequestSettings.end() ||
+                !isSame(it->metadata, latest->second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool Camera3Device::RequestThread::updateSessionParameters(const CameraMetadata& settings) {
     ATRACE_CALL();
     bool updatesDetected = false;
@@ -3891,21 +3948,23 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
 
         bool settingsOverrideChanged = overrideSettingsOverride(captureRequest);
 
-        // If the request is the same as last, or we had triggers now or last time or
-        // changing overrides this time
+        // Settings changed by the service, which must be sent even if the request is the
+        // same as last: we had triggers now or last time or changing overrides this time
+        bool settingsChanged = triggersMixedIn ||
+                captureRequest->mRotateAndCropChanged ||
+                captureRequest->mAutoframingChanged ||
+                captureRequest->mTestPatternChanged || settingsOverrideChanged ||
+                (flags::inject_session_params() && mForceNewRequestAfterReconfigure);
+
+        // If the request is not the same as last, or the settings changed
         bool newRequest =
-                (mPrevRequest != captureRequest || triggersMixedIn ||
-                         captureRequest->mRotateAndCropChanged ||
-                         captureRequest->mAutoframingChanged ||
-                         captureRequest->mTestPatternChanged || settingsOverrideChanged ||
-                         (flags::inject_session_params() && mForceNewRequestAfterReconfigure)) &&
+                (mPrevRequest != captureRequest || settingsChanged) &&
                 // Request settings are all the same within one batch, so only treat the first
                 // request in a batch as new
                 !(batchedRequest && i > 0);
 
+        std::set<std::string> cameraIdsWithZoom;
         if (newRequest) {
-            std::set<std::string> cameraIdsWithZoom;
-
             if (flags::inject_session_params() && mForceNewRequestAfterReconfigure) {
                 // This only needs to happen once.
                 mForceNewRequestAfterReconfigure = false;
@@ -4038,6 +4097,20 @@ status_t Camera3Device::RequestThread::prepareHalRequests() {
                 }
             }
 
+            // A different request may still have the settings sent last, for example when a
+            // repeating burst only alternates outputs, or when the client sets a new repeating
+            // request with the same settings. The HAL can reuse them then, saving the copy of
+            // the whole settings to the HAL and to the latest request info for every frame.
+            // Can't reuse across configure calls, where mPrevRequest is cleared.
+            if (mPrevRequest != nullptr && !settingsChanged &&
+                    hasLatestRequestSettings(captureRequest)) {
+                newRequest = false;
+                mPrevRequest = captureRequest;
+                mPrevCameraIdsWithZoom = cameraIdsWithZoom;
+            }
+        }
+
+        if (newRequest) {
             /**
              * The request should be presorted so accesses in HAL
              *   are O(logn). Sidenote, sorting a sorted metadata is nop.
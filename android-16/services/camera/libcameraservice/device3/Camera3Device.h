@@ -1245,6 +1245,10 @@ class Camera3Device :
         // Update next request sent to HAL
         void updateNextRequest(NextRequest& nextRequest);
 
+        // Check whether the settings of a request, sorted and ready to be sent, are the same as
+        // the latest settings sent to HAL, so that the HAL can be told to reuse them.
+        bool hasLatestRequestSettings(const sp<CaptureRequest>& captureRequest);
+
         wp<Camera3Device>  mParent;
         wp<camera3::StatusTracker>  mStatusTracker;
         sp<HalInterface>   mInterface;
@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include "device3/DistortionMapper.h"
 #include "utils/SessionConfigurationUtilsHost.h"
@@ -278,7 +279,7 @@ status_t DistortionMapper::mapRawToCorrected(int32_t *coordPairs, int coordCount
     }
 
     for (int i = 0; i < coordCount * 2; i += 2) {
-        const GridQuad *quad = findEnclosingQuad(coordPairs + i, mapperInfo->mDistortedGrid);
+        const GridQuad *quad = findEnclosingQuad(coordPairs + i, *mapperInfo);
         if (quad == nullptr) {
             ALOGE("Raw to corrected mapping failure: No quad found for (%d, %d)",
                     *(coordPairs + i), *(coordPairs + i + 1));
@@ -488,47 +489,130 @@ status_t DistortionMapper::buildGrids(DistortionMapperInfo *mapperInfo) {
         }
     }
 
+    // Index the distorted quads by the buckets their bounds overlap
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    float maxY = std::numeric_limits<float>::lowest();
+    for (const GridQuad& quad : mapperInfo->mDistortedGrid) {
+        for (size_t k = 0; k < quad.coords.size(); k += 2) {
+            minX = std::min(minX, quad.coords[k]);
+            maxX = std::max(maxX, quad.coords[k]);
+            minY = std::min(minY, quad.coords[k + 1]);
+            maxY = std::max(maxY, quad.coords[k + 1]);
+        }
+    }
+    mapperInfo->mBucketOriginX = minX;
+    mapperInfo->mBucketOriginY = minY;
+    mapperInfo->mInvBucketWidth = maxX > minX ? kBucketCount / (maxX - minX) : 0.f;
+    mapperInfo->mInvBucketHeight = maxY > minY ? kBucketCount / (maxY - minY) : 0.f;
+
+    // Buckets covered by each quad, as [first x, last x, first y, last y]
+    std::vector<std::array<size_t, 4>> quadBuckets(mapperInfo->mDistortedGrid.size());
+    std::vector<uint32_t> &starts = mapperInfo->mBucketStarts;
+    starts.assign(kBucketCount * kBucketCount + 1, 0);
+    for (size_t q = 0; q < quadBuckets.size(); q++) {
+        const std::array<float, 8> &coords = mapperInfo->mDistortedGrid[q].coords;
+        float quadMinX = std::min({coords[0], coords[2], coords[4], coords[6]});
+        float quadMaxX = std::max({coords[0], coords[2], coords[4], coords[6]});
+        float quadMinY = std::min({coords[1], coords[3], coords[5], coords[7]});
+        float quadMaxY = std::max({coords[1], coords[3], coords[5], coords[7]});
+        quadBuckets[q] = {
+            bucketIndex(quadMinX, mapperInfo->mBucketOriginX, mapperInfo->mInvBucketWidth),
+            bucketIndex(quadMaxX, mapperInfo->mBucketOriginX, mapperInfo->mInvBucketWidth),
+            bucketIndex(quadMinY, mapperInfo->mBucketOriginY, mapperInfo->mInvBucketHeight),
+            bucketIndex(quadMaxY, mapperInfo->mBucketOriginY, mapperInfo->mInvBucketHeight)
+        };
+        for (size_t by = quadBuckets[q][2]; by <= quadBuckets[q][3]; by++) {
+            for (size_t bx = quadBuckets[q][0]; bx <= quadBuckets[q][1]; bx++) {
+                starts[by * kBucketCount + bx + 1]++;
+            }
+        }
+    }
+    for (size_t b = 1; b < starts.size(); b++) {
+        starts[b] += starts[b - 1];
+    }
+    mapperInfo->mBucketQuads.resize(starts.back());
+    std::vector<uint32_t> next(starts.begin(), starts.end() - 1);
+    for (size_t q = 0; q < quadBuckets.size(); q++) {
+        for (size_t by = quadBuckets[q][2]; by <= quadBuckets[q][3]; by++) {
+            for (size_t bx = quadBuckets[q][0]; bx <= quadBuckets[q][1]; bx++) {
+                mapperInfo->mBucketQuads[next[by * kBucketCount + bx]++] = q;
+            }
+        }
+    }
+
     mapperInfo->mValidGrids = true;
     return OK;
 }
 
+size_t DistortionMapper::bucketIndex(float coord, float origin, float invBucketSize) {
+    // Monotonic in coord, so that a point within the bounds of a quad is within the buckets
+    // of the quad. Points outside of the grid fall into the border buckets.
+    float bucket = (coord - origin) * invBucketSize;
+    if (!(bucket > 0)) return 0;
+    return std::min(kBucketCount - 1, static_cast<size_t>(bucket));
+}
+
+bool DistortionMapper::isInQuad(float x, float y, const GridQuad& quad) {
+    const float &x1 = quad.coords[0];
+    const float &y1 = quad.coords[1];
+    const float &x2 = quad.coords[2];
+    const float &y2 = quad.coords[3];
+    const float &x3 = quad.coords[4];
+    const float &y3 = quad.coords[5];
+    const float &x4 = quad.coords[6];
+    const float &y4 = quad.coords[7];
+
+    // Point-in-quad test:
+
+    // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
+    // edges (or on top of one of the edges or corners), traversed in a consistent direction.
+    // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
+    // have the same sign (or be zero) for all edges.
+    // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
+    // En is to the left of Ep, or overlapping.
+    float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
+    if (s1 > 0) return false;
+    float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
+    if (s2 > 0) return false;
+    float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
+    if (s3 > 0) return false;
+    float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
+    if (s4 > 0) return false;
+
+    return true;
+}
+
 const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
         const int32_t pt[2], const std::vector<GridQuad>& grid) {
     const float x = pt[0];
     const float y = pt[1];
 
     for (const GridQuad& quad : grid) {
-        const float &x1 = quad.coords[0];
-        const float &y1 = quad.coords[1];
-        const float &x2 = quad.coords[2];
-        const float &y2 = quad.coords[3];
-        const float &x3 = quad.coords[4];
-        const float &y3 = quad.coords[5];
-        const float &x4 = quad.coords[6];
-        const float &y4 = quad.coords[7];
-
-        // Point-in-quad test:
-
-        // Quad has corners P1-P4; if P is within the quad, then it is on the same side of all the
-        // edges (or on top of one of the edges or corners), traversed in a consistent direction.
-        // This means that the cross product of edge En = Pn->P(n+1 mod 4) and line Ep = Pn->P must
-        // have the same sign (or be zero) for all edges.
-        // For clockwise traversal, the sign should be negative or zero for Ep x En, indicating that
-        // En is to the left of Ep, or overlapping.
-        float s1 = (x - x1) * (y2 - y1) - (y - y1) * (x2 - x1);
-        if (s1 > 0) continue;
-        float s2 = (x - x2) * (y3 - y2) - (y - y2) * (x3 - x2);
-        if (s2 > 0) continue;
-        float s3 = (x - x3) * (y4 - y3) - (y - y3) * (x4 - x3);
-        if (s3 > 0) continue;
-        float s4 = (x - x4) * (y1 - y4) - (y - y4) * (x1 - x4);
-        if (s4 > 0) continue;
-
-        return &quad;
+        if (isInQuad(x, y, quad)) return &quad;
     }
     return nullptr;
 }
 
+const DistortionMapper::GridQuad* DistortionMapper::findEnclosingQuad(
+        const int32_t pt[2], const DistortionMapperInfo& mapperInfo) {
+    const float x = pt[0];
+    const float y = pt[1];
+
+    size_t bucket =
+            bucketIndex(y, mapperInfo.mBucketOriginY, mapperInfo.mInvBucketHeight) * kBucketCount +
+            bucketIndex(x, mapperInfo.mBucketOriginX, mapperInfo.mInvBucketWidth);
+    for (uint32_t n = mapperInfo.mBucketStarts[bucket];
+            n < mapperInfo.mBucketStarts[bucket + 1]; n++) {
+        const GridQuad& quad = mapperInfo.mDistortedGrid[mapperInfo.mBucketQuads[n]];
+        if (isInQuad(x, y, quad)) return &quad;
+    }
+
+    // Quads folded over by a very large distortion may enclose points out of their bounds
+    return findEnclosingQuad(pt, mapperInfo.mDistortedGrid);
+}
+
 float DistortionMapper::calculateUorV(const int32_t pt[2], const GridQuad& quad, bool calculateU) {
     const float x = pt[0];
     const float y = pt[1];
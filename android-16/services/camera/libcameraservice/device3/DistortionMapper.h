@@ -155,12 +155,25 @@ class DistortionMapper : public CoordinateMapper {
 
         std::vector<GridQuad> mCorrectedGrid;
         std::vector<GridQuad> mDistortedGrid;
+
+        // Uniform grid of buckets over the bounds of the distorted grid. The quads whose bounds
+        // overlap bucket b are mDistortedGrid[mBucketQuads[n]], for n from mBucketStarts[b] to
+        // mBucketStarts[b + 1], in grid order.
+        float mBucketOriginX, mBucketOriginY;
+        float mInvBucketWidth, mInvBucketHeight;
+        std::vector<uint32_t> mBucketStarts;
+        std::vector<uint32_t> mBucketQuads;
     };
 
     // Find which grid quad encloses the point; returns null if none do
     static const GridQuad* findEnclosingQuad(
             const int32_t pt[2], const std::vector<GridQuad>& grid);
 
+    // Find which quad of the distorted grid encloses the point, only testing the quads of the
+    // bucket of the point; returns null if none do
+    static const GridQuad* findEnclosingQuad(
+            const int32_t pt[2], const DistortionMapperInfo& mapperInfo);
+
     // Calculate 'horizontal' interpolation coordinate for the point and the quad
     // Assumes the point P is within the quad Q.
     // Given quad with points P1-P4, and edges E12-E41, and considering the edge segments as
@@ -184,6 +197,8 @@ class DistortionMapper : public CoordinateMapper {
 
     // Number of quads in each dimension of the mapping grids
     constexpr static size_t kGridSize = 15;
+    // Number of buckets in each dimension of the distorted grid index
+    constexpr static size_t kBucketCount = 32;
     // Margin to expand the grid by to ensure it doesn't clip the domain
     constexpr static float kGridMargin = 0.05f;
     // Fuzziness for float inequality tests
@@ -209,6 +224,12 @@ class DistortionMapper : public CoordinateMapper {
     // Utility to create reverse mapping grids
     status_t buildGrids(DistortionMapperInfo *mapperInfo);
 
+    // Index of the bucket of a coordinate, in one dimension
+    static size_t bucketIndex(float coord, float origin, float invBucketSize);
+
+    // Whether the point is within the quad, or on one of its edges
+    static bool isInQuad(float x, float y, const GridQuad& quad);
+
     DistortionMapperInfo mDistortionMapperInfo;
     DistortionMapperInfo mDistortionMapperInfoMaximumResolution;
 
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "CameraMetadataCompareTest"
+
+#include <gtest/gtest.h>
+
+#include <camera/CameraMetadata.h>
+
+#include "../utils/CameraMetadataCompare.h"
+
+using namespace android;
+
+static CameraMetadata makeSettings(int32_t aeRegionLeft) {
+    CameraMetadata settings;
+    uint8_t aeMode = ANDROID_CONTROL_AE_MODE_ON;
+    int32_t aeRegions[] = {aeRegionLeft, 0, 100, 100, 1};
+    int32_t fpsRange[] = {30, 30};
+    settings.update(ANDROID_CONTROL_AE_MODE, &aeMode, 1);
+    settings.update(ANDROID_CONTROL_AE_REGIONS, aeRegions, 5);
+    settings.update(ANDROID_CONTROL_AE_TARGET_FPS_RANGE, fpsRange, 2);
+    settings.sort();
+    return settings;
+}
+
+TEST(CameraMetadataCompareTest, SameSettings) {
+    CameraMetadata a = makeSettings(0);
+    CameraMetadata b = makeSettings(0);
+
+    const camera_metadata_t *bufferA = a.getAndLock();
+    const camera_metadata_t *bufferB = b.getAndLock();
+    EXPECT_TRUE(isSameCameraMetadata(bufferA, bufferB));
+    b.unlock(bufferB);
+
+    // A buffer with more room for entries holds the same settings
+    CameraMetadata c(10, 100);
+    c.append(b);
+    c.sort();
+    const camera_metadata_t *bufferC = c.getAndLock();
+    EXPECT_TRUE(isSameCameraMetadata(bufferA, bufferC));
+    c.unlock(bufferC);
+    a.unlock(bufferA);
+
+    EXPECT_TRUE(isSameCameraMetadata(nullptr, nullptr));
+}
+
+TEST(CameraMetadataCompareTest, DifferentSettings) {
+    CameraMetadata a = makeSettings(0);
+    const camera_metadata_t *bufferA = a.getAndLock();
+
+    // Different value
+    CameraMetadata b = makeSettings(10);
+    const camera_metadata_t *bufferB = b.getAndLock();
+    EXPECT_FALSE(isSameCameraMetadata(bufferA, bufferB));
+    b.unlock(bufferB);
+
+    // Extra entry
+    b = makeSettings(0);
+    uint8_t trigger = ANDROID_CONTROL_AF_TRIGGER_START;
+    b.update(ANDROID_CONTROL_AF_TRIGGER, &trigger, 1);
+    b.sort();
+    bufferB = b.getAndLock();
+    EXPECT_FALSE(isSameCameraMetadata(bufferA, bufferB));
+    b.unlock(bufferB);
+
+    // Same number of entries, different tag
+    b = makeSettings(0);
+    b.erase(ANDROID_CONTROL_AE_MODE);
+    uint8_t afMode = ANDROID_CONTROL_AF_MODE_AUTO;
+    b.update(ANDROID_CONTROL_AF_MODE, &afMode, 1);
+    b.sort();
+    bufferB = b.getAndLock();
+    EXPECT_FALSE(isSameCameraMetadata(bufferA, bufferB));
+    b.unlock(bufferB);
+
+    EXPECT_FALSE(isSameCameraMetadata(bufferA, nullptr));
+    EXPECT_FALSE(isSameCameraMetadata(nullptr, bufferA));
+    a.unlock(bufferA);
+}
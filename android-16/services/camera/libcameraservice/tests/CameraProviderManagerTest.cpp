@@ -570,6 +570,81 @@ TEST(CameraProviderManagerTest, InitializeTest) {
             "Incorrect instance requested from service manager";
 }
 
+// Checks that a provider listing deviceNames gets the expectedNames devices, in this order,
+// whether they are initialized one by one or in parallel.
+static void checkInitializedDevices(const std::vector<hardware::hidl_string>& deviceNames,
+        const std::vector<std::string>& expectedNames) {
+    hardware::hidl_vec<common::V1_0::VendorTagSection> vendorSection;
+    status_t res;
+    sp<CameraProviderManager> providerManager = new CameraProviderManager();
+    sp<TestStatusListener> statusListener = new TestStatusListener();
+    TestHidlInteractionProxy serviceProxy;
+    sp<TestICameraProvider> provider =  new TestICameraProvider(deviceNames,
+            vendorSection);
+    serviceProxy.setProvider(provider);
+
+    res = providerManager->initialize(statusListener, &serviceProxy);
+    ASSERT_EQ(res, OK) << "Unable to initialize provider manager";
+
+    // The provider dump lists its devices in the order they were added.
+    FILE* dumpFile = tmpfile();
+    ASSERT_NE(dumpFile, nullptr);
+    providerManager->dump(fileno(dumpFile), Vector<String16>());
+    rewind(dumpFile);
+
+    std::vector<std::string> dumpedNames;
+    const std::string devicePrefix = "== Camera HAL device ";
+    const std::string staticInfoSuffix = "static information: ==";
+    char line[1024];
+    while (fgets(line, sizeof(line), dumpFile) != nullptr) {
+        std::string dumpLine(line);
+        if (dumpLine.rfind(devicePrefix, 0) == 0 &&
+                dumpLine.find(staticInfoSuffix) != std::string::npos) {
+            size_t nameEnd = dumpLine.find(' ', devicePrefix.size());
+            dumpedNames.push_back(dumpLine.substr(devicePrefix.size(),
+                    nameEnd - devicePrefix.size()));
+        }
+    }
+    fclose(dumpFile);
+
+    EXPECT_EQ(dumpedNames, expectedNames) << "Devices not added in provider order";
+}
+
+static void checkInitializeKeepsDeviceOrder() {
+    std::vector<hardware::hidl_string> deviceNames;
+    deviceNames.push_back("device@3.2/test/5");
+    deviceNames.push_back("device@3.2/test/2");
+    deviceNames.push_back("device@3.2/test/9");
+    deviceNames.push_back("device@3.2/test/0");
+    deviceNames.push_back("device@3.2/test/7");
+    checkInitializedDevices(deviceNames,
+            std::vector<std::string>(deviceNames.begin(), deviceNames.end()));
+}
+
+static void checkInitializeRejectsDuplicateDevice() {
+    // The second device with the same id and major version is rejected, as when added
+    // after initialization.
+    std::vector<hardware::hidl_string> deviceNames;
+    deviceNames.push_back("device@3.2/test/1");
+    deviceNames.push_back("device@3.2/test/0");
+    deviceNames.push_back("device@3.3/test/1");
+    checkInitializedDevices(deviceNames, {"device@3.2/test/1", "device@3.2/test/0"});
+}
+
+TEST_WITH_FLAGS(CameraProviderManagerTest, InitializeKeepsDeviceOrderTest,
+        REQUIRES_FLAGS_DISABLED(ACONFIG_FLAG(com::android::internal::camera::flags,
+                parallel_provider_device_init))) {
+    checkInitializeKeepsDeviceOrder();
+    checkInitializeRejectsDuplicateDevice();
+}
+
+TEST_WITH_FLAGS(CameraProviderManagerTest, InitializeInParallelKeepsDeviceOrderTest,
+        REQUIRES_FLAGS_ENABLED(ACONFIG_FLAG(com::android::internal::camera::flags,
+                parallel_provider_device_init))) {
+    checkInitializeKeepsDeviceOrder();
+    checkInitializeRejectsDuplicateDevice();
+}
+
 TEST(CameraProviderManagerTest, MultipleVendorTagTest) {
     hardware::hidl_string sectionName = "VendorTestSection";
     hardware::hidl_string tagName = "VendorTestTag";
@@ -348,6 +348,57 @@ TEST(DistortionMapperTest, LargeTransform) {
     RandomTransformTest(this, testActiveArray, m, /*clamp*/false, /*simple*/false);
 }
 
+// Check that the bucket index of the distorted grid finds the same enclosing quads as a search of
+// the whole grid, including for points on quad edges and out of the grid
+TEST(DistortionMapperTest, EnclosingQuadIndex) {
+    float bigDistortion[] = {0.1, -0.003, 0.004, 0.02, 0.01};
+
+    DistortionMapper m;
+    setupTestMapper(&m, bigDistortion, testICal,
+            /*activeArray*/testActiveArray,
+            /*preCorrectionActiveArray*/testPreCorrActiveArray);
+
+    // Build the grids
+    DistortionMapperInfo *mapperInfo = m.getMapperInfo();
+    int32_t center[2] = {testActiveArray[2] / 2, testActiveArray[3] / 2};
+    ASSERT_EQ(m.mapRawToCorrected(center, 1, mapperInfo, /*clamp*/false, /*simple*/false), OK);
+
+    std::vector<int32_t> coords;
+    for (int32_t y = -100; y < testPreCorrActiveArray[3] + 100; y++) {
+        for (int32_t x = -100; x < testPreCorrActiveArray[2] + 100; x++) {
+            coords.push_back(x);
+            coords.push_back(y);
+        }
+    }
+
+    std::vector<const DistortionMapper::GridQuad*> indexedQuads(coords.size() / 2);
+    base::Timer indexedTimer;
+    for (size_t i = 0; i < coords.size(); i += 2) {
+        indexedQuads[i / 2] = DistortionMapper::findEnclosingQuad(&coords[i], *mapperInfo);
+    }
+    auto indexedDuration = indexedTimer.duration();
+
+    std::vector<const DistortionMapper::GridQuad*> searchedQuads(coords.size() / 2);
+    base::Timer searchedTimer;
+    for (size_t i = 0; i < coords.size(); i += 2) {
+        searchedQuads[i / 2] = DistortionMapper::findEnclosingQuad(&coords[i],
+                mapperInfo->mDistortedGrid);
+    }
+    auto searchedDuration = searchedTimer.duration();
+
+    for (size_t i = 0; i < indexedQuads.size(); i++) {
+        ASSERT_EQ(indexedQuads[i], searchedQuads[i])
+                << "(" << coords[i * 2] << ", " << coords[i * 2 + 1] << ")";
+    }
+
+    auto perCoordUs = [&coords](auto duration) {
+        return (std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(
+                duration) / (coords.size() / 2)).count();
+    };
+    RecordProperty("IndexedDurationPerCoordUs", fmt::sprintf("%f", perCoordUs(indexedDuration)));
+    RecordProperty("SearchedDurationPerCoordUs", fmt::sprintf("%f", perCoordUs(searchedDuration)));
+}
+
 // Compare against values calculated by OpenCV
 // undistortPoints() method, which is the same as mapRawToCorrected
 // Ignore clamping
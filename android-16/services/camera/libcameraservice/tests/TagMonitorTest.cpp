@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "TagMonitorTest"
+
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "../utils/TagMonitor.h"
+
+using namespace android;
+
+static const std::unordered_map<std::string, CameraMetadata> kNoPhysicalMetadata;
+
+// Returns the events of a binary event log, oldest first
+static std::vector<TagMonitor::MonitorEvent> parseBinaryLog(const std::vector<uint8_t> &log,
+        TagMonitor::MonitorLogHeader *header) {
+    std::vector<TagMonitor::MonitorEvent> events;
+    if (log.size() < sizeof(*header)) {
+        ADD_FAILURE() << "Log of " << log.size() << " bytes has no header";
+        return events;
+    }
+    memcpy(header, log.data(), sizeof(*header));
+    if (log.size() != sizeof(*header) + header->numEvents * sizeof(TagMonitor::MonitorEvent)) {
+        ADD_FAILURE() << "Log of " << log.size() << " bytes for " << header->numEvents
+                << " events";
+        return events;
+    }
+    events.resize(header->numEvents);
+    if (!events.empty()) {
+        memcpy(events.data(), log.data() + sizeof(*header),
+                events.size() * sizeof(TagMonitor::MonitorEvent));
+    }
+    return events;
+}
+
+TEST(TagMonitorTest, ValueChanges) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor("android.control.aeMode");
+
+    CameraMetadata metadata;
+    uint8_t aeMode = ANDROID_CONTROL_AE_MODE_ON;
+    metadata.update(ANDROID_CONTROL_AE_MODE, &aeMode, 1);
+    monitor.monitorMetadata(TagMonitor::REQUEST, 1, 100, metadata, kNoPhysicalMetadata);
+    monitor.monitorMetadata(TagMonitor::REQUEST, 2, 200, metadata, kNoPhysicalMetadata);
+
+    aeMode = ANDROID_CONTROL_AE_MODE_OFF;
+    metadata.update(ANDROID_CONTROL_AE_MODE, &aeMode, 1);
+    monitor.monitorMetadata(TagMonitor::RESULT, 2, 200, metadata, kNoPhysicalMetadata);
+    monitor.monitorMetadata(TagMonitor::REQUEST, 3, 300, metadata, kNoPhysicalMetadata);
+
+    metadata.erase(ANDROID_CONTROL_AE_MODE);
+    monitor.monitorMetadata(TagMonitor::REQUEST, 4, 400, metadata, kNoPhysicalMetadata);
+
+    // Most recent first, requests and results tracked separately
+    std::vector<std::string> events;
+    monitor.getLatestMonitoredTagEvents(events);
+    ASSERT_EQ(4u, events.size());
+    EXPECT_EQ(0u, events[0].find("f4:400ns:")) << events[0];
+    EXPECT_NE(std::string::npos, events[0].find("(Removed)")) << events[0];
+    EXPECT_EQ(0u, events[1].find("f3:300ns:")) << events[1];
+    EXPECT_EQ(0u, events[2].find("f2:200ns:")) << events[2];
+    EXPECT_NE(std::string::npos, events[2].find("RES:")) << events[2];
+    EXPECT_EQ(0u, events[3].find("f1:100ns:")) << events[3];
+}
+
+TEST(TagMonitorTest, DisableMonitoring) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor("android.control.aeMode");
+
+    CameraMetadata metadata;
+    uint8_t aeMode = ANDROID_CONTROL_AE_MODE_ON;
+    metadata.update(ANDROID_CONTROL_AE_MODE, &aeMode, 1);
+    monitor.monitorMetadata(TagMonitor::REQUEST, 1, 100, metadata, kNoPhysicalMetadata);
+
+    monitor.disableMonitoring();
+    monitor.monitorMetadata(TagMonitor::REQUEST, 2, 200, metadata, kNoPhysicalMetadata);
+    std::vector<std::string> events;
+    monitor.getLatestMonitoredTagEvents(events);
+    EXPECT_EQ(1u, events.size());
+
+    // The latest-seen values are forgotten while monitoring is disabled
+    monitor.parseTagsToMonitor("android.control.aeMode");
+    monitor.monitorMetadata(TagMonitor::REQUEST, 3, 300, metadata, kNoPhysicalMetadata);
+    events.clear();
+    monitor.getLatestMonitoredTagEvents(events);
+    ASSERT_EQ(2u, events.size());
+    EXPECT_EQ(0u, events[0].find("f3:300ns:")) << events[0];
+}
+
+TEST(TagMonitorTest, LargeValues) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor("android.tonemap.curveRed");
+
+    // Changes past the values kept in the event log are still detected
+    std::vector<float> curve(64, 0.5f);
+    CameraMetadata metadata;
+    metadata.update(ANDROID_TONEMAP_CURVE_RED, curve.data(), curve.size());
+    monitor.monitorMetadata(TagMonitor::RESULT, 1, 100, metadata, kNoPhysicalMetadata);
+    curve.back() = 1.0f;
+    metadata.update(ANDROID_TONEMAP_CURVE_RED, curve.data(), curve.size());
+    monitor.monitorMetadata(TagMonitor::RESULT, 2, 200, metadata, kNoPhysicalMetadata);
+    monitor.monitorMetadata(TagMonitor::RESULT, 3, 300, metadata, kNoPhysicalMetadata);
+
+    std::vector<std::string> events;
+    monitor.getLatestMonitoredTagEvents(events);
+    ASSERT_EQ(2u, events.size());
+    EXPECT_NE(std::string::npos, events[0].find("of 64 values")) << events[0];
+}
+
+TEST(TagMonitorTest, BinaryDump) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor("android.sensor.exposureTime");
+
+    // More changes than the event log keeps
+    CameraMetadata metadata;
+    const size_t numFrames = 300;
+    for (size_t i = 0; i < numFrames; i++) {
+        int64_t exposureTime = i;
+        metadata.update(ANDROID_SENSOR_EXPOSURE_TIME, &exposureTime, 1);
+        monitor.monitorMetadata(TagMonitor::RESULT, i, (i + 1) * 1000, metadata,
+                kNoPhysicalMetadata);
+    }
+
+    TagMonitor::MonitorLogHeader header;
+    std::vector<TagMonitor::MonitorEvent> events =
+            parseBinaryLog(monitor.getMonitoredMetadataBinary(), &header);
+    EXPECT_EQ(TagMonitor::kMonitorLogMagic, header.magic);
+    EXPECT_EQ(TagMonitor::kMonitorLogVersion, header.version);
+    EXPECT_EQ(sizeof(TagMonitor::MonitorEvent), header.eventSize);
+    ASSERT_EQ(100u, events.size());
+
+    // Oldest first
+    for (size_t i = 0; i < events.size(); i++) {
+        const TagMonitor::MonitorEvent &event = events[i];
+        int64_t frameNumber = numFrames - events.size() + i;
+        EXPECT_EQ(frameNumber, event.frameNumber);
+        EXPECT_EQ(TagMonitor::RESULT, event.source);
+        EXPECT_EQ(TagMonitor::VALUE_CHANGED, event.kind);
+        EXPECT_EQ(ANDROID_SENSOR_EXPOSURE_TIME, event.tag);
+        EXPECT_EQ(1u, event.count);
+        int64_t exposureTime;
+        memcpy(&exposureTime, event.data, sizeof(exposureTime));
+        EXPECT_EQ(frameNumber, exposureTime);
+    }
+}
+
+TEST(TagMonitorTest, ConcurrentMonitoringAndDump) {
+    TagMonitor monitor;
+    monitor.parseTagsToMonitor("android.sensor.exposureTime,android.control.aeRegions");
+
+    // Requests and results are monitored by their own threads while dumps copy the
+    // event logs they are writing. Every value of a frame is its frame number, and the
+    // regions fill most of the event data, so a torn copy shows as mixed values.
+    const int64_t numFrames = 100000;
+    const size_t numRegionValues = 15;
+    auto monitorSource = [&monitor, numFrames, numRegionValues](TagMonitor::eventSource source) {
+        CameraMetadata metadata;
+        std::vector<int32_t> regions(numRegionValues);
+        for (int64_t i = 0; i < numFrames; i++) {
+            int64_t exposureTime = i;
+            std::fill(regions.begin(), regions.end(), i);
+            metadata.update(ANDROID_SENSOR_EXPOSURE_TIME, &exposureTime, 1);
+            metadata.update(ANDROID_CONTROL_AE_REGIONS, regions.data(), regions.size());
+            monitor.monitorMetadata(source, i, (i + 1) * 1000, metadata, kNoPhysicalMetadata);
+        }
+    };
+    std::atomic<bool> done = false;
+    size_t numDumps = 0;
+    std::thread dumper([&monitor, &done, &numDumps, numRegionValues]() {
+        while (!done) {
+            TagMonitor::MonitorLogHeader header;
+            std::vector<TagMonitor::MonitorEvent> events =
+                    parseBinaryLog(monitor.getMonitoredMetadataBinary(), &header);
+            ASSERT_LE(events.size(), 100u);
+            int64_t lastFrameNumber[2] = {-1, -1};
+            for (size_t i = 0; i < events.size(); i++) {
+                const TagMonitor::MonitorEvent &event = events[i];
+                ASSERT_LT(event.source, 2u);
+                ASSERT_EQ(TagMonitor::VALUE_CHANGED, event.kind);
+                ASSERT_EQ((event.frameNumber + 1) * 1000, event.timestamp);
+                if (event.tag == ANDROID_SENSOR_EXPOSURE_TIME) {
+                    ASSERT_EQ(1u, event.count);
+                    int64_t exposureTime;
+                    memcpy(&exposureTime, event.data, sizeof(exposureTime));
+                    ASSERT_EQ(event.frameNumber, exposureTime);
+                } else {
+                    ASSERT_EQ(ANDROID_CONTROL_AE_REGIONS, event.tag);
+                    ASSERT_EQ(numRegionValues, event.count);
+                    int32_t regions[numRegionValues];
+                    memcpy(regions, event.data, sizeof(regions));
+                    for (int32_t value : regions) {
+                        ASSERT_EQ(event.frameNumber, value);
+                    }
+                }
+                // Events are in sequence order, and so in frame order for each source
+                if (i > 0) {
+                    ASSERT_LT(events[i - 1].sequence, event.sequence);
+                }
+                ASSERT_LE(lastFrameNumber[event.source], event.frameNumber);
+                lastFrameNumber[event.source] = event.frameNumber;
+            }
+            numDumps++;
+        }
+    });
+    std::thread requests(monitorSource, TagMonitor::REQUEST);
+    std::thread results(monitorSource, TagMonitor::RESULT);
+    requests.join();
+    results.join();
+    done = true;
+    dumper.join();
+    EXPECT_GT(numDumps, 0u);
+
+    // The last events of both sources are all there once the monitoring threads are done
+    TagMonitor::MonitorLogHeader header;
+    std::vector<TagMonitor::MonitorEvent> events =
+            parseBinaryLog(monitor.getMonitoredMetadataBinary(), &header);
+    ASSERT_EQ(100u, events.size());
+    EXPECT_EQ(numFrames - 1, events.back().frameNumber);
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "YuvTileCopyTest"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "../utils/YuvTileCopy.h"
+
+using namespace android;
+
+namespace {
+
+// A grid of tiles over a camera buffer whose size is not a multiple of the tile size.
+constexpr size_t kWidth = 1920 + 64;
+constexpr size_t kHeight = 1080 + 40;
+constexpr size_t kStride = kWidth + 32;
+constexpr size_t kTileSize = 512;
+// codec input rows are padded
+constexpr int32_t kCodecStride = kTileSize + 64;
+
+enum class CameraLayout { NV12, NV21, I420, YV12 };
+enum class CodecLayout { NV12, NV21, I420, YV12 };
+
+class CameraBuffer {
+public:
+    explicit CameraBuffer(CameraLayout layout) : mData(kStride * kHeight * 2) {
+        std::mt19937 random(42);
+        for (uint8_t &value : mData) {
+            value = random();
+        }
+        mPlanes.data = mData.data();
+        mPlanes.stride = kStride;
+        uint8_t *chroma = mData.data() + kStride * kHeight;
+        switch (layout) {
+            case CameraLayout::NV12:
+            case CameraLayout::NV21:
+                mPlanes.chromaStride = kStride;
+                mPlanes.chromaStep = 2;
+                mPlanes.dataCb = chroma + (layout == CameraLayout::NV12 ? 0 : 1);
+                mPlanes.dataCr = chroma + (layout == CameraLayout::NV12 ? 1 : 0);
+                break;
+            case CameraLayout::I420:
+            case CameraLayout::YV12: {
+                mPlanes.chromaStride = kStride / 2;
+                mPlanes.chromaStep = 1;
+                uint8_t *second = chroma + kStride / 2 * kHeight / 2;
+                mPlanes.dataCb = layout == CameraLayout::I420 ? chroma : second;
+                mPlanes.dataCr = layout == CameraLayout::I420 ? second : chroma;
+                break;
+            }
+        }
+    }
+
+    const CameraYuvPlanes &planes() const { return mPlanes; }
+
+private:
+    std::vector<uint8_t> mData;
+    CameraYuvPlanes mPlanes;
+};
+
+MediaImage2 codecImage(CodecLayout layout) {
+    MediaImage2 image = {};
+    image.mType = MediaImage2::MEDIA_IMAGE_TYPE_YUV;
+    image.mNumPlanes = 3;
+    image.mWidth = kTileSize;
+    image.mHeight = kTileSize;
+    image.mBitDepth = 8;
+    image.mBitDepthAllocated = 8;
+    image.mPlane[MediaImage2::Y] = {0, 1, kCodecStride, 1, 1};
+    const uint32_t chroma = kCodecStride * kTileSize;
+    switch (layout) {
+        case CodecLayout::NV12:
+        case CodecLayout::NV21: {
+            const uint32_t u = chroma + (layout == CodecLayout::NV12 ? 0 : 1);
+            const uint32_t v = chroma + (layout == CodecLayout::NV12 ? 1 : 0);
+            image.mPlane[MediaImage2::U] = {u, 2, kCodecStride, 2, 2};
+            image.mPlane[MediaImage2::V] = {v, 2, kCodecStride, 2, 2};
+            break;
+        }
+        case CodecLayout::I420:
+        case CodecLayout::YV12: {
+            const uint32_t second = chroma + kCodecStride / 2 * kTileSize / 2;
+            const uint32_t u = layout == CodecLayout::I420 ? chroma : second;
+            const uint32_t v = layout == CodecLayout::I420 ? second : chroma;
+            image.mPlane[MediaImage2::U] = {u, 1, kCodecStride / 2, 2, 2};
+            image.mPlane[MediaImage2::V] = {v, 1, kCodecStride / 2, 2, 2};
+            break;
+        }
+    }
+    return image;
+}
+
+size_t codecImageSize() {
+    return kCodecStride * kTileSize * 2;
+}
+
+// The copy one sample at a time, which copyYuvTile() must match.
+void copyYuvTilePerSample(const CameraYuvPlanes &src, uint8_t *dst, const MediaImage2 &image,
+        size_t top, size_t left, size_t width, size_t height) {
+    for (size_t row = 0; row < height; row++) {
+        for (size_t col = 0; col < width; col++) {
+            dst[image.mPlane[MediaImage2::Y].mOffset +
+                    image.mPlane[MediaImage2::Y].mRowInc * row + col] =
+                    src.data[(top + row) * src.stride + left + col];
+        }
+    }
+    for (size_t row = top / 2; row < (top + height) / 2; row++) {
+        for (size_t col = left / 2; col < (left + width) / 2; col++) {
+            const size_t srcIndex = row * src.chromaStride + src.chromaStep * col;
+            for (auto plane : {MediaImage2::U, MediaImage2::V}) {
+                dst[image.mPlane[plane].mOffset +
+                        image.mPlane[plane].mRowInc * (row - top / 2) +
+                        image.mPlane[plane].mColInc * (col - left / 2)] =
+                        (plane == MediaImage2::U ? src.dataCb : src.dataCr)[srcIndex];
+            }
+        }
+    }
+}
+
+template <typename Copy>
+void forEachTile(Copy copy) {
+    for (size_t top = 0; top < kHeight; top += kTileSize) {
+        for (size_t left = 0; left < kWidth; left += kTileSize) {
+            copy(top, left, std::min(kTileSize, kWidth - left), std::min(kTileSize, kHeight - top));
+        }
+    }
+}
+
+} // namespace
+
+TEST(YuvTileCopyTest, MatchesPerSampleCopy) {
+    for (auto cameraLayout : {CameraLayout::NV12, CameraLayout::NV21, CameraLayout::I420,
+                CameraLayout::YV12}) {
+        CameraBuffer camera(cameraLayout);
+        for (auto codecLayout : {CodecLayout::NV12, CodecLayout::NV21, CodecLayout::I420,
+                    CodecLayout::YV12}) {
+            const MediaImage2 image = codecImage(codecLayout);
+            std::vector<uint8_t> expected(codecImageSize());
+            std::vector<uint8_t> actual(codecImageSize());
+            forEachTile([&](size_t top, size_t left, size_t width, size_t height) {
+                std::fill(expected.begin(), expected.end(), 0);
+                std::fill(actual.begin(), actual.end(), 0);
+                copyYuvTilePerSample(camera.planes(), expected.data(), image,
+                        top, left, width, height);
+                copyYuvTile(camera.planes(), actual.data(), image, top, left, width, height);
+                EXPECT_EQ(expected, actual) << "camera layout " << (int)cameraLayout
+                        << ", codec layout " << (int)codecLayout
+                        << ", tile at " << top << "," << left;
+            });
+        }
+    }
+}
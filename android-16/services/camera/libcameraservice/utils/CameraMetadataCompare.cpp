@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CameraMetadataCompare.h"
+
+#include <string.h>
+
+namespace android {
+
+bool isSameCameraMetadata(const camera_metadata_t *a, const camera_metadata_t *b) {
+    if (a == b) {
+        return true;
+    }
+    if (a == nullptr || b == nullptr) {
+        return false;
+    }
+
+    size_t entryCount = get_camera_metadata_entry_count(a);
+    if (entryCount != get_camera_metadata_entry_count(b) ||
+            get_camera_metadata_data_count(a) != get_camera_metadata_data_count(b)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < entryCount; i++) {
+        camera_metadata_ro_entry_t entryA, entryB;
+        if (get_camera_metadata_ro_entry(a, i, &entryA) != 0 ||
+                get_camera_metadata_ro_entry(b, i, &entryB) != 0) {
+            return false;
+        }
+        if (entryA.tag != entryB.tag || entryA.type != entryB.type ||
+                entryA.count != entryB.count) {
+            return false;
+        }
+        if (entryA.count > 0 && memcmp(entryA.data.u8, entryB.data.u8,
+                entryA.count * camera_metadata_type_size[entryA.type]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace android
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA_CAMERAMETADATACOMPARE_H
+#define ANDROID_SERVERS_CAMERA_CAMERAMETADATACOMPARE_H
+
+#include <system/camera_metadata.h>
+
+namespace android {
+
+/**
+ * Returns true if both metadata buffers hold the same entries, with the same
+ * values, in the same order. Entries are compared in order and the first
+ * difference ends the comparison, so this is meant for sorted buffers: two
+ * buffers with the same entries in a different order compare different.
+ *
+ * The capacity of the buffers is not compared. A null buffer is only the same
+ * as another null buffer.
+ */
+bool isSameCameraMetadata(const camera_metadata_t *a, const camera_metadata_t *b);
+
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERAMETADATACOMPARE_H
@@ -18,6 +18,7 @@
 #define ATRACE_TAG ATRACE_TAG_CAMERA
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -34,21 +35,40 @@ namespace android {
 
 TagMonitor::TagMonitor():
         mMonitoringEnabled(false),
-        mMonitoringEvents(kMaxMonitorEvents),
+        mConfigGeneration(0),
+        mNextEventSequence(0),
         mVendorTagId(CAMERA_METADATA_INVALID_VENDOR_ID)
 {}
 
 TagMonitor::TagMonitor(const TagMonitor& other):
         mMonitoringEnabled(other.mMonitoringEnabled.load()),
+        mConfigGeneration(other.mConfigGeneration.load()),
         mMonitoredTagList(other.mMonitoredTagList),
-        mLastMonitoredRequestValues(other.mLastMonitoredRequestValues),
-        mLastMonitoredResultValues(other.mLastMonitoredResultValues),
-        mLastMonitoredPhysicalRequestKeys(other.mLastMonitoredPhysicalRequestKeys),
-        mLastMonitoredPhysicalResultKeys(other.mLastMonitoredPhysicalResultKeys),
-        mMonitoringEvents(other.mMonitoringEvents),
-        mVendorTagId(other.mVendorTagId) {}
+        mNextEventSequence(other.mNextEventSequence.load()),
+        mVendorTagId(other.mVendorTagId) {
+    for (size_t i = 0; i < std::size(mSources); i++) {
+        SourceMonitor &monitor = mSources[i];
+        const SourceMonitor &otherMonitor = other.mSources[i];
+        monitor.configGeneration = otherMonitor.configGeneration;
+        monitor.tags = otherMonitor.tags;
+        monitor.lastValues = otherMonitor.lastValues;
+        monitor.physicalCameraIds = otherMonitor.physicalCameraIds;
+        monitor.numPhysicalCameras = otherMonitor.numPhysicalCameras;
+        monitor.lastInputStreamId = otherMonitor.lastInputStreamId;
+        monitor.lastStreamIds = otherMonitor.lastStreamIds;
+        monitor.numLastStreamIds = otherMonitor.numLastStreamIds;
+        monitor.numEvents = otherMonitor.numEvents.load();
+        for (size_t j = 0; j < kMaxMonitorEvents; j++) {
+            monitor.events[j].sequence = otherMonitor.events[j].sequence.load();
+            for (size_t k = 0; k < kEventWords; k++) {
+                monitor.events[j].words[k] = otherMonitor.events[j].words[k].load();
+            }
+        }
+    }
+}
 
 const std::string TagMonitor::kMonitorOption("-m");
+const std::string TagMonitor::kMonitorBinaryDumpOption("-mbin");
 
 const char* TagMonitor::k3aTags =
         "android.control.aeMode, android.control.afMode, android.control.awbMode,"
@@ -104,18 +124,30 @@ void TagMonitor::parseTagsToMonitor(std::string tagNames) {
 
     if (gotTag) {
         // Got at least one new tag
+        mConfigGeneration++;
         mMonitoringEnabled = true;
     }
 }
 
 void TagMonitor::disableMonitoring() {
+    std::lock_guard<std::mutex> lock(mMonitorMutex);
     mMonitoringEnabled = false;
-    mLastMonitoredRequestValues.clear();
-    mLastMonitoredResultValues.clear();
-    mLastMonitoredPhysicalRequestKeys.clear();
-    mLastMonitoredPhysicalResultKeys.clear();
-    mLastStreamIds.clear();
-    mLastInputStreamId = -1;
+    // Forget the latest-seen values once monitoring is enabled again
+    mConfigGeneration++;
+}
+
+void TagMonitor::updateSourceConfig(SourceMonitor &monitor) {
+    if (monitor.configGeneration == mConfigGeneration.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMonitorMutex);
+    monitor.configGeneration = mConfigGeneration.load(std::memory_order_relaxed);
+    monitor.tags = mMonitoredTagList;
+    monitor.lastValues.assign(monitor.tags.size() * (kMaxPhysicalCameras + 1), LastValue());
+    monitor.numPhysicalCameras = 0;
+    monitor.lastInputStreamId = -1;
+    monitor.numLastStreamIds = 0;
 }
 
 void TagMonitor::monitorMetadata(eventSource source, int64_t frameNumber, nsecs_t timestamp,
@@ -125,112 +157,202 @@ void TagMonitor::monitorMetadata(eventSource source, int64_t frameNumber, nsecs_
         int32_t inputStreamId) {
     if (!mMonitoringEnabled) return;
 
-    std::lock_guard<std::mutex> lock(mMonitorMutex);
+    SourceMonitor &monitor = mSources[source];
+    updateSourceConfig(monitor);
 
     if (timestamp == 0) {
         timestamp = systemTime(SYSTEM_TIME_BOOTTIME);
     }
-    std::unordered_set<int32_t> outputStreamIds;
-    for (size_t i = 0; i < numOutputBuffers; i++) {
-        const camera3::camera_stream_buffer_t *src = outputBuffers + i;
-        int32_t streamId = camera3::Camera3Stream::cast(src->stream)->getId();
-        outputStreamIds.emplace(streamId);
-    }
     std::string emptyId;
-    for (auto tag : mMonitoredTagList) {
-        monitorSingleMetadata(source, frameNumber, timestamp, emptyId, tag, metadata,
-                outputStreamIds, inputStreamId);
-
-        for (auto& m : physicalMetadata) {
-            monitorSingleMetadata(source, frameNumber, timestamp, m.first, tag, m.second,
-                    outputStreamIds, inputStreamId);
-        }
-    }
-}
-
-void TagMonitor::monitorSingleMetadata(eventSource source, int64_t frameNumber, nsecs_t timestamp,
-        const std::string& cameraId, uint32_t tag, const CameraMetadata& metadata,
-        const std::unordered_set<int32_t> &outputStreamIds, int32_t inputStreamId) {
-
-    CameraMetadata &lastValues = (source == REQUEST) ?
-            (cameraId.empty() ? mLastMonitoredRequestValues :
-                    mLastMonitoredPhysicalRequestKeys[cameraId]) :
-            (cameraId.empty() ? mLastMonitoredResultValues :
-                    mLastMonitoredPhysicalResultKeys[cameraId]);
-
-    camera_metadata_ro_entry entry = metadata.find(tag);
-    if (lastValues.isEmpty()) {
-        lastValues = CameraMetadata(mMonitoredTagList.size());
-        const camera_metadata_t *metaBuffer =
-                lastValues.getAndLock();
-        set_camera_metadata_vendor_id(
-                const_cast<camera_metadata_t *> (metaBuffer), mVendorTagId);
-        lastValues.unlock(metaBuffer);
-    }
-
-    camera_metadata_entry lastEntry = lastValues.find(tag);
 
     // Monitor when the stream ids change, this helps visually see what
     // monitored metadata values are for capture requests with different
     // stream ids.
     if (source == REQUEST) {
-        if (inputStreamId != mLastInputStreamId) {
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, camera_metadata_ro_entry_t{},
-                                      cameraId, std::unordered_set<int>(), inputStreamId);
-            mLastInputStreamId = inputStreamId;
+        if (inputStreamId != monitor.lastInputStreamId) {
+            MonitorEvent *event = beginEvent(monitor, source, INPUT_STREAM_CHANGED, frameNumber,
+                    timestamp, emptyId);
+            event->inputStreamId = inputStreamId;
+            endEvent(monitor);
+            monitor.lastInputStreamId = inputStreamId;
         }
 
-        if (outputStreamIds != mLastStreamIds) {
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, camera_metadata_ro_entry_t{},
-                                      cameraId, outputStreamIds, -1);
-            mLastStreamIds = outputStreamIds;
+        std::array<int32_t, kMaxEventStreamIds> streamIds;
+        size_t numStreamIds = 0;
+        for (size_t i = 0; i < numOutputBuffers && numStreamIds < kMaxEventStreamIds; i++) {
+            const camera3::camera_stream_buffer_t *src = outputBuffers + i;
+            int32_t streamId = camera3::Camera3Stream::cast(src->stream)->getId();
+            auto streamIdsEnd = streamIds.begin() + numStreamIds;
+            if (std::find(streamIds.begin(), streamIdsEnd, streamId) == streamIdsEnd) {
+                streamIds[numStreamIds++] = streamId;
+            }
+        }
+        std::sort(streamIds.begin(), streamIds.begin() + numStreamIds);
+        if (numStreamIds != monitor.numLastStreamIds ||
+                !std::equal(streamIds.begin(), streamIds.begin() + numStreamIds,
+                        monitor.lastStreamIds.begin())) {
+            MonitorEvent *event = beginEvent(monitor, source, OUTPUT_STREAMS_CHANGED,
+                    frameNumber, timestamp, emptyId);
+            event->count = numStreamIds;
+            memcpy(event->data, streamIds.data(), numStreamIds * sizeof(int32_t));
+            endEvent(monitor);
+            monitor.lastStreamIds = streamIds;
+            monitor.numLastStreamIds = numStreamIds;
         }
     }
-    if (entry.count > 0) {
-        bool isDifferent = false;
-        if (lastEntry.count > 0) {
-            // Have a last value, compare to see if changed
-            if (lastEntry.type == entry.type &&
-                    lastEntry.count == entry.count) {
-                // Same type and count, compare values
-                size_t bytesPerValue = camera_metadata_type_size[lastEntry.type];
-                size_t entryBytes = bytesPerValue * lastEntry.count;
-                int cmp = memcmp(entry.data.u8, lastEntry.data.u8, entryBytes);
-                if (cmp != 0) {
-                    isDifferent = true;
-                }
-            } else {
-                // Count or type has changed
-                isDifferent = true;
+
+    const size_t numTags = monitor.tags.size();
+    monitorSingleMetadata(source, monitor, frameNumber, timestamp, emptyId,
+            monitor.lastValues.data(), metadata);
+
+    for (auto& m : physicalMetadata) {
+        size_t i = 0;
+        while (i < monitor.numPhysicalCameras && monitor.physicalCameraIds[i] != m.first) {
+            i++;
+        }
+        if (i == monitor.numPhysicalCameras) {
+            if (i == kMaxPhysicalCameras) {
+                ALOGV("%s: Too many physical cameras, not monitoring camera %s", __FUNCTION__,
+                        m.first.c_str());
+                continue;
             }
-        } else {
-            // No last entry, so always consider to be different
-            isDifferent = true;
+            monitor.physicalCameraIds[i] = m.first;
+            monitor.numPhysicalCameras++;
         }
+        monitorSingleMetadata(source, monitor, frameNumber, timestamp, m.first,
+                monitor.lastValues.data() + (i + 1) * numTags, m.second);
+    }
+}
+
+// FNV-1a hash of the values of a tag too large to be kept whole
+static uint64_t hashEventData(const uint8_t *data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+void TagMonitor::monitorSingleMetadata(eventSource source, SourceMonitor &monitor,
+        int64_t frameNumber, nsecs_t timestamp, const std::string& cameraId,
+        LastValue *lastValues, const CameraMetadata& metadata) {
+    for (size_t i = 0; i < monitor.tags.size(); i++) {
+        uint32_t tag = monitor.tags[i];
+        LastValue &lastValue = lastValues[i];
+
+        camera_metadata_ro_entry entry = metadata.find(tag);
+        if (entry.count > 0) {
+            size_t entryBytes = camera_metadata_type_size[entry.type] * entry.count;
+            size_t keptBytes = std::min(entryBytes, kMaxEventDataSize);
+            uint64_t hash = (entryBytes > kMaxEventDataSize) ?
+                    hashEventData(entry.data.u8, entryBytes) : 0;
+
+            // No last value is always considered to be different
+            bool isDifferent = !lastValue.present ||
+                    lastValue.type != entry.type ||
+                    lastValue.count != entry.count ||
+                    lastValue.hash != hash ||
+                    memcmp(entry.data.u8, lastValue.data, keptBytes) != 0;
+            if (!isDifferent) continue;
 
-        if (isDifferent) {
             ALOGV("%s: Tag %s changed", __FUNCTION__,
                   get_local_camera_metadata_tag_name_vendor_id(
                           tag, mVendorTagId));
-            lastValues.update(entry);
-            mMonitoringEvents.emplace(source, frameNumber, timestamp, entry, cameraId,
-                                      std::unordered_set<int>(), -1);
+            lastValue.present = true;
+            lastValue.type = entry.type;
+            lastValue.count = entry.count;
+            lastValue.hash = hash;
+            memcpy(lastValue.data, entry.data.u8, keptBytes);
+
+            MonitorEvent *event = beginEvent(monitor, source, VALUE_CHANGED, frameNumber,
+                    timestamp, cameraId);
+            event->tag = tag;
+            event->type = entry.type;
+            event->count = entry.count;
+            memcpy(event->data, entry.data.u8, keptBytes);
+            endEvent(monitor);
+        } else if (lastValue.present) {
+            // Value has been removed
+            ALOGV("%s: Tag %s removed", __FUNCTION__,
+                  get_local_camera_metadata_tag_name_vendor_id(
+                          tag, mVendorTagId));
+            lastValue.present = false;
+
+            MonitorEvent *event = beginEvent(monitor, source, VALUE_REMOVED, frameNumber,
+                    timestamp, cameraId);
+            event->tag = tag;
+            event->type = get_local_camera_metadata_tag_type_vendor_id(tag, mVendorTagId);
+            endEvent(monitor);
+        }
+    }
+}
+
+TagMonitor::MonitorEvent* TagMonitor::beginEvent(SourceMonitor &monitor, eventSource source,
+        eventKind kind, int64_t frameNumber, nsecs_t timestamp, const std::string& cameraId) {
+    MonitorEvent *event = &monitor.pendingEvent;
+    event->sequence = mNextEventSequence.fetch_add(1, std::memory_order_relaxed);
+    event->frameNumber = frameNumber;
+    event->timestamp = timestamp;
+    event->tag = 0;
+    event->count = 0;
+    event->inputStreamId = -1;
+    event->source = source;
+    event->kind = kind;
+    event->type = 0;
+    event->reserved = 0;
+    strlcpy(event->cameraId, cameraId.c_str(), sizeof(event->cameraId));
+    return event;
+}
+
+void TagMonitor::endEvent(SourceMonitor &monitor) {
+    uint64_t words[kEventWords];
+    memcpy(words, &monitor.pendingEvent, sizeof(words));
+
+    uint64_t index = monitor.numEvents.load(std::memory_order_relaxed);
+    EventSlot &slot = monitor.events[index % kMaxMonitorEvents];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kEventWords; i++) {
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    slot.sequence.store(2 * (index + 1), std::memory_order_release);
+    monitor.numEvents.store(index + 1, std::memory_order_release);
+}
+
+std::vector<TagMonitor::MonitorEvent> TagMonitor::getLatestEvents() const {
+    std::vector<MonitorEvent> events;
+    events.reserve(std::size(mSources) * kMaxMonitorEvents);
+
+    for (const SourceMonitor &monitor : mSources) {
+        uint64_t numEvents = monitor.numEvents.load(std::memory_order_acquire);
+        uint64_t firstEvent = (numEvents > kMaxMonitorEvents) ? numEvents - kMaxMonitorEvents : 0;
+        for (uint64_t i = firstEvent; i < numEvents; i++) {
+            const EventSlot &slot = monitor.events[i % kMaxMonitorEvents];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            uint64_t words[kEventWords];
+            for (size_t j = 0; j < kEventWords; j++) {
+                words[j] = slot.words[j].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // Skip the events overwritten while being copied
+            if (sequence != 2 * (i + 1) ||
+                    slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                continue;
+            }
+            MonitorEvent event;
+            memcpy(&event, words, sizeof(event));
+            events.push_back(event);
         }
-    } else if (lastEntry.count > 0) {
-        // Value has been removed
-        ALOGV("%s: Tag %s removed", __FUNCTION__,
-              get_local_camera_metadata_tag_name_vendor_id(
-                      tag, mVendorTagId));
-        lastValues.erase(tag);
-        entry.tag = tag;
-        entry.type = get_local_camera_metadata_tag_type_vendor_id(tag,
-                mVendorTagId);
-        entry.count = 0;
-        mLastInputStreamId = inputStreamId;
-        mLastStreamIds = outputStreamIds;
-        mMonitoringEvents.emplace(source, frameNumber, timestamp, entry, cameraId,
-                                  std::unordered_set<int>(), -1);
     }
+
+    std::sort(events.begin(), events.end(),
+            [](const MonitorEvent &a, const MonitorEvent &b) {
+                return a.sequence > b.sequence;
+            });
+    if (events.size() > kMaxMonitorEvents) {
+        events.resize(kMaxMonitorEvents);
+    }
+    return events;
 }
 
 void TagMonitor::dumpMonitoredMetadata(int fd) {
@@ -249,36 +371,53 @@ void TagMonitor::dumpMonitoredMetadata(int fd) {
         dprintf(fd, "     Tag monitoring disabled (enable with -m <name1,..,nameN>)\n");
     }
 
-    if (mMonitoringEvents.size() == 0) { return; }
-
-    dprintf(fd, "     Monitored tag event log:\n");
-
     std::vector<std::string> eventStrs;
     dumpMonitoredTagEventsToVectorLocked(eventStrs);
+    if (eventStrs.empty()) { return; }
+
+    dprintf(fd, "     Monitored tag event log:\n");
     for (const std::string &eventStr : eventStrs) {
         dprintf(fd, "        %s", eventStr.c_str());
     }
 }
 
+std::vector<uint8_t> TagMonitor::getMonitoredMetadataBinary() const {
+    std::vector<MonitorEvent> events = getLatestEvents();
+    std::reverse(events.begin(), events.end());
+
+    MonitorLogHeader header = {
+        .magic = kMonitorLogMagic,
+        .version = kMonitorLogVersion,
+        .eventSize = sizeof(MonitorEvent),
+        .vendorTagId = static_cast<uint64_t>(mVendorTagId),
+        .numEvents = static_cast<uint32_t>(events.size()),
+        .reserved = 0,
+    };
+    std::vector<uint8_t> log(sizeof(header) + events.size() * sizeof(MonitorEvent));
+    memcpy(log.data(), &header, sizeof(header));
+    memcpy(log.data() + sizeof(header), events.data(), events.size() * sizeof(MonitorEvent));
+    return log;
+}
+
 void TagMonitor::getLatestMonitoredTagEvents(std::vector<std::string> &out) {
     std::lock_guard<std::mutex> lock(mMonitorMutex);
     dumpMonitoredTagEventsToVectorLocked(out);
 }
 
 void TagMonitor::dumpMonitoredTagEventsToVectorLocked(std::vector<std::string> &vec) {
-    if (mMonitoringEvents.size() == 0) { return; }
-
-    for (const auto& event : mMonitoringEvents) {
+    for (const MonitorEvent& event : getLatestEvents()) {
         int indentation = (event.source == REQUEST) ? 15 : 30;
-        std::string eventString = fmt::sprintf("f%d:%" PRId64 "ns:%*s%*s",
+        std::string eventString = fmt::sprintf("f%" PRId64 ":%" PRId64 "ns:%*s%*s",
                 event.frameNumber, event.timestamp,
-                2, event.cameraId.c_str(),
+                2, event.cameraId,
                 indentation,
                 event.source == REQUEST ? "REQ:" : "RES:");
 
-        if (!event.outputStreamIds.empty()) {
+        if (event.kind == OUTPUT_STREAMS_CHANGED) {
             eventString += " output stream ids:";
-            for (const auto& id : event.outputStreamIds) {
+            for (uint32_t i = 0; i < event.count && i < kMaxEventStreamIds; i++) {
+                int32_t id;
+                memcpy(&id, event.data + i * sizeof(id), sizeof(id));
                 eventString += fmt::sprintf(" %d", id);
             }
             eventString += "\n";
@@ -286,7 +425,7 @@ void TagMonitor::dumpMonitoredTagEventsToVectorLocked(std::vector<std::string> &
             continue;
         }
 
-        if (event.inputStreamId != -1) {
+        if (event.kind == INPUT_STREAM_CHANGED) {
             eventString += fmt::sprintf(" input stream id: %d\n", event.inputStreamId);
             vec.emplace_back(eventString);
             continue;
@@ -297,12 +436,18 @@ void TagMonitor::dumpMonitoredTagEventsToVectorLocked(std::vector<std::string> &
                 get_local_camera_metadata_section_name_vendor_id(event.tag, mVendorTagId),
                 get_local_camera_metadata_tag_name_vendor_id(event.tag, mVendorTagId));
 
-        if (event.newData.empty()) {
+        if (event.kind == VALUE_REMOVED) {
             eventString += " (Removed)\n";
         } else {
+            // Only the leading values of large tags are kept
+            uint32_t keptCount = std::min<uint32_t>(event.count,
+                    kMaxEventDataSize / camera_metadata_type_size[event.type]);
             eventString += getEventDataString(
-                    event.newData.data(), event.tag, event.type,
-                    event.newData.size() / camera_metadata_type_size[event.type], indentation + 18);
+                    event.data, event.tag, event.type, keptCount, indentation + 18);
+            if (keptCount < event.count) {
+                eventString += fmt::sprintf("%*s(first %" PRIu32 " of %" PRIu32 " values)\n",
+                        indentation + 22, "", keptCount, event.count);
+            }
         }
         vec.emplace_back(eventString);
     }
@@ -387,22 +532,4 @@ std::string TagMonitor::getEventDataString(const uint8_t* data_ptr, uint32_t tag
     return returnStr.str();
 }
 
-template<typename T>
-TagMonitor::MonitorEvent::MonitorEvent(eventSource src, uint32_t frameNumber, nsecs_t timestamp,
-        const T &value, const std::string& cameraId,
-        const std::unordered_set<int32_t> &outputStreamIds,
-        int32_t inputStreamId) :
-        source(src),
-        frameNumber(frameNumber),
-        timestamp(timestamp),
-        cameraId(cameraId),
-        tag(value.tag),
-        type(value.type),
-        newData(value.data.u8, value.data.u8 + camera_metadata_type_size[value.type] * value.count),
-        outputStreamIds(outputStreamIds),
-        inputStreamId(inputStreamId) {}
-
-TagMonitor::MonitorEvent::~MonitorEvent() {
-}
-
 } // namespace android
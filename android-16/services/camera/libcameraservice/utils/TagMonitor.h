@@ -17,6 +17,7 @@
 #ifndef ANDROID_SERVERS_CAMERA_TAGMONITOR_H
 #define ANDROID_SERVERS_CAMERA_TAGMONITOR_H
 
+#include <array>
 #include <vector>
 #include <atomic>
 #include <mutex>
@@ -26,7 +27,6 @@
 #include <utils/RefBase.h>
 #include <utils/Timers.h>
 
-#include <media/RingBuffer.h>
 #include <system/camera_metadata.h>
 #include <system/camera_vendor_tags.h>
 #include <camera/CameraMetadata.h>
@@ -37,18 +37,87 @@ namespace android {
 /**
  * A monitor for camera metadata values.
  * Tracks changes to specified metadata values over time, keeping a circular
- * buffer log that can be dumped at will. */
+ * buffer log that can be dumped at will.
+ *
+ * Requests are only monitored by the request thread, and results only by the
+ * thread processing capture results, one at a time. Each event source keeps
+ * its own latest-seen values and event log, so monitoring a request or result
+ * takes no lock and allocates no memory, and can be left enabled at high frame
+ * rates. */
 class TagMonitor {
   public:
 
     // Monitor argument
     static const std::string kMonitorOption;
+    // Dump the event log in the binary format below instead of as text.
+    // Each camera device dump then has a line
+    //   "Monitored tag event log (binary, <size> bytes):"
+    // followed by the <size> bytes of the log and a newline, e.g. extract it with
+    //   tail -c +<offset of the byte after the line + 1> dump | head -c <size>
+    static const std::string kMonitorBinaryDumpOption;
 
     enum eventSource {
         REQUEST,
         RESULT
     };
 
+    enum eventKind {
+        // The value of a tag changed, or the tag was added
+        VALUE_CHANGED,
+        // The tag was removed
+        VALUE_REMOVED,
+        // The output streams of the requests changed
+        OUTPUT_STREAMS_CHANGED,
+        // The input stream of the requests changed
+        INPUT_STREAM_CHANGED
+    };
+
+    // Values of tags past this size are truncated in the event log
+    static constexpr size_t kMaxEventDataSize = 64;
+    // Physical camera ids past this size are truncated in the event log
+    static constexpr size_t kMaxCameraIdSize = 16;
+
+    /**
+     * A monitoring event, stored inline in the event log.
+     * The binary dump writes the events as is, so the layout must not change
+     * without bumping kMonitorLogVersion.
+     */
+    struct MonitorEvent {
+        // Order of the event among the events of all sources
+        uint64_t sequence;
+        int64_t frameNumber;
+        nsecs_t timestamp;
+        uint32_t tag;
+        // Number of values of the tag, or of output stream ids; data only has
+        // the first kMaxEventDataSize bytes of them
+        uint32_t count;
+        int32_t inputStreamId;
+        uint8_t source;
+        uint8_t kind;
+        uint8_t type;
+        uint8_t reserved;
+        // Null-terminated, empty for the logical camera
+        char cameraId[kMaxCameraIdSize];
+        // Tag values, or output stream ids as int32_t
+        uint8_t data[kMaxEventDataSize];
+    };
+
+    /**
+     * Header of the binary dump, followed by numEvents MonitorEvents, oldest
+     * first. All fields are in host byte order.
+     */
+    struct MonitorLogHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t eventSize;
+        uint64_t vendorTagId;
+        uint32_t numEvents;
+        uint32_t reserved;
+    };
+
+    static constexpr uint32_t kMonitorLogMagic = 0x4e4f4d54; // "TMON"
+    static constexpr uint16_t kMonitorLogVersion = 1;
+
     TagMonitor();
 
     TagMonitor(const TagMonitor& other);
@@ -74,12 +143,83 @@ class TagMonitor {
     // Dump current event log to the provided fd
     void dumpMonitoredMetadata(int fd);
 
+    // Returns the current event log as a MonitorLogHeader followed by the events
+    std::vector<uint8_t> getMonitoredMetadataBinary() const;
+
     // Dumps the latest monitored Tag events to the passed vector.
     // NOTE: The events are appended to the vector in reverser chronological order
     // (i.e. most recent first)
     void getLatestMonitoredTagEvents(std::vector<std::string> &out);
 
   private:
+    // Latest-seen value of a tracked tag
+    struct LastValue {
+        bool present = false;
+        uint8_t type = 0;
+        uint32_t count = 0;
+        // Hash of the whole value, for values larger than data
+        uint64_t hash = 0;
+        uint8_t data[kMaxEventDataSize];
+    };
+
+    static_assert(sizeof(MonitorEvent) % sizeof(uint64_t) == 0);
+    static constexpr size_t kEventWords = sizeof(MonitorEvent) / sizeof(uint64_t);
+
+    // An event log entry. sequence is odd while the entry is being written,
+    // and 2 * (index + 1) once words hold the index-th event of the source.
+    // The event is kept in atomic words, so that dumps can copy it while it is
+    // overwritten, and drop the copy.
+    struct EventSlot {
+        std::atomic<uint64_t> sequence{0};
+        std::array<std::atomic<uint64_t>, kEventWords> words{};
+    };
+
+    // A ring buffer for tracking the last kMaxMonitorEvents metadata changes
+    static constexpr size_t kMaxMonitorEvents = 100;
+    static constexpr size_t kMaxPhysicalCameras = 8;
+    static constexpr size_t kMaxEventStreamIds = kMaxEventDataSize / sizeof(int32_t);
+
+    // Monitoring state of one event source, only updated by the thread
+    // monitoring that source
+    struct SourceMonitor {
+        // Value of mConfigGeneration the state below was set up for
+        uint32_t configGeneration = 0;
+        std::vector<uint32_t> tags;
+        // Latest-seen values of the tags of the logical camera, followed by
+        // those of each physical camera in physicalCameraIds
+        std::vector<LastValue> lastValues;
+        std::array<std::string, kMaxPhysicalCameras> physicalCameraIds;
+        size_t numPhysicalCameras = 0;
+
+        int32_t lastInputStreamId = -1;
+        std::array<int32_t, kMaxEventStreamIds> lastStreamIds;
+        size_t numLastStreamIds = 0;
+
+        // Event being filled in between beginEvent() and endEvent()
+        MonitorEvent pendingEvent;
+        // Number of events ever written to events
+        std::atomic<uint64_t> numEvents{0};
+        std::array<EventSlot, kMaxMonitorEvents> events;
+    };
+
+    // Set up the state of monitor for the current monitored tags, if they
+    // changed since it was last set up
+    void updateSourceConfig(SourceMonitor &monitor);
+
+    void monitorSingleMetadata(eventSource source, SourceMonitor &monitor,
+            int64_t frameNumber, nsecs_t timestamp, const std::string& cameraId,
+            LastValue *lastValues, const CameraMetadata& metadata);
+
+    // Starts the next event of monitor, and returns it to be filled in;
+    // endEvent() writes it to the event log of monitor
+    MonitorEvent* beginEvent(SourceMonitor &monitor, eventSource source, eventKind kind,
+            int64_t frameNumber, nsecs_t timestamp, const std::string& cameraId);
+    void endEvent(SourceMonitor &monitor);
+
+    // Returns the last kMaxMonitorEvents events of all sources, most recent
+    // first
+    std::vector<MonitorEvent> getLatestEvents() const;
+
     // Dumps monitored tag events to the passed vector without acquiring
     // mMonitorMutex. mMonitorMutex must be acquired before calling this
     // function.
@@ -88,56 +228,18 @@ class TagMonitor {
     static std::string getEventDataString(const uint8_t* data_ptr, uint32_t tag, int type,
             int count, int indentation);
 
-    void monitorSingleMetadata(TagMonitor::eventSource source, int64_t frameNumber,
-            nsecs_t timestamp, const std::string& cameraId, uint32_t tag,
-            const CameraMetadata& metadata, const std::unordered_set<int32_t> &outputStreamIds,
-            int32_t inputStreamId);
-
     std::atomic<bool> mMonitoringEnabled;
+    // Guards mMonitoredTagList. Only taken by the monitoring threads when the
+    // monitored tags change.
     std::mutex mMonitorMutex;
+    // Incremented whenever the monitored tags change or monitoring is disabled
+    std::atomic<uint32_t> mConfigGeneration;
 
     // Current tags to monitor and record changes to
     std::vector<uint32_t> mMonitoredTagList;
 
-    // Latest-seen values of tracked tags
-    CameraMetadata mLastMonitoredRequestValues;
-    CameraMetadata mLastMonitoredResultValues;
-
-    std::unordered_map<std::string, CameraMetadata> mLastMonitoredPhysicalRequestKeys;
-    std::unordered_map<std::string, CameraMetadata> mLastMonitoredPhysicalResultKeys;
-
-    int32_t mLastInputStreamId = -1;
-    std::unordered_set<int32_t> mLastStreamIds;
-
-    /**
-     * A monitoring event
-     * Stores a new metadata field value and the timestamp at which it changed.
-     * Copies the source metadata value array and frees it on destruct.
-     */
-    struct MonitorEvent {
-        template<typename T>
-        MonitorEvent(eventSource src, uint32_t frameNumber, nsecs_t timestamp,
-                const T &newValue, const std::string& cameraId,
-                const std::unordered_set<int32_t> &outputStreamIds, int32_t inputStreamId);
-        ~MonitorEvent();
-
-        eventSource source;
-        uint32_t frameNumber;
-        nsecs_t timestamp;
-        std::string cameraId;
-        uint32_t tag;
-        uint8_t type;
-        std::vector<uint8_t> newData;
-        // NOTE: We want to print changes to outputStreamIds and inputStreamId in their own lines.
-        // So any MonitorEvent where these fields are not the default value will have garbage
-        // values for all fields other than source, frameNumber, timestamp, and cameraId.
-        std::unordered_set<int32_t> outputStreamIds;
-        int32_t inputStreamId = -1;
-    };
-
-    // A ring buffer for tracking the last kMaxMonitorEvents metadata changes
-    static const int kMaxMonitorEvents = 100;
-    RingBuffer<MonitorEvent> mMonitoringEvents;
+    std::atomic<uint64_t> mNextEventSequence;
+    SourceMonitor mSources[2];
 
     // 3A fields to use with the "3a" option
     static const char *k3aTags;
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Camera3-YuvTileCopy"
+#define ATRACE_TAG ATRACE_TAG_CAMERA
+//#define LOG_NDEBUG 0
+
+#include "YuvTileCopy.h"
+
+#include <algorithm>
+
+#include <libyuv.h>
+#include <utils/Trace.h>
+
+namespace android {
+
+void copyYuvTile(const CameraYuvPlanes &yuvBuffer, uint8_t *codecData,
+        const MediaImage2 &imageInfo, size_t top, size_t left, size_t width, size_t height) {
+    ATRACE_CALL();
+
+    // The libyuv plane functions below pick the fastest row function for the CPU, and copy a
+    // whole plane in one go when both planes have no padding.
+    uint8_t *dstY = codecData + imageInfo.mPlane[MediaImage2::Y].mOffset;
+    uint8_t *dstU = codecData + imageInfo.mPlane[MediaImage2::U].mOffset;
+    uint8_t *dstV = codecData + imageInfo.mPlane[MediaImage2::V].mOffset;
+    int32_t dstUvRowInc = imageInfo.mPlane[MediaImage2::U].mRowInc;
+
+    // Y
+    libyuv::CopyPlane(yuvBuffer.data + top * yuvBuffer.stride + left, yuvBuffer.stride,
+            dstY, imageInfo.mPlane[MediaImage2::Y].mRowInc, width, height);
+
+    // U is Cb, V is Cr
+    bool codecUPlaneFirst = imageInfo.mPlane[MediaImage2::V].mOffset >
+            imageInfo.mPlane[MediaImage2::U].mOffset;
+    uint32_t codecUvOffsetDiff = codecUPlaneFirst ?
+            imageInfo.mPlane[MediaImage2::V].mOffset - imageInfo.mPlane[MediaImage2::U].mOffset :
+            imageInfo.mPlane[MediaImage2::U].mOffset - imageInfo.mPlane[MediaImage2::V].mOffset;
+    bool isCodecUvSemiplannar = (codecUvOffsetDiff == 1) &&
+            (imageInfo.mPlane[MediaImage2::U].mRowInc ==
+            imageInfo.mPlane[MediaImage2::V].mRowInc) &&
+            (imageInfo.mPlane[MediaImage2::U].mColInc == 2) &&
+            (imageInfo.mPlane[MediaImage2::V].mColInc == 2);
+    bool isCodecUvPlannar =
+            ((codecUPlaneFirst && codecUvOffsetDiff >=
+                    imageInfo.mPlane[MediaImage2::U].mRowInc * imageInfo.mHeight/2) ||
+            ((!codecUPlaneFirst && codecUvOffsetDiff >=
+                    imageInfo.mPlane[MediaImage2::V].mRowInc * imageInfo.mHeight/2))) &&
+            imageInfo.mPlane[MediaImage2::U].mColInc == 1 &&
+            imageInfo.mPlane[MediaImage2::V].mColInc == 1;
+    bool cameraUPlaneFirst = yuvBuffer.dataCr > yuvBuffer.dataCb;
+
+    size_t chromaTop = top / 2;
+    size_t chromaWidth = width / 2;
+    size_t chromaHeight = (top + height) / 2 - chromaTop;
+    if (isCodecUvSemiplannar && yuvBuffer.chromaStep == 2) {
+        // UV semiplannar
+        // The chrome plane could be either Cb first, or Cr first. Take the
+        // smaller address.
+        const uint8_t *src = std::min(yuvBuffer.dataCb, yuvBuffer.dataCr) +
+                chromaTop * yuvBuffer.chromaStride + left;
+        uint8_t *dst = codecUPlaneFirst ? dstU : dstV;
+        if (codecUPlaneFirst == cameraUPlaneFirst) {
+            libyuv::CopyPlane(src, yuvBuffer.chromaStride, dst, dstUvRowInc,
+                    chromaWidth * 2, chromaHeight);
+        } else {
+            libyuv::SwapUVPlane(src, yuvBuffer.chromaStride, dst, dstUvRowInc,
+                    chromaWidth, chromaHeight);
+        }
+    } else if (isCodecUvSemiplannar && yuvBuffer.chromaStep == 1) {
+        // Interleave the camera U and V planes
+        const uint8_t *srcCb = yuvBuffer.dataCb + chromaTop * yuvBuffer.chromaStride + left / 2;
+        const uint8_t *srcCr = yuvBuffer.dataCr + chromaTop * yuvBuffer.chromaStride + left / 2;
+        libyuv::MergeUVPlane(codecUPlaneFirst ? srcCb : srcCr, yuvBuffer.chromaStride,
+                codecUPlaneFirst ? srcCr : srcCb, yuvBuffer.chromaStride,
+                codecUPlaneFirst ? dstU : dstV, dstUvRowInc, chromaWidth, chromaHeight);
+    } else if (isCodecUvPlannar && yuvBuffer.chromaStep == 1) {
+        // U plane
+        libyuv::CopyPlane(yuvBuffer.dataCb + chromaTop * yuvBuffer.chromaStride + left / 2,
+                yuvBuffer.chromaStride, dstU, imageInfo.mPlane[MediaImage2::U].mRowInc,
+                chromaWidth, chromaHeight);
+
+        // V plane
+        libyuv::CopyPlane(yuvBuffer.dataCr + chromaTop * yuvBuffer.chromaStride + left / 2,
+                yuvBuffer.chromaStride, dstV, imageInfo.mPlane[MediaImage2::V].mRowInc,
+                chromaWidth, chromaHeight);
+    } else if (isCodecUvPlannar && yuvBuffer.chromaStep == 2) {
+        // Deinterleave the camera UV plane
+        const uint8_t *src = std::min(yuvBuffer.dataCb, yuvBuffer.dataCr) +
+                chromaTop * yuvBuffer.chromaStride + left;
+        libyuv::SplitUVPlane(src, yuvBuffer.chromaStride,
+                cameraUPlaneFirst ? dstU : dstV,
+                imageInfo.mPlane[cameraUPlaneFirst ? MediaImage2::U : MediaImage2::V].mRowInc,
+                cameraUPlaneFirst ? dstV : dstU,
+                imageInfo.mPlane[cameraUPlaneFirst ? MediaImage2::V : MediaImage2::U].mRowInc,
+                chromaWidth, chromaHeight);
+    } else {
+        // Any other layout, one sample at a time.
+        uint8_t *dst = codecData;
+        for (auto row = top/2; row < (top+height)/2; row++) {
+            for (auto col = left/2; col < (left+width)/2; col++) {
+                // U/Cb
+                int32_t dstIndex = imageInfo.mPlane[MediaImage2::U].mOffset +
+                        imageInfo.mPlane[MediaImage2::U].mRowInc * (row - top/2) +
+                        imageInfo.mPlane[MediaImage2::U].mColInc * (col - left/2);
+                int32_t srcIndex = row * yuvBuffer.chromaStride + yuvBuffer.chromaStep * col;
+                dst[dstIndex] = yuvBuffer.dataCb[srcIndex];
+
+                // V/Cr
+                dstIndex = imageInfo.mPlane[MediaImage2::V].mOffset +
+                        imageInfo.mPlane[MediaImage2::V].mRowInc * (row - top/2) +
+                        imageInfo.mPlane[MediaImage2::V].mColInc * (col - left/2);
+                srcIndex = row * yuvBuffer.chromaStride + yuvBuffer.chromaStep * col;
+                dst[dstIndex] = yuvBuffer.dataCr[srcIndex];
+            }
+        }
+    }
+}
+
+} // namespace android
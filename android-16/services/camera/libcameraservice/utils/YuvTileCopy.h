@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_SERVERS_CAMERA_YUVTILECOPY_H
+#define ANDROID_SERVERS_CAMERA_YUVTILECOPY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <media/hardware/VideoAPI.h>
+
+namespace android {
+
+/**
+ * The planes of a YCbCr_420_888 camera buffer, as in CpuConsumer::LockedBuffer.
+ */
+struct CameraYuvPlanes {
+    const uint8_t *data;
+    const uint8_t *dataCb;
+    const uint8_t *dataCr;
+    uint32_t stride;
+    uint32_t chromaStride;
+    uint32_t chromaStep;
+};
+
+/**
+ * Copies the tile of |width| x |height| pixels at |top|, |left| of |yuvBuffer|
+ * to the codec input image at |codecData|, whose planes are described by
+ * |imageInfo|, an 8-bit YUV MediaImage2 with 3 planes.
+ *
+ * Semiplanar and planar layouts on either side are copied a plane at a time,
+ * interleaving, deinterleaving or swapping the chroma planes as needed. Other
+ * layouts are copied one sample at a time.
+ */
+void copyYuvTile(const CameraYuvPlanes &yuvBuffer, uint8_t *codecData,
+        const MediaImage2 &imageInfo, size_t top, size_t left, size_t width, size_t height);
+
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_YUVTILECOPY_H
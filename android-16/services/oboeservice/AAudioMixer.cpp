@@ -20,16 +20,29 @@
 
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
-#include <cstring>
+#include <algorithm>
 #include <utils/Trace.h>
 
 #include "AAudioMixer.h"
 
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define USE_NEON (true)
+#include <arm_neon.h>
+#else
+#define USE_NEON (false)
+#endif
+
+#if defined(__SSE2__)
+#define USE_SSE (true)
+#include <emmintrin.h>
+#else
+#define USE_SSE (false)
+#endif
+
 #ifndef AAUDIO_MIXER_ATRACE_ENABLED
 #define AAUDIO_MIXER_ATRACE_ENABLED    1
 #endif
 
-using android::WrappingBuffer;
 using android::FifoBuffer;
 using android::fifo_frames_t;
 
@@ -38,24 +51,20 @@ void AAudioMixer::allocate(int32_t samplesPerFrame, int32_t framesPerBurst) {
     mFramesPerBurst = framesPerBurst;
     int32_t samplesPerBuffer = samplesPerFrame * framesPerBurst;
     mOutputBuffer = std::make_unique<float[]>(samplesPerBuffer);
-    mBufferSizeInBytes = samplesPerBuffer * sizeof(float);
 }
 
-void AAudioMixer::clear() {
-    memset(mOutputBuffer.get(), 0, mBufferSizeInBytes);
+void AAudioMixer::reserveStreams(size_t numStreams) {
+    mStreams.reserve(numStreams);
+    mSources.reserve(numStreams);
+    mGains.reserve(numStreams);
 }
 
-int32_t AAudioMixer::mix(
-        int streamIndex, const std::shared_ptr<FifoBuffer>& fifo, bool allowUnderflow) {
-    WrappingBuffer wrappingBuffer;
-    float *destination = mOutputBuffer.get();
-
-#if AAUDIO_MIXER_ATRACE_ENABLED
-    ATRACE_BEGIN("aaMix");
-#endif /* AAUDIO_MIXER_ATRACE_ENABLED */
+int32_t AAudioMixer::addStream(int streamIndex, const std::shared_ptr<FifoBuffer>& fifo,
+                               bool allowUnderflow, float gain) {
+    MixerStream stream;
 
     // Gather the data from the client. May be in two parts.
-    fifo_frames_t fullFrames = fifo->getFullDataAvailable(&wrappingBuffer);
+    fifo_frames_t fullFrames = fifo->getFullDataAvailable(&stream.wrappingBuffer);
 #if AAUDIO_MIXER_ATRACE_ENABLED
     if (ATRACE_ENABLED()) {
         char rdyText[] = "aaMixRdy#";
@@ -64,7 +73,7 @@ int32_t AAudioMixer::mix(
         ATRACE_INT(rdyText, fullFrames);
     }
 #else /* MIXER_ATRACE_ENABLED */
-    (void) trackIndex;
+    (void) streamIndex;
 #endif /* AAUDIO_MIXER_ATRACE_ENABLED */
 
     // If allowUnderflow then always advance by one burst even if we do not have the data.
@@ -78,38 +87,111 @@ int32_t AAudioMixer::mix(
         framesDesired = fullFrames; // just use what is available then stop
     }
 
-    // Mix data in one or two parts.
-    int partIndex = 0;
-    int32_t framesLeft = framesDesired;
-    while (framesLeft > 0 && partIndex < WrappingBuffer::SIZE) {
-        fifo_frames_t framesToMixFromPart = framesLeft;
-        fifo_frames_t framesAvailableFromPart = wrappingBuffer.numFrames[partIndex];
-        if (framesAvailableFromPart > 0) {
-            if (framesToMixFromPart > framesAvailableFromPart) {
-                framesToMixFromPart = framesAvailableFromPart;
-            }
-            mixPart(destination, (float *)wrappingBuffer.data[partIndex],
-                    framesToMixFromPart);
+    const int32_t framesRead = std::min(framesDesired, fullFrames);
+    stream.fifo = fifo;
+    stream.framesToMix = framesRead;
+    stream.framesToAdvance = framesDesired;
+    stream.gain = gain;
+    mStreams.push_back(std::move(stream));
+    return framesRead;
+}
+
+void AAudioMixer::mixStreams() {
+#if AAUDIO_MIXER_ATRACE_ENABLED
+    ATRACE_BEGIN("aaMix");
+#endif /* AAUDIO_MIXER_ATRACE_ENABLED */
 
-            destination += framesToMixFromPart * mSamplesPerFrame;
-            framesLeft -= framesToMixFromPart;
+    // Each stream has at most two parts, and streams only drop out before the end
+    // of the burst, so the burst is divided into segments where the set of
+    // source pointers does not change. Each segment is mixed in one pass.
+    float *destination = mOutputBuffer.get();
+    int32_t frameIndex = 0;
+    while (frameIndex < mFramesPerBurst) {
+        int32_t segmentEnd = mFramesPerBurst;
+        mSources.clear();
+        mGains.clear();
+        for (const MixerStream& stream : mStreams) {
+            if (frameIndex >= stream.framesToMix) {
+                continue; // no more data from this stream
+            }
+            const int32_t framesInPart0 = stream.wrappingBuffer.numFrames[0];
+            const float *source;
+            int32_t partEnd;
+            if (frameIndex < framesInPart0) {
+                source = static_cast<const float *>(stream.wrappingBuffer.data[0])
+                        + frameIndex * mSamplesPerFrame;
+                partEnd = std::min(framesInPart0, stream.framesToMix);
+            } else {
+                source = static_cast<const float *>(stream.wrappingBuffer.data[1])
+                        + (frameIndex - framesInPart0) * mSamplesPerFrame;
+                partEnd = stream.framesToMix;
+            }
+            segmentEnd = std::min(segmentEnd, partEnd);
+            mSources.push_back(source);
+            mGains.push_back(stream.gain);
         }
-        partIndex++;
+        mixSamples(destination + frameIndex * mSamplesPerFrame,
+                   (segmentEnd - frameIndex) * mSamplesPerFrame,
+                   mSources.data(), mGains.data(), mSources.size());
+        frameIndex = segmentEnd;
+    }
+
+    for (MixerStream& stream : mStreams) {
+        stream.fifo->advanceReadIndex(stream.framesToAdvance);
     }
-    fifo->advanceReadIndex(framesDesired);
+    mStreams.clear();
 
 #if AAUDIO_MIXER_ATRACE_ENABLED
     ATRACE_END();
 #endif /* AAUDIO_MIXER_ATRACE_ENABLED */
-
-    return (framesDesired - framesLeft); // framesRead
 }
 
-void AAudioMixer::mixPart(float *destination, float *source, int32_t numFrames) {
-    int32_t numSamples = numFrames * mSamplesPerFrame;
-    // TODO maybe optimize using SIMD
-    for (int sampleIndex = 0; sampleIndex < numSamples; sampleIndex++) {
-        *destination++ += *source++;
+void AAudioMixer::mixSamples(float *destination, int32_t numSamples,
+                             const float * const *sources, const float *gains,
+                             size_t numSources) {
+    int32_t sampleIndex = 0;
+#if USE_NEON || USE_SSE
+    // Mix blocks of 16 samples held in four vector accumulators,
+    // so the output is written once regardless of the number of sources.
+    constexpr int32_t kBlockSize = 16;
+#if USE_NEON
+    for (; sampleIndex + kBlockSize <= numSamples; sampleIndex += kBlockSize) {
+        float32x4_t sum[4] = {vdupq_n_f32(0.0f), vdupq_n_f32(0.0f),
+                              vdupq_n_f32(0.0f), vdupq_n_f32(0.0f)};
+        for (size_t sourceIndex = 0; sourceIndex < numSources; sourceIndex++) {
+            const float *source = sources[sourceIndex] + sampleIndex;
+            const float32x4_t gain = vdupq_n_f32(gains[sourceIndex]);
+            for (int i = 0; i < 4; i++) {
+                sum[i] = vmlaq_f32(sum[i], vld1q_f32(source + i * 4), gain);
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            vst1q_f32(destination + sampleIndex + i * 4, sum[i]);
+        }
+    }
+#else
+    for (; sampleIndex + kBlockSize <= numSamples; sampleIndex += kBlockSize) {
+        __m128 sum[4] = {_mm_setzero_ps(), _mm_setzero_ps(),
+                         _mm_setzero_ps(), _mm_setzero_ps()};
+        for (size_t sourceIndex = 0; sourceIndex < numSources; sourceIndex++) {
+            const float *source = sources[sourceIndex] + sampleIndex;
+            const __m128 gain = _mm_set1_ps(gains[sourceIndex]);
+            for (int i = 0; i < 4; i++) {
+                sum[i] = _mm_add_ps(sum[i], _mm_mul_ps(_mm_loadu_ps(source + i * 4), gain));
+            }
+        }
+        for (int i = 0; i < 4; i++) {
+            _mm_storeu_ps(destination + sampleIndex + i * 4, sum[i]);
+        }
+    }
+#endif
+#endif // USE_NEON || USE_SSE
+    for (; sampleIndex < numSamples; sampleIndex++) {
+        float sum = 0.0f;
+        for (size_t sourceIndex = 0; sourceIndex < numSources; sourceIndex++) {
+            sum += sources[sourceIndex][sampleIndex] * gains[sourceIndex];
+        }
+        destination[sampleIndex] = sum;
     }
 }
 
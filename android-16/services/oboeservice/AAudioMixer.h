@@ -18,40 +18,78 @@
 #define AAUDIO_AAUDIO_MIXER_H
 
 #include <stdint.h>
+#include <memory>
+#include <vector>
 
 #include <aaudio/AAudio.h>
 #include <fifo/FifoBuffer.h>
 
+/**
+ * Mixes the FIFOs of the client streams of a shared endpoint into one burst.
+ *
+ * Streams are added with addStream() and then mixed together by mixStreams()
+ * in a single pass over the output buffer, rather than accumulating each stream
+ * into the output buffer in turn.
+ */
 class AAudioMixer {
 public:
     AAudioMixer() = default;
 
     void allocate(int32_t samplesPerFrame, int32_t framesPerBurst);
 
-    void clear();
+    /**
+     * Make room for mixing numStreams streams, so that addStream() and mixStreams()
+     * do not allocate memory for up to that many streams.
+     */
+    void reserveStreams(size_t numStreams);
 
     /**
-     * Mix from this FIFO
+     * Add a stream to be mixed by the next call to mixStreams().
+     * The FIFO is not read or advanced until then, so the caller must keep
+     * the FIFO memory valid until mixStreams() returns.
+     *
      * @param streamIndex for marking stream variables in systrace
      * @param fifo to read from
      * @param allowUnderflow if true then allow mixer to advance read index past the write index
-     * @return frames read from this stream
+     * @param gain linear gain applied to this stream
+     * @return frames that will be read from this stream
      */
-    int32_t mix(int streamIndex,
-                const std::shared_ptr<android::FifoBuffer>& fifo,
-                bool allowUnderflow);
+    int32_t addStream(int streamIndex,
+                      const std::shared_ptr<android::FifoBuffer>& fifo,
+                      bool allowUnderflow,
+                      float gain = 1.0f);
+
+    /**
+     * Mix the added streams into the output buffer, replacing its contents,
+     * and advance the read index of each FIFO.
+     * The output is silence if no streams were added.
+     * The list of added streams is cleared.
+     */
+    void mixStreams();
 
     float *getOutputBuffer();
 
     int32_t getFramesPerBurst() const { return mFramesPerBurst; }
 
 private:
-    void mixPart(float *destination, float *source, int32_t numFrames);
+    struct MixerStream {
+        std::shared_ptr<android::FifoBuffer> fifo;
+        android::WrappingBuffer wrappingBuffer;
+        int32_t framesToMix; // frames of data available in wrappingBuffer to mix
+        int32_t framesToAdvance; // frames to advance the read index, may exceed framesToMix
+        float gain;
+    };
+
+    // Sum numSamples from each of the numSources into destination.
+    static void mixSamples(float *destination, int32_t numSamples,
+                           const float * const *sources, const float *gains, size_t numSources);
 
     std::unique_ptr<float[]> mOutputBuffer;
     int32_t  mSamplesPerFrame = 0;
     int32_t  mFramesPerBurst = 0;
-    int32_t  mBufferSizeInBytes = 0;
+    std::vector<MixerStream> mStreams;
+    std::vector<const float *> mSources; // per segment scratch for mixStreams()
+    std::vector<float> mGains;
 };
 
 #endif //AAUDIO_AAUDIO_MIXER_H
@@ -55,7 +55,7 @@ public:
      */
     virtual void close() = 0;
 
-    aaudio_result_t registerStream(const android::sp<AAudioServiceStreamBase>& stream)
+    virtual aaudio_result_t registerStream(const android::sp<AAudioServiceStreamBase>& stream)
             EXCLUDES(mLockStreams);
 
     aaudio_result_t unregisterStream(const android::sp<AAudioServiceStreamBase>& stream)
@@ -63,6 +63,19 @@ aaudio_result_t AAudioServiceEndpointPlay::open(const aaudio::AAudioStreamReques
     return result;
 }
 
+aaudio_result_t AAudioServiceEndpointPlay::registerStream(
+        const sp<AAudioServiceStreamBase>& stream) {
+    aaudio_result_t result = AAudioServiceEndpointShared::registerStream(stream);
+    if (result == AAUDIO_OK) {
+        // callbackLoop() mixes at most every registered stream, and does so under
+        // mLockStreams, so grow its lists here rather than on the mixer thread.
+        const std::lock_guard<std::mutex> lock(mLockStreams);
+        mMixer.reserveStreams(mRegisteredStreams.size());
+        mMixedStreams.reserve(mRegisteredStreams.size());
+    }
+    return result;
+}
+
 // Mix data from each application stream and write result to the shared MMAP stream.
 void *AAudioServiceEndpointPlay::callbackLoop() {
     ALOGD("%s() entering >>>>>>>>>>>>>>> MIXER", __func__);
@@ -71,16 +84,13 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
 
     // result might be a frame count
     while (mCallbackEnabled.load() && getStreamInternal()->isActive() && (result >= 0)) {
-        // Mix data from each active stream.
-        mMixer.clear();
-
         { // brackets are for lock_guard
             int index = 0;
             int64_t mmapFramesWritten = getStreamInternal()->getFramesWritten();
 
             std::lock_guard <std::mutex> lock(mLockStreams);
+            // Add the data from each active stream to the mixer.
             for (const auto& clientStream : mRegisteredStreams) {
-                int64_t clientFramesRead = 0;
                 bool allowUnderflow = true;
 
                 if (clientStream->isSuspended()) {
@@ -98,49 +108,59 @@ void *AAudioServiceEndpointPlay::callbackLoop() {
                 sp<AAudioServiceStreamShared> streamShared =
                         static_cast<AAudioServiceStreamShared *>(clientStream.get());
 
+                std::shared_ptr<SharedRingBuffer> audioDataQueue;
+                std::shared_ptr<FifoBuffer> fifo;
                 {
                     // Lock the AudioFifo to protect against close.
+                    // The FIFO memory is then kept by audioDataQueue until after the mix,
+                    // so the lock is not held while mixing.
                     std::lock_guard <std::mutex> lock(streamShared->audioDataQueueLock);
-                    std::shared_ptr<SharedRingBuffer> audioDataQueue
-                            = streamShared->getAudioDataQueue_l();
-                    std::shared_ptr<FifoBuffer> fifo;
-                    if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())) {
-
-                        // Determine offset between framePosition in client's stream
-                        // vs the underlying MMAP stream.
-                        clientFramesRead = fifo->getReadCounter();
-                        // These two indices refer to the same frame.
-                        int64_t positionOffset = mmapFramesWritten - clientFramesRead;
-                        streamShared->setTimestampPositionOffset(positionOffset);
-
-                        int32_t framesMixed = mMixer.mix(index, fifo, allowUnderflow);
-
-                        if (streamShared->isFlowing()) {
-                            // Consider it an underflow if we got less than a burst
-                            // after the data started flowing.
-                            bool underflowed = allowUnderflow
-                                               && framesMixed < mMixer.getFramesPerBurst();
-                            if (underflowed) {
-                                streamShared->incrementXRunCount();
-                            }
-                        } else if (framesMixed > 0) {
-                            // Mark beginning of data flow after a start.
-                            streamShared->setFlowing(true);
+                    audioDataQueue = streamShared->getAudioDataQueue_l();
+                }
+                if (audioDataQueue && (fifo = audioDataQueue->getFifoBuffer())) {
+                    // Determine offset between framePosition in client's stream
+                    // vs the underlying MMAP stream.
+                    int64_t clientFramesRead = fifo->getReadCounter();
+                    // These two indices refer to the same frame.
+                    int64_t positionOffset = mmapFramesWritten - clientFramesRead;
+                    streamShared->setTimestampPositionOffset(positionOffset);
+
+                    // The client applies its own volume, so mix at unity gain.
+                    int32_t framesMixed = mMixer.addStream(index, fifo, allowUnderflow);
+
+                    if (streamShared->isFlowing()) {
+                        // Consider it an underflow if we got less than a burst
+                        // after the data started flowing.
+                        bool underflowed = allowUnderflow
+                                           && framesMixed < mMixer.getFramesPerBurst();
+                        if (underflowed) {
+                            streamShared->incrementXRunCount();
                         }
-                        clientFramesRead = fifo->getReadCounter();
+                    } else if (framesMixed > 0) {
+                        // Mark beginning of data flow after a start.
+                        streamShared->setFlowing(true);
                     }
+                    mMixedStreams.push_back({streamShared, std::move(audioDataQueue),
+                                             std::move(fifo)});
                 }
 
+                index++; // just used for labelling tracks in systrace
+            }
+
+            // Mix all the streams in one pass, this advances each FIFO.
+            mMixer.mixStreams();
+
+            for (MixedStream& mixedStream : mMixedStreams) {
+                int64_t clientFramesRead = mixedStream.fifo->getReadCounter();
                 if (clientFramesRead > 0) {
                     // This timestamp represents the completion of data being read out of the
                     // client buffer. It is sent to the client and used in the timing model
                     // to decide when the client has room to write more data.
                     Timestamp timestamp(clientFramesRead, AudioClock::getNanoseconds());
-                    streamShared->markTransferTime(timestamp);
+                    mixedStream.stream->markTransferTime(timestamp);
                 }
-
-                index++; // just used for labelling tracks in systrace
             }
+            mMixedStreams.clear();
         }
 
         // Write mixer output to stream using a blocking write.
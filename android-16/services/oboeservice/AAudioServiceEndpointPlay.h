@@ -41,11 +41,23 @@ public:
 
     aaudio_result_t open(const aaudio::AAudioStreamRequest &request) override;
 
+    aaudio_result_t registerStream(const android::sp<AAudioServiceStreamBase>& stream) override
+            EXCLUDES(mLockStreams);
+
     void *callbackLoop() override;
 
 private:
+    // A client stream that was added to the mixer for the current burst.
+    struct MixedStream {
+        android::sp<AAudioServiceStreamShared> stream;
+        // Keeps the FIFO memory valid until the mix is done, even if the stream is closed.
+        std::shared_ptr<SharedRingBuffer> audioDataQueue;
+        std::shared_ptr<android::FifoBuffer> fifo;
+    };
+
     bool                     mLatencyTuningEnabled = false; // TODO implement tuning
     AAudioMixer              mMixer;    //
+    std::vector<MixedStream> mMixedStreams; // only used by callbackLoop(), under mLockStreams
 };
 
 } /* namespace aaudio */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2025 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <fifo/FifoBuffer.h>
+
+#include "AAudioMixer.h"
+
+using android::FifoBuffer;
+using android::FifoBufferAllocated;
+using android::fifo_frames_t;
+
+constexpr int32_t kSamplesPerFrame = 2;
+constexpr int32_t kBurstsPerFifo = 4;
+
+// Client FIFOs, kept full, with an odd offset so that the reads wrap around.
+static std::vector<std::shared_ptr<FifoBuffer>> createFifos(int32_t numStreams,
+                                                            int32_t framesPerBurst) {
+    std::vector<std::shared_ptr<FifoBuffer>> fifos;
+    const fifo_frames_t capacity = framesPerBurst * kBurstsPerFifo;
+    std::vector<float> data(capacity * kSamplesPerFrame, 0.1f);
+    for (int32_t i = 0; i < numStreams; i++) {
+        auto fifo = std::make_shared<FifoBufferAllocated>(
+                kSamplesPerFrame * sizeof(float), capacity);
+        fifo->write(data.data(), capacity);
+        fifo->advanceReadIndex(i * 7 % framesPerBurst);
+        fifos.push_back(std::move(fifo));
+    }
+    return fifos;
+}
+
+// Writes one burst into each FIFO, as the clients would.
+static void refillFifos(const std::vector<std::shared_ptr<FifoBuffer>>& fifos,
+                        int32_t framesPerBurst) {
+    for (const auto& fifo : fifos) {
+        fifo->advanceWriteIndex(framesPerBurst);
+    }
+}
+
+/**
+ * Mixes numStreams client streams into one burst.
+ *
+ * Args: number of streams, frames per burst.
+ */
+static void BM_AAudioMixer(benchmark::State& state) {
+    const int32_t numStreams = state.range(0);
+    const int32_t framesPerBurst = state.range(1);
+    AAudioMixer mixer;
+    mixer.allocate(kSamplesPerFrame, framesPerBurst);
+    mixer.reserveStreams(numStreams);
+    auto fifos = createFifos(numStreams, framesPerBurst);
+
+    for (auto _ : state) {
+        for (int32_t i = 0; i < numStreams; i++) {
+            mixer.addStream(i, fifos[i], true /* allowUnderflow */);
+        }
+        mixer.mixStreams();
+        benchmark::DoNotOptimize(mixer.getOutputBuffer());
+        benchmark::ClobberMemory();
+        refillFifos(fifos, framesPerBurst);
+    }
+    state.counters["time_per_frame"] = benchmark::Counter(framesPerBurst,
+            benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+static void MixerArgs(benchmark::internal::Benchmark* b) {
+    for (int64_t numStreams : {1, 2, 4, 8, 16}) {
+        for (int64_t framesPerBurst : {48, 96, 192, 240, 960}) {
+            b->Args({numStreams, framesPerBurst});
+        }
+    }
+}
+
+BENCHMARK(BM_AAudioMixer)->Apply(MixerArgs);
+
+BENCHMARK_MAIN();